@@ -0,0 +1,202 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "mock_drm.h"
+#include "../../plugins/platforms/drm/drm_atomic_cursor.h"
+#include "../../plugins/platforms/drm/drm_buffer.h"
+#include "../../plugins/platforms/drm/drm_object_plane.h"
+
+#include <QtTest>
+
+using namespace KWin;
+
+static const int s_fd = 30;
+static const uint32_t s_planeId = 100;
+static const uint32_t s_crtcId = 3;
+
+class MockBuffer : public DrmBuffer
+{
+public:
+    MockBuffer(quint32 bufferId, const QSize &size)
+        : DrmBuffer(s_fd)
+    {
+        m_bufferId = bufferId;
+        m_size = size;
+    }
+};
+
+class AtomicCursorTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testPopulate();
+    void testHidden();
+    void testCommit();
+    void testUnchangedPosition();
+
+private:
+    uint64_t value(const MockDrm::AtomicCommit &commit, DrmPlane::PropertyIndex property) const;
+
+    QVector<_drmModeProperty> m_properties;
+    DrmPlane *m_plane = nullptr;
+};
+
+void AtomicCursorTest::initTestCase()
+{
+    const char *names[] = {"type", "SRC_X", "SRC_Y", "SRC_W", "SRC_H", "CRTC_X", "CRTC_Y",
+                           "CRTC_W", "CRTC_H", "FB_ID", "CRTC_ID", "rotation"};
+    for (uint32_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        _drmModeProperty property{};
+        // the property ids are the PropertyIndex plus one
+        property.prop_id = i + 1;
+        qstrncpy(property.name, names[i], sizeof(property.name));
+        m_properties << property;
+    }
+    MockDrm::addDrmModeProperties(s_fd, m_properties);
+}
+
+void AtomicCursorTest::init()
+{
+    m_plane = new DrmPlane(s_planeId, s_fd);
+    QVERIFY(m_plane->initProps());
+    MockDrm::clearAtomicCommits();
+}
+
+void AtomicCursorTest::cleanup()
+{
+    delete m_plane;
+    m_plane = nullptr;
+}
+
+uint64_t AtomicCursorTest::value(const MockDrm::AtomicCommit &commit, DrmPlane::PropertyIndex property) const
+{
+    return commit.objects.value(s_planeId).value(uint32_t(property) + 1, 0xdeadbeef);
+}
+
+void AtomicCursorTest::testPopulate()
+{
+    // the cursor state goes along with a commit of the whole output
+    MockBuffer buffer(7, QSize(64, 64));
+    DrmAtomicCursor cursor(m_plane, s_fd);
+    QVERIFY(!cursor.isDirty());
+    cursor.setBuffer(&buffer);
+    cursor.setPosition(QPoint(10, 20));
+    cursor.setCrtc(s_crtcId);
+    QVERIFY(cursor.isDirty());
+
+    drmModeAtomicReq *req = drmModeAtomicAlloc();
+    QVERIFY(cursor.populate(req));
+    QCOMPARE(drmModeAtomicCommit(s_fd, req, DRM_MODE_ATOMIC_NONBLOCK, nullptr), 0);
+    drmModeAtomicFree(req);
+    cursor.committed();
+    QVERIFY(!cursor.isDirty());
+    QVERIFY(!cursor.isCommitPending());
+
+    const auto commits = MockDrm::atomicCommits();
+    QCOMPARE(commits.count(), 1);
+    const MockDrm::AtomicCommit commit = commits.first();
+    QCOMPARE(value(commit, DrmPlane::PropertyIndex::FbId), uint64_t(7));
+    QCOMPARE(value(commit, DrmPlane::PropertyIndex::CrtcId), uint64_t(s_crtcId));
+    QCOMPARE(value(commit, DrmPlane::PropertyIndex::CrtcX), uint64_t(10));
+    QCOMPARE(value(commit, DrmPlane::PropertyIndex::CrtcY), uint64_t(20));
+    QCOMPARE(value(commit, DrmPlane::PropertyIndex::CrtcW), uint64_t(64));
+    QCOMPARE(value(commit, DrmPlane::PropertyIndex::CrtcH), uint64_t(64));
+    QCOMPARE(value(commit, DrmPlane::PropertyIndex::SrcX), uint64_t(0));
+    QCOMPARE(value(commit, DrmPlane::PropertyIndex::SrcW), uint64_t(64 << 16));
+    QCOMPARE(value(commit, DrmPlane::PropertyIndex::SrcH), uint64_t(64 << 16));
+}
+
+void AtomicCursorTest::testHidden()
+{
+    // a hidden cursor and a cursor on a disabled crtc detach the plane
+    MockBuffer buffer(7, QSize(64, 64));
+    DrmAtomicCursor cursor(m_plane, s_fd);
+    cursor.setCrtc(s_crtcId);
+    QVERIFY(cursor.commit(nullptr));
+    cursor.pageFlipped();
+
+    cursor.setBuffer(&buffer);
+    cursor.setCrtc(0);
+    QVERIFY(cursor.commit(nullptr));
+    cursor.pageFlipped();
+
+    const auto commits = MockDrm::atomicCommits();
+    QCOMPARE(commits.count(), 2);
+    for (const MockDrm::AtomicCommit &commit : commits) {
+        QCOMPARE(value(commit, DrmPlane::PropertyIndex::FbId), uint64_t(0));
+        QCOMPARE(value(commit, DrmPlane::PropertyIndex::CrtcId), uint64_t(0));
+        QCOMPARE(value(commit, DrmPlane::PropertyIndex::CrtcW), uint64_t(0));
+        QCOMPARE(value(commit, DrmPlane::PropertyIndex::SrcW), uint64_t(0));
+    }
+}
+
+void AtomicCursorTest::testCommit()
+{
+    // a commit of its own only touches the cursor plane and asks for a page flip event
+    MockBuffer buffer(7, QSize(64, 64));
+    DrmAtomicCursor cursor(m_plane, s_fd);
+    cursor.setBuffer(&buffer);
+    cursor.setCrtc(s_crtcId);
+    cursor.setPosition(QPoint(10, 20));
+
+    int userData = 0;
+    QVERIFY(cursor.commit(&userData));
+    QVERIFY(cursor.isCommitPending());
+    QVERIFY(!cursor.isDirty());
+
+    auto commits = MockDrm::atomicCommits();
+    QCOMPARE(commits.count(), 1);
+    QCOMPARE(commits.first().fd, s_fd);
+    QCOMPARE(commits.first().flags, uint32_t(DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT));
+    QCOMPARE(commits.first().userData, static_cast<void *>(&userData));
+    QCOMPARE(commits.first().objects.keys(), QList<uint32_t>{s_planeId});
+    QCOMPARE(value(commits.first(), DrmPlane::PropertyIndex::CrtcX), uint64_t(10));
+
+    // motion until the page flip is collected
+    cursor.setPosition(QPoint(11, 21));
+    cursor.setPosition(QPoint(12, 22));
+    QVERIFY(cursor.isDirty());
+    cursor.pageFlipped();
+    QVERIFY(!cursor.isCommitPending());
+
+    QVERIFY(cursor.commit(&userData));
+    commits = MockDrm::atomicCommits();
+    QCOMPARE(commits.count(), 2);
+    QCOMPARE(value(commits.last(), DrmPlane::PropertyIndex::CrtcX), uint64_t(12));
+    QCOMPARE(value(commits.last(), DrmPlane::PropertyIndex::CrtcY), uint64_t(22));
+    QCOMPARE(value(commits.last(), DrmPlane::PropertyIndex::FbId), uint64_t(7));
+}
+
+void AtomicCursorTest::testUnchangedPosition()
+{
+    // motion within the same pixel doesn't need a commit
+    DrmAtomicCursor cursor(m_plane, s_fd);
+    cursor.setPosition(QPoint(10, 20));
+    cursor.committed();
+    cursor.setPosition(QPoint(10, 20));
+    QVERIFY(!cursor.isDirty());
+    cursor.setCrtc(0);
+    QVERIFY(!cursor.isDirty());
+}
+
+QTEST_GUILESS_MAIN(AtomicCursorTest)
+#include "atomiccursortest.moc"
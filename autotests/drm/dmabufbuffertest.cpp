@@ -0,0 +1,156 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../../plugins/platforms/drm/drm_buffer_gbm.h"
+
+#include <QtTest>
+
+#include <gbm.h>
+#include <xf86drmMode.h>
+
+// mocking
+
+struct gbm_bo {
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t format;
+    uint32_t handle;
+};
+
+static int s_destroyedBos = 0;
+static int s_addFbResult = 0;
+static uint32_t s_addedFormat = 0;
+static uint32_t s_addedHandle = 0;
+static uint32_t s_addedPitch = 0;
+static QVector<uint32_t> s_framebuffers;
+
+uint32_t gbm_bo_get_width(struct gbm_bo *bo)
+{
+    return bo->width;
+}
+
+uint32_t gbm_bo_get_height(struct gbm_bo *bo)
+{
+    return bo->height;
+}
+
+uint32_t gbm_bo_get_stride(struct gbm_bo *bo)
+{
+    return bo->stride;
+}
+
+uint32_t gbm_bo_get_format(struct gbm_bo *bo)
+{
+    return bo->format;
+}
+
+union gbm_bo_handle gbm_bo_get_handle(struct gbm_bo *bo)
+{
+    union gbm_bo_handle handle;
+    handle.u32 = bo->handle;
+    return handle;
+}
+
+void gbm_bo_destroy(struct gbm_bo *bo)
+{
+    s_destroyedBos++;
+    delete bo;
+}
+
+int drmModeAddFB2(int fd, uint32_t width, uint32_t height, uint32_t pixel_format, const uint32_t bo_handles[4],
+                  const uint32_t pitches[4], const uint32_t offsets[4], uint32_t *buf_id, uint32_t flags)
+{
+    Q_UNUSED(fd)
+    Q_UNUSED(width)
+    Q_UNUSED(height)
+    Q_UNUSED(offsets)
+    Q_UNUSED(flags)
+    if (s_addFbResult != 0) {
+        return s_addFbResult;
+    }
+    s_addedFormat = pixel_format;
+    s_addedHandle = bo_handles[0];
+    s_addedPitch = pitches[0];
+    *buf_id = s_framebuffers.count() + 1;
+    s_framebuffers << *buf_id;
+    return 0;
+}
+
+int drmModeRmFB(int fd, uint32_t bufferId)
+{
+    Q_UNUSED(fd)
+    return s_framebuffers.removeOne(bufferId) ? 0 : -1;
+}
+
+using KWin::DrmDmabufBuffer;
+
+class DmabufBufferTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void testCreate();
+    void testAddFbFailure();
+};
+
+void DmabufBufferTest::init()
+{
+    s_destroyedBos = 0;
+    s_addFbResult = 0;
+    s_addedFormat = 0;
+    s_addedHandle = 0;
+    s_addedPitch = 0;
+    s_framebuffers.clear();
+}
+
+void DmabufBufferTest::testCreate()
+{
+    auto bo = new gbm_bo{1920, 1080, 7680, GBM_FORMAT_XRGB8888, 42};
+    QScopedPointer<DrmDmabufBuffer> buffer(new DrmDmabufBuffer(3, bo, nullptr));
+    QCOMPARE(buffer->fd(), 3);
+    QCOMPARE(buffer->getBo(), bo);
+    QCOMPARE(buffer->size(), QSize(1920, 1080));
+    QCOMPARE(buffer->bufferId(), 1u);
+    QCOMPARE(s_addedFormat, uint32_t(GBM_FORMAT_XRGB8888));
+    QCOMPARE(s_addedHandle, 42u);
+    QCOMPARE(s_addedPitch, 7680u);
+    QCOMPARE(s_framebuffers.count(), 1);
+
+    // destroying the buffer removes the framebuffer and releases the imported bo
+    buffer.reset();
+    QVERIFY(s_framebuffers.isEmpty());
+    QCOMPARE(s_destroyedBos, 1);
+}
+
+void DmabufBufferTest::testAddFbFailure()
+{
+    s_addFbResult = -22;
+    auto bo = new gbm_bo{1920, 1080, 7680, GBM_FORMAT_XRGB8888, 42};
+    QScopedPointer<DrmDmabufBuffer> buffer(new DrmDmabufBuffer(3, bo, nullptr));
+    // a buffer without framebuffer is rejected by DrmBackend::scanout
+    QCOMPARE(buffer->bufferId(), 0u);
+    QVERIFY(s_framebuffers.isEmpty());
+
+    buffer.reset();
+    QCOMPARE(s_destroyedBos, 1);
+}
+
+QTEST_GUILESS_MAIN(DmabufBufferTest)
+#include "dmabufbuffertest.moc"
@@ -22,7 +22,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMap>
 #include <QVector>
 
+#include <cerrno>
+
+struct _drmModeAtomicReq {
+    QMap<uint32_t, QMap<uint32_t, uint64_t>> objects;
+    int count = 0;
+};
+
 static QMap<int, QVector<_drmModeProperty>> s_drmProperties{};
+static QVector<MockDrm::AtomicCommit> s_atomicCommits{};
+static bool s_testCommitsRejected = false;
 
 namespace MockDrm
 {
@@ -32,17 +41,84 @@ void addDrmModeProperties(int fd, const QVector<_drmModeProperty> &properties)
     s_drmProperties.insert(fd, properties);
 }
 
+QVector<AtomicCommit> atomicCommits()
+{
+    return s_atomicCommits;
+}
+
+void clearAtomicCommits()
+{
+    s_atomicCommits.clear();
+    s_testCommitsRejected = false;
+}
+
+void setTestCommitsRejected(bool rejected)
+{
+    s_testCommitsRejected = rejected;
+}
+
+}
+
+drmModeAtomicReqPtr drmModeAtomicAlloc()
+{
+    return new _drmModeAtomicReq;
+}
+
+void drmModeAtomicFree(drmModeAtomicReqPtr req)
+{
+    delete req;
 }
 
 int drmModeAtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id, uint64_t value)
 {
-    Q_UNUSED(req)
-    Q_UNUSED(object_id)
-    Q_UNUSED(property_id)
-    Q_UNUSED(value)
+    if (!req) {
+        return -EINVAL;
+    }
+    req->objects[object_id][property_id] = value;
+    // like libdrm, the number of properties in the request
+    return ++req->count;
+}
+
+int drmModeAtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void *user_data)
+{
+    s_atomicCommits << MockDrm::AtomicCommit{fd, flags, user_data, req->objects};
+    if (s_testCommitsRejected && (flags & DRM_MODE_ATOMIC_TEST_ONLY)) {
+        errno = EINVAL;
+        return -EINVAL;
+    }
     return 0;
 }
 
+drmModeObjectPropertiesPtr drmModeObjectGetProperties(int fd, uint32_t object_id, uint32_t object_type)
+{
+    Q_UNUSED(object_id)
+    Q_UNUSED(object_type)
+    // every object has all properties of the fd, their values are 0
+    auto it = s_drmProperties.find(fd);
+    if (it == s_drmProperties.end()) {
+        return nullptr;
+    }
+    auto *properties = new drmModeObjectProperties;
+    properties->count_props = it->count();
+    properties->props = new uint32_t[it->count()];
+    properties->prop_values = new uint64_t[it->count()];
+    for (int i = 0; i < it->count(); ++i) {
+        properties->props[i] = it->at(i).prop_id;
+        properties->prop_values[i] = 0;
+    }
+    return properties;
+}
+
+void drmModeFreeObjectProperties(drmModeObjectPropertiesPtr ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    delete[] ptr->props;
+    delete[] ptr->prop_values;
+    delete ptr;
+}
+
 drmModePropertyPtr drmModeGetProperty(int fd, uint32_t propertyId)
 {
     auto it = s_drmProperties.find(fd);
@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <cstdint>
 #include <xf86drmMode.h>
 
+#include <QMap>
 #include <QVector>
 
 namespace MockDrm
@@ -29,4 +30,22 @@ namespace MockDrm
 
 void addDrmModeProperties(int fd, const QVector<_drmModeProperty> &properties);
 
+struct AtomicCommit {
+    int fd;
+    uint32_t flags;
+    void *userData;
+    // property id to value for every object id
+    QMap<uint32_t, QMap<uint32_t, uint64_t>> objects;
+};
+/**
+ * The atomic requests passed to drmModeAtomicCommit since the last clearAtomicCommits().
+ */
+QVector<AtomicCommit> atomicCommits();
+void clearAtomicCommits();
+/**
+ * Whether drmModeAtomicCommit rejects requests with DRM_MODE_ATOMIC_TEST_ONLY, they still get
+ * recorded. Reset by clearAtomicCommits().
+ */
+void setTestCommitsRejected(bool rejected);
+
 }
@@ -0,0 +1,159 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "mock_drm.h"
+#include "../../plugins/platforms/drm/drm_atomic_cursor.h"
+#include "../../plugins/platforms/drm/drm_buffer.h"
+#include "../../plugins/platforms/drm/drm_object_plane.h"
+#include "../../plugins/platforms/drm/drm_scanout.h"
+
+#include <QtTest>
+
+using namespace KWin;
+
+static const int s_fd = 31;
+static const uint32_t s_primaryPlaneId = 100;
+static const uint32_t s_cursorPlaneId = 101;
+static const uint32_t s_crtcId = 3;
+
+class MockBuffer : public DrmBuffer
+{
+public:
+    MockBuffer(quint32 bufferId, const QSize &size)
+        : DrmBuffer(s_fd)
+    {
+        m_bufferId = bufferId;
+        m_size = size;
+    }
+};
+
+class ScanoutTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testTestCommitFirst();
+    void testRejectedTestCommit();
+    void testCursor();
+
+private:
+    uint64_t fbId(const MockDrm::AtomicCommit &commit, uint32_t planeId) const;
+
+    DrmPlane *m_primaryPlane = nullptr;
+    DrmPlane *m_cursorPlane = nullptr;
+};
+
+void ScanoutTest::initTestCase()
+{
+    const char *names[] = {"type", "SRC_X", "SRC_Y", "SRC_W", "SRC_H", "CRTC_X", "CRTC_Y",
+                           "CRTC_W", "CRTC_H", "FB_ID", "CRTC_ID", "rotation"};
+    QVector<_drmModeProperty> properties;
+    for (uint32_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        _drmModeProperty property{};
+        // the property ids are the PropertyIndex plus one
+        property.prop_id = i + 1;
+        qstrncpy(property.name, names[i], sizeof(property.name));
+        properties << property;
+    }
+    MockDrm::addDrmModeProperties(s_fd, properties);
+}
+
+void ScanoutTest::init()
+{
+    m_primaryPlane = new DrmPlane(s_primaryPlaneId, s_fd);
+    QVERIFY(m_primaryPlane->initProps());
+    m_cursorPlane = new DrmPlane(s_cursorPlaneId, s_fd);
+    QVERIFY(m_cursorPlane->initProps());
+    MockDrm::clearAtomicCommits();
+}
+
+void ScanoutTest::cleanup()
+{
+    delete m_primaryPlane;
+    m_primaryPlane = nullptr;
+    delete m_cursorPlane;
+    m_cursorPlane = nullptr;
+}
+
+uint64_t ScanoutTest::fbId(const MockDrm::AtomicCommit &commit, uint32_t planeId) const
+{
+    return commit.objects.value(planeId).value(uint32_t(DrmPlane::PropertyIndex::FbId) + 1, 0xdeadbeef);
+}
+
+void ScanoutTest::testTestCommitFirst()
+{
+    // the client buffer is only committed for real once a test commit succeeded
+    MockBuffer buffer(7, QSize(1920, 1080));
+    int userData = 0;
+    QVERIFY(scanoutAtomically(s_fd, m_primaryPlane, &buffer, nullptr, &userData));
+    QCOMPARE(m_primaryPlane->next(), &buffer);
+
+    const auto commits = MockDrm::atomicCommits();
+    QCOMPARE(commits.count(), 2);
+    QCOMPARE(commits.at(0).flags, uint32_t(DRM_MODE_ATOMIC_TEST_ONLY));
+    QCOMPARE(fbId(commits.at(0), s_primaryPlaneId), uint64_t(7));
+    QCOMPARE(commits.at(1).flags, uint32_t(DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT));
+    QCOMPARE(commits.at(1).userData, static_cast<void *>(&userData));
+    QCOMPARE(fbId(commits.at(1), s_primaryPlaneId), uint64_t(7));
+}
+
+void ScanoutTest::testRejectedTestCommit()
+{
+    // a client buffer the kernel rejects is never committed for real and the primary plane
+    // gets no next buffer, so that the output falls back to composition
+    MockDrm::setTestCommitsRejected(true);
+    MockBuffer buffer(7, QSize(1920, 1080));
+    QVERIFY(!scanoutAtomically(s_fd, m_primaryPlane, &buffer, nullptr, nullptr));
+    QVERIFY(!m_primaryPlane->next());
+
+    const auto commits = MockDrm::atomicCommits();
+    QCOMPARE(commits.count(), 1);
+    QCOMPARE(commits.first().flags, uint32_t(DRM_MODE_ATOMIC_TEST_ONLY));
+}
+
+void ScanoutTest::testCursor()
+{
+    // the pending cursor state goes along with the client buffer
+    MockBuffer cursorBuffer(8, QSize(64, 64));
+    DrmAtomicCursor cursor(m_cursorPlane, s_fd);
+    cursor.setBuffer(&cursorBuffer);
+    cursor.setCrtc(s_crtcId);
+
+    MockBuffer buffer(7, QSize(1920, 1080));
+    MockDrm::setTestCommitsRejected(true);
+    QVERIFY(!scanoutAtomically(s_fd, m_primaryPlane, &buffer, &cursor, nullptr));
+    QVERIFY(cursor.isDirty());
+
+    MockDrm::clearAtomicCommits();
+    QVERIFY(scanoutAtomically(s_fd, m_primaryPlane, &buffer, &cursor, nullptr));
+    QVERIFY(!cursor.isDirty());
+    QVERIFY(!cursor.isCommitPending());
+
+    const auto commits = MockDrm::atomicCommits();
+    QCOMPARE(commits.count(), 2);
+    for (const MockDrm::AtomicCommit &commit : commits) {
+        QCOMPARE(fbId(commit, s_primaryPlaneId), uint64_t(7));
+        QCOMPARE(fbId(commit, s_cursorPlaneId), uint64_t(8));
+    }
+}
+
+QTEST_GUILESS_MAIN(ScanoutTest)
+#include "scanouttest.moc"
@@ -0,0 +1,167 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "abstract_client.h"
+#include "composite.h"
+#include "effects.h"
+#include "effectloader.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "effect_builtins.h"
+
+#include <KConfigGroup>
+
+#include <KWayland/Client/blur.h>
+#include <KWayland/Client/connection_thread.h>
+#include <KWayland/Client/registry.h>
+#include <KWayland/Client/surface.h>
+#include <KWayland/Client/xdgshell.h>
+
+using namespace KWin;
+using namespace KWayland::Client;
+static const QString s_socketName = QStringLiteral("wayland_test_effects_blur-0");
+
+class BlurTest : public QObject
+{
+Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testCacheHitWhenOnlyWindowChanges();
+};
+
+void BlurTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient*>();
+    qRegisterMetaType<KWin::Effect*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    // disable all effects - we don't want to have it interact with the rendering
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (QString name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QVERIFY(Compositor::self());
+
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene);
+    QCOMPARE(scene->compositingType(), KWin::OpenGL2Compositing);
+}
+
+void BlurTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void BlurTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+
+    auto effectsImpl = static_cast<EffectsHandlerImpl *>(effects);
+    effectsImpl->unloadAllEffects();
+    QVERIFY(effectsImpl->loadedEffects().isEmpty());
+}
+
+void BlurTest::testCacheHitWhenOnlyWindowChanges()
+{
+    // this test verifies that a blurred window which updates itself, like a panel whose
+    // clock ticks, reuses its blurred background until something underneath changes
+    EffectsHandlerImpl *e = static_cast<EffectsHandlerImpl*>(effects);
+    const QString blurName = BuiltInEffects::nameForEffect(BuiltInEffect::Blur);
+    if (!e->loadEffect(blurName)) {
+        QSKIP("The blur is not supported by the OpenGL implementation");
+    }
+    Effect *blur = e->findEffect(blurName);
+    QVERIFY(blur);
+
+    // the blur manager is announced once the effect is loaded
+    Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    registry.create(Test::waylandConnection());
+    registry.setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+    const auto blurInterface = registry.interface(Registry::Interface::Blur);
+    QVERIFY(blurInterface.name != 0);
+    QScopedPointer<BlurManager> blurManager(registry.createBlurManager(blurInterface.name, blurInterface.version));
+    QVERIFY(blurManager->isValid());
+
+    // an opaque window underneath the blurred one
+    QScopedPointer<Surface> belowSurface(Test::createSurface());
+    QScopedPointer<XdgShellSurface> belowShellSurface(Test::createXdgShellStableSurface(belowSurface.data()));
+    AbstractClient *below = Test::renderAndWaitForShown(belowSurface.data(), QSize(400, 300), Qt::red, QImage::Format_RGB32);
+    QVERIFY(below);
+    below->move(QPoint(100, 100));
+
+    // the translucent "panel", blurred as a whole
+    QScopedPointer<Surface> panelSurface(Test::createSurface());
+    QScopedPointer<XdgShellSurface> panelShellSurface(Test::createXdgShellStableSurface(panelSurface.data()));
+    QScopedPointer<Blur> panelBlur(blurManager->createBlur(panelSurface.data()));
+    panelBlur->setRegion(nullptr);
+    panelBlur->commit();
+    AbstractClient *panel = Test::renderAndWaitForShown(panelSurface.data(), QSize(200, 50), QColor(0, 0, 255, 128));
+    QVERIFY(panel);
+    QVERIFY(panel->hasAlpha());
+    panel->move(QPoint(200, 200));
+    QVERIFY(workspace()->stackingOrder().indexOf(panel) > workspace()->stackingOrder().indexOf(below));
+
+    // the panel got blurred anew after it was shown and moved
+    QTRY_VERIFY(blur->property("cacheMisses").toInt() > 0);
+    QTest::qWait(100);
+
+    // the panel updates itself, nothing underneath changed
+    int hits = blur->property("cacheHits").toInt();
+    int misses = blur->property("cacheMisses").toInt();
+    Test::render(panelSurface.data(), QSize(200, 50), QColor(0, 255, 0, 128));
+    QTRY_VERIFY(blur->property("cacheHits").toInt() > hits);
+    QCOMPARE(blur->property("cacheMisses").toInt(), misses);
+
+    // the window underneath changes, the background has to be blurred anew
+    hits = blur->property("cacheHits").toInt();
+    misses = blur->property("cacheMisses").toInt();
+    Test::render(belowSurface.data(), QSize(400, 300), Qt::yellow, QImage::Format_RGB32);
+    QTRY_VERIFY(blur->property("cacheMisses").toInt() > misses);
+    QCOMPARE(blur->property("cacheHits").toInt(), hits);
+
+    // and can be used again afterwards
+    hits = blur->property("cacheHits").toInt();
+    Test::render(panelSurface.data(), QSize(200, 50), QColor(0, 0, 255, 128));
+    QTRY_VERIFY(blur->property("cacheHits").toInt() > hits);
+}
+
+WAYLANDTEST_MAIN(BlurTest)
+#include "blur_test.moc"
@@ -0,0 +1,184 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "abstract_client.h"
+#include "composite.h"
+#include "cursor.h"
+#include "effectloader.h"
+#include "effect_builtins.h"
+#include "platform.h"
+#include "scene.h"
+#include "screens.h"
+#include "wayland_server.h"
+
+#include <KConfigGroup>
+
+#include <KWayland/Client/surface.h>
+#include <KWayland/Client/xdgshell.h>
+
+using namespace KWin;
+using namespace KWayland::Client;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_output_damage-0");
+
+class OutputDamageTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testScreenRepaint_data();
+    void testScreenRepaint();
+    void testWindowAcrossScreens();
+};
+
+static int pixelCount(const QRegion &region)
+{
+    int count = 0;
+    for (const QRect &rect : region) {
+        count += rect.width() * rect.height();
+    }
+    return count;
+}
+
+// Waits until no screen got rendered for a while.
+static void waitForIdle(QSignalSpy &spy)
+{
+    while (spy.wait(100)) {
+        spy.clear();
+    }
+    spy.clear();
+}
+
+// Sums up the repainted pixels of every screen.
+static QVector<int> repaintedPixels(const QSignalSpy &spy)
+{
+    QVector<int> pixels(screens()->count(), 0);
+    for (const QList<QVariant> &arguments : spy) {
+        pixels[arguments.at(0).toInt()] += pixelCount(arguments.at(1).value<QRegion>());
+    }
+    return pixels;
+}
+
+void OutputDamageTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+    QMetaObject::invokeMethod(kwinApp()->platform(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(int, 3));
+
+    // disable all effects, they must not add repaints on their own
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QCOMPARE(screens()->count(), 3);
+    QCOMPARE(screens()->geometry(0), QRect(0, 0, 1280, 1024));
+    QCOMPARE(screens()->geometry(1), QRect(1280, 0, 1280, 1024));
+    QCOMPARE(screens()->geometry(2), QRect(2560, 0, 1280, 1024));
+    QVERIFY(Compositor::self());
+    waylandServer()->initWorkspace();
+}
+
+void OutputDamageTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+    // keep the software cursor away from the damage used in the tests
+    Cursors::self()->mouse()->setPos(QPoint(640, 900));
+}
+
+void OutputDamageTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+}
+
+void OutputDamageTest::testScreenRepaint_data()
+{
+    QTest::addColumn<int>("screen");
+    QTest::addColumn<QRect>("repaint");
+
+    QTest::newRow("first") << 0 << QRect(100, 100, 10, 10);
+    QTest::newRow("second") << 1 << QRect(1400, 200, 20, 10);
+    QTest::newRow("third") << 2 << QRect(3000, 300, 5, 40);
+}
+
+void OutputDamageTest::testScreenRepaint()
+{
+    // this test verifies that a repaint on one screen only repaints that part of that screen
+    QSignalSpy renderedSpy(Compositor::self()->scene(), &Scene::screenRendered);
+    QVERIFY(renderedSpy.isValid());
+    waitForIdle(renderedSpy);
+
+    QFETCH(int, screen);
+    QFETCH(QRect, repaint);
+    Compositor::self()->addRepaint(repaint);
+    QVERIFY(renderedSpy.wait());
+    // give the other screens the chance to get painted
+    QTest::qWait(100);
+
+    QVector<int> expected(screens()->count(), 0);
+    expected[screen] = repaint.width() * repaint.height();
+    QCOMPARE(repaintedPixels(renderedSpy), expected);
+}
+
+void OutputDamageTest::testWindowAcrossScreens()
+{
+    // this test verifies that the repaints of a window reach every screen the window is on,
+    // not just the screen which got painted first
+    QScopedPointer<Surface> surface(Test::createSurface());
+    QVERIFY(!surface.isNull());
+    QScopedPointer<XdgShellSurface> shellSurface(Test::createXdgShellStableSurface(surface.data()));
+    QVERIFY(!shellSurface.isNull());
+    AbstractClient *client = Test::renderAndWaitForShown(surface.data(), QSize(100, 50), Qt::blue);
+    QVERIFY(client);
+    client->move(QPoint(1280 - 40, 100));
+    QCOMPARE(client->frameGeometry(), QRect(1240, 100, 100, 50));
+
+    QSignalSpy renderedSpy(Compositor::self()->scene(), &Scene::screenRendered);
+    QVERIFY(renderedSpy.isValid());
+    waitForIdle(renderedSpy);
+
+    client->addRepaint(QRect(0, 0, 100, 50));
+    QVERIFY(renderedSpy.wait());
+    QTest::qWait(100);
+
+    // 40 columns on the first screen, 60 on the second one, nothing on the third one
+    const QVector<int> expected{40 * 50, 60 * 50, 0};
+    QCOMPARE(repaintedPixels(renderedSpy), expected);
+
+    shellSurface.reset();
+    QVERIFY(Test::waitForWindowDestroyed(client));
+}
+
+WAYLANDTEST_MAIN(OutputDamageTest)
+#include "output_damage_test.moc"
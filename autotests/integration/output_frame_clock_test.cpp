@@ -0,0 +1,174 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "composite.h"
+#include "effectloader.h"
+#include "effect_builtins.h"
+#include "platform.h"
+#include "scene.h"
+#include "screens.h"
+#include "wayland_server.h"
+
+#include <KConfigGroup>
+
+#include <QTimer>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_output_frame_clock-0");
+
+class OutputFrameClockTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testMixedRefreshRates_data();
+    void testMixedRefreshRates();
+    void testOnlyDamagedScreenIsPainted_data();
+    void testOnlyDamagedScreenIsPainted();
+
+private:
+    void setSyncsToVBlank(bool enabled);
+};
+
+void OutputFrameClockTest::initTestCase()
+{
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    const QVector<QRect> geometries {
+        QRect(0, 0, 1280, 1024),
+        QRect(1280, 0, 1280, 1024),
+    };
+    const QVector<int> scales {1, 1};
+    const QVector<int> refreshRates {60000, 144000};
+    QMetaObject::invokeMethod(kwinApp()->platform(), "setVirtualOutputs", Qt::DirectConnection,
+                              Q_ARG(int, 2),
+                              Q_ARG(QVector<QRect>, geometries),
+                              Q_ARG(QVector<int>, scales),
+                              Q_ARG(QVector<int>, refreshRates));
+
+    // disable all effects, they must not add repaints on their own
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+    qputenv("KWIN_WAYLAND_VIRTUAL_PER_SCREEN_PRESENTATION", QByteArrayLiteral("1"));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QCOMPARE(screens()->count(), 2);
+    QVERIFY(Compositor::self());
+    QVERIFY(Compositor::self()->scene());
+    QVERIFY(Compositor::self()->scene()->perScreenPresentation());
+}
+
+void OutputFrameClockTest::setSyncsToVBlank(bool enabled)
+{
+    QMetaObject::invokeMethod(kwinApp()->platform(), "setSyncsToVBlank", Qt::DirectConnection,
+                              Q_ARG(bool, enabled));
+    QCOMPARE(Compositor::self()->scene()->syncsToVBlank(), enabled);
+}
+
+void OutputFrameClockTest::testMixedRefreshRates_data()
+{
+    QTest::addColumn<bool>("syncsToVBlank");
+
+    QTest::newRow("no vsync") << false;
+    QTest::newRow("vsync") << true;
+}
+
+void OutputFrameClockTest::testMixedRefreshRates()
+{
+    // this test verifies that a 60 Hz screen doesn't throttle a 144 Hz screen next to it
+    QFETCH(bool, syncsToVBlank);
+    setSyncsToVBlank(syncsToVBlank);
+
+    QSignalSpy swapSpy(Compositor::self(), &Compositor::screenBufferSwapCompleted);
+    QVERIFY(swapSpy.isValid());
+
+    // keep both screens damaged all the time
+    QTimer damageTimer;
+    connect(&damageTimer, &QTimer::timeout, Compositor::self(), &Compositor::addRepaintFull);
+    damageTimer.start(1);
+    QTest::qWait(2000);
+    damageTimer.stop();
+
+    int frames[2] = {0, 0};
+    for (const QList<QVariant> &arguments : qAsConst(swapSpy)) {
+        const int screenId = arguments.first().toInt();
+        QVERIFY(screenId == 0 || screenId == 1);
+        frames[screenId]++;
+    }
+
+    // No screen can be presented more often than it refreshes, some slack is given for
+    // the test machine being busy.
+    QVERIFY2(frames[0] <= 2 * 60 + 2, QByteArray::number(frames[0]).constData());
+    QVERIFY2(frames[0] >= 2 * 60 * 3 / 4, QByteArray::number(frames[0]).constData());
+    QVERIFY2(frames[1] <= 2 * 144 + 2, QByteArray::number(frames[1]).constData());
+    QVERIFY2(frames[1] >= 2 * 144 * 3 / 4, QByteArray::number(frames[1]).constData());
+    QVERIFY(frames[1] > 2 * frames[0]);
+
+    // let the last page flips complete
+    QTest::qWait(100);
+}
+
+void OutputFrameClockTest::testOnlyDamagedScreenIsPainted_data()
+{
+    QTest::addColumn<bool>("syncsToVBlank");
+
+    QTest::newRow("no vsync") << false;
+    QTest::newRow("vsync") << true;
+}
+
+void OutputFrameClockTest::testOnlyDamagedScreenIsPainted()
+{
+    // this test verifies that damage on one screen doesn't cause a new frame on the other one
+    QFETCH(bool, syncsToVBlank);
+    setSyncsToVBlank(syncsToVBlank);
+
+    QSignalSpy swapSpy(Compositor::self(), &Compositor::screenBufferSwapCompleted);
+    QVERIFY(swapSpy.isValid());
+
+    Compositor::self()->addRepaint(QRect(1400, 100, 50, 50));
+    QVERIFY(swapSpy.wait());
+    QCOMPARE(swapSpy.count(), 1);
+    QCOMPARE(swapSpy.first().first().toInt(), 1);
+
+    Compositor::self()->addRepaint(QRect(100, 100, 50, 50));
+    QVERIFY(swapSpy.wait());
+    QCOMPARE(swapSpy.count(), 2);
+    QCOMPARE(swapSpy.last().first().toInt(), 0);
+
+    // nothing left to paint
+    QVERIFY(!swapSpy.wait(100));
+}
+
+WAYLANDTEST_MAIN(OutputFrameClockTest)
+#include "output_frame_clock_test.moc"
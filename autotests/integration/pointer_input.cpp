@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "cursor.h"
 #include "deleted.h"
 #include "effects.h"
+#include "input.h"
 #include "pointer_input.h"
 #include "options.h"
 #include "screenedge.h"
@@ -130,6 +131,8 @@ private Q_SLOTS:
     void testResizeCursor();
     void testMoveCursor();
     void testHideShowCursor();
+    void testFindToplevelManyWindows();
+    void benchmarkMotionManyWindows();
 
 private:
     void render(KWayland::Client::Surface *surface, const QSize &size = QSize(100, 50));
@@ -1626,6 +1629,92 @@ void PointerInputTest::testHideShowCursor()
     QCOMPARE(kwinApp()->platform()->isCursorHidden(), false);
 }
 
+void PointerInputTest::testFindToplevelManyWindows()
+{
+    // this test verifies that the window under the pointer is found with many windows
+    // and that the lookup follows window movement and the stacking order
+    using namespace KWayland::Client;
+    const int columns = 16;
+    const int rows = 12;
+    QVector<Surface *> surfaces;
+    QVector<XdgShellSurface *> shellSurfaces;
+    QVector<AbstractClient *> windows;
+    for (int i = 0; i < columns * rows; ++i) {
+        Surface *surface = Test::createSurface(m_compositor);
+        QVERIFY(surface);
+        XdgShellSurface *shellSurface = Test::createXdgShellStableSurface(surface, surface);
+        QVERIFY(shellSurface);
+        AbstractClient *window = Test::renderAndWaitForShown(surface, QSize(80, 80), Qt::blue);
+        QVERIFY(window);
+        window->move(QPoint((i % columns) * 80, (i / columns) * 80));
+        surfaces << surface;
+        shellSurfaces << shellSurface;
+        windows << window;
+    }
+
+    for (AbstractClient *window : windows) {
+        QCOMPARE(input()->findToplevel(window->frameGeometry().center()), window);
+    }
+    QVERIFY(!input()->findToplevel(QPoint(1500, 500)));
+
+    // moving a window is picked up without a stacking order change
+    AbstractClient *first = windows.first();
+    AbstractClient *last = windows.last();
+    first->move(QPoint(1460, 460));
+    QCOMPARE(input()->findToplevel(QPoint(1500, 500)), first);
+    QVERIFY(!input()->findToplevel(QPoint(40, 40)));
+
+    // an overlapped window is found after being raised
+    first->move(last->pos());
+    QCOMPARE(input()->findToplevel(last->frameGeometry().center()), first);
+    workspace()->raiseClient(last);
+    QCOMPARE(input()->findToplevel(last->frameGeometry().center()), last);
+
+    qDeleteAll(shellSurfaces);
+    for (AbstractClient *window : windows) {
+        delete surfaces.takeFirst();
+        QVERIFY(Test::waitForWindowDestroyed(window));
+    }
+}
+
+void PointerInputTest::benchmarkMotionManyWindows()
+{
+    // this benchmark moves the pointer over hundreds of windows through the platform, so that
+    // every event takes the whole path of PointerInputRedirection::processMotion
+    using namespace KWayland::Client;
+    const int columns = 20;
+    const int rows = 15;
+    QVector<Surface *> surfaces;
+    QVector<XdgShellSurface *> shellSurfaces;
+    QVector<AbstractClient *> windows;
+    for (int i = 0; i < columns * rows; ++i) {
+        Surface *surface = Test::createSurface(m_compositor);
+        QVERIFY(surface);
+        XdgShellSurface *shellSurface = Test::createXdgShellStableSurface(surface, surface);
+        QVERIFY(shellSurface);
+        AbstractClient *window = Test::renderAndWaitForShown(surface, QSize(64, 64), Qt::blue);
+        QVERIFY(window);
+        window->move(QPoint((i % columns) * 64, (i / columns) * 64));
+        surfaces << surface;
+        shellSurfaces << shellSurface;
+        windows << window;
+    }
+
+    quint32 timestamp = 1;
+    QBENCHMARK {
+        for (int i = 0; i < columns * rows; ++i) {
+            kwinApp()->platform()->pointerMotion(QPointF((i % columns) * 64 + 32, (i / columns) * 64 + 32), timestamp++);
+        }
+    }
+    QCOMPARE(input()->pointer()->focus().data(), static_cast<Toplevel *>(windows.last()));
+
+    qDeleteAll(shellSurfaces);
+    for (AbstractClient *window : windows) {
+        delete surfaces.takeFirst();
+        QVERIFY(Test::waitForWindowDestroyed(window));
+    }
+}
+
 }
 
 WAYLANDTEST_MAIN(KWin::PointerInputTest)
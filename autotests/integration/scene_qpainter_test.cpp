@@ -52,6 +52,7 @@ private Q_SLOTS:
     void cleanup();
     void testStartFrame();
     void testCursorMoving();
+    void testPointerMotionFrames();
     void testWindow_data();
     void testWindow();
     void testWindowScaled();
@@ -152,6 +153,29 @@ void SceneQPainterTest::testCursorMoving()
     QCOMPARE(referenceImage, *scene->qpainterRenderBuffer());
 }
 
+void SceneQPainterTest::testPointerMotionFrames()
+{
+    // this test verifies that frames painting the software cursor after pointer motion are counted
+    auto scene = Compositor::self()->scene();
+    QVERIFY(scene);
+    QVERIFY(kwinApp()->platform()->usesSoftwareCursor());
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    const quint64 pointerMotionFrames = Compositor::self()->pointerMotionFrames();
+
+    KWin::Cursors::self()->mouse()->setPos(100, 100);
+    QVERIFY(frameRenderedSpy.wait());
+    QCOMPARE(Compositor::self()->pointerMotionFrames(), pointerMotionFrames + 1);
+    KWin::Cursors::self()->mouse()->setPos(110, 100);
+    QVERIFY(frameRenderedSpy.wait());
+    QCOMPARE(Compositor::self()->pointerMotionFrames(), pointerMotionFrames + 2);
+
+    // a repaint which is not caused by the pointer is not counted
+    Compositor::self()->addRepaintFull();
+    QVERIFY(frameRenderedSpy.wait());
+    QCOMPARE(Compositor::self()->pointerMotionFrames(), pointerMotionFrames + 2);
+}
+
 void SceneQPainterTest::testWindow_data()
 {
     QTest::addColumn<Test::XdgShellSurfaceType>("type");
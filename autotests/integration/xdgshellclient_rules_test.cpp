@@ -220,6 +220,7 @@ private Q_SLOTS:
     void testInactiveOpacityForceTemporarily();
 
     void testMatchAfterNameChange();
+    void testMatchTitleRegExp();
 };
 
 void TestXdgShellClientRules::initTestCase()
@@ -4538,5 +4539,37 @@ void TestXdgShellClientRules::testMatchAfterNameChange()
     QCOMPARE(c->keepAbove(), true);
 }
 
+void TestXdgShellClientRules::testMatchTitleRegExp()
+{
+    KSharedConfig::Ptr config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    config->group("General").writeEntry("count", 1);
+
+    KConfigGroup group = config->group("1");
+    group.writeEntry("above", true);
+    group.writeEntry("aboverule", int(Rules::Force));
+    group.writeEntry("title", "^Build \\d+ finished$");
+    group.writeEntry("titlematch", int(Rules::RegExpMatch));
+    group.sync();
+
+    RuleBook::self()->setConfig(config);
+    workspace()->slotReconfigure();
+
+    QScopedPointer<Surface> surface(Test::createSurface());
+    QScopedPointer<XdgShellSurface> shellSurface(Test::createXdgShellStableSurface(surface.data()));
+    shellSurface->setTitle(QStringLiteral("Build 42 running"));
+
+    auto c = Test::renderAndWaitForShown(surface.data(), QSize(100, 50), Qt::blue);
+    QVERIFY(c);
+    QVERIFY(c->isActive());
+    QCOMPARE(c->keepAbove(), false);
+
+    // the title change re-evaluates the rules through a queued connection
+    QSignalSpy captionChangedSpy(c, &AbstractClient::captionChanged);
+    QVERIFY(captionChangedSpy.isValid());
+    shellSurface->setTitle(QStringLiteral("Build 42 finished"));
+    QVERIFY(captionChangedSpy.wait());
+    QTRY_COMPARE(c->keepAbove(), true);
+}
+
 WAYLANDTEST_MAIN(TestXdgShellClientRules)
 #include "xdgshellclient_rules_test.moc"
@@ -0,0 +1,237 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "mock_libinput.h"
+#include "mock_udev.h"
+#include "../../libinput/connection.h"
+#include "../../libinput/device.h"
+#include "../../libinput/event_queue.h"
+#include "../../libinput/events.h"
+
+#include <QEventLoop>
+#include <QThread>
+#include <QTimer>
+#include <QtTest>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+Q_LOGGING_CATEGORY(KWIN_CORE, "kwin_core", QtCriticalMsg)
+
+using namespace KWin::LibInput;
+
+// one second of motion events of a 8 kHz device
+static const int s_motionEventCount = 8000;
+
+class EventQueueBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void testFifo();
+    void testFull();
+    void benchmarkMotionStream_data();
+    void benchmarkMotionStream();
+
+private:
+    libinput_device *m_nativeDevice = nullptr;
+    Device *m_device = nullptr;
+    QScopedPointer<QObject> m_connectionParent;
+    Connection *m_connection = nullptr;
+    int m_pipe[2];
+};
+
+void EventQueueBenchmark::initTestCase()
+{
+    udev::s_mockUdev = new udev;
+    // stands in for the fd of libinput, it is readable while events are pending
+    QCOMPARE(pipe2(m_pipe, O_CLOEXEC | O_NONBLOCK), 0);
+    libinput::s_fd = m_pipe[0];
+
+    m_connectionParent.reset(new QObject);
+    m_connection = Connection::create(m_connectionParent.data());
+    QVERIFY(m_connection);
+    // like InputRedirection the events are processed on this thread
+    connect(m_connection, &Connection::eventsRead, this,
+        [this] {
+            m_connection->processEvents();
+        }, Qt::QueuedConnection
+    );
+    m_connection->setup();
+}
+
+void EventQueueBenchmark::cleanupTestCase()
+{
+    // destroying the parent quits the libinput thread, which deletes the connection
+    QThread *thread = m_connection->thread();
+    m_connectionParent.reset();
+    QVERIFY(thread->wait());
+    m_connection = nullptr;
+
+    libinput::s_fd = -1;
+    close(m_pipe[0]);
+    close(m_pipe[1]);
+    delete udev::s_mockUdev;
+    udev::s_mockUdev = nullptr;
+}
+
+void EventQueueBenchmark::init()
+{
+    m_nativeDevice = new libinput_device;
+    m_nativeDevice->pointer = true;
+    m_device = new Device(m_nativeDevice);
+}
+
+void EventQueueBenchmark::cleanup()
+{
+    delete m_device;
+    m_device = nullptr;
+
+    delete m_nativeDevice;
+    m_nativeDevice = nullptr;
+}
+
+static libinput_event_pointer *createNativeMotionEvent(libinput_device *device, int index)
+{
+    libinput_event_pointer *nativeEvent = new libinput_event_pointer;
+    nativeEvent->device = device;
+    nativeEvent->type = LIBINPUT_EVENT_POINTER_MOTION;
+    nativeEvent->time = index / 8;
+    nativeEvent->delta = QSizeF(1, -0.5);
+    return nativeEvent;
+}
+
+static Event *createMotionEvent(libinput_device *device, int index)
+{
+    return Event::create(createNativeMotionEvent(device, index));
+}
+
+void EventQueueBenchmark::testFifo()
+{
+    EventQueue queue(4);
+    QVERIFY(queue.isEmpty());
+    QVERIFY(!queue.peek());
+    QVERIFY(!queue.pop());
+
+    Event *first = createMotionEvent(m_nativeDevice, 0);
+    Event *second = createMotionEvent(m_nativeDevice, 1);
+    QVERIFY(queue.push(first));
+    QVERIFY(queue.push(second));
+    QVERIFY(!queue.isEmpty());
+    QCOMPARE(queue.peek(), first);
+    QCOMPARE(queue.pop(), first);
+    QCOMPARE(queue.peek(), second);
+    QCOMPARE(queue.pop(), second);
+    QVERIFY(queue.isEmpty());
+
+    delete first;
+    delete second;
+}
+
+void EventQueueBenchmark::testFull()
+{
+    EventQueue queue(4);
+    QCOMPARE(queue.capacity(), 4u);
+
+    QVector<Event*> events;
+    for (int i = 0; i < 5; ++i) {
+        events << createMotionEvent(m_nativeDevice, i);
+    }
+    for (int i = 0; i < 4; ++i) {
+        QVERIFY(queue.push(events.at(i)));
+    }
+    QVERIFY(!queue.push(events.at(4)));
+
+    // wrapping around after taking an event
+    QCOMPARE(queue.pop(), events.at(0));
+    QVERIFY(queue.push(events.at(4)));
+    for (int i = 1; i < 5; ++i) {
+        QCOMPARE(queue.pop(), events.at(i));
+    }
+    QVERIFY(queue.isEmpty());
+
+    qDeleteAll(events);
+}
+
+void EventQueueBenchmark::benchmarkMotionStream_data()
+{
+    QTest::addColumn<int>("consumerDelay");
+
+    QTest::newRow("idle main thread") << 0;
+    // the main thread is busy with every motion for some time, so even more
+    // of the queued motion events get merged
+    QTest::newRow("busy main thread") << 100;
+}
+
+void EventQueueBenchmark::benchmarkMotionStream()
+{
+    // Replays the motion stream through the libinput thread of the connection and
+    // processes it on this thread. The stream does not fit into the event queue, so the
+    // connection has to stall reading and get resumed by processEvents.
+    QFETCH(int, consumerDelay);
+
+    const QSizeF expectedDelta(s_motionEventCount, -0.5 * s_motionEventCount);
+    QSizeF delta;
+    int motionEvents = 0;
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+    connect(m_connection, &Connection::pointerMotion, &loop,
+        [&] (const QSizeF &motionDelta) {
+            delta += motionDelta;
+            motionEvents++;
+            if (consumerDelay) {
+                QThread::usleep(consumerDelay);
+            }
+            if (delta == expectedDelta) {
+                loop.quit();
+            }
+        }
+    );
+
+    QBENCHMARK {
+        delta = QSizeF();
+        motionEvents = 0;
+        {
+            QMutexLocker locker(&libinput::s_eventsMutex);
+            for (int i = 0; i < s_motionEventCount; ++i) {
+                libinput::s_events.enqueue(createNativeMotionEvent(m_nativeDevice, i));
+            }
+        }
+        QCOMPARE(write(m_pipe[1], "x", 1), ssize_t(1));
+        timeout.start(10000);
+        loop.exec();
+        timeout.stop();
+
+        // no motion got lost while merging
+        QCOMPARE(delta, expectedDelta);
+        QVERIFY(motionEvents > 0 && motionEvents < s_motionEventCount);
+        // reading got resumed until libinput had no events left
+        QMutexLocker locker(&libinput::s_eventsMutex);
+        QVERIFY(libinput::s_events.isEmpty());
+    }
+}
+
+QTEST_GUILESS_MAIN(EventQueueBenchmark)
+#include "event_queue_benchmark.moc"
@@ -22,6 +22,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <config-kwin.h>
 
 #include <linux/input.h>
+#include <unistd.h>
+
+QMutex libinput::s_eventsMutex;
+QQueue<libinput_event *> libinput::s_events;
+int libinput::s_fd = -1;
 
 int libinput_device_keyboard_has_key(struct libinput_device *device, uint32_t code)
 {
@@ -695,19 +700,28 @@ int libinput_udev_assign_seat(struct libinput *libinput, const char *seat_id)
 int libinput_get_fd(struct libinput *libinput)
 {
     Q_UNUSED(libinput)
-    return -1;
+    return libinput::s_fd;
 }
 
 int libinput_dispatch(struct libinput *libinput)
 {
     Q_UNUSED(libinput)
+    if (libinput::s_fd != -1) {
+        char buffer[64];
+        while (read(libinput::s_fd, buffer, sizeof(buffer)) > 0) {
+        }
+    }
     return 0;
 }
 
 struct libinput_event *libinput_get_event(struct libinput *libinput)
 {
     Q_UNUSED(libinput)
-    return nullptr;
+    QMutexLocker locker(&libinput::s_eventsMutex);
+    if (libinput::s_events.isEmpty()) {
+        return nullptr;
+    }
+    return libinput::s_events.dequeue();
 }
 
 void libinput_suspend(struct libinput *libinput)
@@ -22,7 +22,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <libinput.h>
 
 #include <QByteArray>
+#include <QMutex>
 #include <QPointF>
+#include <QQueue>
 #include <QSizeF>
 #include <QVector>
 
@@ -164,6 +166,11 @@ struct libinput {
     int refCount = 1;
     QByteArray seat;
     int assignSeatRetVal = 0;
+    // events handed out by libinput_get_event, may be filled from any thread
+    static QMutex s_eventsMutex;
+    static QQueue<libinput_event *> s_events;
+    // returned by libinput_get_fd, libinput_dispatch reads it empty
+    static int s_fd;
 };
 
 #endif
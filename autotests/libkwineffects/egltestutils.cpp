@@ -0,0 +1,88 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "egltestutils.h"
+#include "kwinglplatform.h"
+#include "kwinglutils.h"
+
+#include <epoxy/gl.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+namespace KWin
+{
+
+SurfacelessEglContext::~SurfacelessEglContext()
+{
+    destroy();
+}
+
+QByteArray SurfacelessEglContext::create()
+{
+    qputenv("LIBGL_ALWAYS_SOFTWARE", QByteArrayLiteral("1"));
+
+    if (!epoxy_has_egl_extension(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless")) {
+        return QByteArrayLiteral("EGL_MESA_platform_surfaceless is not supported");
+    }
+    m_display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (m_display == EGL_NO_DISPLAY || !eglInitialize(m_display, nullptr, nullptr)) {
+        m_display = EGL_NO_DISPLAY;
+        return QByteArrayLiteral("Could not initialize a surfaceless EGL display");
+    }
+    if (!epoxy_has_egl_extension(m_display, "EGL_KHR_surfaceless_context") ||
+            !epoxy_has_egl_extension(m_display, "EGL_KHR_no_config_context")) {
+        return QByteArrayLiteral("Surfaceless EGL contexts are not supported");
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        return QByteArrayLiteral("Desktop OpenGL is not available");
+    }
+    m_context = eglCreateContext(m_display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, nullptr);
+    if (m_context == EGL_NO_CONTEXT) {
+        return QByteArrayLiteral("Could not create a surfaceless EGL context");
+    }
+    if (!eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context)) {
+        eglDestroyContext(m_display, m_context);
+        m_context = EGL_NO_CONTEXT;
+        return QByteArrayLiteral("Could not make a surfaceless EGL context current");
+    }
+
+    GLPlatform::instance()->detect(EglPlatformInterface);
+    initGL([](const char *name) {
+        return eglGetProcAddress(name);
+    });
+    return QByteArray();
+}
+
+void SurfacelessEglContext::destroy()
+{
+    if (m_context != EGL_NO_CONTEXT) {
+        cleanupGL();
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(m_display, m_context);
+        m_context = EGL_NO_CONTEXT;
+    }
+    if (m_display != EGL_NO_DISPLAY) {
+        eglTerminate(m_display);
+        m_display = EGL_NO_DISPLAY;
+    }
+}
+
+}
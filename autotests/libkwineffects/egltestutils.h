@@ -0,0 +1,62 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_EGLTESTUTILS_H
+#define KWIN_EGLTESTUTILS_H
+
+#include <QByteArray>
+
+#include <epoxy/egl.h>
+
+namespace KWin
+{
+
+/**
+ * A surfaceless EGL context on llvmpipe for the tests of kwinglutils, so that the
+ * results do not depend on the GPU of the machine.
+ */
+class SurfacelessEglContext
+{
+public:
+    SurfacelessEglContext() = default;
+    ~SurfacelessEglContext();
+
+    /**
+     * Creates the context, makes it current and initializes kwinglutils for it.
+     * @returns an empty string on success, otherwise the reason to skip the test
+     */
+    QByteArray create();
+    /**
+     * Releases the context again, does nothing if none got created.
+     */
+    void destroy();
+
+    bool isValid() const {
+        return m_context != EGL_NO_CONTEXT;
+    }
+
+private:
+    EGLDisplay m_display = EGL_NO_DISPLAY;
+    EGLContext m_context = EGL_NO_CONTEXT;
+    Q_DISABLE_COPY(SurfacelessEglContext)
+};
+
+}
+
+#endif
@@ -0,0 +1,120 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "egltestutils.h"
+#include "kwinglplatform.h"
+#include "kwinglutils.h"
+
+#include <QtTest>
+
+#include <epoxy/gl.h>
+
+using namespace KWin;
+
+class GLAsyncReadbackTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testReadback();
+    void testSubRect();
+
+private:
+    SurfacelessEglContext m_egl;
+};
+
+void GLAsyncReadbackTest::initTestCase()
+{
+    const QByteArray error = m_egl.create();
+    if (!error.isEmpty()) {
+        QSKIP(error.constData());
+    }
+    if (!GLAsyncReadback::supported() || !GLRenderTarget::supported()) {
+        QSKIP("Pixel buffer objects and fences are not supported");
+    }
+}
+
+void GLAsyncReadbackTest::cleanupTestCase()
+{
+    if (!m_egl.isValid()) {
+        return;
+    }
+    m_egl.destroy();
+}
+
+static void fillRect(const QRect &rect, const QColor &color)
+{
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(rect.x(), rect.y(), rect.width(), rect.height());
+    glClearColor(color.redF(), color.greenF(), color.blueF(), color.alphaF());
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+void GLAsyncReadbackTest::testReadback()
+{
+    GLTexture texture(GL_RGBA8, 4, 2);
+    GLRenderTarget target(texture);
+    QVERIFY(target.valid());
+    GLRenderTarget::pushRenderTarget(&target);
+    // the bottom row is red, the top row is blue
+    fillRect(QRect(0, 0, 4, 1), Qt::red);
+    fillRect(QRect(0, 1, 4, 1), Qt::blue);
+
+    GLAsyncReadback readback(QRect(0, 0, 4, 2));
+    GLRenderTarget::popRenderTarget();
+
+    QTRY_VERIFY(readback.isReady());
+    const QImage image = readback.image();
+    QCOMPARE(image.size(), QSize(4, 2));
+    QCOMPARE(image.format(), QImage::Format_RGBA8888);
+    // the rows are in the order OpenGL returns them
+    QCOMPARE(image.pixelColor(0, 0), QColor(Qt::red));
+    QCOMPARE(image.pixelColor(3, 0), QColor(Qt::red));
+    QCOMPARE(image.pixelColor(0, 1), QColor(Qt::blue));
+    QCOMPARE(image.pixelColor(3, 1), QColor(Qt::blue));
+}
+
+void GLAsyncReadbackTest::testSubRect()
+{
+    GLTexture texture(GL_RGBA8, 8, 8);
+    GLRenderTarget target(texture);
+    QVERIFY(target.valid());
+    GLRenderTarget::pushRenderTarget(&target);
+    fillRect(QRect(0, 0, 8, 8), Qt::black);
+    fillRect(QRect(2, 3, 3, 2), Qt::green);
+
+    GLAsyncReadback readback(QRect(2, 3, 3, 2));
+    // the readback must not be affected by rendering after it was issued
+    fillRect(QRect(0, 0, 8, 8), Qt::white);
+    GLRenderTarget::popRenderTarget();
+
+    const QImage image = readback.image();
+    QCOMPARE(image.size(), QSize(3, 2));
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            QCOMPARE(image.pixelColor(x, y), QColor(Qt::green));
+        }
+    }
+    QVERIFY(readback.isReady());
+}
+
+QTEST_GUILESS_MAIN(GLAsyncReadbackTest)
+#include "glasyncreadbacktest.moc"
@@ -0,0 +1,133 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "egltestutils.h"
+#include "kwinglplatform.h"
+#include "kwinglutils.h"
+
+#include <QImage>
+#include <QRegion>
+#include <QtTest>
+
+#include <epoxy/gl.h>
+
+#include <cstring>
+
+using namespace KWin;
+
+Q_DECLARE_METATYPE(KWin::GLPixelUnpackBuffer::Mode)
+
+class GLPixelUnpackBufferTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testUpload_data();
+    void testUpload();
+
+private:
+    SurfacelessEglContext m_egl;
+};
+
+static const QSize s_size(16, 12);
+
+void GLPixelUnpackBufferTest::initTestCase()
+{
+    const QByteArray error = m_egl.create();
+    if (!error.isEmpty()) {
+        QSKIP(error.constData());
+    }
+}
+
+void GLPixelUnpackBufferTest::cleanupTestCase()
+{
+    m_egl.destroy();
+}
+
+void GLPixelUnpackBufferTest::testUpload_data()
+{
+    QTest::addColumn<GLPixelUnpackBuffer::Mode>("mode");
+    QTest::addColumn<int>("padding");
+
+    const struct {
+        const char *name;
+        GLPixelUnpackBuffer::Mode mode;
+    } modes[] = {
+        {"copy", GLPixelUnpackBuffer::Mode::Copy},
+        {"unpack", GLPixelUnpackBuffer::Mode::Unpack},
+        {"stream", GLPixelUnpackBuffer::Mode::Stream},
+    };
+    for (const auto &mode : modes) {
+        const QByteArray name(mode.name);
+        QTest::newRow(name + "/packed rows") << mode.mode << 0;
+        QTest::newRow(name + "/padded rows") << mode.mode << 8;
+        // the stride of a shm buffer doesn't have to be a multiple of the pixel size
+        QTest::newRow(name + "/unaligned stride") << mode.mode << 2;
+    }
+}
+
+void GLPixelUnpackBufferTest::testUpload()
+{
+    QFETCH(GLPixelUnpackBuffer::Mode, mode);
+    QFETCH(int, padding);
+
+    GLPixelUnpackBuffer buffer;
+    buffer.setMode(mode);
+    if (buffer.mode() != mode) {
+        QSKIP("Upload mode is not supported by the GL implementation");
+    }
+
+    // every pixel of the source is different
+    const int bytesPerLine = s_size.width() * 4 + padding;
+    QByteArray data(bytesPerLine * s_size.height(), 0);
+    QImage image(reinterpret_cast<uchar *>(data.data()), s_size.width(), s_size.height(),
+                 bytesPerLine, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < s_size.height(); ++y) {
+        for (int x = 0; x < s_size.width(); ++x) {
+            const QRgb pixel = qRgba(x * 16, y * 16, 128, 255);
+            std::memcpy(image.scanLine(y) + x * 4, &pixel, sizeof(pixel));
+        }
+    }
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    const QByteArray black(s_size.width() * s_size.height() * 4, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, s_size.width(), s_size.height(), 0,
+                 GL_BGRA, GL_UNSIGNED_BYTE, black.constData());
+
+    // only the damaged rects are uploaded, one of them reaches out of the image
+    const QRegion damage = QRegion(3, 2, 5, 4) + QRegion(12, 9, 8, 8);
+    buffer.upload(GL_TEXTURE_2D, image, damage, GL_BGRA, GL_UNSIGNED_BYTE);
+
+    QImage result(s_size, QImage::Format_ARGB32_Premultiplied);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_BGRA, GL_UNSIGNED_BYTE, result.bits());
+    glDeleteTextures(1, &texture);
+
+    for (int y = 0; y < s_size.height(); ++y) {
+        for (int x = 0; x < s_size.width(); ++x) {
+            const QRgb expected = damage.contains(QPoint(x, y)) ? qRgba(x * 16, y * 16, 128, 255) : 0;
+            QCOMPARE(result.pixel(x, y), expected);
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(GLPixelUnpackBufferTest)
+#include "glpixelunpackbuffertest.moc"
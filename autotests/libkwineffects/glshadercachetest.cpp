@@ -0,0 +1,244 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "egltestutils.h"
+#include "kwinglplatform.h"
+#include "kwinglshadercache_p.h"
+#include "kwinglutils.h"
+
+#include <QDir>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <epoxy/gl.h>
+
+using namespace KWin;
+
+static const QByteArray s_vertexSource = QByteArrayLiteral(
+    "#version 140\n"
+    "in vec4 position;\n"
+    "void main() { gl_Position = position; }\n");
+
+static const QByteArray s_fragmentSource = QByteArrayLiteral(
+    "#version 140\n"
+    "uniform vec4 color;\n"
+    "out vec4 fragColor;\n"
+    "void main() { fragColor = color; }\n");
+
+class GLShaderCacheTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testKey();
+    void testStoreAndLoad();
+    void testCorruptBinary();
+    void testTraits();
+    void testDeferredWrite();
+    void testStaleDriver();
+
+private:
+    GLuint compileProgram(GLShaderCache *cache) const;
+
+    SurfacelessEglContext m_egl;
+};
+
+void GLShaderCacheTest::initTestCase()
+{
+    // Mesa needs its own cache to hand out program binaries
+    qunsetenv("MESA_GLSL_CACHE_DISABLE");
+
+    const QByteArray error = m_egl.create();
+    if (!error.isEmpty()) {
+        QSKIP(error.constData());
+    }
+    if (!GLShaderCache::supported() || !hasGLVersion(3, 1)) {
+        QSKIP("Program binaries are not supported");
+    }
+}
+
+void GLShaderCacheTest::cleanupTestCase()
+{
+    if (!m_egl.isValid()) {
+        return;
+    }
+    m_egl.destroy();
+}
+
+GLuint GLShaderCacheTest::compileProgram(GLShaderCache *cache) const
+{
+    const GLuint program = glCreateProgram();
+    const QByteArray sources[] = {s_vertexSource, s_fragmentSource};
+    const GLenum types[] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+    for (int i = 0; i < 2; ++i) {
+        const GLuint shader = glCreateShader(types[i]);
+        const char *source = sources[i].constData();
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+        glAttachShader(program, shader);
+        glDeleteShader(shader);
+    }
+    glBindAttribLocation(program, 0, "position");
+    cache->prepareLink(program);
+    glLinkProgram(program);
+    return program;
+}
+
+void GLShaderCacheTest::testKey()
+{
+    QTemporaryDir dir;
+    GLShaderCache cache(dir.path());
+    const QByteArray key = cache.key(s_vertexSource, s_fragmentSource, QByteArrayLiteral("position"));
+    QCOMPARE(key, cache.key(s_vertexSource, s_fragmentSource, QByteArrayLiteral("position")));
+    QVERIFY(key != cache.key(s_vertexSource, s_fragmentSource + ' ', QByteArrayLiteral("position")));
+    QVERIFY(key != cache.key(s_vertexSource, s_fragmentSource, QByteArrayLiteral("vertex")));
+    // the separator keeps moving bytes between the sources from colliding
+    QVERIFY(cache.key("ab", "c", QByteArray()) != cache.key("a", "bc", QByteArray()));
+}
+
+void GLShaderCacheTest::testStoreAndLoad()
+{
+    QTemporaryDir dir;
+    QByteArray key;
+    {
+        GLShaderCache cache(dir.path());
+        cache.warm();
+        key = cache.key(s_vertexSource, s_fragmentSource, QByteArrayLiteral("position"));
+
+        const GLuint program = glCreateProgram();
+        QVERIFY(!cache.load(program, key));
+        glDeleteProgram(program);
+
+        const GLuint linked = compileProgram(&cache);
+        GLint status = 0;
+        glGetProgramiv(linked, GL_LINK_STATUS, &status);
+        QVERIFY(status);
+        cache.store(linked, key);
+        glDeleteProgram(linked);
+    }
+
+    // a new cache picks the binary up from disk without compiling
+    GLShaderCache cache(dir.path());
+    cache.warm();
+    const GLuint program = glCreateProgram();
+    QVERIFY(cache.load(program, key));
+    QVERIFY(glGetUniformLocation(program, "color") != -1);
+    QCOMPARE(glGetAttribLocation(program, "position"), 0);
+    glDeleteProgram(program);
+}
+
+void GLShaderCacheTest::testCorruptBinary()
+{
+    QTemporaryDir dir;
+    QByteArray key;
+    {
+        GLShaderCache cache(dir.path());
+        key = cache.key(s_vertexSource, s_fragmentSource, QByteArrayLiteral("position"));
+        const GLuint linked = compileProgram(&cache);
+        cache.store(linked, key);
+        glDeleteProgram(linked);
+    }
+
+    // garble the binary the way a driver update without a version bump would
+    QDir cacheDir(dir.path());
+    const QStringList driverDirs = cacheDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    QCOMPARE(driverDirs.count(), 1);
+    QVERIFY(cacheDir.cd(driverDirs.first()));
+    const QString fileName = cacheDir.filePath(QString::fromLatin1(key) + QStringLiteral(".bin"));
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QByteArray data = file.readAll();
+    for (int i = 12; i < data.size(); ++i) {
+        data[i] = ~data[i];
+    }
+    file.seek(0);
+    file.write(data);
+    file.close();
+
+    GLShaderCache cache(dir.path());
+    cache.warm();
+    const GLuint program = glCreateProgram();
+    QVERIFY(!cache.load(program, key));
+    glDeleteProgram(program);
+    // rejected binaries get dropped
+    QVERIFY(!QFile::exists(fileName));
+}
+
+void GLShaderCacheTest::testTraits()
+{
+    QTemporaryDir dir;
+    {
+        GLShaderCache cache(dir.path());
+        cache.warm();
+        QVERIFY(cache.traits().isEmpty());
+        cache.addTraits(ShaderTrait::MapTexture);
+        cache.addTraits(ShaderTrait::MapTexture | ShaderTrait::Modulate);
+        cache.addTraits(ShaderTrait::MapTexture);
+        QCOMPARE(cache.traits().count(), 2);
+    }
+
+    GLShaderCache cache(dir.path());
+    cache.warm();
+    const QVector<ShaderTraits> traits = cache.traits();
+    QCOMPARE(traits.count(), 2);
+    QVERIFY(traits.contains(ShaderTrait::MapTexture));
+    QVERIFY(traits.contains(ShaderTrait::MapTexture | ShaderTrait::Modulate));
+}
+
+void GLShaderCacheTest::testDeferredWrite()
+{
+    // storing a binary doesn't touch the disk until the cache gets flushed
+    QTemporaryDir dir;
+    GLShaderCache cache(dir.path());
+    cache.warm();
+    const QByteArray key = cache.key(s_vertexSource, s_fragmentSource, QByteArrayLiteral("position"));
+    const GLuint linked = compileProgram(&cache);
+    cache.store(linked, key);
+    cache.addTraits(ShaderTrait::MapTexture);
+    glDeleteProgram(linked);
+    QVERIFY(QDir(dir.path()).entryList(QDir::Dirs | QDir::NoDotAndDotDot).isEmpty());
+
+    cache.flush();
+    QDir cacheDir(dir.path());
+    const QStringList driverDirs = cacheDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    QCOMPARE(driverDirs.count(), 1);
+    QVERIFY(cacheDir.cd(driverDirs.first()));
+    QVERIFY(cacheDir.exists(QString::fromLatin1(key) + QStringLiteral(".bin")));
+    QVERIFY(cacheDir.exists(QStringLiteral("traits")));
+}
+
+void GLShaderCacheTest::testStaleDriver()
+{
+    // the binaries of a previous driver get removed when the cache is warmed up
+    QTemporaryDir dir;
+    QDir cacheDir(dir.path());
+    QVERIFY(cacheDir.mkpath(QStringLiteral("0123456789abcdef")));
+    QFile stale(cacheDir.filePath(QStringLiteral("0123456789abcdef/stale.bin")));
+    QVERIFY(stale.open(QIODevice::WriteOnly));
+    stale.write(QByteArrayLiteral("stale"));
+    stale.close();
+
+    GLShaderCache cache(dir.path());
+    cache.warm();
+    QVERIFY(!cacheDir.exists(QStringLiteral("0123456789abcdef")));
+}
+
+QTEST_GUILESS_MAIN(GLShaderCacheTest)
+#include "glshadercachetest.moc"
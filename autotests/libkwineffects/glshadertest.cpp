@@ -0,0 +1,246 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwinglutils.h"
+
+#include <QMatrix4x4>
+#include <QVector2D>
+#include <QVector4D>
+#include <QtTest>
+
+#include <epoxy/gl.h>
+
+using namespace KWin;
+
+// Counts the GL calls done by GLShader by replacing libepoxy's dispatch pointers.
+struct GLCalls {
+    int getUniformLocation = 0;
+    int uniform = 0;
+    QByteArray lastName;
+};
+static GLCalls s_calls;
+
+static GLuint mock_glCreateProgram()
+{
+    return 1;
+}
+
+static void mock_glDeleteProgram(GLuint program)
+{
+    Q_UNUSED(program)
+}
+
+static GLint mock_glGetUniformLocation(GLuint program, const GLchar *name)
+{
+    Q_UNUSED(program)
+    s_calls.getUniformLocation++;
+    s_calls.lastName = name;
+    static const QByteArrayList uniforms = {
+        QByteArrayLiteral("modelViewProjectionMatrix"),
+        QByteArrayLiteral("modulation"),
+        QByteArrayLiteral("saturation"),
+        QByteArrayLiteral("offset"),
+        QByteArrayLiteral("geometryColor"),
+        QByteArrayLiteral("blurRadius"),
+    };
+    return uniforms.indexOf(QByteArray(name));
+}
+
+static void mock_glUniform1f(GLint location, GLfloat v0)
+{
+    Q_UNUSED(location)
+    Q_UNUSED(v0)
+    s_calls.uniform++;
+}
+
+static void mock_glUniform1i(GLint location, GLint v0)
+{
+    Q_UNUSED(location)
+    Q_UNUSED(v0)
+    s_calls.uniform++;
+}
+
+static void mock_glUniformfv(GLint location, GLsizei count, const GLfloat *value)
+{
+    Q_UNUSED(location)
+    Q_UNUSED(count)
+    Q_UNUSED(value)
+    s_calls.uniform++;
+}
+
+static void mock_glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value)
+{
+    Q_UNUSED(location)
+    Q_UNUSED(count)
+    Q_UNUSED(transpose)
+    Q_UNUSED(value)
+    s_calls.uniform++;
+}
+
+class TestShader : public GLShader
+{
+public:
+    TestShader()
+        : GLShader(GLShader::ExplicitLinking)
+    {
+    }
+};
+
+class GLShaderTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void testLocationCache();
+    void testTemporaryName();
+    void testUnknownUniform();
+    void testValueShadowing();
+    void testColor();
+    void testCallsPerFrame();
+};
+
+void GLShaderTest::initTestCase()
+{
+    epoxy_glCreateProgram = mock_glCreateProgram;
+    epoxy_glDeleteProgram = mock_glDeleteProgram;
+    epoxy_glGetUniformLocation = mock_glGetUniformLocation;
+    epoxy_glUniform1f = mock_glUniform1f;
+    epoxy_glUniform1i = mock_glUniform1i;
+    epoxy_glUniform2fv = mock_glUniformfv;
+    epoxy_glUniform3fv = mock_glUniformfv;
+    epoxy_glUniform4fv = mock_glUniformfv;
+    epoxy_glUniformMatrix4fv = mock_glUniformMatrix4fv;
+}
+
+void GLShaderTest::init()
+{
+    s_calls = GLCalls();
+}
+
+void GLShaderTest::testLocationCache()
+{
+    TestShader shader;
+    QCOMPARE(shader.uniformLocation("blurRadius"), 5);
+    QCOMPARE(s_calls.getUniformLocation, 1);
+    QCOMPARE(shader.uniformLocation("blurRadius"), 5);
+    QCOMPARE(shader.uniformLocation("offset"), 3);
+    QCOMPARE(s_calls.getUniformLocation, 2);
+
+    // the cache is per shader
+    TestShader other;
+    QCOMPARE(other.uniformLocation("blurRadius"), 5);
+    QCOMPARE(s_calls.getUniformLocation, 3);
+}
+
+void GLShaderTest::testTemporaryName()
+{
+    // the cache must compare the names, not the pointers
+    TestShader shader;
+    QByteArray name = QByteArrayLiteral("offset");
+    QCOMPARE(shader.uniformLocation(name.constData()), 3);
+    name = QByteArrayLiteral("blurRadius");
+    QCOMPARE(shader.uniformLocation(name.constData()), 5);
+    QCOMPARE(s_calls.getUniformLocation, 2);
+    QCOMPARE(s_calls.lastName, QByteArrayLiteral("blurRadius"));
+}
+
+void GLShaderTest::testUnknownUniform()
+{
+    TestShader shader;
+    QVERIFY(!shader.setUniform("doesNotExist", 1.0f));
+    QVERIFY(!shader.setUniform("doesNotExist", 1.0f));
+    QCOMPARE(s_calls.getUniformLocation, 1);
+    QCOMPARE(s_calls.uniform, 0);
+}
+
+void GLShaderTest::testValueShadowing()
+{
+    TestShader shader;
+    QVERIFY(shader.setUniform("blurRadius", 2.0f));
+    QVERIFY(shader.setUniform("blurRadius", 2.0f));
+    QCOMPARE(s_calls.uniform, 1);
+    QVERIFY(shader.setUniform("blurRadius", 3.0f));
+    QCOMPARE(s_calls.uniform, 2);
+
+    // the same value with a different type has to be set
+    QVERIFY(shader.setUniform("blurRadius", 3));
+    QCOMPARE(s_calls.uniform, 3);
+
+    QVERIFY(shader.setUniform("offset", QVector2D(1, 2)));
+    QVERIFY(shader.setUniform("offset", QVector2D(1, 2)));
+    QCOMPARE(s_calls.uniform, 4);
+    QVERIFY(shader.setUniform("offset", QVector2D(2, 1)));
+    QCOMPARE(s_calls.uniform, 5);
+
+    QMatrix4x4 matrix;
+    matrix.translate(10, 20);
+    QVERIFY(shader.setUniform(GLShader::ModelViewProjectionMatrix, matrix));
+    QVERIFY(shader.setUniform("modelViewProjectionMatrix", matrix));
+    QCOMPARE(s_calls.uniform, 6);
+    matrix.translate(1, 0);
+    QVERIFY(shader.setUniform(GLShader::ModelViewProjectionMatrix, matrix));
+    QCOMPARE(s_calls.uniform, 7);
+}
+
+void GLShaderTest::testColor()
+{
+    TestShader shader;
+    QVERIFY(shader.setUniform(GLShader::Color, QColor(Qt::red)));
+    QVERIFY(shader.setUniform(GLShader::Color, QVector4D(1, 0, 0, 1)));
+    QCOMPARE(s_calls.uniform, 1);
+    QVERIFY(shader.setUniform(GLShader::Color, QColor(Qt::green)));
+    QCOMPARE(s_calls.uniform, 2);
+}
+
+void GLShaderTest::testCallsPerFrame()
+{
+    // Paints a frame with 100 windows the way the scene does: every window sets the
+    // projection, modulation and saturation, only a few windows differ.
+    TestShader shader;
+    QMatrix4x4 projection;
+    projection.ortho(0, 1920, 1080, 0, 0, 65535);
+
+    auto paintFrame = [&] {
+        for (int i = 0; i < 100; ++i) {
+            QMatrix4x4 mvp = projection;
+            if (i % 25 == 0) {
+                mvp.translate(i + 1, 0);
+            }
+            shader.setUniform(GLShader::ModelViewProjectionMatrix, mvp);
+            shader.setUniform(GLShader::ModulationConstant, QVector4D(1, 1, 1, 1));
+            shader.setUniform(GLShader::Saturation, 1.0f);
+            shader.setUniform("blurRadius", 12.0f);
+        }
+    };
+
+    paintFrame();
+    // the locations of the builtin uniforms and blurRadius
+    const int locationLookups = s_calls.getUniformLocation;
+    QVERIFY(locationLookups > 0);
+
+    s_calls = GLCalls();
+    paintFrame();
+    QCOMPARE(s_calls.getUniformLocation, 0);
+    // the matrix changes to and back from the four translated ones
+    QCOMPARE(s_calls.uniform, 8);
+}
+
+QTEST_GUILESS_MAIN(GLShaderTest)
+#include "glshadertest.moc"
@@ -0,0 +1,156 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "egltestutils.h"
+#include "kwinglplatform.h"
+#include "kwinglutils.h"
+
+#include <QImage>
+#include <QRegion>
+#include <QtTest>
+
+#include <epoxy/gl.h>
+
+using namespace KWin;
+
+Q_DECLARE_METATYPE(KWin::GLPixelUnpackBuffer::Mode)
+
+class GLTextureUploadBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkUpload_data();
+    void benchmarkUpload();
+    void benchmarkConvertAndUpload_data();
+    void benchmarkConvertAndUpload();
+
+private:
+    SurfacelessEglContext m_egl;
+    GLuint m_texture = 0;
+    QImage m_image;
+};
+
+static const QSize s_size(1920, 1080);
+
+void GLTextureUploadBenchmark::initTestCase()
+{
+    // benchmark against llvmpipe so that the numbers do not depend on the GPU of the machine
+    const QByteArray error = m_egl.create();
+    if (!error.isEmpty()) {
+        QSKIP(error.constData());
+    }
+
+    m_image = QImage(s_size, QImage::Format_ARGB32_Premultiplied);
+    m_image.fill(Qt::darkCyan);
+
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, s_size.width(), s_size.height(), 0,
+                 GL_BGRA, GL_UNSIGNED_BYTE, m_image.constBits());
+}
+
+void GLTextureUploadBenchmark::cleanupTestCase()
+{
+    if (!m_egl.isValid()) {
+        return;
+    }
+    glDeleteTextures(1, &m_texture);
+    m_egl.destroy();
+}
+
+static QRegion smallRects()
+{
+    QRegion rects;
+    for (int y = 0; y < s_size.height(); y += 120) {
+        for (int x = 0; x < s_size.width(); x += 240) {
+            rects += QRect(x + 20, y + 20, 64, 32);
+        }
+    }
+    return rects;
+}
+
+void GLTextureUploadBenchmark::benchmarkUpload_data()
+{
+    QTest::addColumn<GLPixelUnpackBuffer::Mode>("mode");
+    QTest::addColumn<QRegion>("damage");
+
+    const QRegion full(QRect(QPoint(0, 0), s_size));
+    QTest::newRow("copy/full") << GLPixelUnpackBuffer::Mode::Copy << full;
+    QTest::newRow("copy/small rects") << GLPixelUnpackBuffer::Mode::Copy << smallRects();
+    QTest::newRow("unpack/full") << GLPixelUnpackBuffer::Mode::Unpack << full;
+    QTest::newRow("unpack/small rects") << GLPixelUnpackBuffer::Mode::Unpack << smallRects();
+    QTest::newRow("stream/full") << GLPixelUnpackBuffer::Mode::Stream << full;
+    QTest::newRow("stream/small rects") << GLPixelUnpackBuffer::Mode::Stream << smallRects();
+}
+
+void GLTextureUploadBenchmark::benchmarkUpload()
+{
+    QFETCH(GLPixelUnpackBuffer::Mode, mode);
+    QFETCH(QRegion, damage);
+
+    GLPixelUnpackBuffer buffer;
+    buffer.setMode(mode);
+    if (buffer.mode() != mode) {
+        QSKIP("Upload mode is not supported by the GL implementation");
+    }
+
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    QBENCHMARK {
+        buffer.upload(GL_TEXTURE_2D, m_image, damage, GL_BGRA, GL_UNSIGNED_BYTE);
+        glFinish();
+    }
+}
+
+void GLTextureUploadBenchmark::benchmarkConvertAndUpload_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<QRegion>("damage");
+
+    // the formats of shm buffers, a premultiplied image got converted without a copy
+    const QRegion full(QRect(QPoint(0, 0), s_size));
+    QTest::newRow("argb32 premultiplied/full") << int(QImage::Format_ARGB32_Premultiplied) << full;
+    QTest::newRow("argb32 premultiplied/small rects") << int(QImage::Format_ARGB32_Premultiplied) << smallRects();
+    QTest::newRow("rgb32/full") << int(QImage::Format_RGB32) << full;
+    QTest::newRow("rgb32/small rects") << int(QImage::Format_RGB32) << smallRects();
+}
+
+void GLTextureUploadBenchmark::benchmarkConvertAndUpload()
+{
+    // the way shm buffers used to be uploaded: convert the whole image, then copy every rect
+    QFETCH(int, format);
+    QFETCH(QRegion, damage);
+
+    QImage image(s_size, QImage::Format(format));
+    image.fill(Qt::darkCyan);
+
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    QBENCHMARK {
+        const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        for (const QRect &rect : damage) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x(), rect.y(), rect.width(), rect.height(),
+                            GL_BGRA, GL_UNSIGNED_BYTE, im.copy(rect).constBits());
+        }
+        glFinish();
+    }
+}
+
+QTEST_GUILESS_MAIN(GLTextureUploadBenchmark)
+#include "gltextureuploadbenchmark.moc"
@@ -0,0 +1,212 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "egltestutils.h"
+#include "kwinglplatform.h"
+#include "kwinglutils.h"
+
+#include <QMatrix4x4>
+#include <QVector4D>
+#include <QtTest>
+
+#include <epoxy/gl.h>
+
+using namespace KWin;
+
+// The plane layouts of EGL_WL_bind_wayland_display the scene splits dmabufs into
+enum class PlaneLayout {
+    Y_U_V,
+    Y_UV,
+    Y_XUXV
+};
+Q_DECLARE_METATYPE(PlaneLayout)
+
+class GLYuvShaderTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testConversion_data();
+    void testConversion();
+
+private:
+    SurfacelessEglContext m_egl;
+};
+
+void GLYuvShaderTest::initTestCase()
+{
+    // llvmpipe stands in for the GPU, the planes are uploaded instead of imported from dmabufs
+    const QByteArray error = m_egl.create();
+    if (!error.isEmpty()) {
+        QSKIP(error.constData());
+    }
+    if (!hasGLVersion(3, 0)) {
+        QSKIP("Single channel textures are not supported");
+    }
+}
+
+void GLYuvShaderTest::cleanupTestCase()
+{
+    if (!m_egl.isValid()) {
+        return;
+    }
+    m_egl.destroy();
+}
+
+void GLYuvShaderTest::testConversion_data()
+{
+    QTest::addColumn<PlaneLayout>("layout");
+    QTest::addColumn<int>("y");
+    QTest::addColumn<int>("u");
+    QTest::addColumn<int>("v");
+    QTest::addColumn<QColor>("expected");
+
+    const struct {
+        const char *name;
+        PlaneLayout layout;
+    } layouts[] = {
+        {"Y_U_V", PlaneLayout::Y_U_V},
+        {"Y_UV", PlaneLayout::Y_UV},
+        {"Y_XUXV", PlaneLayout::Y_XUXV},
+    };
+    for (const auto &layout : layouts) {
+        const QByteArray name(layout.name);
+        QTest::newRow(name + "/white") << layout.layout << 235 << 128 << 128 << QColor(255, 255, 255);
+        QTest::newRow(name + "/black") << layout.layout << 16 << 128 << 128 << QColor(0, 0, 0);
+        QTest::newRow(name + "/red") << layout.layout << 82 << 90 << 240 << QColor(255, 0, 0);
+        QTest::newRow(name + "/green") << layout.layout << 145 << 54 << 34 << QColor(0, 255, 0);
+        QTest::newRow(name + "/blue") << layout.layout << 41 << 240 << 110 << QColor(0, 0, 255);
+    }
+}
+
+static GLuint createPlane(GLenum internalFormat, GLenum format, int channels, const QVector<uchar> &pixel)
+{
+    const QSize size(4, 4);
+    QVector<uchar> data;
+    for (int i = 0; i < size.width() * size.height(); ++i) {
+        data << pixel.mid(0, channels);
+    }
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, size.width(), size.height(), 0,
+                 format, GL_UNSIGNED_BYTE, data.constData());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+void GLYuvShaderTest::testConversion()
+{
+    QFETCH(PlaneLayout, layout);
+    QFETCH(int, y);
+    QFETCH(int, u);
+    QFETCH(int, v);
+
+    GLuint planes[3] = {0, 0, 0};
+    planes[0] = createPlane(GL_R8, GL_RED, 1, {uchar(y)});
+    QVector4D uSelector(1, 0, 0, 0);
+    QVector4D vSelector(1, 0, 0, 0);
+    switch (layout) {
+    case PlaneLayout::Y_U_V:
+        planes[1] = createPlane(GL_R8, GL_RED, 1, {uchar(u)});
+        planes[2] = createPlane(GL_R8, GL_RED, 1, {uchar(v)});
+        break;
+    case PlaneLayout::Y_UV:
+        planes[1] = planes[2] = createPlane(GL_RG8, GL_RG, 2, {uchar(u), uchar(v)});
+        vSelector = QVector4D(0, 1, 0, 0);
+        break;
+    case PlaneLayout::Y_XUXV:
+        planes[1] = planes[2] = createPlane(GL_RGBA8, GL_RGBA, 4, {uchar(y), uchar(u), uchar(y), uchar(v)});
+        uSelector = QVector4D(0, 1, 0, 0);
+        vSelector = QVector4D(0, 0, 0, 1);
+        break;
+    }
+
+    GLTexture target(GL_RGBA8, 4, 4);
+    GLRenderTarget renderTarget(target);
+    GLRenderTarget::pushRenderTarget(&renderTarget);
+
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    vbo->reset();
+    const GLVertexAttrib attribs[] {
+        { VA_Position, 2, GL_FLOAT, offsetof(GLVertex2D, position) },
+        { VA_TexCoord, 2, GL_FLOAT, offsetof(GLVertex2D, texcoord) },
+    };
+    vbo->setAttribLayout(attribs, 2, sizeof(GLVertex2D));
+    GLVertex2D *verts = static_cast<GLVertex2D *>(vbo->map(6 * sizeof(GLVertex2D)));
+    verts[0] = GLVertex2D{{0, 0}, {0, 0}};
+    verts[1] = GLVertex2D{{0, 4}, {0, 1}};
+    verts[2] = GLVertex2D{{4, 0}, {1, 0}};
+    verts[3] = GLVertex2D{{4, 0}, {1, 0}};
+    verts[4] = GLVertex2D{{0, 4}, {0, 1}};
+    verts[5] = GLVertex2D{{4, 4}, {1, 1}};
+    vbo->unmap();
+
+    for (int i = 0; i < 3; ++i) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, planes[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    QMatrix4x4 projection;
+    projection.ortho(QRect(0, 0, 4, 4));
+
+    GLShader *shader = ShaderManager::instance()->pushShader(ShaderTrait::MapTexture | ShaderTrait::YuvConversion);
+    QVERIFY(shader->isValid());
+    shader->setUniform(GLShader::ModelViewProjectionMatrix, projection);
+    shader->setUniform("samplerU", 1);
+    shader->setUniform("samplerV", 2);
+    shader->setUniform("uSelector", uSelector);
+    shader->setUniform("vSelector", vSelector);
+
+    glViewport(0, 0, 4, 4);
+    vbo->render(GL_TRIANGLES);
+    ShaderManager::instance()->popShader();
+
+    uchar pixel[4];
+    glReadPixels(1, 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+    GLRenderTarget::popRenderTarget();
+
+    for (int i = 0; i < 3; ++i) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glDeleteTextures(1, &planes[0]);
+    glDeleteTextures(1, &planes[1]);
+    if (planes[2] != planes[1]) {
+        glDeleteTextures(1, &planes[2]);
+    }
+
+    // the coefficients are rounded, allow for a small error
+    QFETCH(QColor, expected);
+    QVERIFY(qAbs(pixel[0] - expected.red()) <= 2);
+    QVERIFY(qAbs(pixel[1] - expected.green()) <= 2);
+    QVERIFY(qAbs(pixel[2] - expected.blue()) <= 2);
+    QCOMPARE(pixel[3], uchar(255));
+}
+
+QTEST_GUILESS_MAIN(GLYuvShaderTest)
+#include "glyuvshadertest.moc"
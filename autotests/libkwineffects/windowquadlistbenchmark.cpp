@@ -0,0 +1,143 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include <kwineffects.h>
+#include <QMatrix4x4>
+#include <QTest>
+
+// values of the GL enums accepted by makeInterleavedArrays
+static const uint s_glTriangles = 0x0004;
+static const uint s_glQuads = 0x0007;
+
+class WindowQuadListBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void benchmarkMakeGrid_data();
+    void benchmarkMakeGrid();
+    void benchmarkMakeRegularGrid_data();
+    void benchmarkMakeRegularGrid();
+    void benchmarkMakeInterleavedArrays_data();
+    void benchmarkMakeInterleavedArrays();
+
+private:
+    static KWin::WindowQuad makeQuad(const QRectF &rect, KWin::WindowQuadType type);
+    static KWin::WindowQuadList makeWindowQuads(const QSize &size);
+};
+
+KWin::WindowQuad WindowQuadListBenchmark::makeQuad(const QRectF &r, KWin::WindowQuadType type)
+{
+    KWin::WindowQuad quad(type);
+    quad[ 0 ] = KWin::WindowVertex(r.x(), r.y(), r.x(), r.y());
+    quad[ 1 ] = KWin::WindowVertex(r.x() + r.width(), r.y(), r.x() + r.width(), r.y());
+    quad[ 2 ] = KWin::WindowVertex(r.x() + r.width(), r.y() + r.height(), r.x() + r.width(), r.y() + r.height());
+    quad[ 3 ] = KWin::WindowVertex(r.x(), r.y() + r.height(), r.x(), r.y() + r.height());
+    return quad;
+}
+
+KWin::WindowQuadList WindowQuadListBenchmark::makeWindowQuads(const QSize &size)
+{
+    // a decorated window: the contents plus the four decoration borders
+    const int border = 4;
+    const int titleBar = 28;
+    KWin::WindowQuadList quads;
+    quads << makeQuad(QRectF(border, titleBar, size.width() - 2 * border, size.height() - titleBar - border), KWin::WindowQuadContents);
+    quads << makeQuad(QRectF(0, 0, size.width(), titleBar), KWin::WindowQuadDecoration);
+    quads << makeQuad(QRectF(0, titleBar, border, size.height() - titleBar - border), KWin::WindowQuadDecoration);
+    quads << makeQuad(QRectF(size.width() - border, titleBar, border, size.height() - titleBar - border), KWin::WindowQuadDecoration);
+    quads << makeQuad(QRectF(0, size.height() - border, size.width(), border), KWin::WindowQuadDecoration);
+    return quads;
+}
+
+void WindowQuadListBenchmark::benchmarkMakeGrid_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("quadSize");
+
+    // wobbly windows and magic lamp use grids of this density
+    QTest::newRow("800x600/20") << QSize(800, 600) << 20;
+    QTest::newRow("1920x1080/20") << QSize(1920, 1080) << 20;
+    QTest::newRow("1920x1080/10") << QSize(1920, 1080) << 10;
+}
+
+void WindowQuadListBenchmark::benchmarkMakeGrid()
+{
+    QFETCH(QSize, size);
+    QFETCH(int, quadSize);
+    const KWin::WindowQuadList quads = makeWindowQuads(size);
+    KWin::WindowQuadList grid;
+    QBENCHMARK {
+        grid = quads.makeGrid(quadSize);
+    }
+    QVERIFY(!grid.isEmpty());
+}
+
+void WindowQuadListBenchmark::benchmarkMakeRegularGrid_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("subdivisions");
+
+    QTest::newRow("800x600/20") << QSize(800, 600) << 20;
+    QTest::newRow("1920x1080/40") << QSize(1920, 1080) << 40;
+}
+
+void WindowQuadListBenchmark::benchmarkMakeRegularGrid()
+{
+    QFETCH(QSize, size);
+    QFETCH(int, subdivisions);
+    const KWin::WindowQuadList quads = makeWindowQuads(size);
+    KWin::WindowQuadList grid;
+    QBENCHMARK {
+        grid = quads.makeRegularGrid(subdivisions, subdivisions);
+    }
+    QVERIFY(!grid.isEmpty());
+}
+
+void WindowQuadListBenchmark::benchmarkMakeInterleavedArrays_data()
+{
+    QTest::addColumn<uint>("type");
+    QTest::addColumn<int>("verticesPerQuad");
+
+    QTest::newRow("quads") << s_glQuads << 4;
+    QTest::newRow("triangles") << s_glTriangles << 6;
+}
+
+void WindowQuadListBenchmark::benchmarkMakeInterleavedArrays()
+{
+    QFETCH(uint, type);
+    QFETCH(int, verticesPerQuad);
+
+    const KWin::WindowQuadList grid = makeWindowQuads(QSize(1920, 1080)).makeGrid(10);
+    QMatrix4x4 textureMatrix;
+    textureMatrix.scale(1.0 / 1920, 1.0 / 1080);
+
+    // the vertex buffer is 16 byte aligned, like the streaming GLVertexBuffer
+    const size_t size = grid.count() * verticesPerQuad * sizeof(KWin::GLVertex2D);
+    void *memory = qMallocAligned(size, 16);
+    QVERIFY(memory);
+    KWin::GLVertex2D *vertices = static_cast<KWin::GLVertex2D *>(memory);
+    QBENCHMARK {
+        grid.makeInterleavedArrays(type, vertices, textureMatrix);
+    }
+    qFreeAligned(memory);
+}
+
+QTEST_MAIN(WindowQuadListBenchmark)
+
+#include "windowquadlistbenchmark.moc"
@@ -0,0 +1,44 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "mock_toplevel.h"
+
+namespace KWin
+{
+
+Toplevel::Toplevel(QObject *parent)
+    : QObject(parent)
+{
+}
+
+Toplevel::~Toplevel() = default;
+
+QRect Toplevel::inputGeometry() const
+{
+    return m_inputGeometry;
+}
+
+void Toplevel::setInputGeometry(const QRect &rect)
+{
+    const QRect old = m_inputGeometry;
+    m_inputGeometry = rect;
+    emit frameGeometryChanged(this, old);
+}
+
+}
@@ -0,0 +1,49 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_MOCK_TOPLEVEL_H
+#define KWIN_MOCK_TOPLEVEL_H
+
+#include <QObject>
+#include <QRect>
+
+namespace KWin
+{
+
+class Toplevel : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Toplevel(QObject *parent = nullptr);
+    ~Toplevel() override;
+
+    QRect inputGeometry() const;
+    void setInputGeometry(const QRect &rect);
+
+Q_SIGNALS:
+    void geometryShapeChanged(KWin::Toplevel *toplevel, const QRect &old);
+    void frameGeometryChanged(KWin::Toplevel *toplevel, const QRect &oldGeometry);
+
+private:
+    QRect m_inputGeometry;
+};
+
+}
+
+#endif
@@ -0,0 +1,213 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "testutils.h"
+// KWin
+#include "../damagecollector.h"
+// Qt
+#include <QApplication>
+#include <QtTest>
+#include <QX11Info>
+// xcb
+#include <xcb/xcb.h>
+
+using namespace KWin;
+
+class TestDamageCollector : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testRects();
+    void testCollapse_data();
+    void testCollapse();
+    void testResetsDamage();
+    void testPipelined();
+
+private:
+    // pixmaps keep their content when drawn to, unlike unmapped windows
+    void createDrawable(xcb_pixmap_t *pixmap, xcb_damage_damage_t *damage);
+    void fill(xcb_pixmap_t pixmap, const QVector<QRect> &rects);
+
+    QVector<xcb_pixmap_t> m_pixmaps;
+    QVector<xcb_damage_damage_t> m_damages;
+    xcb_gcontext_t m_gc = XCB_NONE;
+};
+
+void TestDamageCollector::initTestCase()
+{
+    qApp->setProperty("x11RootWindow", QVariant::fromValue<quint32>(QX11Info::appRootWindow()));
+    qApp->setProperty("x11Connection", QVariant::fromValue<void*>(QX11Info::connection()));
+
+    xcb_connection_t *c = connection();
+    xcb_prefetch_extension_data(c, &xcb_damage_id);
+    xcb_prefetch_extension_data(c, &xcb_xfixes_id);
+    const xcb_query_extension_reply_t *damage = xcb_get_extension_data(c, &xcb_damage_id);
+    const xcb_query_extension_reply_t *xfixes = xcb_get_extension_data(c, &xcb_xfixes_id);
+    if (!damage || !damage->present || !xfixes || !xfixes->present) {
+        QSKIP("The X server lacks the DAMAGE or XFIXES extension");
+    }
+    // the extensions have to be initialized before using them
+    free(xcb_damage_query_version_reply(c, xcb_damage_query_version_unchecked(c, 1, 1), nullptr));
+    free(xcb_xfixes_query_version_reply(c, xcb_xfixes_query_version_unchecked(c, 5, 0), nullptr));
+}
+
+void TestDamageCollector::init()
+{
+    m_gc = xcb_generate_id(connection());
+}
+
+void TestDamageCollector::cleanup()
+{
+    for (xcb_damage_damage_t damage : qAsConst(m_damages)) {
+        xcb_damage_destroy(connection(), damage);
+    }
+    for (xcb_pixmap_t pixmap : qAsConst(m_pixmaps)) {
+        xcb_free_pixmap(connection(), pixmap);
+    }
+    if (!m_pixmaps.isEmpty()) {
+        xcb_free_gc(connection(), m_gc);
+    }
+    m_damages.clear();
+    m_pixmaps.clear();
+    xcb_flush(connection());
+}
+
+void TestDamageCollector::createDrawable(xcb_pixmap_t *pixmap, xcb_damage_damage_t *damage)
+{
+    xcb_connection_t *c = connection();
+    *pixmap = xcb_generate_id(c);
+    xcb_create_pixmap(c, 24, *pixmap, rootWindow(), 100, 100);
+    if (m_pixmaps.isEmpty()) {
+        xcb_create_gc(c, m_gc, *pixmap, 0, nullptr);
+    }
+    *damage = xcb_generate_id(c);
+    xcb_damage_create(c, *damage, *pixmap, XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+    m_pixmaps << *pixmap;
+    m_damages << *damage;
+}
+
+void TestDamageCollector::fill(xcb_pixmap_t pixmap, const QVector<QRect> &rects)
+{
+    QVector<xcb_rectangle_t> xrects;
+    for (const QRect &rect : rects) {
+        xrects << xcb_rectangle_t{int16_t(rect.x()), int16_t(rect.y()), uint16_t(rect.width()), uint16_t(rect.height())};
+    }
+    xcb_poly_fill_rectangle(connection(), pixmap, m_gc, xrects.count(), xrects.constData());
+}
+
+void TestDamageCollector::testRects()
+{
+    xcb_pixmap_t pixmap;
+    xcb_damage_damage_t damage;
+    createDrawable(&pixmap, &damage);
+
+    const QVector<QRect> rects = {QRect(0, 0, 10, 10), QRect(20, 20, 10, 10), QRect(50, 50, 5, 5)};
+    fill(pixmap, rects);
+
+    DamageCollector collector(connection());
+    collector.beginFrame();
+    const QRegion region = collector.reply(collector.fetch(damage));
+
+    QRegion expected;
+    for (const QRect &rect : rects) {
+        expected += rect;
+    }
+    QCOMPARE(region, expected);
+    QCOMPARE(collector.fetchCount(), 1);
+    QVERIFY(collector.waitTime() > 0);
+
+    collector.beginFrame();
+    QCOMPARE(collector.fetchCount(), 0);
+    QCOMPARE(collector.waitTime(), 0);
+}
+
+void TestDamageCollector::testCollapse_data()
+{
+    QTest::addColumn<int>("maxRects");
+    QTest::addColumn<int>("expectedRects");
+
+    QTest::newRow("collapsed") << 2 << 1;
+    QTest::newRow("exact") << 3 << 3;
+    QTest::newRow("above") << 64 << 3;
+}
+
+void TestDamageCollector::testCollapse()
+{
+    xcb_pixmap_t pixmap;
+    xcb_damage_damage_t damage;
+    createDrawable(&pixmap, &damage);
+    fill(pixmap, {QRect(0, 0, 10, 10), QRect(20, 20, 10, 10), QRect(50, 50, 5, 5)});
+
+    QFETCH(int, maxRects);
+    DamageCollector collector(connection());
+    collector.setMaxRects(maxRects);
+    QCOMPARE(collector.maxRects(), maxRects);
+
+    const QRegion region = collector.reply(collector.fetch(damage));
+    QTEST(region.rectCount(), "expectedRects");
+    QCOMPARE(region.boundingRect(), QRect(0, 0, 55, 55));
+}
+
+void TestDamageCollector::testResetsDamage()
+{
+    xcb_pixmap_t pixmap;
+    xcb_damage_damage_t damage;
+    createDrawable(&pixmap, &damage);
+    fill(pixmap, {QRect(10, 10, 10, 10)});
+
+    DamageCollector collector(connection());
+    QCOMPARE(collector.reply(collector.fetch(damage)), QRegion(10, 10, 10, 10));
+    // the damage got subtracted
+    QVERIFY(collector.reply(collector.fetch(damage)).isEmpty());
+}
+
+void TestDamageCollector::testPipelined()
+{
+    // all windows share the same region, the replies still need to match their window
+    QVector<xcb_damage_damage_t> damages;
+    QVector<QRect> rects;
+    for (int i = 0; i < 10; ++i) {
+        xcb_pixmap_t pixmap;
+        xcb_damage_damage_t damage;
+        createDrawable(&pixmap, &damage);
+        const QRect rect(i, i * 2, 10 + i, 5);
+        fill(pixmap, {rect});
+        damages << damage;
+        rects << rect;
+    }
+
+    DamageCollector collector(connection());
+    collector.beginFrame();
+    QVector<xcb_xfixes_fetch_region_cookie_t> cookies;
+    for (xcb_damage_damage_t damage : qAsConst(damages)) {
+        cookies << collector.fetch(damage);
+    }
+    xcb_flush(connection());
+    for (int i = 0; i < cookies.count(); ++i) {
+        QCOMPARE(collector.reply(cookies[i]), QRegion(rects[i]));
+    }
+    QCOMPARE(collector.fetchCount(), 10);
+}
+
+Q_CONSTRUCTOR_FUNCTION(forceXcb)
+QTEST_MAIN(TestDamageCollector)
+#include "test_damage_collector.moc"
@@ -0,0 +1,118 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../frametracer.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace KWin;
+
+class FrameTracerTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void testEmpty();
+    void testChromeTrace();
+    void testRingBufferWraps();
+    void testSave();
+};
+
+void FrameTracerTest::init()
+{
+    FrameTracer::self()->clear();
+}
+
+void FrameTracerTest::testEmpty()
+{
+    QCOMPARE(FrameTracer::self()->count(), 0);
+    const QJsonDocument document = QJsonDocument::fromJson(FrameTracer::self()->toChromeTrace());
+    QVERIFY(document.isObject());
+    QVERIFY(document.object().value(QStringLiteral("traceEvents")).toArray().isEmpty());
+}
+
+void FrameTracerTest::testChromeTrace()
+{
+    FrameTracer *tracer = FrameTracer::self();
+    tracer->beginFrame();
+    const quint64 frame = tracer->frame();
+    {
+        FrameTraceScope scope("performCompositing");
+        tracer->instant("swapBuffers");
+    }
+    QCOMPARE(tracer->count(), 3);
+
+    const QJsonDocument document = QJsonDocument::fromJson(tracer->toChromeTrace());
+    const QJsonArray events = document.object().value(QStringLiteral("traceEvents")).toArray();
+    QCOMPARE(events.count(), 3);
+
+    const QJsonObject begin = events.at(0).toObject();
+    QCOMPARE(begin.value(QStringLiteral("name")).toString(), QStringLiteral("performCompositing"));
+    QCOMPARE(begin.value(QStringLiteral("ph")).toString(), QStringLiteral("B"));
+    QCOMPARE(begin.value(QStringLiteral("args")).toObject().value(QStringLiteral("frame")).toDouble(), double(frame));
+
+    const QJsonObject instant = events.at(1).toObject();
+    QCOMPARE(instant.value(QStringLiteral("name")).toString(), QStringLiteral("swapBuffers"));
+    QCOMPARE(instant.value(QStringLiteral("ph")).toString(), QStringLiteral("i"));
+
+    const QJsonObject end = events.at(2).toObject();
+    QCOMPARE(end.value(QStringLiteral("name")).toString(), QStringLiteral("performCompositing"));
+    QCOMPARE(end.value(QStringLiteral("ph")).toString(), QStringLiteral("E"));
+
+    QVERIFY(begin.value(QStringLiteral("ts")).toDouble() <= instant.value(QStringLiteral("ts")).toDouble());
+    QVERIFY(instant.value(QStringLiteral("ts")).toDouble() <= end.value(QStringLiteral("ts")).toDouble());
+}
+
+void FrameTracerTest::testRingBufferWraps()
+{
+    FrameTracer *tracer = FrameTracer::self();
+    for (int i = 0; i < FrameTracer::s_capacity; ++i) {
+        tracer->instant("old");
+    }
+    tracer->instant("new");
+    QCOMPARE(tracer->count(), FrameTracer::s_capacity);
+
+    const QJsonDocument document = QJsonDocument::fromJson(tracer->toChromeTrace());
+    const QJsonArray events = document.object().value(QStringLiteral("traceEvents")).toArray();
+    QCOMPARE(events.count(), FrameTracer::s_capacity);
+    QCOMPARE(events.first().toObject().value(QStringLiteral("name")).toString(), QStringLiteral("old"));
+    QCOMPARE(events.last().toObject().value(QStringLiteral("name")).toString(), QStringLiteral("new"));
+}
+
+void FrameTracerTest::testSave()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    FrameTracer::self()->instant("swapBuffers");
+
+    const QString fileName = dir.filePath(QStringLiteral("trace.json"));
+    QVERIFY(FrameTracer::self()->save(fileName));
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), FrameTracer::self()->toChromeTrace());
+
+    QVERIFY(!FrameTracer::self()->save(dir.filePath(QStringLiteral("missing/trace.json"))));
+}
+
+QTEST_GUILESS_MAIN(FrameTracerTest)
+#include "test_frame_tracer.moc"
@@ -0,0 +1,155 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../platformsupport/scenes/qpainter/damage_image_copy.h"
+
+#include <QImage>
+#include <QRegion>
+#include <QTest>
+
+using namespace KWin;
+
+class QPainterDamageCopyTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testInitialCopy();
+    void testFormatChange();
+    void testDamagedCopy_data();
+    void testDamagedCopy();
+    void testDamageOutsideOfImage();
+    void benchmarkCommit_data();
+    void benchmarkCommit();
+};
+
+static QImage createImage(const QSize &size, const QColor &color, QImage::Format format = QImage::Format_ARGB32_Premultiplied)
+{
+    QImage image(size, format);
+    image.fill(color);
+    return image;
+}
+
+void QPainterDamageCopyTest::testInitialCopy()
+{
+    // without a previous image everything needs to be copied
+    const QImage source = createImage(QSize(100, 50), Qt::red);
+    QImage target;
+    QCOMPARE(copyDamagedImage(target, source, QRegion(0, 0, 10, 10), 1), qint64(source.sizeInBytes()));
+    QCOMPARE(target, source);
+    // the target must not share the data of the source
+    QVERIFY(target.constBits() != source.constBits());
+
+    // a size change needs a full copy as well
+    const QImage bigger = createImage(QSize(200, 50), Qt::blue);
+    QCOMPARE(copyDamagedImage(target, bigger, QRegion(), 1), qint64(bigger.sizeInBytes()));
+    QCOMPARE(target, bigger);
+
+    // and a null image resets the target
+    QCOMPARE(copyDamagedImage(target, QImage(), QRegion(0, 0, 10, 10), 1), qint64(0));
+    QVERIFY(target.isNull());
+}
+
+void QPainterDamageCopyTest::testFormatChange()
+{
+    QImage target = createImage(QSize(100, 50), Qt::red, QImage::Format_RGB32);
+    const QImage source = createImage(QSize(100, 50), Qt::blue);
+    QCOMPARE(copyDamagedImage(target, source, QRegion(0, 0, 1, 1), 1), qint64(source.sizeInBytes()));
+    QCOMPARE(target.format(), QImage::Format_ARGB32_Premultiplied);
+    QCOMPARE(target, source);
+}
+
+void QPainterDamageCopyTest::testDamagedCopy_data()
+{
+    QTest::addColumn<QRegion>("damage");
+    QTest::addColumn<qreal>("scale");
+    QTest::addColumn<QRegion>("bufferDamage");
+
+    QTest::newRow("empty") << QRegion() << 1.0 << QRegion();
+    QTest::newRow("single") << QRegion(10, 5, 20, 10) << 1.0 << QRegion(10, 5, 20, 10);
+    QTest::newRow("multiple") << QRegion(0, 0, 5, 5).united(QRect(50, 20, 10, 30)) << 1.0 << QRegion(0, 0, 5, 5).united(QRect(50, 20, 10, 30));
+    QTest::newRow("scaled") << QRegion(10, 5, 20, 10) << 2.0 << QRegion(20, 10, 40, 20);
+}
+
+void QPainterDamageCopyTest::testDamagedCopy()
+{
+    const QSize size(200, 100);
+    QImage target = createImage(size, Qt::red);
+    const QImage source = createImage(size, Qt::blue);
+
+    QFETCH(QRegion, damage);
+    QFETCH(qreal, scale);
+    QFETCH(QRegion, bufferDamage);
+
+    qint64 expectedBytes = 0;
+    for (const QRect &rect : bufferDamage) {
+        expectedBytes += rect.width() * rect.height() * 4;
+    }
+    QCOMPARE(copyDamagedImage(target, source, damage, scale), expectedBytes);
+
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x) {
+            const QColor expected = bufferDamage.contains(QPoint(x, y)) ? Qt::blue : Qt::red;
+            QCOMPARE(target.pixelColor(x, y), expected);
+        }
+    }
+}
+
+void QPainterDamageCopyTest::testDamageOutsideOfImage()
+{
+    // damage gets clipped to the buffer, e.g. for a client sending too large damage
+    QImage target = createImage(QSize(100, 50), Qt::red);
+    const QImage source = createImage(QSize(100, 50), Qt::blue);
+    QCOMPARE(copyDamagedImage(target, source, QRegion(90, 40, 100, 100), 1), qint64(10 * 10 * 4));
+    QCOMPARE(target.pixelColor(95, 45), QColor(Qt::blue));
+    QCOMPARE(target.pixelColor(85, 45), QColor(Qt::red));
+    QCOMPARE(copyDamagedImage(target, source, QRegion(200, 200, 10, 10), 1), qint64(0));
+}
+
+void QPainterDamageCopyTest::benchmarkCommit_data()
+{
+    QTest::addColumn<bool>("fullCopy");
+    QTest::addColumn<QRegion>("damage");
+
+    // a 4K terminal scrolling by one line and updating the cursor
+    const QRegion scroll = QRegion(0, 2000, 3840, 40).united(QRect(100, 2040, 20, 40));
+    QTest::newRow("full copy") << true << scroll;
+    QTest::newRow("damage copy") << false << scroll;
+}
+
+void QPainterDamageCopyTest::benchmarkCommit()
+{
+    QFETCH(bool, fullCopy);
+    QFETCH(QRegion, damage);
+
+    const QImage source = createImage(QSize(3840, 2160), Qt::blue);
+    QImage target = createImage(source.size(), Qt::red);
+    qint64 bytes = 0;
+    QBENCHMARK {
+        if (fullCopy) {
+            target = source.copy();
+            bytes = target.sizeInBytes();
+        } else {
+            bytes = copyDamagedImage(target, source, damage, 1);
+        }
+    }
+    qDebug() << "Bytes copied per commit:" << bytes;
+}
+
+QTEST_GUILESS_MAIN(QPainterDamageCopyTest)
+#include "test_qpainter_damage_copy.moc"
@@ -0,0 +1,105 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../renderjournal.h"
+
+#include <QTest>
+
+using namespace KWin;
+
+class RenderJournalTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testEmpty();
+    void testConstantRenderTime();
+    void testVaryingRenderTime();
+    void testMissRate();
+    void testCapacity();
+    void testClear();
+};
+
+void RenderJournalTest::testEmpty()
+{
+    RenderJournal journal;
+    QVERIFY(journal.isEmpty());
+    QCOMPARE(journal.count(), 0);
+    QCOMPARE(journal.predictedRenderTime(), qint64(0));
+    QCOMPARE(journal.missRate(), qreal(0));
+}
+
+void RenderJournalTest::testConstantRenderTime()
+{
+    RenderJournal journal;
+    for (int i = 0; i < 10; ++i) {
+        journal.add(4000000, 8000000);
+    }
+    QCOMPARE(journal.count(), 10);
+    QCOMPARE(journal.predictedRenderTime(), qint64(4000000));
+}
+
+void RenderJournalTest::testVaryingRenderTime()
+{
+    // mean is 5ms, standard deviation is 1ms
+    RenderJournal journal;
+    for (int i = 0; i < 8; ++i) {
+        journal.add(i % 2 ? 4000000 : 6000000, 8000000);
+    }
+    QCOMPARE(journal.predictedRenderTime(), qint64(7000000));
+}
+
+void RenderJournalTest::testMissRate()
+{
+    RenderJournal journal;
+    journal.add(2000000, 4000000);
+    journal.add(5000000, 4000000);
+    journal.add(3000000, 4000000);
+    journal.add(4000000, 4000000);
+    QCOMPARE(journal.missRate(), qreal(0.25));
+}
+
+void RenderJournalTest::testCapacity()
+{
+    RenderJournal journal(4);
+    for (int i = 0; i < 4; ++i) {
+        journal.add(10000000, 1000000);
+    }
+    QCOMPARE(journal.missRate(), qreal(1));
+
+    // the old frames get replaced by the new ones
+    for (int i = 0; i < 4; ++i) {
+        journal.add(500000, 1000000);
+    }
+    QCOMPARE(journal.count(), 4);
+    QCOMPARE(journal.missRate(), qreal(0));
+    QCOMPARE(journal.predictedRenderTime(), qint64(500000));
+}
+
+void RenderJournalTest::testClear()
+{
+    RenderJournal journal;
+    journal.add(1000000, 500000);
+    QVERIFY(!journal.isEmpty());
+    journal.clear();
+    QVERIFY(journal.isEmpty());
+    QCOMPARE(journal.missRate(), qreal(0));
+}
+
+QTEST_GUILESS_MAIN(RenderJournalTest)
+#include "test_render_journal.moc"
@@ -0,0 +1,292 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../smartplacement.h"
+
+#include <QTest>
+
+#include <random>
+
+using namespace KWin;
+
+struct PlacedWindow {
+    QRect geometry;
+    int weight;
+};
+
+/**
+ * The smart placement as it was done before SmartPlacement, walking all windows for every tried position.
+ */
+static QPoint referencePlace(const QVector<PlacedWindow> &windows, const QSize &size, const QRect &area)
+{
+    const int none = 0, h_wrong = -1, w_wrong = -2; // overlap types
+    long int overlap, min_overlap = 0;
+    int x_optimal, y_optimal;
+    int possible;
+
+    int cxl, cxr, cyt, cyb;
+    int xl, xr, yt, yb;
+    int basket;
+
+    int x = area.left();
+    int y = area.top();
+    x_optimal = x; y_optimal = y;
+
+    int ch = size.height() - 1;
+    int cw = size.width() - 1;
+
+    bool first_pass = true;
+
+    do {
+        if (y + ch > area.bottom() && ch < area.height()) {
+            overlap = h_wrong;
+        } else if (x + cw > area.right()) {
+            overlap = w_wrong;
+        } else {
+            overlap = none;
+
+            cxl = x; cxr = x + cw;
+            cyt = y; cyb = y + ch;
+            for (const PlacedWindow &window : windows) {
+                xl = window.geometry.x(); yt = window.geometry.y();
+                xr = xl + window.geometry.width(); yb = yt + window.geometry.height();
+
+                if ((cxl < xr) && (cxr > xl) &&
+                        (cyt < yb) && (cyb > yt)) {
+                    xl = qMax(cxl, xl); xr = qMin(cxr, xr);
+                    yt = qMax(cyt, yt); yb = qMin(cyb, yb);
+                    overlap += window.weight * (xr - xl) * (yb - yt);
+                }
+            }
+        }
+
+        if (overlap == none) {
+            x_optimal = x;
+            y_optimal = y;
+            break;
+        }
+
+        if (first_pass) {
+            first_pass = false;
+            min_overlap = overlap;
+        } else if (overlap >= none && overlap < min_overlap) {
+            min_overlap = overlap;
+            x_optimal = x;
+            y_optimal = y;
+        }
+
+        if (overlap > none) {
+            possible = area.right();
+            if (possible - cw > x) possible -= cw;
+
+            for (const PlacedWindow &window : windows) {
+                xl = window.geometry.x(); yt = window.geometry.y();
+                xr = xl + window.geometry.width(); yb = yt + window.geometry.height();
+
+                if ((y < yb) && (yt < ch + y)) {
+                    if ((xr > x) && (possible > xr)) possible = xr;
+
+                    basket = xl - cw;
+                    if ((basket > x) && (possible > basket)) possible = basket;
+                }
+            }
+            x = possible;
+        } else if (overlap == w_wrong) {
+            x = area.left();
+            possible = area.bottom();
+
+            if (possible - ch > y) possible -= ch;
+
+            for (const PlacedWindow &window : windows) {
+                yt = window.geometry.y();
+                yb = yt + window.geometry.height();
+
+                if ((yb > y) && (possible > yb)) possible = yb;
+
+                basket = yt - ch;
+                if ((basket > y) && (possible > basket)) possible = basket;
+            }
+            y = possible;
+        }
+    } while ((overlap != none) && (overlap != h_wrong) && (y < area.bottom()));
+
+    if (ch >= area.height()) {
+        y_optimal = area.top();
+    }
+
+    return QPoint(x_optimal, y_optimal);
+}
+
+static QVector<PlacedWindow> randomWindows(std::mt19937 &generator, const QRect &area, int count)
+{
+    std::uniform_int_distribution<int> width(50, area.width() / 2);
+    std::uniform_int_distribution<int> height(50, area.height() / 2);
+    std::uniform_int_distribution<int> x(area.left() - 100, area.right());
+    std::uniform_int_distribution<int> y(area.top() - 100, area.bottom());
+    std::discrete_distribution<int> weight({1, 18, 1});
+    static const int weights[] = {0, 1, SmartPlacement::aboveWeight};
+
+    QVector<PlacedWindow> windows;
+    windows.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        windows.append({QRect(x(generator), y(generator), width(generator), height(generator)), weights[weight(generator)]});
+    }
+    return windows;
+}
+
+static SmartPlacement createPlacement(const QVector<PlacedWindow> &windows)
+{
+    SmartPlacement placement;
+    for (const PlacedWindow &window : windows) {
+        placement.addWindow(window.geometry, window.weight);
+    }
+    return placement;
+}
+
+class SmartPlacementTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testEmpty();
+    void testNextToWindow();
+    void testBelowWindows();
+    void testIgnoresKeepBelow();
+    void testTooLarge();
+    void testMatchesReference_data();
+    void testMatchesReference();
+    void testBatchMatchesReference();
+    void benchmarkPlace_data();
+    void benchmarkPlace();
+};
+
+void SmartPlacementTest::testEmpty()
+{
+    SmartPlacement placement;
+    QCOMPARE(placement.place(QSize(100, 100), QRect(0, 0, 1280, 1024)), QPoint(0, 0));
+    QCOMPARE(placement.place(QSize(100, 100), QRect(1280, 20, 1280, 1004)), QPoint(1280, 20));
+}
+
+void SmartPlacementTest::testNextToWindow()
+{
+    SmartPlacement placement;
+    placement.addWindow(QRect(0, 0, 300, 200));
+    QCOMPARE(placement.place(QSize(100, 100), QRect(0, 0, 1280, 1024)), QPoint(300, 0));
+}
+
+void SmartPlacementTest::testBelowWindows()
+{
+    // a row filled with windows pushes the window below the lowest top edge that fits
+    SmartPlacement placement;
+    placement.addWindow(QRect(0, 0, 640, 200));
+    placement.addWindow(QRect(640, 0, 640, 300));
+    QCOMPARE(placement.place(QSize(100, 100), QRect(0, 0, 1280, 1024)), QPoint(0, 200));
+}
+
+void SmartPlacementTest::testIgnoresKeepBelow()
+{
+    SmartPlacement placement;
+    placement.addWindow(QRect(0, 0, 1280, 1024), 0);
+    QCOMPARE(placement.place(QSize(100, 100), QRect(0, 0, 1280, 1024)), QPoint(0, 0));
+}
+
+void SmartPlacementTest::testTooLarge()
+{
+    const QRect area(0, 0, 1280, 1024);
+    SmartPlacement placement;
+    placement.addWindow(QRect(0, 0, 300, 200));
+    QCOMPARE(placement.place(QSize(1280, 2000), area), referencePlace({{QRect(0, 0, 300, 200), 1}}, QSize(1280, 2000), area));
+    QCOMPARE(placement.place(QSize(2000, 100), area), referencePlace({{QRect(0, 0, 300, 200), 1}}, QSize(2000, 100), area));
+}
+
+void SmartPlacementTest::testMatchesReference_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<QRect>("area");
+
+    QTest::newRow("few") << 3 << QRect(0, 0, 1280, 1024);
+    QTest::newRow("some") << 20 << QRect(0, 0, 1920, 1080);
+    QTest::newRow("many") << 100 << QRect(0, 0, 1920, 1080);
+    QTest::newRow("offset") << 40 << QRect(1280, 32, 1280, 992);
+}
+
+void SmartPlacementTest::testMatchesReference()
+{
+    // the result has to be exactly the one of the old algorithm
+    QFETCH(int, count);
+    QFETCH(QRect, area);
+
+    std::mt19937 generator(count);
+    std::uniform_int_distribution<int> width(20, area.width() + 50);
+    std::uniform_int_distribution<int> height(20, area.height() + 50);
+    for (int i = 0; i < 200; ++i) {
+        const QVector<PlacedWindow> windows = randomWindows(generator, area, count);
+        const QSize size(width(generator), height(generator));
+        QCOMPARE(createPlacement(windows).place(size, area), referencePlace(windows, size, area));
+    }
+}
+
+void SmartPlacementTest::testBatchMatchesReference()
+{
+    // a batch of windows placed one after the other on a populated desktop
+    const QRect area(0, 0, 1920, 1080);
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> width(200, 800);
+    std::uniform_int_distribution<int> height(150, 600);
+    QVector<PlacedWindow> windows = randomWindows(generator, area, 100);
+    for (int i = 0; i < 50; ++i) {
+        const QSize size(width(generator), height(generator));
+        const QPoint position = createPlacement(windows).place(size, area);
+        QCOMPARE(position, referencePlace(windows, size, area));
+        windows.append({QRect(position, size), 1});
+    }
+}
+
+void SmartPlacementTest::benchmarkPlace_data()
+{
+    QTest::addColumn<bool>("reference");
+
+    QTest::newRow("reference") << true;
+    QTest::newRow("sweep") << false;
+}
+
+void SmartPlacementTest::benchmarkPlace()
+{
+    // 50 windows opened on a desktop with 100 windows
+    QFETCH(bool, reference);
+    const QRect area(0, 0, 1920, 1080);
+    std::mt19937 generator(7);
+    const QVector<PlacedWindow> initial = randomWindows(generator, area, 100);
+    std::uniform_int_distribution<int> width(200, 800);
+    std::uniform_int_distribution<int> height(150, 600);
+    QVector<QSize> sizes;
+    for (int i = 0; i < 50; ++i) {
+        sizes.append(QSize(width(generator), height(generator)));
+    }
+
+    QBENCHMARK {
+        QVector<PlacedWindow> windows = initial;
+        for (const QSize &size : qAsConst(sizes)) {
+            const QPoint position = reference ? referencePlace(windows, size, area) : createPlacement(windows).place(size, area);
+            windows.append({QRect(position, size), 1});
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(SmartPlacementTest)
+#include "test_smart_placement.moc"
@@ -0,0 +1,224 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../effects/blur/softwareblur.h"
+
+#include <QTest>
+#include <QtMath>
+
+#include <random>
+
+using namespace KWin;
+
+static QImage randomImage(const QSize &size, int seed)
+{
+    std::mt19937 generator(seed);
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < image.height(); ++y) {
+        quint32 *line = reinterpret_cast<quint32 *>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            line[x] = generator();
+        }
+    }
+    return image;
+}
+
+static int channel(const QImage &image, int x, int y, int shift)
+{
+    x = qBound(0, x, image.width() - 1);
+    y = qBound(0, y, image.height() - 1);
+    return (reinterpret_cast<const quint32 *>(image.constScanLine(y))[x] >> shift) & 0xff;
+}
+
+/**
+ * The filter passes pixel by pixel, without tables and vector instructions.
+ */
+static QImage referenceDownSample(const QImage &source, int offset)
+{
+    QImage destination(SoftwareBlur::downSampledSize(source.size()), source.format());
+    for (int y = 0; y < destination.height(); ++y) {
+        for (int x = 0; x < destination.width(); ++x) {
+            quint32 pixel = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                const int sum = channel(source, 2 * x, 2 * y, shift) + channel(source, 2 * x + 1, 2 * y, shift)
+                    + channel(source, 2 * x, 2 * y + 1, shift) + channel(source, 2 * x + 1, 2 * y + 1, shift)
+                    + channel(source, 2 * x - offset, 2 * y - offset, shift) + channel(source, 2 * x + 1 + offset, 2 * y - offset, shift)
+                    + channel(source, 2 * x - offset, 2 * y + 1 + offset, shift) + channel(source, 2 * x + 1 + offset, 2 * y + 1 + offset, shift);
+                pixel |= quint32(qRound(sum / 8.0 + 0.001)) << shift;
+            }
+            reinterpret_cast<quint32 *>(destination.scanLine(y))[x] = pixel;
+        }
+    }
+    return destination;
+}
+
+/**
+ * The taps of the up sample shader: halfpixel is half a texel of the destination, that is a
+ * quarter texel of the source, and the shader samples 2 * halfpixel * offset away on the axes
+ * and halfpixel * offset away diagonally. The texel closest to the tap is sampled.
+ */
+static int upSampleTap(int x, qreal halfPixels, int offset)
+{
+    const qreal center = (x + 0.5) / 2.0 - 0.5;
+    return qFloor(center + halfPixels * offset / 4.0 + 0.5);
+}
+
+static QImage referenceUpSample(const QImage &source, const QSize &size, int offset)
+{
+    QImage destination(size, source.format());
+    for (int y = 0; y < destination.height(); ++y) {
+        for (int x = 0; x < destination.width(); ++x) {
+            auto tap = [&](qreal dx, qreal dy, int shift) {
+                return channel(source, upSampleTap(x, dx, offset), upSampleTap(y, dy, offset), shift);
+            };
+            quint32 pixel = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                const int sum = tap(-2, 0, shift) + tap(2, 0, shift) + tap(0, 2, shift) + tap(0, -2, shift)
+                    + 2 * (tap(-1, 1, shift) + tap(1, 1, shift) + tap(1, -1, shift) + tap(-1, -1, shift));
+                pixel |= quint32(qRound(sum / 12.0 + 0.001)) << shift;
+            }
+            reinterpret_cast<quint32 *>(destination.scanLine(y))[x] = pixel;
+        }
+    }
+    return destination;
+}
+
+class SoftwareBlurTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testSize_data();
+    void testSize();
+    void testUniform();
+    void testDownSample_data();
+    void testDownSample();
+    void testUpSample_data();
+    void testUpSample();
+    void testSpreads();
+    void benchmarkBlur_data();
+    void benchmarkBlur();
+};
+
+void SoftwareBlurTest::testSize_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("iterations");
+    QTest::addColumn<QSize>("expected");
+
+    QTest::newRow("even") << QSize(640, 480) << 3 << QSize(320, 240);
+    QTest::newRow("odd") << QSize(101, 33) << 4 << QSize(51, 17);
+    QTest::newRow("tiny") << QSize(1, 1) << 5 << QSize(1, 1);
+}
+
+void SoftwareBlurTest::testSize()
+{
+    QFETCH(QSize, size);
+    QFETCH(int, iterations);
+    const QImage blurred = SoftwareBlur::blur(randomImage(size, 1), iterations, 2);
+    QTEST(blurred.size(), "expected");
+    QCOMPARE(blurred.format(), QImage::Format_ARGB32_Premultiplied);
+}
+
+void SoftwareBlurTest::testUniform()
+{
+    // a single color stays the same, there is no rounding drift
+    QImage image(QSize(128, 96), QImage::Format_ARGB32_Premultiplied);
+    image.fill(qRgba(16, 32, 64, 128));
+    const QImage blurred = SoftwareBlur::blur(image, 4, 3);
+    for (int y = 0; y < blurred.height(); ++y) {
+        for (int x = 0; x < blurred.width(); ++x) {
+            QCOMPARE(blurred.pixel(x, y), qRgba(16, 32, 64, 128));
+        }
+    }
+}
+
+void SoftwareBlurTest::testDownSample_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("offset");
+
+    QTest::newRow("even") << QSize(64, 48) << 1;
+    QTest::newRow("odd") << QSize(33, 17) << 2;
+    QTest::newRow("large offset") << QSize(20, 20) << 15;
+}
+
+void SoftwareBlurTest::testDownSample()
+{
+    QFETCH(QSize, size);
+    QFETCH(int, offset);
+    const QImage source = randomImage(size, size.width());
+    QImage destination(SoftwareBlur::downSampledSize(size), source.format());
+    SoftwareBlur::downSample(source, destination, offset);
+    QCOMPARE(destination, referenceDownSample(source, offset));
+}
+
+void SoftwareBlurTest::testUpSample_data()
+{
+    testDownSample_data();
+}
+
+void SoftwareBlurTest::testUpSample()
+{
+    QFETCH(QSize, size);
+    QFETCH(int, offset);
+    const QImage source = randomImage(SoftwareBlur::downSampledSize(size), size.height());
+    QImage destination(size, source.format());
+    SoftwareBlur::upSample(source, destination, offset);
+    QCOMPARE(destination, referenceUpSample(source, size, offset));
+}
+
+void SoftwareBlurTest::testSpreads()
+{
+    // a white square on black gets blurred into its surroundings
+    QImage image(QSize(64, 64), QImage::Format_ARGB32_Premultiplied);
+    image.fill(qRgba(0, 0, 0, 255));
+    for (int y = 28; y < 36; ++y) {
+        for (int x = 28; x < 36; ++x) {
+            image.setPixel(x, y, qRgba(255, 255, 255, 255));
+        }
+    }
+    const QImage blurred = SoftwareBlur::blur(image, 2, 2);
+    QVERIFY(qRed(blurred.pixel(16, 16)) > 0);
+    QVERIFY(qRed(blurred.pixel(16, 16)) < 255);
+    QVERIFY(qRed(blurred.pixel(16, 10)) < qRed(blurred.pixel(16, 16)));
+    QCOMPARE(qRed(blurred.pixel(0, 0)), 0);
+    QCOMPARE(qAlpha(blurred.pixel(16, 16)), 255);
+}
+
+void SoftwareBlurTest::benchmarkBlur_data()
+{
+    QTest::addColumn<int>("iterations");
+
+    QTest::newRow("2 iterations") << 2;
+    QTest::newRow("3 iterations") << 3;
+    QTest::newRow("4 iterations") << 4;
+}
+
+void SoftwareBlurTest::benchmarkBlur()
+{
+    // one megapixel, the results are the time per megapixel
+    QFETCH(int, iterations);
+    const QImage image = randomImage(QSize(1000, 1000), 1);
+    QBENCHMARK {
+        SoftwareBlur::blur(image, iterations, 2);
+    }
+}
+
+QTEST_GUILESS_MAIN(SoftwareBlurTest)
+#include "test_software_blur.moc"
@@ -0,0 +1,162 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../toplevel_hit_index.h"
+#include "mock_toplevel.h"
+
+#include <QTest>
+
+using namespace KWin;
+
+/**
+ * Looks the position up the way InputRedirection::findToplevel does.
+ */
+static Toplevel *findToplevel(const ToplevelHitIndex &index, const QPoint &pos)
+{
+    for (Toplevel *toplevel : index.candidates(pos)) {
+        if (toplevel->inputGeometry().contains(pos)) {
+            return toplevel;
+        }
+    }
+    return nullptr;
+}
+
+class ToplevelHitIndexTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testStackingOrder();
+    void testNegativePosition();
+    void testGeometryChange();
+    void testDestroyed();
+    void benchmarkManyWindows();
+};
+
+void ToplevelHitIndexTest::testStackingOrder()
+{
+    // overlapping windows are returned from top to bottom, later windows in the list are above
+    Toplevel below;
+    below.setInputGeometry(QRect(0, 0, 400, 400));
+    Toplevel above;
+    above.setInputGeometry(QRect(200, 200, 400, 400));
+
+    ToplevelHitIndex index;
+    QVERIFY(!index.isValid());
+    index.rebuild({&below, &above});
+    QVERIFY(index.isValid());
+
+    QCOMPARE(index.candidates(QPoint(300, 300)), (QVector<Toplevel *>{&above, &below}));
+    QCOMPARE(findToplevel(index, QPoint(300, 300)), &above);
+    QCOMPARE(findToplevel(index, QPoint(100, 100)), &below);
+    QCOMPARE(findToplevel(index, QPoint(500, 500)), &above);
+    QVERIFY(!findToplevel(index, QPoint(500, 100)));
+    QVERIFY(index.candidates(QPoint(2000, 2000)).isEmpty());
+
+    // raising the lower window
+    index.invalidate();
+    QVERIFY(!index.isValid());
+    index.rebuild({&above, &below});
+    QCOMPARE(findToplevel(index, QPoint(300, 300)), &below);
+}
+
+void ToplevelHitIndexTest::testNegativePosition()
+{
+    // windows partially outside of the screen space end up in the cells left of and above the origin
+    Toplevel toplevel;
+    toplevel.setInputGeometry(QRect(-100, -100, 200, 200));
+
+    ToplevelHitIndex index;
+    index.rebuild({&toplevel});
+    QCOMPARE(findToplevel(index, QPoint(-1, -1)), &toplevel);
+    QCOMPARE(findToplevel(index, QPoint(-100, 50)), &toplevel);
+    QCOMPARE(findToplevel(index, QPoint(0, 0)), &toplevel);
+    QVERIFY(!findToplevel(index, QPoint(-101, 0)));
+    QVERIFY(index.candidates(QPoint(-ToplevelHitIndex::cellSize - 1, 0)).isEmpty());
+}
+
+void ToplevelHitIndexTest::testGeometryChange()
+{
+    // moving a window is picked up without rebuilding the index
+    Toplevel toplevel;
+    toplevel.setInputGeometry(QRect(0, 0, 100, 100));
+
+    ToplevelHitIndex index;
+    index.rebuild({&toplevel});
+    QCOMPARE(findToplevel(index, QPoint(50, 50)), &toplevel);
+
+    toplevel.setInputGeometry(QRect(1000, 1000, 100, 100));
+    QVERIFY(index.isValid());
+    QVERIFY(index.candidates(QPoint(50, 50)).isEmpty());
+    QCOMPARE(findToplevel(index, QPoint(1050, 1050)), &toplevel);
+
+    // an empty window is not indexed at all
+    toplevel.setInputGeometry(QRect());
+    QVERIFY(index.candidates(QPoint(1050, 1050)).isEmpty());
+    toplevel.setInputGeometry(QRect(0, 0, 100, 100));
+    QCOMPARE(findToplevel(index, QPoint(50, 50)), &toplevel);
+}
+
+void ToplevelHitIndexTest::testDestroyed()
+{
+    // a destroyed window is dropped from the index, which has to be rebuilt afterwards
+    Toplevel below;
+    below.setInputGeometry(QRect(0, 0, 100, 100));
+    Toplevel *above = new Toplevel;
+    above->setInputGeometry(QRect(0, 0, 100, 100));
+
+    ToplevelHitIndex index;
+    index.rebuild({&below, above});
+    QCOMPARE(findToplevel(index, QPoint(50, 50)), above);
+
+    delete above;
+    QVERIFY(!index.isValid());
+    QCOMPARE(index.candidates(QPoint(50, 50)), QVector<Toplevel *>{&below});
+}
+
+void ToplevelHitIndexTest::benchmarkManyWindows()
+{
+    // a grid of windows covering a large screen, every window gets looked up
+    const int columns = 16;
+    const int rows = 12;
+    QVector<Toplevel *> toplevels;
+    QList<Toplevel *> stacking;
+    for (int i = 0; i < columns * rows; ++i) {
+        Toplevel *toplevel = new Toplevel;
+        toplevel->setInputGeometry(QRect((i % columns) * 80, (i / columns) * 80, 80, 80));
+        toplevels << toplevel;
+        stacking << toplevel;
+    }
+
+    ToplevelHitIndex index;
+    index.rebuild(stacking);
+    for (Toplevel *toplevel : qAsConst(toplevels)) {
+        QCOMPARE(findToplevel(index, toplevel->inputGeometry().center()), toplevel);
+    }
+
+    QBENCHMARK {
+        for (int i = 0; i < columns * rows; ++i) {
+            findToplevel(index, QPoint((i % columns) * 80 + 40, (i / columns) * 80 + 40));
+        }
+    }
+
+    qDeleteAll(toplevels);
+}
+
+QTEST_GUILESS_MAIN(ToplevelHitIndexTest)
+#include "test_toplevel_hit_index.moc"
@@ -0,0 +1,139 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "testutils.h"
+// KWin
+#include "../atoms.h"
+#include "../x11clientprefetch.h"
+// Qt
+#include <QApplication>
+#include <QtTest>
+#include <QX11Info>
+// xcb
+#include <xcb/xcb.h>
+
+#include <memory>
+#include <vector>
+
+using namespace KWin;
+
+class TestX11ClientPrefetch : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void cleanup();
+    void testProperties();
+    void testAdoption_data();
+    void testAdoption();
+
+private:
+    QVector<xcb_window_t> m_windows;
+};
+
+void TestX11ClientPrefetch::initTestCase()
+{
+    qApp->setProperty("x11RootWindow", QVariant::fromValue<quint32>(QX11Info::appRootWindow()));
+    qApp->setProperty("x11Connection", QVariant::fromValue<void*>(QX11Info::connection()));
+    KWin::atoms = new KWin::Atoms;
+}
+
+void TestX11ClientPrefetch::cleanupTestCase()
+{
+    delete KWin::atoms;
+}
+
+void TestX11ClientPrefetch::cleanup()
+{
+    for (xcb_window_t window : qAsConst(m_windows)) {
+        xcb_destroy_window(connection(), window);
+    }
+    m_windows.clear();
+    xcb_flush(connection());
+}
+
+void TestX11ClientPrefetch::testProperties()
+{
+    const xcb_window_t leader = createWindow();
+    const xcb_window_t window = createWindow();
+    m_windows << leader << window;
+
+    const QByteArray colorScheme = QByteArrayLiteral("BreezeDark");
+    xcb_change_property(connection(), XCB_PROP_MODE_REPLACE, window, atoms->kde_color_sheme,
+                        XCB_ATOM_STRING, 8, colorScheme.length(), colorScheme.constData());
+    xcb_change_property(connection(), XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_TRANSIENT_FOR,
+                        XCB_ATOM_WINDOW, 32, 1, &leader);
+    xcb_change_property(connection(), XCB_PROP_MODE_REPLACE, window, atoms->wm_client_leader,
+                        XCB_ATOM_WINDOW, 32, 1, &leader);
+
+    X11ClientPrefetch prefetch(window);
+    QCOMPARE(prefetch.window(), window);
+    QVERIFY(!prefetch.attributes.isNull());
+    QVERIFY(prefetch.attributes->override_redirect);
+    QVERIFY(!prefetch.geometry.isNull());
+    QCOMPARE(prefetch.geometry.rect(), QRect(0, 0, 10, 10));
+    QCOMPARE(QByteArray(prefetch.colorScheme), colorScheme);
+    xcb_window_t transientFor = XCB_WINDOW_NONE;
+    QVERIFY(prefetch.transient.getTransientFor(&transientFor));
+    QCOMPARE(transientFor, leader);
+    QCOMPARE(prefetch.wmClientLeader.value<xcb_window_t>(XCB_WINDOW_NONE), leader);
+    QVERIFY(QByteArray(prefetch.applicationMenuObjectPath).isEmpty());
+}
+
+void TestX11ClientPrefetch::testAdoption_data()
+{
+    QTest::addColumn<bool>("pipelined");
+
+    QTest::newRow("serial") << false;
+    QTest::newRow("pipelined") << true;
+}
+
+void TestX11ClientPrefetch::testAdoption()
+{
+    // stands in for the windows of a session KWin takes over
+    const int windowCount = 200;
+    for (int i = 0; i < windowCount; ++i) {
+        m_windows << createWindow();
+    }
+    xcb_flush(connection());
+
+    QFETCH(bool, pipelined);
+    QBENCHMARK {
+        if (pipelined) {
+            std::vector<std::unique_ptr<X11ClientPrefetch>> prefetches;
+            for (xcb_window_t window : qAsConst(m_windows)) {
+                prefetches.emplace_back(new X11ClientPrefetch(window));
+            }
+            for (const auto &prefetch : prefetches) {
+                prefetch->waitForReplies();
+            }
+        } else {
+            // one round trip per window, how managing used to work
+            for (xcb_window_t window : qAsConst(m_windows)) {
+                X11ClientPrefetch prefetch(window);
+                prefetch.waitForReplies();
+            }
+        }
+    }
+}
+
+Q_CONSTRUCTOR_FUNCTION(forceXcb)
+QTEST_MAIN(TestX11ClientPrefetch)
+#include "test_x11_client_prefetch.moc"
@@ -0,0 +1,196 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../xwl/chunkqueue.h"
+
+#include <QTest>
+
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace KWin::Xwl;
+
+class ChunkQueueTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+    void testSmallTransfer();
+    void testChunks();
+    void testBackpressure();
+    void testReusesBuffers();
+    void benchmarkThroughput_data();
+    void benchmarkThroughput();
+
+private:
+    void write(const QByteArray &data);
+    int m_pipe[2] = {-1, -1};
+};
+
+void ChunkQueueTest::init()
+{
+    QCOMPARE(pipe2(m_pipe, O_CLOEXEC | O_NONBLOCK), 0);
+}
+
+void ChunkQueueTest::cleanup()
+{
+    close(m_pipe[0]);
+    if (m_pipe[1] != -1) {
+        close(m_pipe[1]);
+    }
+    m_pipe[0] = m_pipe[1] = -1;
+}
+
+void ChunkQueueTest::write(const QByteArray &data)
+{
+    QCOMPARE(::write(m_pipe[1], data.constData(), data.size()), ssize_t(data.size()));
+}
+
+void ChunkQueueTest::testSmallTransfer()
+{
+    ChunkQueue queue(1024);
+    QVERIFY(queue.isEmpty());
+    QVERIFY(!queue.isFull());
+
+    write(QByteArrayLiteral("hello"));
+    close(m_pipe[1]);
+    m_pipe[1] = -1;
+
+    QCOMPARE(queue.readFrom(m_pipe[0]), qint64(5));
+    QVERIFY(!queue.isEmpty());
+    QVERIFY(!queue.hasCompleteChunk());
+    QCOMPARE(queue.readFrom(m_pipe[0]), qint64(0));
+    QCOMPARE(queue.count(), 1);
+    QCOMPARE(queue.first(), QByteArrayLiteral("hello"));
+
+    queue.takeFirst();
+    QVERIFY(queue.isEmpty());
+    QCOMPARE(queue.count(), 0);
+}
+
+void ChunkQueueTest::testChunks()
+{
+    // data larger than a chunk gets split up without losing bytes
+    ChunkQueue queue(4, 3);
+    write(QByteArrayLiteral("abcdefghij"));
+
+    QCOMPARE(queue.readFrom(m_pipe[0]), qint64(4));
+    QVERIFY(queue.hasCompleteChunk());
+    QCOMPARE(queue.readFrom(m_pipe[0]), qint64(4));
+    QCOMPARE(queue.readFrom(m_pipe[0]), qint64(2));
+    QCOMPARE(queue.count(), 3);
+    QVERIFY(!queue.isFull());
+
+    QCOMPARE(queue.first(), QByteArrayLiteral("abcd"));
+    queue.takeFirst();
+    QCOMPARE(queue.first(), QByteArrayLiteral("efgh"));
+    queue.takeFirst();
+    QCOMPARE(queue.first(), QByteArrayLiteral("ij"));
+    QVERIFY(!queue.hasCompleteChunk());
+}
+
+void ChunkQueueTest::testBackpressure()
+{
+    // no more data is read once all chunks are full
+    ChunkQueue queue(4, 2);
+    write(QByteArrayLiteral("abcdefghijkl"));
+
+    QCOMPARE(queue.readFrom(m_pipe[0]), qint64(4));
+    QVERIFY(!queue.isFull());
+    QCOMPARE(queue.readFrom(m_pipe[0]), qint64(4));
+    QVERIFY(queue.isFull());
+    // a full queue is not an error, the data stays in the pipe
+    QCOMPARE(queue.readFrom(m_pipe[0]), ChunkQueue::QueueFull);
+    QCOMPARE(queue.readFrom(-1), ChunkQueue::QueueFull);
+
+    queue.takeFirst();
+    QVERIFY(!queue.isFull());
+    QCOMPARE(queue.readFrom(m_pipe[0]), qint64(4));
+    QCOMPARE(queue.first(), QByteArrayLiteral("efgh"));
+    queue.takeFirst();
+    QCOMPARE(queue.first(), QByteArrayLiteral("ijkl"));
+
+    // while reading from the fd fails
+    queue.takeFirst();
+    QCOMPARE(queue.readFrom(-1), qint64(-1));
+}
+
+void ChunkQueueTest::testReusesBuffers()
+{
+    ChunkQueue queue(4, 1);
+    write(QByteArrayLiteral("abcdefgh"));
+
+    QCOMPARE(queue.readFrom(m_pipe[0]), qint64(4));
+    const char *buffer = queue.first().constData();
+    queue.takeFirst();
+    QCOMPARE(queue.readFrom(m_pipe[0]), qint64(4));
+    QVERIFY(queue.first().constData() == buffer);
+    QCOMPARE(queue.first(), QByteArrayLiteral("efgh"));
+}
+
+void ChunkQueueTest::benchmarkThroughput_data()
+{
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("63KiB") << 63 * 1024;
+    QTest::newRow("256KiB") << 256 * 1024;
+    QTest::newRow("1MiB") << 1024 * 1024;
+}
+
+void ChunkQueueTest::benchmarkThroughput()
+{
+    // streams 64 MiB from a writer thread, every chunk is consumed once it is full
+    QFETCH(int, chunkSize);
+    const qint64 total = 64 * 1024 * 1024;
+
+    QBENCHMARK {
+        int writer[2];
+        QCOMPARE(pipe2(writer, O_CLOEXEC), 0);
+        std::thread thread([fd = writer[1], total] {
+            const QByteArray data(64 * 1024, 'x');
+            for (qint64 written = 0; written < total; written += data.size()) {
+                if (::write(fd, data.constData(), data.size()) != data.size()) {
+                    break;
+                }
+            }
+            close(fd);
+        });
+
+        ChunkQueue queue(chunkSize);
+        qint64 received = 0;
+        qint64 length;
+        while ((length = queue.readFrom(writer[0])) > 0) {
+            if (queue.hasCompleteChunk()) {
+                received += queue.first().size();
+                queue.takeFirst();
+            }
+        }
+        received += queue.first().size();
+        thread.join();
+        close(writer[0]);
+        QCOMPARE(length, qint64(0));
+        QCOMPARE(received, total);
+    }
+}
+
+QTEST_GUILESS_MAIN(ChunkQueueTest)
+#include "test_xwl_chunk_queue.moc"
@@ -19,11 +19,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "composite.h"
 
+#include "damagecollector.h"
 #include "dbusinterface.h"
 #include "x11client.h"
 #include "decorations/decoratedclient.h"
 #include "deleted.h"
 #include "effects.h"
+#include "frametracer.h"
 #include "internal_client.h"
 #include "overlaywindow.h"
 #include "platform.h"
@@ -60,6 +62,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <xcb/composite.h>
 #include <xcb/damage.h>
 
+#include <algorithm>
 #include <cstdio>
 
 Q_DECLARE_METATYPE(KWin::X11Compositor::SuspendReason)
@@ -118,6 +121,10 @@ private:
 static inline qint64 milliToNano(int milli) { return qint64(milli) * 1000 * 1000; }
 static inline qint64 nanoToMilli(int nano) { return nano / (1000*1000); }
 
+// Extra time given to a frame on top of its predicted render time, it accounts for
+// the timer firing late and for the work done before the scene gets painted.
+static const qint64 s_renderTimeSafetyMargin = 1000 * 1000;
+
 Compositor::Compositor(QObject* workspace)
     : QObject(workspace)
     , m_state(State::Off)
@@ -142,6 +149,12 @@ Compositor::Compositor(QObject* workspace)
     connect(&m_releaseSelectionTimer, &QTimer::timeout,
             this, &Compositor::releaseCompositorSelection);
 
+    // The shared region of the damage collector goes away with the X connection
+    connect(kwinApp(), &Application::x11ConnectionAboutToBeDestroyed, this, [this] {
+        delete m_damageCollector;
+        m_damageCollector = nullptr;
+    });
+
     m_unusedSupportPropertyTimer.setInterval(compositorLostMessageDelay);
     m_unusedSupportPropertyTimer.setSingleShot(true);
     connect(&m_unusedSupportPropertyTimer, &QTimer::timeout,
@@ -177,6 +190,7 @@ Compositor::~Compositor()
     stop();
     deleteUnusedSupportProperties();
     destroyCompositorSelection();
+    delete m_damageCollector;
     s_compositor = nullptr;
 }
 
@@ -315,8 +329,13 @@ void Compositor::setupX11Support()
     if (!con) {
         delete m_selectionOwner;
         m_selectionOwner = nullptr;
+        delete m_damageCollector;
+        m_damageCollector = nullptr;
         return;
     }
+    if (!m_damageCollector) {
+        m_damageCollector = new DamageCollector(con);
+    }
     claimCompositorSelection();
     xcb_composite_redirect_subwindows(con, kwinApp()->x11RootWindow(),
                                       XCB_COMPOSITE_REDIRECT_MANUAL);
@@ -341,11 +360,13 @@ void Compositor::startupWithWorkspace()
         // No vsync - DO NOT set "0", would cause div-by-zero segfaults.
         vBlankInterval = milliToNano(1);
     }
+    resetRenderJournal();
 
     // Sets also the 'effects' pointer.
     kwinApp()->platform()->createEffectsHandler(this, m_scene);
     connect(Workspace::self(), &Workspace::deletedRemoved, m_scene, &Scene::removeToplevel);
     connect(effects, &EffectsHandler::screenGeometryChanged, this, &Compositor::addRepaintFull);
+    connect(screens(), &Screens::countChanged, this, &Compositor::resetScreenSwaps, Qt::UniqueConnection);
 
     for (X11Client *c : Workspace::self()->clientList()) {
         c->setupCompositing();
@@ -451,6 +472,10 @@ void Compositor::stop()
     delete m_scene;
     m_scene = nullptr;
     compositeTimer.stop();
+    resetRenderJournal();
+    resetScreenSwaps();
+    m_repaintedWindows.clear();
+    m_damagedWindows.clear();
     repaints_region = QRegion();
 
     m_state = State::Off;
@@ -559,6 +584,15 @@ void Compositor::addRepaint(const QRegion& r)
     scheduleRepaint();
 }
 
+void Compositor::addPointerMotionRepaint(const QRegion &region)
+{
+    if (m_state != State::On) {
+        return;
+    }
+    m_pointerMotionRepaint = true;
+    addRepaint(region);
+}
+
 void Compositor::addRepaintFull()
 {
     if (m_state != State::On) {
@@ -582,6 +616,7 @@ void Compositor::aboutToSwapBuffers()
     Q_ASSERT(!m_bufferSwapPending);
 
     m_bufferSwapPending = true;
+    FrameTracer::self()->instant("swapBuffers");
 }
 
 void Compositor::bufferSwapComplete()
@@ -589,12 +624,134 @@ void Compositor::bufferSwapComplete()
     Q_ASSERT(m_bufferSwapPending);
     m_bufferSwapPending = false;
 
+    m_lastPresentationTimestamp = m_monotonicClock.nsecsElapsed();
+    FrameTracer::self()->instant("bufferSwapComplete");
+
     emit bufferSwapCompleted();
 
     if (m_composeAtSwapCompletion) {
         m_composeAtSwapCompletion = false;
-        performCompositing();
+        if (m_scene && m_scene->syncsToVBlank() && !m_scene->blocksForRetrace()) {
+            // We know when the last frame hit the screen, so don't start the next one
+            // earlier than needed to make it for the next vblank.
+            setCompositeTimer();
+        } else {
+            performCompositing();
+        }
+    }
+}
+
+void Compositor::aboutToSwapBuffers(int screenId)
+{
+    if (screenId < 0) {
+        return;
+    }
+    if (screenId >= m_screenSwapsPending.size()) {
+        m_screenSwapsPending.resize(screenId + 1);
+    }
+    while (m_screenPresentationTimestamps.size() <= screenId) {
+        m_screenPresentationTimestamps.append(-1);
+    }
+    Q_ASSERT(!m_screenSwapsPending.at(screenId));
+
+    m_screenSwapsPending[screenId] = true;
+    FrameTracer::self()->instant("swapBuffers");
+}
+
+void Compositor::bufferSwapComplete(int screenId)
+{
+    // The pending swaps are forgotten when the screens change or compositing restarts,
+    // a page flip may still complete afterwards.
+    if (!isScreenSwapPending(screenId)) {
+        return;
+    }
+    m_screenSwapsPending[screenId] = false;
+
+    m_lastPresentationTimestamp = m_monotonicClock.nsecsElapsed();
+    m_screenPresentationTimestamps[screenId] = m_lastPresentationTimestamp;
+    FrameTracer::self()->instant("bufferSwapComplete");
+
+    emit screenBufferSwapCompleted(screenId);
+
+    if (m_composeAtSwapCompletion) {
+        // Paint the screen with the next pass, the others are either painted already or
+        // still wait for their own page flip.
+        m_composeAtSwapCompletion = false;
+        if (m_scene && m_scene->syncsToVBlank() && !m_scene->blocksForRetrace()) {
+            // Like for a swap of all screens, don't start the frame earlier than needed
+            // to make it for the next vblank.
+            setCompositeTimer();
+        } else {
+            performCompositing();
+        }
+    }
+}
+
+void Compositor::resetScreenSwaps()
+{
+    // The screen ids might refer to different outputs now.
+    m_screenSwapsPending.clear();
+    m_screenPresentationTimestamps.clear();
+}
+
+QRegion Compositor::pendingScreenSwapsRegion() const
+{
+    QRegion region;
+    const int count = qMin(m_screenSwapsPending.size(), screens()->count());
+    for (int i = 0; i < count; ++i) {
+        if (m_screenSwapsPending.at(i)) {
+            region |= screens()->geometry(i);
+        }
+    }
+    return region;
+}
+
+// Returns the first vblank which a screen not waiting for its previous frame can still make
+// when starting to paint @p leadTime before it and sets m_leadTime accordingly. Every screen
+// flips at its own refresh rate, so its vblanks are predicted from its last page flip.
+qint64 Compositor::nextScreenVBlank(qint64 now, qint64 leadTime)
+{
+    qint64 nextVBlank = -1;
+    qint64 nextStart = 0;
+    for (int i = 0; i < screens()->count(); ++i) {
+        if (isScreenSwapPending(i)) {
+            continue;
+        }
+        const float refreshRate = screens()->refreshRate(i);
+        const qint64 interval = refreshRate > 0 ? qint64(milliToNano(1000) / refreshRate)
+                                                : milliToNano(1000) / 60;
+        const qint64 screenLeadTime = qMin(leadTime, interval);
+        const qint64 lastPresentation = m_screenPresentationTimestamps.value(i, -1);
+        qint64 target;
+        if (lastPresentation < 0) {
+            // Nothing presented on the screen yet, paint it right away.
+            target = now + screenLeadTime;
+        } else {
+            target = lastPresentation + interval;
+            if (target - screenLeadTime < now) {
+                // We're late for that vblank, aim at the next one we can still make.
+                target += ((now - (target - screenLeadTime)) / interval + 1) * interval;
+            }
+        }
+        if (nextVBlank < 0 || target - screenLeadTime < nextStart) {
+            nextVBlank = target;
+            nextStart = target - screenLeadTime;
+            m_leadTime = screenLeadTime;
+        }
+    }
+    if (nextVBlank < 0) {
+        m_leadTime = qMin(leadTime, vBlankInterval);
+        return now + m_leadTime;
     }
+    return nextVBlank;
+}
+
+void Compositor::resetRenderJournal()
+{
+    m_renderJournal.clear();
+    m_leadTime = options->vBlankTime();
+    m_lastPresentationTimestamp = -1;
+    m_screenPresentationTimestamps.fill(-1);
 }
 
 void Compositor::performCompositing()
@@ -614,17 +771,33 @@ void Compositor::performCompositing()
         return;
     }
 
+    // If every screen presents on its own only the screens still waiting for their
+    // previous frame are blocked, unless that's all of them.
+    const QRegion pendingSwaps = m_scene->perScreenPresentation() ? pendingScreenSwapsRegion() : QRegion();
+    if (!pendingSwaps.isEmpty() && (QRegion(screens()->geometry()) - pendingSwaps).isEmpty()) {
+        m_composeAtSwapCompletion = true;
+        compositeTimer.stop();
+        return;
+    }
+
+    FrameTracer::self()->beginFrame();
+    FrameTraceScope traceScope("performCompositing");
+
     // Create a list of all windows in the stacking order
     QList<Toplevel *> windows = Workspace::self()->xStackingOrder();
     QList<Toplevel *> damaged;
 
-    // Reset the damage state of each window and fetch the damage region
+    // Reset the damage state of each damaged window and fetch the damage region
     // without waiting for a reply
-    for (Toplevel *win : windows) {
-        if (win->resetAndFetchDamage()) {
+    if (m_damageCollector) {
+        m_damageCollector->beginFrame();
+    }
+    for (Toplevel *win : qAsConst(m_damagedWindows)) {
+        if (win->resetAndFetchDamage(m_damageCollector)) {
             damaged << win;
         }
     }
+    m_damagedWindows.clear();
 
     if (damaged.count() > 0) {
         m_scene->triggerFence();
@@ -641,6 +814,7 @@ void Compositor::performCompositing()
     }
 
     // Get the replies
+    FrameTracer::self()->begin("fetchDamage");
     for (Toplevel *win : damaged) {
         // Discard the cached lanczos texture
         if (win->effectWindow()) {
@@ -651,8 +825,9 @@ void Compositor::performCompositing()
             }
         }
 
-        win->getDamageRegionReply();
+        win->getDamageRegionReply(m_damageCollector);
     }
+    FrameTracer::self()->end("fetchDamage");
 
     if (repaints_region.isEmpty() && !windowRepaintsPending()) {
         m_scene->idle();
@@ -671,25 +846,49 @@ void Compositor::performCompositing()
     // TODO? This cannot be used so carelessly - needs protections against broken clients, the
     // window should not get focus before it's displayed, handle unredirected windows properly and
     // so on.
-    for (Toplevel *win : windows) {
-        if (!win->readyForPainting()) {
-            windows.removeAll(win);
-        }
-        if (waylandServer() && waylandServer()->isScreenLocked()) {
-            if(!win->isLockScreen() && !win->isInputMethod()) {
-                windows.removeAll(win);
+    const bool screenLocked = waylandServer() && waylandServer()->isScreenLocked();
+    windows.erase(std::remove_if(windows.begin(), windows.end(),
+        [screenLocked](Toplevel *win) {
+            if (!win->readyForPainting()) {
+                return true;
             }
-        }
-    }
+            return screenLocked && !win->isLockScreen() && !win->isInputMethod();
+        }), windows.end());
 
     QRegion repaints = repaints_region;
     // clear all repaints, so that post-pass can add repaints for the next repaint
     repaints_region = QRegion();
 
+    if (m_scene->perScreenPresentation()) {
+        // The scene only paints the screens covered by the repaints, so they have to include
+        // the repaints of the windows. The part on screens which still wait for their previous
+        // frame is kept for the pass started once that frame has been presented.
+        for (Toplevel *win : qAsConst(m_repaintedWindows)) {
+            repaints |= win->repaints();
+        }
+        repaints_region = repaints & pendingSwaps;
+        repaints -= pendingSwaps;
+        if (repaints.isEmpty() && !pendingSwaps.isEmpty()) {
+            m_composeAtSwapCompletion = true;
+            compositeTimer.stop();
+            return;
+        }
+    }
+
     if (m_framesToTestForSafety > 0 && (m_scene->compositingType() & OpenGLCompositing)) {
         kwinApp()->platform()->createOpenGLSafePoint(Platform::OpenGLSafePoint::PreFrame);
     }
+    FrameTracer::self()->begin("Scene::paint");
     m_timeSinceLastVBlank = m_scene->paint(repaints, windows);
+    FrameTracer::self()->end("Scene::paint");
+    static_cast<EffectsHandlerImpl *>(effects)->finishFrame();
+    if (m_pointerMotionRepaint) {
+        m_pointerMotionRepaint = false;
+        m_pointerMotionFrames++;
+    }
+    if (!m_scene->blocksForRetrace()) {
+        m_renderJournal.add(m_timeSinceLastVBlank, m_leadTime);
+    }
     if (m_framesToTestForSafety > 0) {
         if (m_scene->compositingType() & OpenGLCompositing) {
             kwinApp()->platform()->createOpenGLSafePoint(Platform::OpenGLSafePoint::PostFrame);
@@ -720,49 +919,48 @@ void Compositor::performCompositing()
     // would again add something pending.
     if (m_bufferSwapPending && m_scene->syncsToVBlank()) {
         m_composeAtSwapCompletion = true;
+    } else if (m_scene->perScreenPresentation() && !pendingScreenSwapsRegion().isEmpty()) {
+        // Continue as soon as one of the screens has presented its frame, that paints
+        // every screen at its own refresh rate.
+        m_composeAtSwapCompletion = true;
     } else {
         scheduleRepaint();
     }
 }
 
-template <class T>
-static bool repaintsPending(const QList<T*> &windows)
-{
-    return std::any_of(windows.begin(), windows.end(),
-                       [](T *t) { return !t->repaints().isEmpty(); });
-}
-
-bool Compositor::windowRepaintsPending() const
+// Whether the repaints of the window have to be painted. Wayland clients are only
+// painted once they are ready for painting and internal clients once they are shown.
+static bool hasPendingRepaints(Toplevel *window)
 {
-    if (repaintsPending(Workspace::self()->clientList())) {
-        return true;
-    }
-    if (repaintsPending(Workspace::self()->desktopList())) {
-        return true;
+    if (window->repaints().isEmpty()) {
+        return false;
     }
-    if (repaintsPending(Workspace::self()->unmanagedList())) {
-        return true;
+    if (InternalClient *internal = qobject_cast<InternalClient *>(window)) {
+        return internal->isShown(true);
     }
-    if (repaintsPending(Workspace::self()->deletedList())) {
-        return true;
+    if (window->isClient() && !qobject_cast<X11Client *>(window)) {
+        return window->readyForPainting();
     }
-    if (auto *server = waylandServer()) {
-        const auto &clients = server->clients();
-        auto test = [](AbstractClient *c) {
-            return c->readyForPainting() && !c->repaints().isEmpty();
-        };
-        if (std::any_of(clients.begin(), clients.end(), test)) {
-            return true;
+    return true;
+}
+
+bool Compositor::windowRepaintsPending()
+{
+    bool pending = false;
+    auto it = m_repaintedWindows.begin();
+    while (it != m_repaintedWindows.end()) {
+        if ((*it)->repaints().isEmpty()) {
+            // painted in the meantime
+            it = m_repaintedWindows.erase(it);
+            continue;
         }
+        if (hasPendingRepaints(*it)) {
+            pending = true;
+            break;
+        }
+        ++it;
     }
-    const auto &internalClients = workspace()->internalClients();
-    auto internalTest = [] (InternalClient *client) {
-        return client->isShown(true) && !client->repaints().isEmpty();
-    };
-    if (std::any_of(internalClients.begin(), internalClients.end(), internalTest)) {
-        return true;
-    }
-    return false;
+    return pending;
 }
 
 void Compositor::setCompositeTimer()
@@ -782,9 +980,31 @@ void Compositor::setCompositeTimer()
 
     uint waitTime = 1;
 
-    if (m_scene->blocksForRetrace()) {
+    if (m_scene->syncsToVBlank() && !m_scene->blocksForRetrace() && m_lastPresentationTimestamp >= 0) {
+        // Start compositing just early enough to make it for the vblank we aim at. How much
+        // time we need is predicted from the render times of the recent frames.
+        qint64 leadTime = options->vBlankTime();
+        if (!m_renderJournal.isEmpty()) {
+            leadTime = m_renderJournal.predictedRenderTime() + s_renderTimeSafetyMargin;
+        }
 
-        // TODO: make vBlankTime dynamic?!
+        const qint64 now = m_monotonicClock.nsecsElapsed();
+        qint64 target;
+        if (m_scene->perScreenPresentation()) {
+            target = nextScreenVBlank(now, leadTime);
+        } else {
+            m_leadTime = qMin(leadTime, vBlankInterval);
+            target = m_lastPresentationTimestamp + fpsInterval;
+            if (target - m_leadTime < now) {
+                // We're late for that vblank, aim at the next one we can still make.
+                target += ((now - (target - m_leadTime)) / vBlankInterval + 1) * vBlankInterval;
+            }
+        }
+        waitTime = nanoToMilli(target - m_leadTime - now);
+    } else if (m_scene->blocksForRetrace()) {
+
+        // The render time cannot be measured here as paint() includes the blocking wait for
+        // the retrace, so we keep using the static vBlankTime padding.
         // It's required because glXWaitVideoSync will *likely* block a full frame if one enters
         // a retrace pass which can last a variable amount of time, depending on the actual screen
         // Now, my ooold 19" CRT can do such retrace so that 2ms are entirely sufficient,
@@ -837,7 +1057,12 @@ void Compositor::setCompositeTimer()
         }
     }
     // Force 4fps minimum:
-    compositeTimer.start(qMin(waitTime, 250u), this);
+    compositeTimer.start(qMin(waitTime, 250u), Qt::PreciseTimer, this);
+}
+
+qint64 Compositor::damageFetchWaitTime() const
+{
+    return m_damageCollector ? m_damageCollector->waitTime() : 0;
 }
 
 bool Compositor::isActive()
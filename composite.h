@@ -21,17 +21,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include <kwinglobals.h>
+#include "renderjournal.h"
 
 #include <QObject>
 #include <QElapsedTimer>
 #include <QTimer>
 #include <QBasicTimer>
 #include <QRegion>
+#include <QSet>
+#include <QVector>
 
 namespace KWin
 {
 class CompositorSelectionOwner;
+class DamageCollector;
 class Scene;
+class Toplevel;
 class X11Client;
 
 class KWIN_EXPORT Compositor : public QObject
@@ -54,6 +59,11 @@ public:
     void addRepaint(const QRegion& r);
     void addRepaint(int x, int y, int w, int h);
     void addRepaintFull();
+    /**
+     * Schedules a repaint of @p region caused by the pointer moving, such as the area
+     * of a software cursor. The frame painting it is counted in pointerMotionFrames().
+     */
+    void addPointerMotionRepaint(const QRegion &region);
 
     /**
      * Schedules a new repaint if no repaint is currently scheduled.
@@ -72,6 +82,26 @@ public:
      */
     void bufferSwapComplete();
 
+    /**
+     * Notifies the compositor that the buffer of the screen @p screenId is about to be
+     * presented. Used by platforms whose scene presents every screen on its own, see
+     * Scene::perScreenPresentation(). The screen is not painted again until
+     * bufferSwapComplete(int) is called for it, the other screens are not blocked.
+     */
+    void aboutToSwapBuffers(int screenId);
+
+    /**
+     * Notifies the compositor that the pending buffer swap of the screen @p screenId has completed.
+     */
+    void bufferSwapComplete(int screenId);
+
+    /**
+     * Whether a buffer swap of the screen @p screenId is pending.
+     */
+    bool isScreenSwapPending(int screenId) const {
+        return screenId >= 0 && screenId < m_screenSwapsPending.size() && m_screenSwapsPending.at(screenId);
+    }
+
     /**
      * Toggles compositing, that is if the Compositor is suspended it will be resumed
      * and if the Compositor is active it will be suspended.
@@ -92,6 +122,31 @@ public:
     bool isActive();
     virtual int refreshRate() const = 0;
 
+    /**
+     * The time in nanoseconds before the next vblank at which compositing of the next frame
+     * gets started. It is derived from the render times of the recent frames.
+     */
+    qint64 frameLeadTime() const {
+        return m_leadTime;
+    }
+    /**
+     * The share of the recent frames which took longer to render than their lead time.
+     */
+    qreal frameMissRate() const {
+        return m_renderJournal.missRate();
+    }
+    /**
+     * The number of frames which got painted because the pointer moved. Stays at zero as
+     * long as the platform moves the cursor without compositing.
+     */
+    quint64 pointerMotionFrames() const {
+        return m_pointerMotionFrames;
+    }
+    /**
+     * The time in nanoseconds the last frame was blocked waiting for the damage of X11 windows.
+     */
+    qint64 damageFetchWaitTime() const;
+
     Scene *scene() const {
         return m_scene;
     }
@@ -105,6 +160,26 @@ public:
         return s_compositor != nullptr && s_compositor->isActive();
     }
 
+    /**
+     * Remembers that @p window has pending repaints. Only called from Toplevel.
+     */
+    void addRepaintedWindow(Toplevel *window) {
+        m_repaintedWindows.insert(window);
+    }
+    /**
+     * Remembers that @p window got damaged. Only called from Toplevel.
+     */
+    void addDamagedWindow(Toplevel *window) {
+        m_damagedWindows.insert(window);
+    }
+    /**
+     * Forgets about the pending repaints and damage of @p window, called when it gets destroyed.
+     */
+    void removeTrackedWindow(Toplevel *window) {
+        m_repaintedWindows.remove(window);
+        m_damagedWindows.remove(window);
+    }
+
     // for delayed supportproperty management of effects
     void keepSupportProperty(xcb_atom_t atom);
     void removeSupportProperty(xcb_atom_t atom);
@@ -115,6 +190,7 @@ Q_SIGNALS:
     void aboutToToggleCompositing();
     void sceneCreated();
     void bufferSwapCompleted();
+    void screenBufferSwapCompleted(int screenId);
 
 protected:
     explicit Compositor(QObject *parent = nullptr);
@@ -146,7 +222,11 @@ private:
     void setupX11Support();
 
     void setCompositeTimer();
-    bool windowRepaintsPending() const;
+    void resetRenderJournal();
+    void resetScreenSwaps();
+    QRegion pendingScreenSwapsRegion() const;
+    qint64 nextScreenVBlank(qint64 now, qint64 leadTime);
+    bool windowRepaintsPending();
 
     void releaseCompositorSelection();
     void deleteUnusedSupportProperties();
@@ -160,6 +240,10 @@ private:
     QTimer m_unusedSupportPropertyTimer;
     qint64 vBlankInterval, fpsInterval;
     QRegion repaints_region;
+    // windows which have or had repaints and windows which got damaged since the last pass,
+    // so that we don't have to walk all windows to find them
+    QSet<Toplevel *> m_repaintedWindows;
+    QSet<Toplevel *> m_damagedWindows;
 
     qint64 m_timeSinceLastVBlank;
 
@@ -167,9 +251,20 @@ private:
 
     bool m_bufferSwapPending;
     bool m_composeAtSwapCompletion;
+    // screens whose previous frame is not presented yet, only used with per screen presentation
+    QVector<bool> m_screenSwapsPending;
+    // when the screens presented their previous frame, only used with per screen presentation
+    QVector<qint64> m_screenPresentationTimestamps;
 
     int m_framesToTestForSafety = 3;
     QElapsedTimer m_monotonicClock;
+
+    RenderJournal m_renderJournal;
+    qint64 m_leadTime = 0;
+    qint64 m_lastPresentationTimestamp = -1;
+    bool m_pointerMotionRepaint = false;
+    quint64 m_pointerMotionFrames = 0;
+    DamageCollector *m_damageCollector = nullptr;
 };
 
 class KWIN_EXPORT WaylandCompositor : public Compositor
@@ -0,0 +1,100 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "damagecollector.h"
+
+#include <QElapsedTimer>
+#include <QVector>
+
+namespace KWin
+{
+
+DamageCollector::DamageCollector(xcb_connection_t *connection)
+    : m_connection(connection)
+    , m_region(xcb_generate_id(connection))
+{
+    xcb_xfixes_create_region(m_connection, m_region, 0, nullptr);
+
+    bool ok = false;
+    const int maxRects = qEnvironmentVariableIntValue("KWIN_DAMAGE_MAX_RECTS", &ok);
+    if (ok) {
+        setMaxRects(maxRects);
+    }
+}
+
+DamageCollector::~DamageCollector()
+{
+    xcb_xfixes_destroy_region(m_connection, m_region);
+}
+
+void DamageCollector::setMaxRects(int maxRects)
+{
+    m_maxRects = qMax(1, maxRects);
+}
+
+void DamageCollector::beginFrame()
+{
+    m_waitTime = 0;
+    m_fetchCount = 0;
+}
+
+xcb_xfixes_fetch_region_cookie_t DamageCollector::fetch(xcb_damage_damage_t damage)
+{
+    // Copy the damage region to the shared region, resetting the damaged state
+    xcb_damage_subtract(m_connection, damage, XCB_NONE, m_region);
+    return xcb_xfixes_fetch_region_unchecked(m_connection, m_region);
+}
+
+QRegion DamageCollector::reply(xcb_xfixes_fetch_region_cookie_t cookie)
+{
+    QElapsedTimer timer;
+    timer.start();
+    xcb_xfixes_fetch_region_reply_t *reply = xcb_xfixes_fetch_region_reply(m_connection, cookie, nullptr);
+    m_waitTime += timer.nsecsElapsed();
+    m_fetchCount++;
+
+    if (!reply) {
+        return QRegion();
+    }
+
+    // Convert the reply to a QRegion
+    const int count = xcb_xfixes_fetch_region_rectangles_length(reply);
+    QRegion region;
+
+    if (count > 1 && count <= m_maxRects) {
+        const xcb_rectangle_t *rects = xcb_xfixes_fetch_region_rectangles(reply);
+
+        QVector<QRect> qrects;
+        qrects.reserve(count);
+
+        for (int i = 0; i < count; i++) {
+            qrects << QRect(rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+        }
+
+        region.setRects(qrects.constData(), count);
+    } else {
+        region += QRect(reply->extents.x, reply->extents.y,
+                        reply->extents.width, reply->extents.height);
+    }
+
+    free(reply);
+    return region;
+}
+
+}
@@ -0,0 +1,98 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QRegion>
+
+#include <xcb/damage.h>
+#include <xcb/xfixes.h>
+
+namespace KWin
+{
+
+/**
+ * @brief The DamageCollector fetches the damage of X11 windows with as few requests as possible.
+ *
+ * The damage of all windows damaged in a frame gets requested first and the replies are
+ * collected afterwards, so there is only one round trip per frame. All fetches go through
+ * the same XFixes region, the server processes the requests in order, so a region does
+ * not need to be created and destroyed for every window.
+ *
+ * The time spent waiting for the replies is measured for every frame.
+ */
+class KWIN_EXPORT DamageCollector
+{
+public:
+    explicit DamageCollector(xcb_connection_t *connection);
+    ~DamageCollector();
+
+    xcb_connection_t *connection() const {
+        return m_connection;
+    }
+
+    /**
+     * Moves the damage accumulated by @p damage into the shared region and requests the
+     * rectangles of the region, without waiting for the reply.
+     */
+    xcb_xfixes_fetch_region_cookie_t fetch(xcb_damage_damage_t damage);
+    /**
+     * Waits for the reply to the fetch request @p cookie. If the damage consists of more
+     * than maxRects() rectangles it collapses to their bounding rectangle.
+     */
+    QRegion reply(xcb_xfixes_fetch_region_cookie_t cookie);
+
+    /**
+     * The number of rectangles up to which the damage is kept as is. The default is 16,
+     * it can be changed with the KWIN_DAMAGE_MAX_RECTS environment variable.
+     */
+    int maxRects() const {
+        return m_maxRects;
+    }
+    void setMaxRects(int maxRects);
+
+    /**
+     * Starts a new frame, this resets waitTime() and fetchCount().
+     */
+    void beginFrame();
+    /**
+     * The time in nanoseconds spent blocked on replies in the current frame.
+     */
+    qint64 waitTime() const {
+        return m_waitTime;
+    }
+    /**
+     * The number of damage regions fetched in the current frame.
+     */
+    int fetchCount() const {
+        return m_fetchCount;
+    }
+
+private:
+    xcb_connection_t *m_connection;
+    xcb_xfixes_region_t m_region;
+    int m_maxRects = 16;
+    qint64 m_waitTime = 0;
+    int m_fetchCount = 0;
+    Q_DISABLE_COPY(DamageCollector)
+};
+
+}
@@ -28,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "atoms.h"
 #include "composite.h"
 #include "debug_console.h"
+#include "frametracer.h"
 #include "main.h"
 #include "placement.h"
 #include "platform.h"
@@ -307,6 +308,26 @@ bool CompositorDBusInterface::platformRequiresCompositing() const
     return kwinApp()->platform()->requiresCompositing();
 }
 
+qlonglong CompositorDBusInterface::frameLeadTime() const
+{
+    return m_compositor->frameLeadTime() / 1000;
+}
+
+double CompositorDBusInterface::frameMissRate() const
+{
+    return m_compositor->frameMissRate();
+}
+
+qulonglong CompositorDBusInterface::pointerMotionFrames() const
+{
+    return m_compositor->pointerMotionFrames();
+}
+
+qlonglong CompositorDBusInterface::damageFetchWaitTime() const
+{
+    return m_compositor->damageFetchWaitTime();
+}
+
 void CompositorDBusInterface::resume()
 {
     if (kwinApp()->operationMode() == Application::OperationModeX11) {
@@ -326,6 +347,16 @@ void CompositorDBusInterface::reinitialize()
     m_compositor->reinitialize();
 }
 
+QString CompositorDBusInterface::frameTrace() const
+{
+    return QString::fromUtf8(FrameTracer::self()->toChromeTrace());
+}
+
+bool CompositorDBusInterface::saveFrameTrace(const QString &fileName) const
+{
+    return FrameTracer::self()->save(fileName);
+}
+
 QStringList CompositorDBusInterface::supportedOpenGLPlatformInterfaces() const
 {
     QStringList interfaces;
@@ -123,6 +123,22 @@ class CompositorDBusInterface : public QObject
      */
     Q_PROPERTY(QStringList supportedOpenGLPlatformInterfaces READ supportedOpenGLPlatformInterfaces)
     Q_PROPERTY(bool platformRequiresCompositing READ platformRequiresCompositing)
+    /**
+     * @brief How many microseconds before the vblank the Compositor starts to render a frame.
+     */
+    Q_PROPERTY(qlonglong frameLeadTime READ frameLeadTime)
+    /**
+     * @brief The share of the recently rendered frames which did not finish within the lead time.
+     */
+    Q_PROPERTY(double frameMissRate READ frameMissRate)
+    /**
+     * @brief The number of frames which got painted because the pointer moved.
+     */
+    Q_PROPERTY(qulonglong pointerMotionFrames READ pointerMotionFrames)
+    /**
+     * @brief The time in nanoseconds the last frame waited for the damage of X11 windows.
+     */
+    Q_PROPERTY(qlonglong damageFetchWaitTime READ damageFetchWaitTime)
 public:
     explicit CompositorDBusInterface(Compositor *parent);
     ~CompositorDBusInterface() override = default;
@@ -134,6 +150,10 @@ public:
     QString compositingType() const;
     QStringList supportedOpenGLPlatformInterfaces() const;
     bool platformRequiresCompositing() const;
+    qlonglong frameLeadTime() const;
+    double frameMissRate() const;
+    qulonglong pointerMotionFrames() const;
+    qlonglong damageFetchWaitTime() const;
 
 public Q_SLOTS:
     /**
@@ -171,6 +191,23 @@ public Q_SLOTS:
      * On signal Compositor reloads settings and restarts.
      */
     void reinitialize();
+    /**
+     * @brief The timings of the recently composited frames.
+     *
+     * The stages of each frame are reported in the Chrome trace event format, which can be
+     * loaded into chrome://tracing or the Perfetto UI.
+     *
+     * @return QString JSON document with the recorded trace events
+     * @see saveFrameTrace
+     */
+    QString frameTrace() const;
+    /**
+     * @brief Writes the timings of the recently composited frames to @p fileName.
+     *
+     * @return bool @c true if the trace has been written, @c false otherwise
+     * @see frameTrace
+     */
+    bool saveFrameTrace(const QString &fileName) const;
 
 Q_SIGNALS:
     void compositingToggled(bool active);
@@ -137,6 +137,20 @@ EffectsHandlerImpl::EffectsHandlerImpl(Compositor *compositor, Scene *scene)
         }
     );
     m_effectLoader->setConfig(kwinApp()->config());
+    connect(options, &Options::effectRenderBudgetChanged, this,
+        [this] {
+            if (options->effectRenderBudget() != 0) {
+                return;
+            }
+            for (auto it = m_effectRenderTimes.begin(); it != m_effectRenderTimes.end(); ++it) {
+                if (it->demotedFrames > 0) {
+                    it->demotedFrames = 0;
+                    m_compositor->addRepaintFull();
+                }
+            }
+        }
+    );
+    m_renderTimer.start();
     new EffectsAdaptor(this);
     QDBusConnection dbus = QDBusConnection::sessionBus();
     dbus.registerObject(QStringLiteral("/Effects"), this);
@@ -389,12 +403,42 @@ void EffectsHandlerImpl::reconfigure()
     m_effectLoader->queryAndLoadAll();
 }
 
+// Calls the effect the iterator points to and accounts the time it took to it. The time
+// spent by the following effects and the scene, which the effect calls into recursively,
+// gets accounted to them instead.
+template <typename Function>
+void EffectsHandlerImpl::callEffect(EffectsIterator &iterator, Function call)
+{
+    const int index = iterator - m_activeEffects.constBegin();
+    const qint64 start = m_renderTimer.nsecsElapsed();
+    const qint64 outerChainRenderTime = m_chainRenderTime;
+    m_chainRenderTime = 0;
+
+    call(*iterator++);
+    --iterator;
+
+    const qint64 elapsed = m_renderTimer.nsecsElapsed() - start;
+    if (index < m_activeEffectRenderTimes.count()) {
+        m_activeEffectRenderTimes[index] += elapsed - m_chainRenderTime;
+    }
+    m_chainRenderTime = outerChainRenderTime + elapsed;
+}
+
+template <typename Function>
+void EffectsHandlerImpl::callFinal(Function call)
+{
+    const qint64 start = m_renderTimer.nsecsElapsed();
+    call();
+    m_chainRenderTime += m_renderTimer.nsecsElapsed() - start;
+}
+
 // the idea is that effects call this function again which calls the next one
 void EffectsHandlerImpl::prePaintScreen(ScreenPrePaintData& data, int time)
 {
     if (m_currentPaintScreenIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintScreenIterator++)->prePaintScreen(data, time);
-        --m_currentPaintScreenIterator;
+        callEffect(m_currentPaintScreenIterator, [&](Effect *effect) {
+            effect->prePaintScreen(data, time);
+        });
     }
     // no special final code
 }
@@ -402,10 +446,14 @@ void EffectsHandlerImpl::prePaintScreen(ScreenPrePaintData& data, int time)
 void EffectsHandlerImpl::paintScreen(int mask, const QRegion &region, ScreenPaintData& data)
 {
     if (m_currentPaintScreenIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintScreenIterator++)->paintScreen(mask, region, data);
-        --m_currentPaintScreenIterator;
-    } else
-        m_scene->finalPaintScreen(mask, region, data);
+        callEffect(m_currentPaintScreenIterator, [&](Effect *effect) {
+            effect->paintScreen(mask, region, data);
+        });
+    } else {
+        callFinal([&] {
+            m_scene->finalPaintScreen(mask, region, data);
+        });
+    }
 }
 
 void EffectsHandlerImpl::paintDesktop(int desktop, int mask, QRegion region, ScreenPaintData &data)
@@ -427,8 +475,9 @@ void EffectsHandlerImpl::paintDesktop(int desktop, int mask, QRegion region, Scr
 void EffectsHandlerImpl::postPaintScreen()
 {
     if (m_currentPaintScreenIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintScreenIterator++)->postPaintScreen();
-        --m_currentPaintScreenIterator;
+        callEffect(m_currentPaintScreenIterator, [](Effect *effect) {
+            effect->postPaintScreen();
+        });
     }
     // no special final code
 }
@@ -436,8 +485,9 @@ void EffectsHandlerImpl::postPaintScreen()
 void EffectsHandlerImpl::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int time)
 {
     if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->prePaintWindow(w, data, time);
-        --m_currentPaintWindowIterator;
+        callEffect(m_currentPaintWindowIterator, [&](Effect *effect) {
+            effect->prePaintWindow(w, data, time);
+        });
     }
     // no special final code
 }
@@ -445,28 +495,36 @@ void EffectsHandlerImpl::prePaintWindow(EffectWindow* w, WindowPrePaintData& dat
 void EffectsHandlerImpl::paintWindow(EffectWindow* w, int mask, const QRegion &region, WindowPaintData& data)
 {
     if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->paintWindow(w, mask, region, data);
-        --m_currentPaintWindowIterator;
-    } else
-        m_scene->finalPaintWindow(static_cast<EffectWindowImpl*>(w), mask, region, data);
+        callEffect(m_currentPaintWindowIterator, [&](Effect *effect) {
+            effect->paintWindow(w, mask, region, data);
+        });
+    } else {
+        callFinal([&] {
+            m_scene->finalPaintWindow(static_cast<EffectWindowImpl*>(w), mask, region, data);
+        });
+    }
 }
 
 void EffectsHandlerImpl::paintEffectFrame(EffectFrame* frame, const QRegion &region, double opacity, double frameOpacity)
 {
     if (m_currentPaintEffectFrameIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintEffectFrameIterator++)->paintEffectFrame(frame, region, opacity, frameOpacity);
-        --m_currentPaintEffectFrameIterator;
+        callEffect(m_currentPaintEffectFrameIterator, [&](Effect *effect) {
+            effect->paintEffectFrame(frame, region, opacity, frameOpacity);
+        });
     } else {
-        const EffectFrameImpl* frameImpl = static_cast<const EffectFrameImpl*>(frame);
-        frameImpl->finalRender(region, opacity, frameOpacity);
+        callFinal([&] {
+            const EffectFrameImpl* frameImpl = static_cast<const EffectFrameImpl*>(frame);
+            frameImpl->finalRender(region, opacity, frameOpacity);
+        });
     }
 }
 
 void EffectsHandlerImpl::postPaintWindow(EffectWindow* w)
 {
     if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->postPaintWindow(w);
-        --m_currentPaintWindowIterator;
+        callEffect(m_currentPaintWindowIterator, [&](Effect *effect) {
+            effect->postPaintWindow(w);
+        });
     }
     // no special final code
 }
@@ -482,10 +540,14 @@ Effect *EffectsHandlerImpl::provides(Effect::Feature ef)
 void EffectsHandlerImpl::drawWindow(EffectWindow* w, int mask, const QRegion &region, WindowPaintData& data)
 {
     if (m_currentDrawWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentDrawWindowIterator++)->drawWindow(w, mask, region, data);
-        --m_currentDrawWindowIterator;
-    } else
-        m_scene->finalDrawWindow(static_cast<EffectWindowImpl*>(w), mask, region, data);
+        callEffect(m_currentDrawWindowIterator, [&](Effect *effect) {
+            effect->drawWindow(w, mask, region, data);
+        });
+    } else {
+        callFinal([&] {
+            m_scene->finalDrawWindow(static_cast<EffectWindowImpl*>(w), mask, region, data);
+        });
+    }
 }
 
 void EffectsHandlerImpl::buildQuads(EffectWindow* w, WindowQuadList& quadList)
@@ -521,19 +583,93 @@ bool EffectsHandlerImpl::decorationSupportsBlurBehind() const
 // start another painting pass
 void EffectsHandlerImpl::startPaint()
 {
+    accountPaintingPass();
+
     m_activeEffects.clear();
     m_activeEffects.reserve(loaded_effects.count());
     for(QVector< KWin::EffectPair >::const_iterator it = loaded_effects.constBegin(); it != loaded_effects.constEnd(); ++it) {
+        auto renderTime = m_effectRenderTimes.constFind(it->second);
+        if (renderTime != m_effectRenderTimes.constEnd() && renderTime->demotedFrames > 0) {
+            continue;
+        }
         if (it->second->isActive()) {
             m_activeEffects << it->second;
         }
     }
+    m_activeEffectRenderTimes.fill(0, m_activeEffects.count());
+    m_chainRenderTime = 0;
     m_currentDrawWindowIterator = m_activeEffects.constBegin();
     m_currentPaintWindowIterator = m_activeEffects.constBegin();
     m_currentPaintScreenIterator = m_activeEffects.constBegin();
     m_currentPaintEffectFrameIterator = m_activeEffects.constBegin();
 }
 
+// Adds the render times of the previous painting pass to the ones of the current frame,
+// which gets painted in one pass per screen.
+void EffectsHandlerImpl::accountPaintingPass()
+{
+    for (int i = 0; i < m_activeEffectRenderTimes.count() && i < m_activeEffects.count(); ++i) {
+        m_frameRenderTimes[m_activeEffects.at(i)] += m_activeEffectRenderTimes.at(i);
+    }
+    m_activeEffectRenderTimes.clear();
+}
+
+void EffectsHandlerImpl::finishFrame()
+{
+    accountPaintingPass();
+
+    // effects bypassed in this frame get restored once their time is over
+    for (const EffectPair &pair : qAsConst(loaded_effects)) {
+        auto renderTime = m_effectRenderTimes.find(pair.second);
+        if (renderTime == m_effectRenderTimes.end() || renderTime->demotedFrames == 0) {
+            continue;
+        }
+        if (--renderTime->demotedFrames == 0) {
+            qCDebug(KWIN_CORE) << "Restoring effect" << pair.first << "after it exceeded its render time budget";
+            m_compositor->addRepaintFull();
+        }
+    }
+
+    updateEffectRenderTimes();
+    m_frameRenderTimes.clear();
+}
+
+// Accounts the render times of the finished frame to the effects and bypasses the effects
+// which exceed their share of the frame time for a while.
+void EffectsHandlerImpl::updateEffectRenderTimes()
+{
+    // roughly five seconds at 60 Hz
+    static const int demotionFrames = 300;
+
+    const int refreshRate = qMax(m_compositor->refreshRate(), 1);
+    const qint64 budget = qint64(options->effectRenderBudget()) * 10 * 1000 * 1000 / refreshRate;
+
+    for (auto it = m_frameRenderTimes.constBegin(); it != m_frameRenderTimes.constEnd(); ++it) {
+        Effect *effect = it.key();
+        EffectRenderTime &renderTime = m_effectRenderTimes[effect];
+        const qint64 elapsed = it.value();
+        renderTime.average += (elapsed - renderTime.average) / 16;
+        renderTime.total += elapsed;
+        renderTime.frames++;
+
+        if (budget <= 0 || renderTime.frames < 16 || renderTime.average <= budget) {
+            continue;
+        }
+        // bypassing an effect which grabbed the input would leave the user stuck
+        if (effect == fullscreen_effect || effect == keyboard_grab_effect ||
+                m_grabbedMouseEffects.contains(effect)) {
+            continue;
+        }
+        auto effectIt = std::find_if(loaded_effects.constBegin(), loaded_effects.constEnd(),
+            [effect](const EffectPair &pair) { return pair.second == effect; });
+        qCWarning(KWIN_CORE) << "Bypassing effect" << (effectIt != loaded_effects.constEnd() ? effectIt->first : QString())
+                             << "as it exceeded its render time budget:" << renderTime.average << "ns per frame";
+        renderTime.average = 0;
+        renderTime.demotedFrames = demotionFrames;
+        m_compositor->addRepaintFull();
+    }
+}
+
 void EffectsHandlerImpl::slotClientMaximized(KWin::AbstractClient *c, MaximizeMode maxMode)
 {
     bool horizontal = false;
@@ -677,6 +813,16 @@ bool EffectsHandlerImpl::hasActiveFullScreenEffect() const
     return fullscreen_effect;
 }
 
+bool EffectsHandlerImpl::blocksDirectScanout() const
+{
+    for (auto it = loaded_effects.constBegin(); it != loaded_effects.constEnd(); ++it) {
+        if (it->second->isActive() && it->second->blocksDirectScanout()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool EffectsHandlerImpl::grabKeyboard(Effect* effect)
 {
     if (keyboard_grab_effect != nullptr)
@@ -1453,6 +1599,8 @@ void EffectsHandlerImpl::destroyEffect(Effect *effect)
     }
 
     stopMouseInterception(effect);
+    m_effectRenderTimes.remove(effect);
+    m_frameRenderTimes.remove(effect);
 
     const QList<QByteArray> properties = m_propertiesForEffects.keys();
     for (const QByteArray &property : properties) {
@@ -1546,6 +1694,32 @@ QStringList EffectsHandlerImpl::activeEffects() const
     return ret;
 }
 
+QStringList EffectsHandlerImpl::demotedEffects() const
+{
+    QStringList ret;
+    for (const EffectPair &pair : loaded_effects) {
+        auto it = m_effectRenderTimes.constFind(pair.second);
+        if (it != m_effectRenderTimes.constEnd() && it->demotedFrames > 0) {
+            ret << pair.first;
+        }
+    }
+    return ret;
+}
+
+double EffectsHandlerImpl::effectRenderTime(const QString &name) const
+{
+    auto it = std::find_if(loaded_effects.constBegin(), loaded_effects.constEnd(),
+        [name](const EffectPair &pair) { return pair.first == name; });
+    if (it == loaded_effects.constEnd()) {
+        return -1;
+    }
+    const EffectRenderTime renderTime = m_effectRenderTimes.value(it->second);
+    if (renderTime.frames == 0) {
+        return 0;
+    }
+    return renderTime.total / double(renderTime.frames) / (1000 * 1000);
+}
+
 KWayland::Server::Display *EffectsHandlerImpl::waylandDisplay() const
 {
     if (waylandServer()) {
@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "scene.h"
 
+#include <QElapsedTimer>
 #include <QHash>
 #include <Plasma/FrameSvg>
 
@@ -71,6 +72,10 @@ class KWIN_EXPORT EffectsHandlerImpl : public EffectsHandler
     Q_PROPERTY(QStringList activeEffects READ activeEffects)
     Q_PROPERTY(QStringList loadedEffects READ loadedEffects)
     Q_PROPERTY(QStringList listOfEffects READ listOfEffects)
+    /**
+     * The effects which are currently bypassed because they exceeded their render time budget.
+     */
+    Q_PROPERTY(QStringList demotedEffects READ demotedEffects)
 public:
     EffectsHandlerImpl(Compositor *compositor, Scene *scene);
     ~EffectsHandlerImpl() override;
@@ -153,6 +158,11 @@ public:
     void setActiveFullScreenEffect(Effect* e) override;
     Effect* activeFullScreenEffect() const override;
     bool hasActiveFullScreenEffect() const override;
+    /**
+     * Whether one of the active effects has to see every frame, so that client buffers
+     * must not be put directly on the screen.
+     */
+    bool blocksDirectScanout() const;
 
     void addRepaintFull() override;
     void addRepaint(const QRect& r) override;
@@ -206,6 +216,10 @@ public:
 
     // internal (used by kwin core or compositing code)
     void startPaint();
+    /**
+     * Called once the frame got painted on all screens, accounts its render time to the effects.
+     */
+    void finishFrame();
     void grabbedKeyboardEvent(QKeyEvent* e);
     bool hasKeyboardGrab() const;
     void desktopResized(const QSize &size);
@@ -213,6 +227,7 @@ public:
     void reloadEffect(Effect *effect) override;
     QStringList loadedEffects() const;
     QStringList listOfEffects() const;
+    QStringList demotedEffects() const;
     void unloadAllEffects();
 
     QList<EffectWindow*> elevatedWindows() const;
@@ -293,6 +308,11 @@ public Q_SLOTS:
     Q_SCRIPTABLE QList<bool> areEffectsSupported(const QStringList &names);
     Q_SCRIPTABLE QString supportInformation(const QString& name) const;
     Q_SCRIPTABLE QString debug(const QString& name, const QString& parameter = QString()) const;
+    /**
+     * @returns the average time in milliseconds the effect @p name spent painting per
+     * painting pass, or @c -1 if there is no such effect loaded.
+     */
+    Q_SCRIPTABLE double effectRenderTime(const QString &name) const;
 
 protected Q_SLOTS:
     void slotClientShown(KWin::Toplevel*);
@@ -349,9 +369,15 @@ protected:
 private:
     void registerPropertyType(long atom, bool reg);
     void destroyEffect(Effect *effect);
+    void accountPaintingPass();
+    void updateEffectRenderTimes();
 
     typedef QVector< Effect*> EffectsList;
     typedef EffectsList::const_iterator EffectsIterator;
+    template <typename Function>
+    void callEffect(EffectsIterator &iterator, Function call);
+    template <typename Function>
+    void callFinal(Function call);
     EffectsList m_activeEffects;
     EffectsIterator m_currentDrawWindowIterator;
     EffectsIterator m_currentPaintWindowIterator;
@@ -369,6 +395,21 @@ private:
     EffectLoader *m_effectLoader;
     int m_trackingCursorChanges;
     std::unique_ptr<WindowPropertyNotifyX11Filter> m_x11WindowPropertyNotify;
+
+    struct EffectRenderTime {
+        qint64 average = 0; // exponential moving average over the recent frames
+        qint64 total = 0;
+        quint64 frames = 0;
+        int demotedFrames = 0;
+    };
+    QHash<Effect *, EffectRenderTime> m_effectRenderTimes;
+    // time spent by each entry of m_activeEffects in the current painting pass
+    QVector<qint64> m_activeEffectRenderTimes;
+    // time spent by the effects in the passes of the current frame so far
+    QHash<Effect *, qint64> m_frameRenderTimes;
+    // time spent further down the effect chain by the call that is currently measured
+    qint64 m_chainRenderTime = 0;
+    QElapsedTimer m_renderTimer;
 };
 
 class EffectWindowImpl : public EffectWindow
@@ -24,6 +24,7 @@
 // KConfigSkeleton
 
 #include <QMatrix4x4>
+#include <QPainter>
 #include <QWindow>
 
 #include <KWayland/Server/surface_interface.h>
@@ -37,13 +38,17 @@ static const QByteArray s_contrastAtomName = QByteArrayLiteral("_KDE_NET_WM_BACK
 
 ContrastEffect::ContrastEffect()
 {
-    shader = ContrastShader::create();
+    if (effects->compositingType() == QPainterCompositing) {
+        m_softwareContrast = true;
+    } else {
+        shader = ContrastShader::create();
+    }
 
     reconfigure(ReconfigureAll);
 
     // ### Hackish way to announce support.
     //     Should be included in _NET_SUPPORTED instead.
-    if (shader && shader->isValid()) {
+    if (contrastSupported()) {
         net_wm_contrast_region = effects->announceSupportProperty(s_contrastAtomName, this);
         KWayland::Server::Display *display = effects->waylandDisplay();
         if (display) {
@@ -60,7 +65,7 @@ ContrastEffect::ContrastEffect()
     connect(effects, &EffectsHandler::screenGeometryChanged, this, &ContrastEffect::slotScreenGeometryChanged);
     connect(effects, &EffectsHandler::xcbConnectionChanged, this,
         [this] {
-            if (shader && shader->isValid()) {
+            if (contrastSupported()) {
                 net_wm_contrast_region = effects->announceSupportProperty(s_contrastAtomName, this);
             }
         }
@@ -96,13 +101,21 @@ void ContrastEffect::reconfigure(ReconfigureFlags flags)
     if (shader)
         shader->init();
 
-    if (!shader || !shader->isValid()) {
+    if (!contrastSupported()) {
         effects->removeSupportProperty(s_contrastAtomName, this);
         delete m_contrastManager;
         m_contrastManager = nullptr;
     }
 }
 
+bool ContrastEffect::contrastSupported() const
+{
+    if (m_softwareContrast) {
+        return true;
+    }
+    return shader && shader->isValid();
+}
+
 void ContrastEffect::updateContrastRegion(EffectWindow *w)
 {
     QRegion region;
@@ -266,6 +279,11 @@ QMatrix4x4 ContrastEffect::colorMatrix(qreal contrast, qreal intensity, qreal sa
 
 bool ContrastEffect::enabledByDefault()
 {
+    if (effects->compositingType() == QPainterCompositing) {
+        // like the blur it is computed on the CPU there, which is too expensive for a default
+        return false;
+    }
+
     GLPlatform *gl = GLPlatform::instance();
 
     if (gl->isIntel() && gl->chipClass() < SandyBridge)
@@ -279,6 +297,9 @@ bool ContrastEffect::enabledByDefault()
 
 bool ContrastEffect::supported()
 {
+    if (effects->compositingType() == QPainterCompositing) {
+        return true;
+    }
     bool supported = effects->isOpenGLCompositing() && GLRenderTarget::supported();
 
     if (supported) {
@@ -367,7 +388,7 @@ void ContrastEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, i
     if (!w->isPaintingEnabled()) {
         return;
     }
-    if (!shader || !shader->isValid()) {
+    if (!contrastSupported()) {
         return;
     }
 
@@ -409,7 +430,7 @@ void ContrastEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, i
 
 bool ContrastEffect::shouldContrast(const EffectWindow *w, int mask, const WindowPaintData &data) const
 {
-    if (!shader || !shader->isValid())
+    if (!contrastSupported())
         return false;
 
     if (effects->activeFullScreenEffect() && !w->data(WindowForceBackgroundContrastRole).toBool())
@@ -432,7 +453,7 @@ bool ContrastEffect::shouldContrast(const EffectWindow *w, int mask, const Windo
 
 void ContrastEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region, WindowPaintData &data)
 {
-    const QRect screen = GLRenderTarget::virtualScreenGeometry();
+    const QRect screen = m_softwareContrast ? effects->virtualScreenGeometry() : GLRenderTarget::virtualScreenGeometry();
     if (shouldContrast(w, mask, data)) {
         QRegion shape = region & contrastRegion(w).translated(w->pos()) & screen;
 
@@ -458,7 +479,11 @@ void ContrastEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region
         }
 
         if (!shape.isEmpty()) {
-            doContrast(w, shape, screen, data.opacity(), data.screenProjectionMatrix());
+            if (m_softwareContrast) {
+                doSoftwareContrast(w, shape & screen, data.opacity());
+            } else {
+                doContrast(w, shape, screen, data.opacity(), data.screenProjectionMatrix());
+            }
         }
     }
 
@@ -525,5 +550,61 @@ void ContrastEffect::doContrast(EffectWindow *w, const QRegion& shape, const QRe
     shader->unbind();
 }
 
-} // namespace KWin
+void ContrastEffect::doSoftwareContrast(EffectWindow *w, const QRegion &shape, const float opacity)
+{
+    QPainter *painter = effects->scenePainter();
+    if (painter->device()->devType() != QInternal::Image) {
+        return;
+    }
+    const QImage *buffer = static_cast<QImage *>(painter->device());
+    if (buffer->format() != QImage::Format_RGB32 && buffer->format() != QImage::Format_ARGB32_Premultiplied) {
+        return;
+    }
+    const QRect deviceArea = painter->deviceTransform().mapRect(shape.boundingRect()) & buffer->rect();
+    if (deviceArea.isEmpty()) {
+        return;
+    }
 
+    // The same transformation as the shader: the color is a row vector multiplied with the
+    // matrix, which is blended with the identity for translucent windows. The alpha takes
+    // part as the pixels are premultiplied, it scales the translation of the contrast.
+    QMatrix4x4 matrix = m_colorMatrices.value(w);
+    if (opacity < 1.0) {
+        matrix = opacity * matrix + (1.0 - opacity) * QMatrix4x4();
+    }
+    // in 8.8 fixed point, indexed by input and output channel in the order b, g, r, a
+    static const int channels[4] = { 2, 1, 0, 3 };
+    int coefficients[4][4];
+    for (int in = 0; in < 4; ++in) {
+        for (int out = 0; out < 4; ++out) {
+            coefficients[in][out] = qRound(matrix(channels[in], channels[out]) * 256);
+        }
+    }
+    const bool opaque = buffer->format() == QImage::Format_RGB32;
+
+    QImage contrasted(deviceArea.size(), buffer->format());
+    for (int y = 0; y < deviceArea.height(); ++y) {
+        const QRgb *src = reinterpret_cast<const QRgb *>(buffer->constScanLine(deviceArea.y() + y)) + deviceArea.x();
+        QRgb *dst = reinterpret_cast<QRgb *>(contrasted.scanLine(y));
+        for (int x = 0; x < deviceArea.width(); ++x) {
+            const int pixel[4] = { qBlue(src[x]), qGreen(src[x]), qRed(src[x]), opaque ? 255 : qAlpha(src[x]) };
+            int result[4];
+            for (int out = 0; out < 4; ++out) {
+                const int value = pixel[0] * coefficients[0][out] + pixel[1] * coefficients[1][out]
+                                + pixel[2] * coefficients[2][out] + pixel[3] * coefficients[3][out];
+                result[out] = qBound(0, (value + 128) >> 8, 255);
+            }
+            const int alpha = opaque ? 255 : result[3];
+            dst[x] = qRgba(qMin(result[2], alpha), qMin(result[1], alpha), qMin(result[0], alpha), alpha);
+        }
+    }
+
+    // replace the background like the shader does, the window is painted over it
+    painter->save();
+    painter->setClipRegion(shape, Qt::IntersectClip);
+    painter->setCompositionMode(QPainter::CompositionMode_Source);
+    painter->drawImage(painter->deviceTransform().inverted().mapRect(deviceArea), contrasted);
+    painter->restore();
+}
+
+} // namespace KWin
@@ -64,6 +64,11 @@ public:
         return 76;
     }
 
+    bool blocksDirectScanout() const override {
+        // only translucent windows get a background, an opaque fullscreen window is left alone
+        return false;
+    }
+
     bool eventFilter(QObject *watched, QEvent *event) override;
 
 public Q_SLOTS:
@@ -77,11 +82,15 @@ private:
     bool shouldContrast(const EffectWindow *w, int mask, const WindowPaintData &data) const;
     void updateContrastRegion(EffectWindow *w);
     void doContrast(EffectWindow *w, const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection);
+    void doSoftwareContrast(EffectWindow *w, const QRegion &shape, const float opacity);
+    bool contrastSupported() const;
     void uploadRegion(QVector2D *&map, const QRegion &region);
     void uploadGeometry(GLVertexBuffer *vbo, const QRegion &region);
 
 private:
-    ContrastShader *shader;
+    ContrastShader *shader = nullptr;
+    // apply the color matrix on the CPU for the QPainter compositing
+    bool m_softwareContrast = false;
     long net_wm_contrast_region;
     QRegion m_paintedArea; // actually painted area which is greater than m_damagedArea
     QRegion m_currentContrast; // keeps track of the currently contrasted area of non-caching windows(from bottom to top)
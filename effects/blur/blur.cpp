@@ -21,11 +21,13 @@
 
 #include "blur.h"
 #include "blurshader.h"
+#include "softwareblur.h"
 // KConfigSkeleton
 #include "blurconfig.h"
 
 #include <QGuiApplication>
 #include <QMatrix4x4>
+#include <QPainter>
 #include <QScreen> // for QGuiApplication
 #include <QTime>
 #include <QWindow>
@@ -46,14 +48,18 @@ static const QByteArray s_blurAtomName = QByteArrayLiteral("_KDE_NET_WM_BLUR_BEH
 BlurEffect::BlurEffect()
 {
     initConfig<BlurConfig>();
-    m_shader = new BlurShader(this);
+    if (effects->compositingType() == QPainterCompositing) {
+        m_softwareBlur = true;
+    } else {
+        m_shader = new BlurShader(this);
+    }
 
     initBlurStrengthValues();
     reconfigure(ReconfigureAll);
 
     // ### Hackish way to announce support.
     //     Should be included in _NET_SUPPORTED instead.
-    if (m_shader && m_shader->isValid() && m_renderTargetsValid) {
+    if (blurSupported()) {
         net_wm_blur_region = effects->announceSupportProperty(s_blurAtomName, this);
         KWayland::Server::Display *display = effects->waylandDisplay();
         if (display) {
@@ -70,7 +76,7 @@ BlurEffect::BlurEffect()
     connect(effects, &EffectsHandler::screenGeometryChanged, this, &BlurEffect::slotScreenGeometryChanged);
     connect(effects, &EffectsHandler::xcbConnectionChanged, this,
         [this] {
-            if (m_shader && m_shader->isValid() && m_renderTargetsValid) {
+            if (blurSupported()) {
                 net_wm_blur_region = effects->announceSupportProperty(s_blurAtomName, this);
             }
         }
@@ -105,18 +111,32 @@ bool BlurEffect::renderTargetsValid() const
         }) == m_renderTargets.cend();
 }
 
+bool BlurEffect::blurSupported() const
+{
+    if (m_softwareBlur) {
+        return true;
+    }
+    return m_shader && m_shader->isValid() && m_renderTargetsValid;
+}
+
 void BlurEffect::deleteFBOs()
 {
     qDeleteAll(m_renderTargets);
 
     m_renderTargets.clear();
     m_renderTextures.clear();
+    m_blurCache.clear();
 }
 
 void BlurEffect::updateTexture()
 {
     deleteFBOs();
 
+    if (m_softwareBlur) {
+        // the software blur allocates its images while blurring
+        return;
+    }
+
     /* Reserve memory for:
      *  - The original sized texture (1)
      *  - The downsized textures (m_downSampleIterations)
@@ -262,7 +282,7 @@ void BlurEffect::reconfigure(ReconfigureFlags flags)
 
     updateTexture();
 
-    if (!m_shader || !m_shader->isValid()) {
+    if (!m_softwareBlur && (!m_shader || !m_shader->isValid())) {
         effects->removeSupportProperty(s_blurAtomName, this);
         delete m_blurManager;
         m_blurManager = nullptr;
@@ -335,6 +355,12 @@ void BlurEffect::slotWindowAdded(EffectWindow *w)
 
 void BlurEffect::slotWindowDeleted(EffectWindow *w)
 {
+    // the cache is dropped with the next frame, when the OpenGL context is current
+    auto cacheIt = m_blurCache.find(w);
+    if (cacheIt != m_blurCache.end()) {
+        cacheIt->valid = false;
+    }
+
     auto it = windowBlurChangedConnections.find(w);
     if (it == windowBlurChangedConnections.end()) {
         return;
@@ -366,6 +392,11 @@ bool BlurEffect::eventFilter(QObject *watched, QEvent *event)
 
 bool BlurEffect::enabledByDefault()
 {
+    if (effects->compositingType() == QPainterCompositing) {
+        // like on software emulated OpenGL the blur is too expensive to be enabled by default
+        return false;
+    }
+
     GLPlatform *gl = GLPlatform::instance();
 
     if (gl->isIntel() && gl->chipClass() < SandyBridge)
@@ -379,6 +410,9 @@ bool BlurEffect::enabledByDefault()
 
 bool BlurEffect::supported()
 {
+    if (effects->compositingType() == QPainterCompositing) {
+        return true;
+    }
     bool supported = effects->isOpenGLCompositing() && GLRenderTarget::supported() && GLRenderTarget::blitSupported();
 
     if (supported) {
@@ -489,6 +523,16 @@ void BlurEffect::prePaintScreen(ScreenPrePaintData &data, int time)
     m_paintedArea = QRegion();
     m_currentBlur = QRegion();
 
+    // Drop the cached blur which got outdated during the last frame and wasn't blurred
+    // again, it would only be used after blurring everything anew.
+    for (auto it = m_blurCache.begin(); it != m_blurCache.end();) {
+        if (!it->valid) {
+            it = m_blurCache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
     effects->prePaintScreen(data, time);
 }
 
@@ -499,9 +543,14 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int t
     effects->prePaintWindow(w, data, time);
 
     if (!w->isPaintingEnabled()) {
+        // the area underneath is not tracked while the window is not painted
+        auto it = m_blurCache.find(w);
+        if (it != m_blurCache.end()) {
+            it->valid = false;
+        }
         return;
     }
-    if (!m_shader || !m_shader->isValid()) {
+    if (!m_softwareBlur && (!m_shader || !m_shader->isValid())) {
         return;
     }
 
@@ -528,6 +577,14 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int t
     const QRegion blurArea = blurRegion(w).translated(w->pos()) & screen;
     const QRegion expandedBlur = (w->isDock() ? blurArea : expand(blurArea)) & screen;
 
+    // the cached blur is outdated if a window underneath the blurred area is painted again
+    if (m_paintedArea.intersects(expandedBlur)) {
+        auto it = m_blurCache.find(w);
+        if (it != m_blurCache.end()) {
+            it->valid = false;
+        }
+    }
+
     // if this window or a window underneath the blurred area is painted again we have to
     // blur everything
     if (m_paintedArea.intersects(expandedBlur) || data.paint.intersects(blurArea)) {
@@ -555,7 +612,7 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int t
 
 bool BlurEffect::shouldBlur(const EffectWindow *w, int mask, const WindowPaintData &data) const
 {
-    if (!m_renderTargetsValid || !m_shader || !m_shader->isValid())
+    if (!blurSupported())
         return false;
 
     if (effects->activeFullScreenEffect() && !w->data(WindowForceBlurRole).toBool())
@@ -581,7 +638,7 @@ bool BlurEffect::shouldBlur(const EffectWindow *w, int mask, const WindowPaintDa
 
 void BlurEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region, WindowPaintData &data)
 {
-    const QRect screen = GLRenderTarget::virtualScreenGeometry();
+    const QRect screen = m_softwareBlur ? effects->virtualScreenGeometry() : GLRenderTarget::virtualScreenGeometry();
     if (shouldBlur(w, mask, data)) {
         QRegion shape = region & blurRegion(w).translated(w->pos()) & screen;
 
@@ -606,8 +663,23 @@ void BlurEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region, Wi
             shape = shape & region;
         }
 
+        // the background of a transformed window is not tracked, it doesn't get cached
+        BlurCache *cache = nullptr;
+        if (scaled || translated || (mask & PAINT_WINDOW_TRANSFORMED)) {
+            auto it = m_blurCache.find(w);
+            if (it != m_blurCache.end()) {
+                it->valid = false;
+            }
+        } else if (!m_softwareBlur) {
+            cache = &m_blurCache[w];
+        }
+
         if (!shape.isEmpty()) {
-            doBlur(shape, screen, data.opacity(), data.screenProjectionMatrix(), w->isDock(), w->geometry());
+            if (m_softwareBlur) {
+                doSoftwareBlur(shape, screen, data.opacity(), w->isDock());
+            } else {
+                doBlur(shape, screen, data.opacity(), data.screenProjectionMatrix(), w->isDock(), w->geometry(), cache);
+            }
         }
     }
 
@@ -618,12 +690,16 @@ void BlurEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region, Wi
 void BlurEffect::paintEffectFrame(EffectFrame *frame, const QRegion &region, double opacity, double frameOpacity)
 {
     const QRect screen = effects->virtualScreenGeometry();
-    bool valid = m_renderTargetsValid && m_shader && m_shader->isValid();
+    bool valid = blurSupported();
 
     QRegion shape = frame->geometry().adjusted(-borderSize, -borderSize, borderSize, borderSize) & screen;
 
     if (valid && !shape.isEmpty() && region.intersects(shape.boundingRect()) && frame->style() != EffectFrameNone) {
-        doBlur(shape, screen, opacity * frameOpacity, frame->screenProjectionMatrix(), false, frame->geometry());
+        if (m_softwareBlur) {
+            doSoftwareBlur(shape, screen, opacity * frameOpacity, false);
+        } else {
+            doBlur(shape, screen, opacity * frameOpacity, frame->screenProjectionMatrix(), false, frame->geometry());
+        }
     }
     effects->paintEffectFrame(frame, region, opacity, frameOpacity);
 }
@@ -655,7 +731,19 @@ void BlurEffect::generateNoiseTexture()
     m_noiseTexture.setWrapMode(GL_REPEAT);
 }
 
-void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect)
+static float blurOpacity(float opacity)
+{
+#if 1 // bow shape, always above y = x
+    float o = 1.0f-opacity;
+    o = 1.0f - o*o;
+#else // sigmoid shape, above y = x for x > 0.5, below y = x for x < 0.5
+    float o = 2.0f*opacity - 1.0f;
+    o = 0.5f + o / (1.0f + qAbs(o));
+#endif
+    return o;
+}
+
+void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect, BlurCache *cache)
 {
     // Blur would not render correctly on a secondary monitor because of wrong coordinates
     // BUG: 393723
@@ -676,53 +764,72 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
     const QRect sourceRect = expandedBlurRegion.boundingRect() & screen;
     const QRect destRect = sourceRect.translated(xTranslate, yTranslate);
 
-    GLRenderTarget::pushRenderTargets(m_renderTargetStack);
     int blurRectCount = expandedBlurRegion.rectCount() * 6;
 
-    /*
-     * If the window is a dock or panel we avoid the "extended blur" effect.
-     * Extended blur is when windows that are not under the blurred area affect
-     * the final blur result.
-     * We want to avoid this on panels, because it looks really weird and ugly
-     * when maximized windows or windows near the panel affect the dock blur.
-     */
-    if (isDock) {
-        m_renderTargets.last()->blitFromFramebuffer(sourceRect, destRect);
-
+    // nothing changed underneath since the cached blur, it only has to be drawn again
+    const bool useCache = cache && cache->valid && cache->screen == screen && (shape - cache->shape).isEmpty();
+    if (useCache) {
+        m_cacheHits++;
         if (useSRGB) {
             glEnable(GL_FRAMEBUFFER_SRGB);
         }
-
-        copyScreenSampleTexture(vbo, blurRectCount, shape.translated(xTranslate, yTranslate), screenProjection);
     } else {
-        m_renderTargets.first()->blitFromFramebuffer(sourceRect, destRect);
+        QStack<GLRenderTarget*> renderTargets = m_renderTargetStack;
+        if (cache) {
+            m_cacheMisses++;
+            if (prepareBlurCache(cache, expandedBlurRegion.boundingRect().translated(xTranslate, yTranslate))) {
+                // the last pass renders the half sized result straight into the cache
+                renderTargets.first() = cache->renderTarget.data();
+            } else {
+                cache = nullptr;
+            }
+        }
+        GLRenderTarget::pushRenderTargets(renderTargets);
+
+        /*
+         * If the window is a dock or panel we avoid the "extended blur" effect.
+         * Extended blur is when windows that are not under the blurred area affect
+         * the final blur result.
+         * We want to avoid this on panels, because it looks really weird and ugly
+         * when maximized windows or windows near the panel affect the dock blur.
+         */
+        if (isDock) {
+            m_renderTargets.last()->blitFromFramebuffer(sourceRect, destRect);
+
+            if (useSRGB) {
+                glEnable(GL_FRAMEBUFFER_SRGB);
+            }
 
-        if (useSRGB) {
-            glEnable(GL_FRAMEBUFFER_SRGB);
+            copyScreenSampleTexture(vbo, blurRectCount, shape.translated(xTranslate, yTranslate), screenProjection);
+        } else {
+            m_renderTargets.first()->blitFromFramebuffer(sourceRect, destRect);
+
+            if (useSRGB) {
+                glEnable(GL_FRAMEBUFFER_SRGB);
+            }
+
+            // Remove the m_renderTargets[0] from the top of the stack that we will not use
+            GLRenderTarget::popRenderTarget();
         }
 
-        // Remove the m_renderTargets[0] from the top of the stack that we will not use
-        GLRenderTarget::popRenderTarget();
-    }
+        downSampleTexture(vbo, blurRectCount, cache);
+        upSampleTexture(vbo, blurRectCount, cache);
 
-    downSampleTexture(vbo, blurRectCount);
-    upSampleTexture(vbo, blurRectCount);
+        if (cache) {
+            cache->shape = shape;
+            cache->screen = screen;
+            cache->valid = true;
+        }
+    }
 
     // Modulate the blurred texture with the window opacity if the window isn't opaque
     if (opacity < 1.0) {
         glEnable(GL_BLEND);
-#if 1 // bow shape, always above y = x
-        float o = 1.0f-opacity;
-        o = 1.0f - o*o;
-#else // sigmoid shape, above y = x for x > 0.5, below y = x for x < 0.5
-        float o = 2.0f*opacity - 1.0f;
-        o = 0.5f + o / (1.0f + qAbs(o));
-#endif
-        glBlendColor(0, 0, 0, o);
+        glBlendColor(0, 0, 0, blurOpacity(opacity));
         glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
     }
 
-    upscaleRenderToScreen(vbo, blurRectCount * (m_downSampleIterations + 1), shape.rectCount() * 6, screenProjection, windowRect.topLeft());
+    upscaleRenderToScreen(vbo, blurRectCount * (m_downSampleIterations + 1), shape.rectCount() * 6, screenProjection, windowRect.topLeft(), cache);
 
     if (useSRGB) {
         glDisable(GL_FRAMEBUFFER_SRGB);
@@ -735,10 +842,99 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
     vbo->unbindArrays();
 }
 
-void BlurEffect::upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, QMatrix4x4 screenProjection, QPoint windowPosition)
+void BlurEffect::doSoftwareBlur(const QRegion &shape, const QRect &screen, const float opacity, bool isDock)
+{
+    QPainter *painter = effects->scenePainter();
+    if (painter->device()->devType() != QInternal::Image) {
+        return;
+    }
+    // the pixels painted so far, they are only read
+    const QImage *buffer = static_cast<QImage *>(painter->device());
+    if (buffer->depth() != 32) {
+        return;
+    }
+
+    // docks avoid the "extended blur" like in doBlur()
+    const QRect area = (isDock ? shape.boundingRect() : expand(shape.boundingRect())) & screen;
+    const QRect deviceArea = painter->deviceTransform().mapRect(area) & buffer->rect();
+    if (deviceArea.isEmpty()) {
+        return;
+    }
+    const QImage background(buffer->constScanLine(deviceArea.y()) + deviceArea.x() * 4,
+                            deviceArea.width(), deviceArea.height(), buffer->bytesPerLine(), buffer->format());
+
+    const QImage blurred = SoftwareBlur::blur(background, m_downSampleIterations, qMax(1, m_offset));
+    if (blurred.isNull()) {
+        return;
+    }
+
+    // the last up sample pass is done by the smooth scaling
+    painter->save();
+    painter->setClipRegion(shape, Qt::IntersectClip);
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+    if (opacity < 1.0) {
+        painter->setOpacity(blurOpacity(opacity));
+    }
+    painter->drawImage(painter->deviceTransform().inverted().mapRect(deviceArea), blurred);
+    painter->restore();
+}
+
+bool BlurEffect::prepareBlurCache(BlurCache *cache, const QRect &blurRect)
+{
+    // the blurred area at half size, with a texel more for the linear filtering
+    QRect rect = QRect(QPoint(blurRect.left() / 2 - 1, blurRect.top() / 2 - 1),
+                       QPoint((blurRect.right() + 1) / 2 + 1, (blurRect.bottom() + 1) / 2 + 1))
+                 & QRect(QPoint(0, 0), m_renderTextures[1].size());
+    if (rect.isEmpty()) {
+        return false;
+    }
+
+    // Keep the texture as long as the area fits, it only grows up to the size of the
+    // complete blurred area of the window.
+    if (!cache->renderTarget || cache->texture.width() < rect.width() || cache->texture.height() < rect.height()) {
+        cache->renderTarget.reset();
+        cache->texture = GLTexture(m_renderTextures[1].internalFormat(), rect.size());
+        cache->texture.setFilter(GL_LINEAR);
+        cache->texture.setWrapMode(GL_CLAMP_TO_EDGE);
+        cache->renderTarget.reset(new GLRenderTarget(cache->texture));
+        if (!cache->renderTarget->valid()) {
+            cache->renderTarget.reset();
+            cache->texture = GLTexture();
+            cache->valid = false;
+            return false;
+        }
+    }
+    rect.setSize(cache->texture.size());
+    cache->rect = rect;
+    return true;
+}
+
+void BlurEffect::setCacheTarget(const BlurCache *cache)
+{
+    // The render target of the cache only covers a part of the half sized render texture,
+    // the geometry and the sampled texture coordinates are moved to that part.
+    const QSize size = m_renderTextures[1].size();
+    const QRect &rect = cache->rect;
+
+    QMatrix4x4 modelViewProjectionMatrix;
+    modelViewProjectionMatrix.ortho(rect.x(), rect.x() + rect.width(), rect.y() + rect.height(), rect.y(), 0, 65535);
+
+    m_shader->setModelViewProjectionMatrix(modelViewProjectionMatrix);
+    m_shader->setTargetTextureSize(size);
+    // the first row of the render targets is the bottom of the screen
+    m_shader->setTextureTransform(QVector2D(1.0, 1.0),
+                                  QVector2D(rect.x() / float(size.width()),
+                                            (size.height() - rect.y() - rect.height()) / float(size.height())));
+}
+
+void BlurEffect::upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, QMatrix4x4 screenProjection, QPoint windowPosition, BlurCache *cache)
 {
     glActiveTexture(GL_TEXTURE0);
-    m_renderTextures[1].bind();
+    if (cache) {
+        cache->texture.bind();
+    } else {
+        m_renderTextures[1].bind();
+    }
 
     if (m_noiseStrength > 0) {
         m_shader->bind(BlurShader::NoiseSampleType);
@@ -753,6 +949,16 @@ void BlurEffect::upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int bl
         m_shader->setTargetTextureSize(m_renderTextures[0].size() * GLRenderTarget::virtualScreenScale());
     }
 
+    if (cache) {
+        // the cache only holds a part of the half sized render texture
+        const QSize size = m_renderTextures[1].size();
+        const QRect &rect = cache->rect;
+        m_shader->setTextureTransform(QVector2D(size.width() / float(rect.width()), size.height() / float(rect.height())),
+                                      QVector2D(-rect.x() / float(rect.width()),
+                                                -(size.height() - rect.y() - rect.height()) / float(rect.height())));
+    } else {
+        m_shader->setTextureTransform(QVector2D(1.0, 1.0), QVector2D(0.0, 0.0));
+    }
     m_shader->setOffset(m_offset);
     m_shader->setModelViewProjectionMatrix(screenProjection);
 
@@ -763,7 +969,7 @@ void BlurEffect::upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int bl
     m_shader->unbind();
 }
 
-void BlurEffect::downSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
+void BlurEffect::downSampleTexture(GLVertexBuffer *vbo, int blurRectCount, const BlurCache *cache)
 {
     QMatrix4x4 modelViewProjectionMatrix;
 
@@ -771,11 +977,17 @@ void BlurEffect::downSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
     m_shader->setOffset(m_offset);
 
     for (int i = 1; i <= m_downSampleIterations; i++) {
-        modelViewProjectionMatrix.setToIdentity();
-        modelViewProjectionMatrix.ortho(0, m_renderTextures[i].width(), m_renderTextures[i].height(), 0 , 0, 65535);
+        if (cache && m_downSampleIterations == 1) {
+            // without up sample passes this is the last pass at half size
+            setCacheTarget(cache);
+        } else {
+            modelViewProjectionMatrix.setToIdentity();
+            modelViewProjectionMatrix.ortho(0, m_renderTextures[i].width(), m_renderTextures[i].height(), 0 , 0, 65535);
 
-        m_shader->setModelViewProjectionMatrix(modelViewProjectionMatrix);
-        m_shader->setTargetTextureSize(m_renderTextures[i].size());
+            m_shader->setModelViewProjectionMatrix(modelViewProjectionMatrix);
+            m_shader->setTargetTextureSize(m_renderTextures[i].size());
+            m_shader->setTextureTransform(QVector2D(1.0, 1.0), QVector2D(0.0, 0.0));
+        }
 
         //Copy the image from this texture
         m_renderTextures[i - 1].bind();
@@ -787,7 +999,7 @@ void BlurEffect::downSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
     m_shader->unbind();
 }
 
-void BlurEffect::upSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
+void BlurEffect::upSampleTexture(GLVertexBuffer *vbo, int blurRectCount, const BlurCache *cache)
 {
     QMatrix4x4 modelViewProjectionMatrix;
 
@@ -795,11 +1007,16 @@ void BlurEffect::upSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
     m_shader->setOffset(m_offset);
 
     for (int i = m_downSampleIterations - 1; i >= 1; i--) {
-        modelViewProjectionMatrix.setToIdentity();
-        modelViewProjectionMatrix.ortho(0, m_renderTextures[i].width(), m_renderTextures[i].height(), 0 , 0, 65535);
+        if (cache && i == 1) {
+            setCacheTarget(cache);
+        } else {
+            modelViewProjectionMatrix.setToIdentity();
+            modelViewProjectionMatrix.ortho(0, m_renderTextures[i].width(), m_renderTextures[i].height(), 0 , 0, 65535);
 
-        m_shader->setModelViewProjectionMatrix(modelViewProjectionMatrix);
-        m_shader->setTargetTextureSize(m_renderTextures[i].size());
+            m_shader->setModelViewProjectionMatrix(modelViewProjectionMatrix);
+            m_shader->setTargetTextureSize(m_renderTextures[i].size());
+            m_shader->setTextureTransform(QVector2D(1.0, 1.0), QVector2D(0.0, 0.0));
+        }
 
         //Copy the image from this texture
         m_renderTextures[i + 1].bind();
@@ -25,6 +25,8 @@
 #include <kwinglplatform.h>
 #include <kwinglutils.h>
 
+#include <QHash>
+#include <QSharedPointer>
 #include <QVector>
 #include <QVector2D>
 #include <QStack>
@@ -47,6 +49,12 @@ class BlurShader;
 class BlurEffect : public KWin::Effect
 {
     Q_OBJECT
+    /**
+     * How often the cached background of a window could be used, and how often it had to
+     * be blurred anew.
+     */
+    Q_PROPERTY(int cacheHits READ cacheHits)
+    Q_PROPERTY(int cacheMisses READ cacheMisses)
 
 public:
     BlurEffect();
@@ -67,8 +75,20 @@ public:
         return 75;
     }
 
+    bool blocksDirectScanout() const override {
+        // only translucent windows get a background, an opaque fullscreen window is left alone
+        return false;
+    }
+
     bool eventFilter(QObject *watched, QEvent *event) override;
 
+    int cacheHits() const {
+        return m_cacheHits;
+    }
+    int cacheMisses() const {
+        return m_cacheMisses;
+    }
+
 public Q_SLOTS:
     void slotWindowAdded(KWin::EffectWindow *w);
     void slotWindowDeleted(KWin::EffectWindow *w);
@@ -76,6 +96,20 @@ public Q_SLOTS:
     void slotScreenGeometryChanged();
 
 private:
+    /**
+     * The blurred background of a window from the last frame it got blurred in. It can
+     * be used as long as nothing got painted underneath the blurred area since then.
+     */
+    struct BlurCache {
+        GLTexture texture;
+        QSharedPointer<GLRenderTarget> renderTarget;
+        // the part of the half sized render texture held by the texture
+        QRect rect;
+        QRegion shape;
+        QRect screen;
+        bool valid = false;
+    };
+
     QRect expand(const QRect &rect) const;
     QRegion expand(const QRegion &region) const;
     bool renderTargetsValid() const;
@@ -85,25 +119,31 @@ private:
     QRegion blurRegion(const EffectWindow *w) const;
     bool shouldBlur(const EffectWindow *w, int mask, const WindowPaintData &data) const;
     void updateBlurRegion(EffectWindow *w) const;
-    void doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect);
+    void doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect, BlurCache *cache = nullptr);
+    void doSoftwareBlur(const QRegion &shape, const QRect &screen, const float opacity, bool isDock);
+    bool blurSupported() const;
+    bool prepareBlurCache(BlurCache *cache, const QRect &blurRect);
+    void setCacheTarget(const BlurCache *cache);
     void uploadRegion(QVector2D *&map, const QRegion &region, const int downSampleIterations);
     void uploadGeometry(GLVertexBuffer *vbo, const QRegion &blurRegion, const QRegion &windowRegion);
     void generateNoiseTexture();
 
-    void upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, QMatrix4x4 screenProjection, QPoint windowPosition);
-    void downSampleTexture(GLVertexBuffer *vbo, int blurRectCount);
-    void upSampleTexture(GLVertexBuffer *vbo, int blurRectCount);
+    void upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, QMatrix4x4 screenProjection, QPoint windowPosition, BlurCache *cache);
+    void downSampleTexture(GLVertexBuffer *vbo, int blurRectCount, const BlurCache *cache);
+    void upSampleTexture(GLVertexBuffer *vbo, int blurRectCount, const BlurCache *cache);
     void copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount, QRegion blurShape, QMatrix4x4 screenProjection);
 
 private:
-    BlurShader *m_shader;
+    BlurShader *m_shader = nullptr;
     QVector <GLRenderTarget*> m_renderTargets;
     QVector <GLTexture> m_renderTextures;
     QStack <GLRenderTarget*> m_renderTargetStack;
 
     GLTexture m_noiseTexture;
 
-    bool m_renderTargetsValid;
+    bool m_renderTargetsValid = false;
+    // blur on the CPU for the QPainter compositing
+    bool m_softwareBlur = false;
     long net_wm_blur_region;
     QRegion m_damagedArea; // keeps track of the area which has been damaged (from bottom to top)
     QRegion m_paintedArea; // actually painted area which is greater than m_damagedArea
@@ -131,6 +171,9 @@ private:
     QVector <BlurValuesStruct> blurStrengthValues;
 
     QMap <EffectWindow*, QMetaObject::Connection> windowBlurChangedConnections;
+    QHash <const EffectWindow*, BlurCache> m_blurCache;
+    int m_cacheHits = 0;
+    int m_cacheMisses = 0;
     KWayland::Server::BlurManagerInterface *m_blurManager = nullptr;
 };
 
@@ -62,7 +62,9 @@ BlurShader::BlurShader(QObject *parent)
     QString glUniformString = "uniform sampler2D texUnit;\n"
         "uniform float offset;\n"
         "uniform vec2 renderTextureSize;\n"
-        "uniform vec2 halfpixel;\n";
+        "uniform vec2 halfpixel;\n"
+        "uniform vec2 textureScale;\n"
+        "uniform vec2 textureOffset;\n";
 
     if (core) {
         glUniformString += "out vec4 fragColor;\n\n";
@@ -90,13 +92,14 @@ BlurShader::BlurShader(QObject *parent)
 
     streamFragDown << "void main(void)\n";
     streamFragDown << "{\n";
-    streamFragDown << "    vec2 uv = vec2(gl_FragCoord.xy / renderTextureSize);\n";
+    streamFragDown << "    vec2 uv = vec2(gl_FragCoord.xy / renderTextureSize) * textureScale + textureOffset;\n";
+    streamFragDown << "    vec2 texel = halfpixel * textureScale;\n";
     streamFragDown << "    \n";
     streamFragDown << "    vec4 sum = " << texture2D << "(texUnit, uv) * 4.0;\n";
-    streamFragDown << "    sum += " << texture2D << "(texUnit, uv - halfpixel.xy * offset);\n";
-    streamFragDown << "    sum += " << texture2D << "(texUnit, uv + halfpixel.xy * offset);\n";
-    streamFragDown << "    sum += " << texture2D << "(texUnit, uv + vec2(halfpixel.x, -halfpixel.y) * offset);\n";
-    streamFragDown << "    sum += " << texture2D << "(texUnit, uv - vec2(halfpixel.x, -halfpixel.y) * offset);\n";
+    streamFragDown << "    sum += " << texture2D << "(texUnit, uv - texel.xy * offset);\n";
+    streamFragDown << "    sum += " << texture2D << "(texUnit, uv + texel.xy * offset);\n";
+    streamFragDown << "    sum += " << texture2D << "(texUnit, uv + vec2(texel.x, -texel.y) * offset);\n";
+    streamFragDown << "    sum += " << texture2D << "(texUnit, uv - vec2(texel.x, -texel.y) * offset);\n";
     streamFragDown << "    \n";
     streamFragDown << "    " << fragColor << " = sum / 8.0;\n";
     streamFragDown << "}\n";
@@ -110,16 +113,17 @@ BlurShader::BlurShader(QObject *parent)
 
     streamFragUp << "void main(void)\n";
     streamFragUp << "{\n";
-    streamFragUp << "    vec2 uv = vec2(gl_FragCoord.xy / renderTextureSize);\n";
+    streamFragUp << "    vec2 uv = vec2(gl_FragCoord.xy / renderTextureSize) * textureScale + textureOffset;\n";
+    streamFragUp << "    vec2 texel = halfpixel * textureScale;\n";
     streamFragUp << "    \n";
-    streamFragUp << "    vec4 sum = " << texture2D << "(texUnit, uv + vec2(-halfpixel.x * 2.0, 0.0) * offset);\n";
-    streamFragUp << "    sum += " << texture2D << "(texUnit, uv + vec2(-halfpixel.x, halfpixel.y) * offset) * 2.0;\n";
-    streamFragUp << "    sum += " << texture2D << "(texUnit, uv + vec2(0.0, halfpixel.y * 2.0) * offset);\n";
-    streamFragUp << "    sum += " << texture2D << "(texUnit, uv + vec2(halfpixel.x, halfpixel.y) * offset) * 2.0;\n";
-    streamFragUp << "    sum += " << texture2D << "(texUnit, uv + vec2(halfpixel.x * 2.0, 0.0) * offset);\n";
-    streamFragUp << "    sum += " << texture2D << "(texUnit, uv + vec2(halfpixel.x, -halfpixel.y) * offset) * 2.0;\n";
-    streamFragUp << "    sum += " << texture2D << "(texUnit, uv + vec2(0.0, -halfpixel.y * 2.0) * offset);\n";
-    streamFragUp << "    sum += " << texture2D << "(texUnit, uv + vec2(-halfpixel.x, -halfpixel.y) * offset) * 2.0;\n";
+    streamFragUp << "    vec4 sum = " << texture2D << "(texUnit, uv + vec2(-texel.x * 2.0, 0.0) * offset);\n";
+    streamFragUp << "    sum += " << texture2D << "(texUnit, uv + vec2(-texel.x, texel.y) * offset) * 2.0;\n";
+    streamFragUp << "    sum += " << texture2D << "(texUnit, uv + vec2(0.0, texel.y * 2.0) * offset);\n";
+    streamFragUp << "    sum += " << texture2D << "(texUnit, uv + vec2(texel.x, texel.y) * offset) * 2.0;\n";
+    streamFragUp << "    sum += " << texture2D << "(texUnit, uv + vec2(texel.x * 2.0, 0.0) * offset);\n";
+    streamFragUp << "    sum += " << texture2D << "(texUnit, uv + vec2(texel.x, -texel.y) * offset) * 2.0;\n";
+    streamFragUp << "    sum += " << texture2D << "(texUnit, uv + vec2(0.0, -texel.y * 2.0) * offset);\n";
+    streamFragUp << "    sum += " << texture2D << "(texUnit, uv + vec2(-texel.x, -texel.y) * offset) * 2.0;\n";
     streamFragUp << "    \n";
     streamFragUp << "    " << fragColor << " = sum / 12.0;\n";
     streamFragUp << "}\n";
@@ -159,17 +163,18 @@ BlurShader::BlurShader(QObject *parent)
     // Upsampling + Noise
     streamFragNoise << "void main(void)\n";
     streamFragNoise << "{\n";
-    streamFragNoise << "    vec2 uv = vec2(gl_FragCoord.xy / renderTextureSize);\n";
+    streamFragNoise << "    vec2 uv = vec2(gl_FragCoord.xy / renderTextureSize) * textureScale + textureOffset;\n";
+    streamFragNoise << "    vec2 texel = halfpixel * textureScale;\n";
     streamFragNoise << "    vec2 uvNoise = vec2((texStartPos.xy + gl_FragCoord.xy) / noiseTextureSize);\n";
     streamFragNoise << "    \n";
-    streamFragNoise << "    vec4 sum = " << texture2D << "(texUnit, uv + vec2(-halfpixel.x * 2.0, 0.0) * offset);\n";
-    streamFragNoise << "    sum += " << texture2D << "(texUnit, uv + vec2(-halfpixel.x, halfpixel.y) * offset) * 2.0;\n";
-    streamFragNoise << "    sum += " << texture2D << "(texUnit, uv + vec2(0.0, halfpixel.y * 2.0) * offset);\n";
-    streamFragNoise << "    sum += " << texture2D << "(texUnit, uv + vec2(halfpixel.x, halfpixel.y) * offset) * 2.0;\n";
-    streamFragNoise << "    sum += " << texture2D << "(texUnit, uv + vec2(halfpixel.x * 2.0, 0.0) * offset);\n";
-    streamFragNoise << "    sum += " << texture2D << "(texUnit, uv + vec2(halfpixel.x, -halfpixel.y) * offset) * 2.0;\n";
-    streamFragNoise << "    sum += " << texture2D << "(texUnit, uv + vec2(0.0, -halfpixel.y * 2.0) * offset);\n";
-    streamFragNoise << "    sum += " << texture2D << "(texUnit, uv + vec2(-halfpixel.x, -halfpixel.y) * offset) * 2.0;\n";
+    streamFragNoise << "    vec4 sum = " << texture2D << "(texUnit, uv + vec2(-texel.x * 2.0, 0.0) * offset);\n";
+    streamFragNoise << "    sum += " << texture2D << "(texUnit, uv + vec2(-texel.x, texel.y) * offset) * 2.0;\n";
+    streamFragNoise << "    sum += " << texture2D << "(texUnit, uv + vec2(0.0, texel.y * 2.0) * offset);\n";
+    streamFragNoise << "    sum += " << texture2D << "(texUnit, uv + vec2(texel.x, texel.y) * offset) * 2.0;\n";
+    streamFragNoise << "    sum += " << texture2D << "(texUnit, uv + vec2(texel.x * 2.0, 0.0) * offset);\n";
+    streamFragNoise << "    sum += " << texture2D << "(texUnit, uv + vec2(texel.x, -texel.y) * offset) * 2.0;\n";
+    streamFragNoise << "    sum += " << texture2D << "(texUnit, uv + vec2(0.0, -texel.y * 2.0) * offset);\n";
+    streamFragNoise << "    sum += " << texture2D << "(texUnit, uv + vec2(-texel.x, -texel.y) * offset) * 2.0;\n";
     streamFragNoise << "    \n";
     streamFragNoise << "    " << fragColor << " = sum / 12.0 - (vec4(0.5, 0.5, 0.5, 0) - vec4(" << texture2D << "(noiseTexUnit, uvNoise).rrr, 0));\n";
     streamFragNoise << "}\n";
@@ -191,11 +196,15 @@ BlurShader::BlurShader(QObject *parent)
         m_offsetLocationDownsample = m_shaderDownsample->uniformLocation("offset");
         m_renderTextureSizeLocationDownsample = m_shaderDownsample->uniformLocation("renderTextureSize");
         m_halfpixelLocationDownsample = m_shaderDownsample->uniformLocation("halfpixel");
+        m_textureScaleLocationDownsample = m_shaderDownsample->uniformLocation("textureScale");
+        m_textureOffsetLocationDownsample = m_shaderDownsample->uniformLocation("textureOffset");
 
         m_mvpMatrixLocationUpsample = m_shaderUpsample->uniformLocation("modelViewProjectionMatrix");
         m_offsetLocationUpsample = m_shaderUpsample->uniformLocation("offset");
         m_renderTextureSizeLocationUpsample = m_shaderUpsample->uniformLocation("renderTextureSize");
         m_halfpixelLocationUpsample = m_shaderUpsample->uniformLocation("halfpixel");
+        m_textureScaleLocationUpsample = m_shaderUpsample->uniformLocation("textureScale");
+        m_textureOffsetLocationUpsample = m_shaderUpsample->uniformLocation("textureOffset");
 
         m_mvpMatrixLocationCopysample = m_shaderCopysample->uniformLocation("modelViewProjectionMatrix");
         m_renderTextureSizeLocationCopysample = m_shaderCopysample->uniformLocation("renderTextureSize");
@@ -207,6 +216,8 @@ BlurShader::BlurShader(QObject *parent)
         m_noiseTextureSizeLocationNoisesample = m_shaderNoisesample->uniformLocation("noiseTextureSize");
         m_texStartPosLocationNoisesample = m_shaderNoisesample->uniformLocation("texStartPos");
         m_halfpixelLocationNoisesample = m_shaderNoisesample->uniformLocation("halfpixel");
+        m_textureScaleLocationNoisesample = m_shaderNoisesample->uniformLocation("textureScale");
+        m_textureOffsetLocationNoisesample = m_shaderNoisesample->uniformLocation("textureOffset");
 
         QMatrix4x4 modelViewProjection;
         const QSize screenSize = effects->virtualScreenSize();
@@ -218,6 +229,8 @@ BlurShader::BlurShader(QObject *parent)
         m_shaderDownsample->setUniform(m_offsetLocationDownsample, float(1.0));
         m_shaderDownsample->setUniform(m_renderTextureSizeLocationDownsample, QVector2D(1.0, 1.0));
         m_shaderDownsample->setUniform(m_halfpixelLocationDownsample, QVector2D(1.0, 1.0));
+        m_shaderDownsample->setUniform(m_textureScaleLocationDownsample, QVector2D(1.0, 1.0));
+        m_shaderDownsample->setUniform(m_textureOffsetLocationDownsample, QVector2D(0.0, 0.0));
         ShaderManager::instance()->popShader();
 
         ShaderManager::instance()->pushShader(m_shaderUpsample.data());
@@ -225,6 +238,8 @@ BlurShader::BlurShader(QObject *parent)
         m_shaderUpsample->setUniform(m_offsetLocationUpsample, float(1.0));
         m_shaderUpsample->setUniform(m_renderTextureSizeLocationUpsample, QVector2D(1.0, 1.0));
         m_shaderUpsample->setUniform(m_halfpixelLocationUpsample, QVector2D(1.0, 1.0));
+        m_shaderUpsample->setUniform(m_textureScaleLocationUpsample, QVector2D(1.0, 1.0));
+        m_shaderUpsample->setUniform(m_textureOffsetLocationUpsample, QVector2D(0.0, 0.0));
         ShaderManager::instance()->popShader();
 
         ShaderManager::instance()->pushShader(m_shaderCopysample.data());
@@ -240,6 +255,8 @@ BlurShader::BlurShader(QObject *parent)
         m_shaderNoisesample->setUniform(m_noiseTextureSizeLocationNoisesample, QVector2D(1.0, 1.0));
         m_shaderNoisesample->setUniform(m_texStartPosLocationNoisesample, QVector2D(1.0, 1.0));
         m_shaderNoisesample->setUniform(m_halfpixelLocationNoisesample, QVector2D(1.0, 1.0));
+        m_shaderNoisesample->setUniform(m_textureScaleLocationNoisesample, QVector2D(1.0, 1.0));
+        m_shaderNoisesample->setUniform(m_textureOffsetLocationNoisesample, QVector2D(0.0, 0.0));
 
         glUniform1i(m_shaderNoisesample->uniformLocation("texUnit"), 0);
         glUniform1i(m_shaderNoisesample->uniformLocation("noiseTexUnit"), 1);
@@ -375,6 +392,52 @@ void BlurShader::setTargetTextureSize(const QSize &renderTextureSize)
     }
 }
 
+void BlurShader::setTextureTransform(const QVector2D &scale, const QVector2D &offset)
+{
+    if (!isValid()) {
+        return;
+    }
+
+    switch (m_activeSampleType) {
+    case UpSampleType:
+        if (scale == m_textureScaleUpsample && offset == m_textureOffsetUpsample) {
+            return;
+        }
+
+        m_textureScaleUpsample = scale;
+        m_textureOffsetUpsample = offset;
+        m_shaderUpsample->setUniform(m_textureScaleLocationUpsample, scale);
+        m_shaderUpsample->setUniform(m_textureOffsetLocationUpsample, offset);
+        break;
+
+    case DownSampleType:
+        if (scale == m_textureScaleDownsample && offset == m_textureOffsetDownsample) {
+            return;
+        }
+
+        m_textureScaleDownsample = scale;
+        m_textureOffsetDownsample = offset;
+        m_shaderDownsample->setUniform(m_textureScaleLocationDownsample, scale);
+        m_shaderDownsample->setUniform(m_textureOffsetLocationDownsample, offset);
+        break;
+
+    case NoiseSampleType:
+        if (scale == m_textureScaleNoisesample && offset == m_textureOffsetNoisesample) {
+            return;
+        }
+
+        m_textureScaleNoisesample = scale;
+        m_textureOffsetNoisesample = offset;
+        m_shaderNoisesample->setUniform(m_textureScaleLocationNoisesample, scale);
+        m_shaderNoisesample->setUniform(m_textureOffsetLocationNoisesample, offset);
+        break;
+
+    default:
+        Q_UNREACHABLE();
+        break;
+    }
+}
+
 void BlurShader::setNoiseTextureSize(const QSize &noiseTextureSize)
 {
     const QVector2D noiseTexSize(noiseTextureSize.width(), noiseTextureSize.height());
@@ -55,6 +55,13 @@ public:
     void setModelViewProjectionMatrix(const QMatrix4x4 &matrix);
     void setOffset(float offset);
     void setTargetTextureSize(const QSize &renderTextureSize);
+    /**
+     * The texture coordinates are computed from the fragment coordinates divided by
+     * the target texture size, multiplied with @p scale and moved by @p offset. This
+     * is used when either the render target or the sampled texture only covers a
+     * part of the screen.
+     */
+    void setTextureTransform(const QVector2D &scale, const QVector2D &offset);
     void setNoiseTextureSize(const QSize &noiseTextureSize);
     void setTexturePosition(const QPoint &texPos);
     void setBlurRect(const QRect &blurRect, const QSize &screenSize);
@@ -69,11 +76,15 @@ private:
     int m_offsetLocationDownsample;
     int m_renderTextureSizeLocationDownsample;
     int m_halfpixelLocationDownsample;
+    int m_textureScaleLocationDownsample;
+    int m_textureOffsetLocationDownsample;
 
     int m_mvpMatrixLocationUpsample;
     int m_offsetLocationUpsample;
     int m_renderTextureSizeLocationUpsample;
     int m_halfpixelLocationUpsample;
+    int m_textureScaleLocationUpsample;
+    int m_textureOffsetLocationUpsample;
 
     int m_mvpMatrixLocationCopysample;
     int m_renderTextureSizeLocationCopysample;
@@ -85,21 +96,29 @@ private:
     int m_noiseTextureSizeLocationNoisesample;
     int m_texStartPosLocationNoisesample;
     int m_halfpixelLocationNoisesample;
+    int m_textureScaleLocationNoisesample;
+    int m_textureOffsetLocationNoisesample;
 
     //Caching uniform values to aviod unnecessary setUniform calls
     int m_activeSampleType = -1;
 
     float m_offsetDownsample = 0.0;
     QMatrix4x4 m_matrixDownsample;
+    QVector2D m_textureScaleDownsample = QVector2D(1.0, 1.0);
+    QVector2D m_textureOffsetDownsample;
 
     float m_offsetUpsample = 0.0;
     QMatrix4x4 m_matrixUpsample;
+    QVector2D m_textureScaleUpsample = QVector2D(1.0, 1.0);
+    QVector2D m_textureOffsetUpsample;
 
     QMatrix4x4 m_matrixCopysample;
 
     float m_offsetNoisesample = 0.0;
     QVector2D m_noiseTextureSizeNoisesample;
     QMatrix4x4 m_matrixNoisesample;
+    QVector2D m_textureScaleNoisesample = QVector2D(1.0, 1.0);
+    QVector2D m_textureOffsetNoisesample;
 
     bool m_valid = false;
 
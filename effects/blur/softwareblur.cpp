@@ -0,0 +1,266 @@
+/*
+ *   Copyright © 2020 The KWin developers <kwin@kde.org>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "softwareblur.h"
+
+#include <QVector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace KWin
+{
+
+/*
+ * The taps of a pass are looked up in tables of clamped column indices and row pointers,
+ * the filter loops are free of branches. The channels are summed up in 16 bit, the largest
+ * sum is 12 * 255 for the up sample pass.
+ */
+
+static inline int clamped(int value, int size)
+{
+    return qBound(0, value, size - 1);
+}
+
+static inline const quint32 *row(const QImage &image, int y)
+{
+    return reinterpret_cast<const quint32 *>(image.constScanLine(clamped(y, image.height())));
+}
+
+#if defined(__SSE2__)
+// two pixels with a 16 bit lane per channel
+static inline __m128i pixels(quint32 a, quint32 b)
+{
+    const __m128i packed = _mm_unpacklo_epi32(_mm_cvtsi32_si128(a), _mm_cvtsi32_si128(b));
+    return _mm_unpacklo_epi8(packed, _mm_setzero_si128());
+}
+
+static inline void store(quint32 *destination, __m128i sum)
+{
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(destination), _mm_packus_epi16(sum, sum));
+}
+#elif defined(__ARM_NEON)
+static inline uint16x8_t pixels(quint32 a, quint32 b)
+{
+    return vmovl_u8(vcreate_u8(quint64(a) | (quint64(b) << 32)));
+}
+
+static inline void store(quint32 *destination, uint16x8_t sum)
+{
+    vst1_u8(reinterpret_cast<uint8_t *>(destination), vmovn_u16(sum));
+}
+#endif
+
+// the rounded down sample sum of eight divided by eight
+static inline quint32 downSampleChannel(quint32 sum)
+{
+    return (sum + 4) >> 3;
+}
+
+// the rounded up sample sum of twelve divided by twelve, (x * 5462) >> 16 equals x / 12 for the sums
+static inline quint32 upSampleChannel(quint32 sum)
+{
+    return ((sum + 6) * 5462) >> 16;
+}
+
+/*
+ * The up sample shader samples around the center of the destination pixel, which lies at
+ * (x + 0.5) / 2 - 0.5 in source texels. Its taps on the axes are offset / 2 and the diagonal
+ * ones offset / 4 source texels away, so all taps lie on a quarter texel. This returns the
+ * source texel closest to the tap @p quarterTexels quarter texels away from destination
+ * pixel @p x, negative positions are clamped to the first texel anyway.
+ */
+static inline int upSampleTap(int x, int quarterTexels)
+{
+    return (2 * x + 1 + quarterTexels) / 4;
+}
+
+template <typename Tap, typename Channel>
+static inline quint32 filterPixel(Tap tap, Channel channel)
+{
+    quint32 result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        result |= channel(tap(shift)) << shift;
+    }
+    return result;
+}
+
+void SoftwareBlur::downSample(const QImage &source, QImage &destination, int offset)
+{
+    const int sourceWidth = source.width();
+    const int width = destination.width();
+
+    // the 2x2 block under the destination pixel and the pixels diagonally offset from it
+    QVector<int> left(width), right(width), outerLeft(width), outerRight(width);
+    for (int x = 0; x < width; ++x) {
+        left[x] = clamped(2 * x, sourceWidth);
+        right[x] = clamped(2 * x + 1, sourceWidth);
+        outerLeft[x] = clamped(2 * x - offset, sourceWidth);
+        outerRight[x] = clamped(2 * x + 1 + offset, sourceWidth);
+    }
+
+    for (int y = 0; y < destination.height(); ++y) {
+        const quint32 *top = row(source, 2 * y);
+        const quint32 *bottom = row(source, 2 * y + 1);
+        const quint32 *outerTop = row(source, 2 * y - offset);
+        const quint32 *outerBottom = row(source, 2 * y + 1 + offset);
+        quint32 *out = reinterpret_cast<quint32 *>(destination.scanLine(y));
+
+        int x = 0;
+#if defined(__SSE2__)
+        for (; x + 1 < width; x += 2) {
+            const int a = x, b = x + 1;
+            __m128i sum = pixels(top[left[a]], top[left[b]]);
+            sum = _mm_add_epi16(sum, pixels(top[right[a]], top[right[b]]));
+            sum = _mm_add_epi16(sum, pixels(bottom[left[a]], bottom[left[b]]));
+            sum = _mm_add_epi16(sum, pixels(bottom[right[a]], bottom[right[b]]));
+            sum = _mm_add_epi16(sum, pixels(outerTop[outerLeft[a]], outerTop[outerLeft[b]]));
+            sum = _mm_add_epi16(sum, pixels(outerTop[outerRight[a]], outerTop[outerRight[b]]));
+            sum = _mm_add_epi16(sum, pixels(outerBottom[outerLeft[a]], outerBottom[outerLeft[b]]));
+            sum = _mm_add_epi16(sum, pixels(outerBottom[outerRight[a]], outerBottom[outerRight[b]]));
+            sum = _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(4)), 3);
+            store(out + x, sum);
+        }
+#elif defined(__ARM_NEON)
+        for (; x + 1 < width; x += 2) {
+            const int a = x, b = x + 1;
+            uint16x8_t sum = pixels(top[left[a]], top[left[b]]);
+            sum = vaddq_u16(sum, pixels(top[right[a]], top[right[b]]));
+            sum = vaddq_u16(sum, pixels(bottom[left[a]], bottom[left[b]]));
+            sum = vaddq_u16(sum, pixels(bottom[right[a]], bottom[right[b]]));
+            sum = vaddq_u16(sum, pixels(outerTop[outerLeft[a]], outerTop[outerLeft[b]]));
+            sum = vaddq_u16(sum, pixels(outerTop[outerRight[a]], outerTop[outerRight[b]]));
+            sum = vaddq_u16(sum, pixels(outerBottom[outerLeft[a]], outerBottom[outerLeft[b]]));
+            sum = vaddq_u16(sum, pixels(outerBottom[outerRight[a]], outerBottom[outerRight[b]]));
+            sum = vrshrq_n_u16(sum, 3);
+            store(out + x, sum);
+        }
+#endif
+        for (; x < width; ++x) {
+            out[x] = filterPixel([&](int shift) {
+                auto channel = [shift](quint32 pixel) {
+                    return (pixel >> shift) & 0xff;
+                };
+                return channel(top[left[x]]) + channel(top[right[x]])
+                    + channel(bottom[left[x]]) + channel(bottom[right[x]])
+                    + channel(outerTop[outerLeft[x]]) + channel(outerTop[outerRight[x]])
+                    + channel(outerBottom[outerLeft[x]]) + channel(outerBottom[outerRight[x]]);
+            }, downSampleChannel);
+        }
+    }
+}
+
+void SoftwareBlur::upSample(const QImage &source, QImage &destination, int offset)
+{
+    const int sourceWidth = source.width();
+    const int width = destination.width();
+
+    // the taps half the offset away on the axes and the ones a quarter of it away diagonally
+    QVector<int> center(width), farLeft(width), farRight(width), nearLeft(width), nearRight(width);
+    for (int x = 0; x < width; ++x) {
+        center[x] = clamped(upSampleTap(x, 0), sourceWidth);
+        farLeft[x] = clamped(upSampleTap(x, -2 * offset), sourceWidth);
+        farRight[x] = clamped(upSampleTap(x, 2 * offset), sourceWidth);
+        nearLeft[x] = clamped(upSampleTap(x, -offset), sourceWidth);
+        nearRight[x] = clamped(upSampleTap(x, offset), sourceWidth);
+    }
+
+    for (int y = 0; y < destination.height(); ++y) {
+        const quint32 *middle = row(source, upSampleTap(y, 0));
+        const quint32 *farTop = row(source, upSampleTap(y, -2 * offset));
+        const quint32 *farBottom = row(source, upSampleTap(y, 2 * offset));
+        const quint32 *nearTop = row(source, upSampleTap(y, -offset));
+        const quint32 *nearBottom = row(source, upSampleTap(y, offset));
+        quint32 *out = reinterpret_cast<quint32 *>(destination.scanLine(y));
+
+        int x = 0;
+#if defined(__SSE2__)
+        for (; x + 1 < width; x += 2) {
+            const int a = x, b = x + 1;
+            __m128i diagonal = pixels(nearTop[nearLeft[a]], nearTop[nearLeft[b]]);
+            diagonal = _mm_add_epi16(diagonal, pixels(nearTop[nearRight[a]], nearTop[nearRight[b]]));
+            diagonal = _mm_add_epi16(diagonal, pixels(nearBottom[nearLeft[a]], nearBottom[nearLeft[b]]));
+            diagonal = _mm_add_epi16(diagonal, pixels(nearBottom[nearRight[a]], nearBottom[nearRight[b]]));
+            __m128i sum = _mm_slli_epi16(diagonal, 1);
+            sum = _mm_add_epi16(sum, pixels(middle[farLeft[a]], middle[farLeft[b]]));
+            sum = _mm_add_epi16(sum, pixels(middle[farRight[a]], middle[farRight[b]]));
+            sum = _mm_add_epi16(sum, pixels(farTop[center[a]], farTop[center[b]]));
+            sum = _mm_add_epi16(sum, pixels(farBottom[center[a]], farBottom[center[b]]));
+            sum = _mm_mulhi_epu16(_mm_add_epi16(sum, _mm_set1_epi16(6)), _mm_set1_epi16(5462));
+            store(out + x, sum);
+        }
+#elif defined(__ARM_NEON)
+        for (; x + 1 < width; x += 2) {
+            const int a = x, b = x + 1;
+            uint16x8_t diagonal = pixels(nearTop[nearLeft[a]], nearTop[nearLeft[b]]);
+            diagonal = vaddq_u16(diagonal, pixels(nearTop[nearRight[a]], nearTop[nearRight[b]]));
+            diagonal = vaddq_u16(diagonal, pixels(nearBottom[nearLeft[a]], nearBottom[nearLeft[b]]));
+            diagonal = vaddq_u16(diagonal, pixels(nearBottom[nearRight[a]], nearBottom[nearRight[b]]));
+            uint16x8_t sum = vshlq_n_u16(diagonal, 1);
+            sum = vaddq_u16(sum, pixels(middle[farLeft[a]], middle[farLeft[b]]));
+            sum = vaddq_u16(sum, pixels(middle[farRight[a]], middle[farRight[b]]));
+            sum = vaddq_u16(sum, pixels(farTop[center[a]], farTop[center[b]]));
+            sum = vaddq_u16(sum, pixels(farBottom[center[a]], farBottom[center[b]]));
+            sum = vaddq_u16(sum, vdupq_n_u16(6));
+            const uint16x4_t low = vshrn_n_u32(vmull_u16(vget_low_u16(sum), vdup_n_u16(5462)), 16);
+            const uint16x4_t high = vshrn_n_u32(vmull_u16(vget_high_u16(sum), vdup_n_u16(5462)), 16);
+            store(out + x, vcombine_u16(low, high));
+        }
+#endif
+        for (; x < width; ++x) {
+            out[x] = filterPixel([&](int shift) {
+                auto channel = [shift](quint32 pixel) {
+                    return (pixel >> shift) & 0xff;
+                };
+                const quint32 diagonal = channel(nearTop[nearLeft[x]]) + channel(nearTop[nearRight[x]])
+                    + channel(nearBottom[nearLeft[x]]) + channel(nearBottom[nearRight[x]]);
+                return 2 * diagonal
+                    + channel(middle[farLeft[x]]) + channel(middle[farRight[x]])
+                    + channel(farTop[center[x]]) + channel(farBottom[center[x]]);
+            }, upSampleChannel);
+        }
+    }
+}
+
+QImage SoftwareBlur::blur(const QImage &image, int iterations, int offset)
+{
+    Q_ASSERT(image.depth() == 32);
+    if (image.isNull() || iterations < 1) {
+        return QImage();
+    }
+
+    // the same passes as the OpenGL blur, the last up sample pass is done by the caller
+    QVector<QImage> levels;
+    levels.reserve(iterations + 1);
+    levels.append(image);
+    for (int i = 1; i <= iterations; ++i) {
+        QImage level(downSampledSize(levels.last().size()), image.format());
+        downSample(levels.last(), level, offset);
+        levels.append(level);
+    }
+    for (int i = iterations - 1; i >= 1; --i) {
+        upSample(levels[i + 1], levels[i], offset);
+    }
+    return levels[1];
+}
+
+} // namespace KWin
@@ -0,0 +1,63 @@
+/*
+ *   Copyright © 2020 The KWin developers <kwin@kde.org>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef SOFTWAREBLUR_H
+#define SOFTWAREBLUR_H
+
+#include <QImage>
+
+namespace KWin
+{
+
+/**
+ * The dual Kawase blur of the blur effect, computed on the CPU for the QPainter compositing.
+ *
+ * The images have to be in a 32 bit format, all four channels are filtered the same way.
+ * The filter passes process two pixels at once with SSE2 or NEON where available.
+ */
+class SoftwareBlur
+{
+public:
+    /**
+     * Blurs @p image with @p iterations down and up sample passes, sampling @p offset pixels
+     * apart. Like the OpenGL blur the result is returned at half the size of @p image, it is
+     * meant to be scaled up while drawing it.
+     */
+    static QImage blur(const QImage &image, int iterations, int offset);
+
+    /**
+     * Renders @p source into @p destination at half its size. The sizes are rounded up.
+     */
+    static void downSample(const QImage &source, QImage &destination, int offset);
+    /**
+     * Renders @p source into @p destination at twice its size.
+     */
+    static void upSample(const QImage &source, QImage &destination, int offset);
+
+    /**
+     * @returns the size of @p size after a down sample pass
+     */
+    static QSize downSampledSize(const QSize &size) {
+        return QSize((size.width() + 1) / 2, (size.height() + 1) / 2);
+    }
+};
+
+} // namespace KWin
+
+#endif
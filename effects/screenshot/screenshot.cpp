@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <kwinxrenderutils.h>
 #include <QtConcurrentRun>
 #include <QDataStream>
+#include <QFutureWatcher>
 #include <QTemporaryFile>
 #include <QDir>
 #include <QDBusConnection>
@@ -35,6 +36,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <KLocalizedString>
 #include <KNotification>
 
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 
 namespace KWin
@@ -50,6 +54,16 @@ const static QString s_errorInvalidArea = QStringLiteral("org.kde.kwin.Screensho
 const static QString s_errorInvalidAreaMsg = QStringLiteral("Invalid area requested");
 const static QString s_errorInvalidScreen = QStringLiteral("org.kde.kwin.Screenshot.Error.InvalidScreen");
 const static QString s_errorInvalidScreenMsg = QStringLiteral("Invalid screen requested");
+const static QString s_errorAlreadyStreaming = QStringLiteral("org.kde.kwin.Screenshot.Error.AlreadyStreaming");
+const static QString s_errorAlreadyStreamingMsg = QStringLiteral("A screen is already being streamed");
+const static QString s_errorUnsupported = QStringLiteral("org.kde.kwin.Screenshot.Error.Unsupported");
+const static QString s_errorUnsupportedMsg = QStringLiteral("Streaming is not supported by the compositing backend");
+// frames of a stream which are read back or waiting to be written, further frames get dropped
+static const int s_maxQueuedStreamFrames = 2;
+// how long the reading side of a stream may block it, in milliseconds
+static const int s_streamWriteTimeout = 1000;
+// how often pending readbacks are polled when no frames get painted, in milliseconds
+static const int s_idleReadbackInterval = 16;
 
 bool ScreenShotEffect::supported()
 {
@@ -62,11 +76,32 @@ ScreenShotEffect::ScreenShotEffect()
 {
     connect(effects, &EffectsHandler::windowClosed, this, &ScreenShotEffect::windowClosed);
     QDBusConnection::sessionBus().registerObject(QStringLiteral("/Screenshot"), this, QDBusConnection::ExportScriptableContents);
+
+    // the readbacks are polled after every frame, the timer only covers an idle screen
+    m_readbackTimer.setSingleShot(true);
+    m_readbackTimer.setInterval(s_idleReadbackInterval);
+    connect(&m_readbackTimer, &QTimer::timeout, this,
+        [this] {
+            if (effects->makeOpenGLContextCurrent()) {
+                finishReadbacks();
+                effects->doneOpenGLContextCurrent();
+            }
+        }
+    );
+    m_streamPool.setMaxThreadCount(1);
 }
 
 ScreenShotEffect::~ScreenShotEffect()
 {
     QDBusConnection::sessionBus().unregisterObject(QStringLiteral("/Screenshot"));
+    if (!m_readbacks.isEmpty()) {
+        effects->makeOpenGLContextCurrent();
+        m_readbacks.clear();
+        effects->doneOpenGLContextCurrent();
+    }
+    // the writes time out, so a reading side which doesn't read can't block this
+    stopStream();
+    m_streamPool.waitForDone();
 }
 
 #ifdef KWIN_HAVE_XRENDER_COMPOSITING
@@ -156,6 +191,76 @@ static xcb_pixmap_t xpixmapFromImage(const QImage &image)
     return pixmap;
 }
 
+static void writeImage(int fd, const QImage &img)
+{
+    QFile file;
+    if (file.open(fd, QIODevice::WriteOnly, QFileDevice::AutoCloseHandle)) {
+        QDataStream ds(&file);
+        ds << img;
+        file.close();
+    } else {
+        close(fd);
+    }
+}
+
+static bool writeStreamFrame(int fd, const QImage &img)
+{
+    QByteArray data;
+    QDataStream ds(&data, QIODevice::WriteOnly);
+    ds << img;
+    if (ds.status() != QDataStream::Ok) {
+        return false;
+    }
+    // the fd is non-blocking, a reading side which stops reading fails the stream
+    const char *bytes = data.constData();
+    qint64 remaining = data.size();
+    while (remaining > 0) {
+        const ssize_t written = write(fd, bytes, remaining);
+        if (written > 0) {
+            bytes += written;
+            remaining -= written;
+            continue;
+        }
+        if (written == -1 && errno == EINTR) {
+            continue;
+        }
+        if (written == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            pollfd pfd = {fd, POLLOUT, 0};
+            if (poll(&pfd, 1, s_streamWriteTimeout) > 0 && !(pfd.revents & (POLLERR | POLLHUP))) {
+                continue;
+            }
+        }
+        return false;
+    }
+    return true;
+}
+
+static QString saveTempImage(const QImage &img)
+{
+    if (img.isNull()) {
+        return QString();
+    }
+    QTemporaryFile temp(QDir::tempPath() + QDir::separator() + QLatin1String("kwin_screenshot_XXXXXX.png"));
+    temp.setAutoRemove(false);
+    if (!temp.open()) {
+        return QString();
+    }
+    img.save(&temp);
+    temp.close();
+    return temp.fileName();
+}
+
+static QImage convertReadback(const QImage &raw, const QImage &cursor, const QPoint &cursorPos)
+{
+    // OpenGL returns the rows bottom to top
+    QImage img = raw.mirrored().convertToFormat(QImage::Format_ARGB32);
+    if (!cursor.isNull()) {
+        QPainter painter(&img);
+        painter.drawImage(cursorPos, cursor);
+    }
+    return img;
+}
+
 void ScreenShotEffect::paintScreen(int mask, const QRegion &region, ScreenPaintData &data)
 {
     m_cachedOutputGeometry = data.outputGeometry();
@@ -165,6 +270,9 @@ void ScreenShotEffect::paintScreen(int mask, const QRegion &region, ScreenPaintD
 void ScreenShotEffect::postPaintScreen()
 {
     effects->postPaintScreen();
+    if (!m_readbacks.isEmpty()) {
+        finishReadbacks();
+    }
     if (m_scheduledScreenshot) {
         WindowPaintData d(m_scheduledScreenshot);
         double left = 0;
@@ -211,10 +319,12 @@ void ScreenShotEffect::postPaintScreen()
         if (validTarget) {
             d.setXTranslation(-m_scheduledScreenshot->x() - left);
             d.setYTranslation(-m_scheduledScreenshot->y() - top);
+            const QPoint origin(m_scheduledScreenshot->x() + left, m_scheduledScreenshot->y() + top);
 
             // render window into offscreen texture
             int mask = PAINT_WINDOW_TRANSFORMED | PAINT_WINDOW_TRANSLUCENT;
             QImage img;
+            bool pending = false;
             if (effects->isOpenGLCompositing()) {
                 GLRenderTarget::pushRenderTarget(target.data());
                 glClearColor(0.0, 0.0, 0.0, 0.0);
@@ -227,11 +337,22 @@ void ScreenShotEffect::postPaintScreen()
 
                 effects->drawWindow(m_scheduledScreenshot, mask, infiniteRegion(), d);
 
-                // copy content from framebuffer into image
-                img = QImage(QSize(width, height), QImage::Format_ARGB32);
-                glReadnPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, img.sizeInBytes(), (GLvoid*)img.bits());
+                if (GLAsyncReadback::supported()) {
+                    // the image gets sent once the GPU delivered the pixels
+                    const WindowMode mode = m_windowMode;
+                    startReadback(QRect(0, 0, width, height), origin, m_type & INCLUDE_CURSOR,
+                        [this, mode] (const QImage &img) {
+                            sendWindowImage(img, mode);
+                        }
+                    );
+                    pending = true;
+                } else {
+                    // copy content from framebuffer into image
+                    img = QImage(QSize(width, height), QImage::Format_ARGB32);
+                    glReadnPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, img.sizeInBytes(), (GLvoid*)img.bits());
+                    ScreenShotEffect::convertFromGLImage(img, width, height);
+                }
                 GLRenderTarget::popRenderTarget();
-                ScreenShotEffect::convertFromGLImage(img, width, height);
             }
 #ifdef KWIN_HAVE_XRENDER_COMPOSITING
             xcb_image_t *xImage = nullptr;
@@ -245,30 +366,11 @@ void ScreenShotEffect::postPaintScreen()
             }
 #endif
 
-            if (m_type & INCLUDE_CURSOR) {
-                grabPointerImage(img, m_scheduledScreenshot->x() + left, m_scheduledScreenshot->y() + top);
-            }
-
-            if (m_windowMode == WindowMode::Xpixmap) {
-                const xcb_pixmap_t xpix = xpixmapFromImage(img);
-                emit screenshotCreated(xpix);
-                m_windowMode = WindowMode::NoCapture;
-            } else if (m_windowMode == WindowMode::File) {
-                sendReplyImage(img);
-            } else if (m_windowMode == WindowMode::FileDescriptor) {
-                QtConcurrent::run(
-                    [] (int fd, const QImage &img) {
-                        QFile file;
-                        if (file.open(fd, QIODevice::WriteOnly, QFileDevice::AutoCloseHandle)) {
-                            QDataStream ds(&file);
-                            ds << img;
-                            file.close();
-                        } else {
-                            close(fd);
-                        }
-                    }, m_fd, img);
-                m_windowMode = WindowMode::NoCapture;
-                m_fd = -1;
+            if (!pending) {
+                if (m_type & INCLUDE_CURSOR) {
+                    grabPointerImage(img, origin.x(), origin.y());
+                }
+                sendWindowImage(img, m_windowMode);
             }
 #ifdef KWIN_HAVE_XRENDER_COMPOSITING
             if (xImage) {
@@ -279,82 +381,209 @@ void ScreenShotEffect::postPaintScreen()
         m_scheduledScreenshot = nullptr;
     }
 
-    if (!m_scheduledGeometry.isNull()) {
-        if (!m_cachedOutputGeometry.isNull()) {
-            // special handling for per-output geometry rendering
-            const QRect intersection = m_scheduledGeometry.intersected(m_cachedOutputGeometry);
-            if (intersection.isEmpty()) {
-                // doesn't intersect, not going onto this screenshot
-                return;
-            }
-            const QImage img = blitScreenshot(intersection);
-            if (img.size() == m_scheduledGeometry.size()) {
-                // we are done
-                sendReplyImage(img);
-                return;
-            }
-            if (m_multipleOutputsImage.isNull()) {
-                m_multipleOutputsImage = QImage(m_scheduledGeometry.size(), QImage::Format_ARGB32);
-                m_multipleOutputsImage.fill(Qt::transparent);
-            }
-            QPainter p;
-            p.begin(&m_multipleOutputsImage);
-            p.drawImage(intersection.topLeft() - m_scheduledGeometry.topLeft(), img);
-            p.end();
-            m_multipleOutputsRendered = m_multipleOutputsRendered.united(intersection);
-            if (m_multipleOutputsRendered.boundingRect() == m_scheduledGeometry) {
-                sendReplyImage(m_multipleOutputsImage);
-            }
+    if (m_stream) {
+        grabStreamFrame();
+    }
 
-        } else {
-            const QImage img = blitScreenshot(m_scheduledGeometry);
-            sendReplyImage(img);
+    if (!m_scheduledGeometry.isNull()) {
+        // with per-output rendering only the part on the current output can be grabbed
+        const QRect geometry = m_cachedOutputGeometry.isNull()
+            ? m_scheduledGeometry
+            : m_scheduledGeometry.intersected(m_cachedOutputGeometry);
+        if (!geometry.isEmpty() && !m_readbackRequested.intersects(geometry)) {
+            m_readbackRequested += geometry;
+            grabArea(geometry,
+                [this, geometry] (const QImage &img) {
+                    sendAreaImage(geometry, img);
+                }
+            );
         }
     }
 }
 
+void ScreenShotEffect::sendWindowImage(const QImage &img, WindowMode mode)
+{
+    if (mode == WindowMode::Xpixmap) {
+        const xcb_pixmap_t xpix = xpixmapFromImage(img);
+        emit screenshotCreated(xpix);
+        m_windowMode = WindowMode::NoCapture;
+    } else if (mode == WindowMode::File) {
+        sendReplyImage(img);
+    } else if (mode == WindowMode::FileDescriptor) {
+        QtConcurrent::run(writeImage, m_fd, img);
+        m_windowMode = WindowMode::NoCapture;
+        m_fd = -1;
+    }
+}
+
+void ScreenShotEffect::sendAreaImage(const QRect &geometry, const QImage &img)
+{
+    if (img.size() == m_scheduledGeometry.size()) {
+        // we are done
+        sendReplyImage(img);
+        return;
+    }
+    if (m_multipleOutputsImage.isNull()) {
+        m_multipleOutputsImage = QImage(m_scheduledGeometry.size(), QImage::Format_ARGB32);
+        m_multipleOutputsImage.fill(Qt::transparent);
+    }
+    QPainter p;
+    p.begin(&m_multipleOutputsImage);
+    p.drawImage(geometry.topLeft() - m_scheduledGeometry.topLeft(), img);
+    p.end();
+    m_multipleOutputsRendered = m_multipleOutputsRendered.united(geometry);
+    if (m_multipleOutputsRendered.boundingRect() == m_scheduledGeometry) {
+        sendReplyImage(m_multipleOutputsImage);
+    }
+}
+
 void ScreenShotEffect::sendReplyImage(const QImage &img)
 {
     if (m_fd != -1) {
-        QtConcurrent::run(
-            [] (int fd, const QImage &img) {
-                QFile file;
-                if (file.open(fd, QIODevice::WriteOnly, QFileDevice::AutoCloseHandle)) {
-                    QDataStream ds(&file);
-                    ds << img;
-                    file.close();
-                } else {
-                    close(fd);
-                }
-            }, m_fd, img);
+        QtConcurrent::run(writeImage, m_fd, img);
         m_fd = -1;
     } else {
-        QDBusConnection::sessionBus().send(m_replyMessage.createReply(saveTempImage(img)));
+        // encoding the png takes long, so it happens in a worker thread
+        const QDBusMessage replyMessage = m_replyMessage;
+        auto watcher = new QFutureWatcher<QString>(this);
+        connect(watcher, &QFutureWatcher<QString>::finished, this,
+            [watcher, replyMessage] {
+                const QString fileName = watcher->result();
+                if (!fileName.isEmpty()) {
+                    KNotification::event(KNotification::Notification,
+                                        i18nc("Notification caption that a screenshot got saved to file", "Screenshot"),
+                                        i18nc("Notification with path to screenshot file", "Screenshot saved to %1", fileName),
+                                        QStringLiteral("spectacle"));
+                }
+                QDBusConnection::sessionBus().send(replyMessage.createReply(fileName));
+                watcher->deleteLater();
+            }
+        );
+        watcher->setFuture(QtConcurrent::run(saveTempImage, img));
     }
     m_scheduledGeometry = QRect();
     m_multipleOutputsImage = QImage();
     m_multipleOutputsRendered = QRegion();
+    m_readbackRequested = QRegion();
     m_captureCursor = false;
     m_windowMode = WindowMode::NoCapture;
 }
 
-QString ScreenShotEffect::saveTempImage(const QImage &img)
+void ScreenShotEffect::grabArea(const QRect &geometry, const std::function<void (const QImage &)> &callback)
 {
-    if (img.isNull()) {
-        return QString();
+    if (!effects->isOpenGLCompositing() || !GLAsyncReadback::supported() || !GLRenderTarget::blitSupported()) {
+        callback(blitScreenshot(geometry));
+        return;
     }
-    QTemporaryFile temp(QDir::tempPath() + QDir::separator() + QLatin1String("kwin_screenshot_XXXXXX.png"));
-    temp.setAutoRemove(false);
-    if (!temp.open()) {
-        return QString();
+    GLTexture tex(GL_RGBA8, geometry.width(), geometry.height());
+    GLRenderTarget target(tex);
+    target.blitFromFramebuffer(geometry);
+    GLRenderTarget::pushRenderTarget(&target);
+    startReadback(QRect(QPoint(0, 0), geometry.size()), geometry.topLeft(), m_captureCursor, callback);
+    GLRenderTarget::popRenderTarget();
+}
+
+void ScreenShotEffect::grabStreamFrame()
+{
+    if (m_stream->failed.loadAcquire()) {
+        // the reading side went away
+        stopStream();
+        return;
     }
-    img.save(&temp);
-    temp.close();
-    KNotification::event(KNotification::Notification,
-                        i18nc("Notification caption that a screenshot got saved to file", "Screenshot"),
-                        i18nc("Notification with path to screenshot file", "Screenshot saved to %1", temp.fileName()),
-                        QStringLiteral("spectacle"));
-    return temp.fileName();
+    if (!m_cachedOutputGeometry.isNull() && !m_cachedOutputGeometry.contains(m_stream->geometry)) {
+        return;
+    }
+    if (m_stream->queuedFrames.loadAcquire() >= s_maxQueuedStreamFrames) {
+        // drop the frame rather than waiting for the GPU or the reading side
+        return;
+    }
+    const QRect geometry = m_stream->geometry;
+    GLTexture tex(GL_RGBA8, geometry.width(), geometry.height());
+    GLRenderTarget target(tex);
+    target.blitFromFramebuffer(geometry);
+    GLRenderTarget::pushRenderTarget(&target);
+    m_stream->queuedFrames.ref();
+    startReadback(QRect(QPoint(0, 0), geometry.size()), geometry.topLeft(), m_stream->captureCursor, nullptr, m_stream);
+    GLRenderTarget::popRenderTarget();
+}
+
+void ScreenShotEffect::startReadback(const QRect &rect, const QPoint &origin, bool includeCursor,
+                                     const std::function<void (const QImage &)> &callback,
+                                     const QSharedPointer<ScreenStream> &stream)
+{
+    PendingReadback pending;
+    pending.readback.reset(new GLAsyncReadback(rect));
+    if (includeCursor) {
+        // the cursor has to be taken now, it might have moved once the pixels arrive
+        const auto cursor = effects->cursorImage();
+        pending.cursor = cursor.image();
+        pending.cursorPos = effects->cursorPos() - cursor.hotSpot() - origin;
+    }
+    pending.callback = callback;
+    pending.stream = stream;
+    m_readbacks.append(pending);
+    m_readbackTimer.start();
+}
+
+void ScreenShotEffect::finishReadbacks()
+{
+    // readbacks complete in the order they were issued
+    while (!m_readbacks.isEmpty() && m_readbacks.first().readback->isReady()) {
+        const PendingReadback pending = m_readbacks.takeFirst();
+        const QImage raw = pending.readback->image();
+        const QImage cursor = pending.cursor;
+        const QPoint cursorPos = pending.cursorPos;
+
+        if (pending.stream) {
+            if (pending.stream->stopped) {
+                continue;
+            }
+            const QSharedPointer<ScreenStream> stream = pending.stream;
+            QtConcurrent::run(&m_streamPool,
+                [stream, raw, cursor, cursorPos] {
+                    if (!stream->failed.loadAcquire()
+                            && !writeStreamFrame(stream->fd, convertReadback(raw, cursor, cursorPos))) {
+                        stream->failed.storeRelease(1);
+                    }
+                    stream->queuedFrames.deref();
+                }
+            );
+            continue;
+        }
+
+        auto watcher = new QFutureWatcher<QImage>(this);
+        const auto callback = pending.callback;
+        connect(watcher, &QFutureWatcher<QImage>::finished, this,
+            [watcher, callback] {
+                callback(watcher->result());
+                watcher->deleteLater();
+            }
+        );
+        watcher->setFuture(QtConcurrent::run(convertReadback, raw, cursor, cursorPos));
+    }
+    if (m_readbacks.isEmpty()) {
+        m_readbackTimer.stop();
+    } else {
+        m_readbackTimer.start();
+    }
+}
+
+void ScreenShotEffect::stopStream()
+{
+    if (!m_stream) {
+        return;
+    }
+    m_stream->stopped = true;
+    // the frames which are still queued are dropped
+    m_stream->failed.storeRelease(1);
+    // the pool runs the jobs in order, so the fd gets closed after the write in progress
+    const int fd = m_stream->fd;
+    QtConcurrent::run(&m_streamPool,
+        [fd] {
+            close(fd);
+        }
+    );
+    m_stream.reset();
 }
 
 void ScreenShotEffect::screenshotWindowUnderCursor(int mask)
@@ -604,6 +833,38 @@ QString ScreenShotEffect::screenshotArea(int x, int y, int width, int height, bo
     return QString();
 }
 
+void ScreenShotEffect::streamScreen(QDBusUnixFileDescriptor fd, int screen, bool captureCursor)
+{
+    if (!calledFromDBus()) {
+        return;
+    }
+    if (m_stream) {
+        sendErrorReply(s_errorAlreadyStreaming, s_errorAlreadyStreamingMsg);
+        return;
+    }
+    if (!effects->isOpenGLCompositing() || !GLAsyncReadback::supported() || !GLRenderTarget::blitSupported()) {
+        sendErrorReply(s_errorUnsupported, s_errorUnsupportedMsg);
+        return;
+    }
+    const QRect geometry = effects->clientArea(FullScreenArea, screen, 0);
+    if (geometry.isNull()) {
+        sendErrorReply(s_errorInvalidScreen, s_errorInvalidScreenMsg);
+        return;
+    }
+    const int streamFd = dup(fd.fileDescriptor());
+    if (streamFd == -1) {
+        sendErrorReply(s_errorFd, s_errorFdMsg);
+        return;
+    }
+    // the frames are written with a timeout, see writeStreamFrame()
+    fcntl(streamFd, F_SETFL, fcntl(streamFd, F_GETFL) | O_NONBLOCK);
+    m_stream.reset(new ScreenStream);
+    m_stream->fd = streamFd;
+    m_stream->geometry = geometry;
+    m_stream->captureCursor = captureCursor;
+    effects->addRepaint(geometry);
+}
+
 QImage ScreenShotEffect::blitScreenshot(const QRect &geometry)
 {
     QImage img;
@@ -684,7 +945,7 @@ void ScreenShotEffect::convertFromGLImage(QImage &img, int w, int h)
 
 bool ScreenShotEffect::isActive() const
 {
-    return (m_scheduledScreenshot != nullptr || !m_scheduledGeometry.isNull()) && !effects->isScreenLocked();
+    return (m_scheduledScreenshot != nullptr || !m_scheduledGeometry.isNull() || m_stream) && !effects->isScreenLocked();
 }
 
 void ScreenShotEffect::windowClosed( EffectWindow* w )
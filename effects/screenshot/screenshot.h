@@ -28,10 +28,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDBusUnixFileDescriptor>
 #include <QObject>
 #include <QImage>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <functional>
 
 namespace KWin
 {
 
+class GLAsyncReadback;
+
 class ScreenShotEffect : public Effect, protected QDBusContext
 {
     Q_OBJECT
@@ -132,18 +139,41 @@ public Q_SLOTS:
      * @returns Path to stored screenshot, or null string in failure case.
      */
     Q_SCRIPTABLE QString screenshotArea(int x, int y, int width, int height, bool captureCursor = false);
+    /**
+     * Starts streaming the screen identified by @p screen into the @p fd passed to the method.
+     *
+     * Every time the screen gets repainted a frame is read back without blocking the
+     * compositor and written into the fd using a QDataStream. If the reading side does not
+     * keep up, frames get dropped. The stream ends once the reading side closes the pipe.
+     *
+     * Functionality requires pixel buffer objects and fences, if they are not available an
+     * error is returned.
+     *
+     * @param fd File descriptor into which the frames should be written
+     * @param screen Number of screen as numbered by QDesktopWidget
+     * @param captureCursor Whether to include the mouse cursor
+     */
+    Q_SCRIPTABLE void streamScreen(QDBusUnixFileDescriptor fd, int screen, bool captureCursor = false);
 
 Q_SIGNALS:
     Q_SCRIPTABLE void screenshotCreated(qulonglong handle);
 
 private Q_SLOTS:
     void windowClosed( KWin::EffectWindow* w );
+    void finishReadbacks();
 
 private:
+    struct ScreenStream;
     void grabPointerImage(QImage& snapshot, int offsetx, int offsety);
     QImage blitScreenshot(const QRect &geometry);
-    QString saveTempImage(const QImage &img);
+    void grabArea(const QRect &geometry, const std::function<void (const QImage &)> &callback);
+    void grabStreamFrame();
+    void startReadback(const QRect &rect, const QPoint &origin, bool includeCursor,
+                       const std::function<void (const QImage &)> &callback,
+                       const QSharedPointer<ScreenStream> &stream = QSharedPointer<ScreenStream>());
+    void stopStream();
     void sendReplyImage(const QImage &img);
+    void sendAreaImage(const QRect &geometry, const QImage &img);
     enum class InfoMessageMode {
         Window,
         Screen
@@ -167,6 +197,29 @@ private:
     };
     WindowMode m_windowMode = WindowMode::NoCapture;
     int m_fd = -1;
+    void sendWindowImage(const QImage &img, WindowMode mode);
+
+    struct PendingReadback {
+        QSharedPointer<GLAsyncReadback> readback;
+        QImage cursor;
+        QPoint cursorPos;
+        std::function<void (const QImage &)> callback;
+        QSharedPointer<ScreenStream> stream;
+    };
+    struct ScreenStream {
+        int fd = -1;
+        QRect geometry;
+        bool captureCursor = false;
+        bool stopped = false;
+        QAtomicInt queuedFrames;
+        QAtomicInt failed;
+    };
+    QVector<PendingReadback> m_readbacks;
+    QTimer m_readbackTimer;
+    QRegion m_readbackRequested;
+    QSharedPointer<ScreenStream> m_stream;
+    // a single thread keeps the frames of the stream in order
+    QThreadPool m_streamPool;
 };
 
 } // namespace
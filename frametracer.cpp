@@ -0,0 +1,107 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "frametracer.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <chrono>
+
+namespace KWin
+{
+
+FrameTracer *FrameTracer::self()
+{
+    static FrameTracer tracer;
+    return &tracer;
+}
+
+void FrameTracer::beginFrame()
+{
+    ++m_frame;
+}
+
+void FrameTracer::record(const char *name, Phase phase)
+{
+    const quint64 head = m_head.load(std::memory_order_relaxed);
+    Event &event = m_events[head % s_capacity];
+    event.name = name;
+    event.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    event.frame = m_frame;
+    event.phase = phase;
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+void FrameTracer::clear()
+{
+    m_head.store(0, std::memory_order_release);
+}
+
+int FrameTracer::count() const
+{
+    return int(qMin<quint64>(m_head.load(std::memory_order_acquire), s_capacity));
+}
+
+QByteArray FrameTracer::toChromeTrace() const
+{
+    const quint64 head = m_head.load(std::memory_order_acquire);
+    const quint64 first = head > quint64(s_capacity) ? head - s_capacity : 0;
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray traceEvents;
+    for (quint64 i = first; i < head; ++i) {
+        const Event &event = m_events[i % s_capacity];
+        QJsonObject object{
+            {QStringLiteral("name"), QString::fromLatin1(event.name)},
+            {QStringLiteral("cat"), QStringLiteral("kwin")},
+            {QStringLiteral("ph"), QString(QLatin1Char(char(event.phase)))},
+            {QStringLiteral("ts"), event.timestamp / 1000.0},
+            {QStringLiteral("pid"), pid},
+            {QStringLiteral("tid"), 1},
+            {QStringLiteral("args"), QJsonObject{{QStringLiteral("frame"), qint64(event.frame)}}},
+        };
+        if (event.phase == Phase::Instant) {
+            object.insert(QStringLiteral("s"), QStringLiteral("t"));
+        }
+        traceEvents.append(object);
+    }
+
+    const QJsonObject document{
+        {QStringLiteral("traceEvents"), traceEvents},
+        {QStringLiteral("displayTimeUnit"), QStringLiteral("ms")},
+    };
+    return QJsonDocument(document).toJson(QJsonDocument::Compact);
+}
+
+bool FrameTracer::save(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    const QByteArray trace = toChromeTrace();
+    return file.write(trace) == trace.size();
+}
+
+}
@@ -0,0 +1,130 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QByteArray>
+#include <QString>
+
+#include <array>
+#include <atomic>
+
+namespace KWin
+{
+
+/**
+ * @brief The FrameTracer records when the stages of a composited frame start and end.
+ *
+ * The events are kept in a fixed size ring buffer, so recording is cheap enough to be
+ * always enabled; only the most recent events are kept. The recorded events can be
+ * exported in the Chrome trace event format, which is understood by chrome://tracing
+ * and the Perfetto UI.
+ *
+ * Events are recorded by the compositing thread only. Event names must be string
+ * literals, only the pointer gets stored.
+ */
+class KWIN_EXPORT FrameTracer
+{
+public:
+    enum class Phase : char {
+        Begin = 'B',
+        End = 'E',
+        Instant = 'i'
+    };
+
+    static FrameTracer *self();
+
+    /**
+     * Starts a new frame, the events recorded from now on get associated with it.
+     */
+    void beginFrame();
+    quint64 frame() const {
+        return m_frame;
+    }
+
+    void begin(const char *name) {
+        record(name, Phase::Begin);
+    }
+    void end(const char *name) {
+        record(name, Phase::End);
+    }
+    void instant(const char *name) {
+        record(name, Phase::Instant);
+    }
+
+    /**
+     * Drops all recorded events.
+     */
+    void clear();
+    /**
+     * @returns the number of events that can be exported.
+     */
+    int count() const;
+
+    /**
+     * @returns the recorded events as Chrome trace JSON document.
+     */
+    QByteArray toChromeTrace() const;
+    /**
+     * Writes the recorded events as Chrome trace JSON document to @p fileName.
+     * @returns @c true on success, @c false if the file could not be written
+     */
+    bool save(const QString &fileName) const;
+
+    static const int s_capacity = 4096;
+
+private:
+    struct Event {
+        const char *name;
+        qint64 timestamp;
+        quint64 frame;
+        Phase phase;
+    };
+
+    void record(const char *name, Phase phase);
+
+    std::array<Event, s_capacity> m_events;
+    std::atomic<quint64> m_head{0};
+    quint64 m_frame = 0;
+};
+
+/**
+ * Records the begin of a stage on construction and its end on destruction.
+ */
+class FrameTraceScope
+{
+public:
+    explicit FrameTraceScope(const char *name)
+        : m_name(name)
+    {
+        FrameTracer::self()->begin(m_name);
+    }
+    ~FrameTraceScope()
+    {
+        FrameTracer::self()->end(m_name);
+    }
+
+private:
+    Q_DISABLE_COPY(FrameTraceScope)
+    const char *m_name;
+};
+
+}
@@ -43,6 +43,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "popup_input_filter.h"
 #include "screenedge.h"
 #include "screens.h"
+#include "toplevel_hit_index.h"
 #include "unmanaged.h"
 #include "wayland_server.h"
 #include "workspace.h"
@@ -1980,6 +1981,12 @@ void InputRedirection::init()
 
 void InputRedirection::setupWorkspace()
 {
+    m_unmanagedIndex = new ToplevelHitIndex(this);
+    connect(workspace(), &Workspace::unmanagedAdded, m_unmanagedIndex, &ToplevelHitIndex::invalidate);
+    connect(workspace(), &Workspace::unmanagedRemoved, m_unmanagedIndex, &ToplevelHitIndex::invalidate);
+    m_stackingIndex = new ToplevelHitIndex(this);
+    connect(workspace(), &Workspace::stackingOrderChanged, m_stackingIndex, &ToplevelHitIndex::invalidate);
+
     if (waylandServer()) {
         using namespace KWayland::Server;
         FakeInputInterface *fakeInput = waylandServer()->display()->createFakeInput(this);
@@ -2436,8 +2443,17 @@ Toplevel *InputRedirection::findToplevel(const QPoint &pos)
         if (effects && static_cast<EffectsHandlerImpl*>(effects)->isMouseInterception()) {
             return nullptr;
         }
-        const QList<Unmanaged *> &unmanaged = Workspace::self()->unmanagedList();
-        foreach (Unmanaged *u, unmanaged) {
+        if (!m_unmanagedIndex->isValid()) {
+            // the first unmanaged window in the list wins, so it goes on top
+            const QList<Unmanaged *> &unmanaged = Workspace::self()->unmanagedList();
+            QList<Toplevel *> toplevels;
+            toplevels.reserve(unmanaged.count());
+            for (auto it = unmanaged.crbegin(); it != unmanaged.crend(); ++it) {
+                toplevels << *it;
+            }
+            m_unmanagedIndex->rebuild(toplevels);
+        }
+        for (Toplevel *u : m_unmanagedIndex->candidates(pos)) {
             if (u->inputGeometry().contains(pos) && acceptsInput(u, pos)) {
                 return u;
             }
@@ -2446,41 +2462,43 @@ Toplevel *InputRedirection::findToplevel(const QPoint &pos)
     return findManagedToplevel(pos);
 }
 
+static bool acceptsPointerFocus(Toplevel *t, bool isScreenLocked)
+{
+    if (t->isDeleted()) {
+        // a deleted window doesn't get mouse events
+        return false;
+    }
+    if (AbstractClient *c = dynamic_cast<AbstractClient*>(t)) {
+        if (!c->isOnCurrentActivity() || !c->isOnCurrentDesktop() || c->isMinimized() || c->isHiddenInternal()) {
+            return false;
+        }
+    }
+    if (!t->readyForPainting()) {
+        return false;
+    }
+    if (isScreenLocked) {
+        if (!t->isLockScreen() && !t->isInputMethod()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 Toplevel *InputRedirection::findManagedToplevel(const QPoint &pos)
 {
     if (!Workspace::self()) {
         return nullptr;
     }
     const bool isScreenLocked = waylandServer() && waylandServer()->isScreenLocked();
-    const QList<Toplevel *> &stacking = Workspace::self()->stackingOrder();
-    if (stacking.isEmpty()) {
-        return nullptr;
+    if (!m_stackingIndex->isValid()) {
+        m_stackingIndex->rebuild(Workspace::self()->stackingOrder());
     }
-    auto it = stacking.end();
-    do {
-        --it;
-        Toplevel *t = (*it);
-        if (t->isDeleted()) {
-            // a deleted window doesn't get mouse events
-            continue;
-        }
-        if (AbstractClient *c = dynamic_cast<AbstractClient*>(t)) {
-            if (!c->isOnCurrentActivity() || !c->isOnCurrentDesktop() || c->isMinimized() || c->isHiddenInternal()) {
-                continue;
-            }
-        }
-        if (!t->readyForPainting()) {
-            continue;
-        }
-        if (isScreenLocked) {
-            if (!t->isLockScreen() && !t->isInputMethod()) {
-                continue;
-            }
-        }
-        if (t->inputGeometry().contains(pos) && acceptsInput(t, pos)) {
+    // only the windows overlapping the position are looked at, top most first
+    for (Toplevel *t : m_stackingIndex->candidates(pos)) {
+        if (acceptsPointerFocus(t, isScreenLocked) && t->inputGeometry().contains(pos) && acceptsInput(t, pos)) {
             return t;
         }
-    } while (it != stacking.begin());
+    }
     return nullptr;
 }
 
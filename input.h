@@ -53,6 +53,7 @@ class WindowSelectorFilter;
 class SwitchEvent;
 class TabletEvent;
 class TabletInputFilter;
+class ToplevelHitIndex;
 
 namespace Decoration
 {
@@ -327,6 +328,10 @@ private:
 
     WindowSelectorFilter *m_windowSelector = nullptr;
 
+    // speed up finding the window under the pointer
+    ToplevelHitIndex *m_unmanagedIndex = nullptr;
+    ToplevelHitIndex *m_stackingIndex = nullptr;
+
     QVector<InputEventFilter*> m_filters;
     QVector<InputEventSpy*> m_spies;
 
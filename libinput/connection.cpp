@@ -162,11 +162,17 @@ Connection *Connection::create(QObject *parent)
 }
 
 
+// Number of events which can be in flight between the libinput thread and the main thread.
+// If the main thread falls that much behind, the events stay queued in libinput.
+static const quint32 s_eventQueueCapacity = 1024;
+
 Connection::Connection(Context *input, QObject *parent)
     : QObject(parent)
     , m_input(input)
     , m_notifier(nullptr)
     , m_mutex(QMutex::Recursive)
+    , m_eventQueue(s_eventQueueCapacity)
+    , m_releasedEvents(s_eventQueueCapacity)
     , m_leds()
 {
     Q_ASSERT(m_input);
@@ -177,6 +183,12 @@ Connection::Connection(Context *input, QObject *parent)
 
 Connection::~Connection()
 {
+    while (Event *event = m_eventQueue.pop()) {
+        delete event;
+    }
+    while (Event *event = m_releasedEvents.pop()) {
+        delete event;
+    }
     delete s_adaptor;
     s_adaptor = nullptr;
     s_self = nullptr;
@@ -209,6 +221,7 @@ void Connection::doSetup()
                 if (!m_input->isSuspended()) {
                     return;
                 }
+                QMutexLocker locker(&m_mutex);
                 m_input->resume();
                 wasSuspended = true;
             } else {
@@ -229,6 +242,7 @@ void Connection::deactivate()
     m_pointerBeforeSuspend = hasPointer();
     m_touchBeforeSuspend = hasTouch();
     m_tabletModeSwitchBeforeSuspend = hasTabletModeSwitch();
+    QMutexLocker locker(&m_mutex);
     m_input->suspend();
     handleEvent();
 }
@@ -236,20 +250,55 @@ void Connection::deactivate()
 void Connection::handleEvent()
 {
     QMutexLocker locker(&m_mutex);
-    const bool wasEmpty = m_eventQueue.isEmpty();
-    do {
+    destroyReleasedEvents();
+    bool queued = false;
+    while (m_pendingEvents < m_eventQueue.capacity()) {
         m_input->dispatch();
         Event *event = m_input->event();
         if (!event) {
             break;
         }
-        m_eventQueue << event;
-    } while (true);
-    if (wasEmpty && !m_eventQueue.isEmpty()) {
+        // cannot fail, there are never more events pending than the queue can hold
+        m_eventQueue.push(event);
+        m_pendingEvents++;
+        queued = true;
+    }
+    if (m_pendingEvents == m_eventQueue.capacity()) {
+        // the fd stays readable while events are left in libinput, stop listening to it
+        // until the main thread released some events
+        if (m_notifier) {
+            m_notifier->setEnabled(false);
+        }
+        m_readingStalled.store(true);
+    }
+    if (queued && !m_eventsReadPending.exchange(true)) {
         emit eventsRead();
     }
 }
 
+void Connection::destroyReleasedEvents()
+{
+    while (Event *event = m_releasedEvents.pop()) {
+        delete event;
+        m_pendingEvents--;
+    }
+}
+
+void Connection::releaseEvent(Event *event)
+{
+    // Events get destroyed on the libinput thread as destroying them calls into libinput.
+    const bool released = m_releasedEvents.push(event);
+    Q_ASSERT(released);
+    Q_UNUSED(released)
+}
+
+void Connection::EventReleaser::cleanup(Event *event)
+{
+    if (event) {
+        s_self->releaseEvent(event);
+    }
+}
+
 #ifndef KWIN_BUILD_TESTING
 QPointF devicePointToGlobalPosition(const QPointF &devicePos, const AbstractWaylandOutput *output)
 {
@@ -283,9 +332,13 @@ QPointF devicePointToGlobalPosition(const QPointF &devicePos, const AbstractWayl
 
 void Connection::processEvents()
 {
-    QMutexLocker locker(&m_mutex);
+    m_eventsReadPending.store(false);
     while (!m_eventQueue.isEmpty()) {
-        QScopedPointer<Event> event(m_eventQueue.takeFirst());
+        // The getters of the events call into libinput, which must not race with
+        // libinput_dispatch() on the libinput thread. The mutex is taken per event,
+        // so the libinput thread can continue reading between two events.
+        QMutexLocker locker(&m_mutex);
+        QScopedPointer<Event, EventReleaser> event(m_eventQueue.pop());
         switch (event->type()) {
             case LIBINPUT_EVENT_DEVICE_ADDED: {
                 auto device = new Device(event->nativeDevice());
@@ -398,18 +451,16 @@ void Connection::processEvents()
                 auto deltaNonAccel = pe->deltaUnaccelerated();
                 quint32 latestTime = pe->time();
                 quint64 latestTimeUsec = pe->timeMicroseconds();
-                auto it = m_eventQueue.begin();
-                while (it != m_eventQueue.end()) {
-                    if ((*it)->type() == LIBINPUT_EVENT_POINTER_MOTION) {
-                        QScopedPointer<PointerEvent> p(static_cast<PointerEvent*>(*it));
-                        delta += p->delta();
-                        deltaNonAccel += p->deltaUnaccelerated();
-                        latestTime = p->time();
-                        latestTimeUsec = p->timeMicroseconds();
-                        it = m_eventQueue.erase(it);
-                    } else {
+                // merge the motion events of the same device the main thread fell behind with
+                while (Event *next = m_eventQueue.peek()) {
+                    if (next->type() != LIBINPUT_EVENT_POINTER_MOTION || next->nativeDevice() != pe->nativeDevice()) {
                         break;
                     }
+                    QScopedPointer<PointerEvent, EventReleaser> p(static_cast<PointerEvent*>(m_eventQueue.pop()));
+                    delta += p->delta();
+                    deltaNonAccel += p->deltaUnaccelerated();
+                    latestTime = p->time();
+                    latestTimeUsec = p->timeMicroseconds();
                 }
                 emit pointerMotion(delta, deltaNonAccel, latestTime, latestTimeUsec, pe->device());
                 break;
@@ -637,6 +688,16 @@ void Connection::processEvents()
         }
         wasSuspended = false;
     }
+    if (m_readingStalled.exchange(false)) {
+        // the notifier belongs to the libinput thread, resume reading there
+        QMetaObject::invokeMethod(this,
+            [this] {
+                if (m_notifier) {
+                    m_notifier->setEnabled(true);
+                }
+                handleEvent();
+            }, Qt::QueuedConnection);
+    }
 }
 
 void Connection::setScreenSize(const QSize &size)
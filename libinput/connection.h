@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "../input.h"
 #include "../keyboard_input.h"
+#include "event_queue.h"
 #include <kwinglobals.h>
 
 #include <QObject>
@@ -31,6 +32,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QVector>
 #include <QStringList>
 
+#include <atomic>
+
 class QSocketNotifier;
 class QThread;
 
@@ -153,6 +156,8 @@ private Q_SLOTS:
 private:
     Connection(Context *input, QObject *parent = nullptr);
     void handleEvent();
+    void releaseEvent(Event *event);
+    void destroyReleasedEvents();
     void applyDeviceConfig(Device *device);
     void applyScreenToDevice(Device *device);
     Context *m_input;
@@ -169,7 +174,18 @@ private:
     bool m_touchBeforeSuspend = false;
     bool m_tabletModeSwitchBeforeSuspend = false;
     QMutex m_mutex;
-    QVector<Event*> m_eventQueue;
+    // events read on the libinput thread and waiting to be processed on the main thread
+    EventQueue m_eventQueue;
+    // processed events waiting to be destroyed on the libinput thread
+    EventQueue m_releasedEvents;
+    // events handed out to the main thread which have not been destroyed yet,
+    // only accessed on the libinput thread
+    quint32 m_pendingEvents = 0;
+    std::atomic<bool> m_eventsReadPending{false};
+    std::atomic<bool> m_readingStalled{false};
+    struct EventReleaser {
+        static void cleanup(Event *event);
+    };
     bool wasSuspended = false;
     QVector<Device*> m_devices;
     KSharedConfigPtr m_config;
@@ -0,0 +1,115 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_LIBINPUT_EVENT_QUEUE_H
+#define KWIN_LIBINPUT_EVENT_QUEUE_H
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+
+namespace KWin
+{
+namespace LibInput
+{
+
+class Event;
+
+/**
+ * @brief Bounded lock-free queue to pass events from one thread to another one.
+ *
+ * Exactly one thread may push() and exactly one other thread may peek() and pop().
+ * The storage is allocated once, so neither side ever allocates or blocks.
+ */
+class EventQueue
+{
+public:
+    /**
+     * Creates a queue which holds up to @p capacity events, @p capacity must be a power of two.
+     */
+    explicit EventQueue(quint32 capacity)
+        : m_events(new Event*[capacity])
+        , m_mask(capacity - 1)
+    {
+        Q_ASSERT(capacity > 0 && (capacity & m_mask) == 0);
+    }
+
+    quint32 capacity() const {
+        return m_mask + 1;
+    }
+
+    /**
+     * Appends @p event to the queue. Only to be called from the producer thread.
+     * @returns @c false if the queue is full
+     */
+    bool push(Event *event) {
+        const quint32 tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) > m_mask) {
+            return false;
+        }
+        m_events[tail & m_mask] = event;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @returns the first event in the queue without taking it, or @c null if the queue
+     * is empty. Only to be called from the consumer thread.
+     */
+    Event *peek() const {
+        const quint32 head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return m_events[head & m_mask];
+    }
+
+    /**
+     * Takes the first event from the queue. Only to be called from the consumer thread.
+     * @returns the event or @c null if the queue is empty
+     */
+    Event *pop() {
+        const quint32 head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        Event *event = m_events[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return event;
+    }
+
+    bool isEmpty() const {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+private:
+    Q_DISABLE_COPY(EventQueue)
+    std::unique_ptr<Event*[]> m_events;
+    quint32 m_mask;
+    // head and tail are written by different threads, keep them on different cache lines
+    std::atomic<quint32> m_head{0};
+    char m_padding[64 - sizeof(std::atomic<quint32>)];
+    std::atomic<quint32> m_tail{0};
+};
+
+}
+}
+
+#endif
@@ -605,6 +605,11 @@ bool Effect::isActive() const
     return true;
 }
 
+bool Effect::blocksDirectScanout() const
+{
+    return true;
+}
+
 QString Effect::debug(const QString &) const
 {
     return QString();
@@ -932,6 +937,7 @@ bool WindowQuad::smoothNeeded() const
 WindowQuadList WindowQuadList::splitAtX(double x) const
 {
     WindowQuadList ret;
+    ret.reserve(count() * 2);
     foreach (const WindowQuad & quad, *this) {
 #if !defined(QT_NO_DEBUG)
         if (quad.isTransformed())
@@ -964,6 +970,7 @@ WindowQuadList WindowQuadList::splitAtX(double x) const
 WindowQuadList WindowQuadList::splitAtY(double y) const
 {
     WindowQuadList ret;
+    ret.reserve(count() * 2);
     foreach (const WindowQuad & quad, *this) {
 #if !defined(QT_NO_DEBUG)
         if (quad.isTransformed())
@@ -1015,9 +1022,15 @@ WindowQuadList WindowQuadList::makeGrid(int maxQuadSize) const
         bottom = qMax(bottom, quad.bottom());
     }
 
+    // Each quad covers a part of the grid over the bounding rectangle, only the
+    // cells along the quad borders get split into several quads.
+    const int columns = qCeil((right - left) / maxQuadSize) + 1;
+    const int rows = qCeil((bottom - top) / maxQuadSize) + 1;
+
     WindowQuadList ret;
+    ret.reserve(columns * rows + count() * (columns + rows));
 
-    foreach (const WindowQuad &quad, *this) {
+    for (const WindowQuad &quad : *this) {
         const double quadLeft   = quad.left();
         const double quadRight  = quad.right();
         const double quadTop    = quad.top();
@@ -1076,8 +1089,9 @@ WindowQuadList WindowQuadList::makeRegularGrid(int xSubdivisions, int ySubdivisi
     double yIncrement = (bottom - top) / ySubdivisions;
 
     WindowQuadList ret;
+    ret.reserve((xSubdivisions + 1) * (ySubdivisions + 1) + count() * (xSubdivisions + ySubdivisions));
 
-    foreach (const WindowQuad &quad, *this) {
+    for (const WindowQuad &quad : *this) {
         const double quadLeft   = quad.left();
         const double quadRight  = quad.right();
         const double quadTop    = quad.top();
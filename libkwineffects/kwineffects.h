@@ -188,7 +188,7 @@ X-KDE-Library=kwin4_effect_cooleffect
 
 #define KWIN_EFFECT_API_MAKE_VERSION( major, minor ) (( major ) << 8 | ( minor ))
 #define KWIN_EFFECT_API_VERSION_MAJOR 0
-#define KWIN_EFFECT_API_VERSION_MINOR 230
+#define KWIN_EFFECT_API_VERSION_MINOR 232
 #define KWIN_EFFECT_API_VERSION KWIN_EFFECT_API_MAKE_VERSION( \
         KWIN_EFFECT_API_VERSION_MAJOR, KWIN_EFFECT_API_VERSION_MINOR )
 
@@ -544,6 +544,17 @@ public:
      */
     virtual bool isActive() const;
 
+    /**
+     * Overwrite this method to indicate whether a fullscreen window may be put directly
+     * on the screen while your effect is active. Direct scanout bypasses the whole paint
+     * chain, so only effects which leave opaque fullscreen windows untouched should
+     * return @c false.
+     *
+     * The default implementation of this method returns @c true.
+     * @since 5.19
+     */
+    virtual bool blocksDirectScanout() const;
+
     /**
      * Reimplement this method to provide online debugging.
      * This could be as trivial as printing specific detail information about the effect state
@@ -2543,9 +2554,11 @@ public:
 private:
     friend class WindowQuad;
     friend class WindowQuadList;
-    double px, py; // position
-    double ox, oy; // origional position
-    double tx, ty; // texture coords
+    // Stored in single precision, like the vertices uploaded to the GPU. This keeps
+    // a WindowQuad small enough to be stored inline in WindowQuadList.
+    float px, py; // position
+    float ox, oy; // origional position
+    float tx, ty; // texture coords
 };
 
 /**
@@ -2557,6 +2570,7 @@ private:
 class KWINEFFECTS_EXPORT WindowQuad
 {
 public:
+    WindowQuad();
     explicit WindowQuad(WindowQuadType type, int id = -1);
     WindowQuad makeSubQuad(double x1, double y1, double x2, double y2) const;
     WindowVertex& operator[](int index);
@@ -2585,8 +2599,23 @@ private:
     int quadID;
 };
 
+} // namespace KWin
+
+Q_DECLARE_TYPEINFO(KWin::WindowVertex, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(KWin::WindowQuad, Q_MOVABLE_TYPE);
+
+namespace KWin
+{
+
+/**
+ * @short List of WindowQuads.
+ *
+ * The quads are stored contiguously, so building and iterating the list does not
+ * need one heap allocation per quad. Effects generating many quads should reserve()
+ * the expected size up front.
+ */
 class KWINEFFECTS_EXPORT WindowQuadList
-    : public QList< WindowQuad >
+    : public QVector< WindowQuad >
 {
 public:
     WindowQuadList splitAtX(double x) const;
@@ -3833,6 +3862,14 @@ void WindowVertex::setY(double y)
  WindowQuad
 ***************************************************************/
 
+inline
+WindowQuad::WindowQuad()
+    : quadType(WindowQuadError)
+    , uvSwapped(false)
+    , quadID(-1)
+{
+}
+
 inline
 WindowQuad::WindowQuad(WindowQuadType t, int id)
     : quadType(t)
@@ -0,0 +1,309 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwinglshadercache_p.h"
+#include "kwinglplatform.h"
+#include "logging_p.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace KWin
+{
+
+// bump when the layout of the files changes
+static const quint32 s_cacheVersion = 1;
+static const QString s_suffix = QStringLiteral(".bin");
+static const QString s_traitsFile = QStringLiteral("traits");
+// limits of the binaries kept on disk, the least recently used ones get dropped first
+static const qint64 s_maxCacheSize = 32 * 1024 * 1024;
+static const int s_maxBinaries = 256;
+// the built-in shaders only use a few dozen trait sets
+static const int s_maxTraits = 64;
+
+static QByteArray driverKey()
+{
+    GLPlatform *platform = GLPlatform::instance();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(platform->glVendorString());
+    hash.addData(platform->glRendererString());
+    hash.addData(platform->glVersionString());
+    hash.addData(platform->glShadingLanguageVersionString());
+    return hash.result().toHex().left(16);
+}
+
+GLShaderCache::GLShaderCache(const QString &directory)
+    : m_baseDirectory(directory)
+    , m_directory(directory + QLatin1Char('/') + QString::fromLatin1(driverKey()))
+{
+}
+
+GLShaderCache::~GLShaderCache()
+{
+    flush();
+}
+
+bool GLShaderCache::supported()
+{
+    if (qgetenv("KWIN_GL_SHADER_CACHE") == QByteArrayLiteral("0")) {
+        return false;
+    }
+    if (GLPlatform::instance()->isGLES()) {
+        if (!hasGLVersion(3, 0) && !hasGLExtension(QByteArrayLiteral("GL_OES_get_program_binary"))) {
+            return false;
+        }
+    } else if (!hasGLVersion(4, 1) && !hasGLExtension(QByteArrayLiteral("GL_ARB_get_program_binary"))) {
+        return false;
+    }
+    // Mesa only offers binary formats when its own shader cache is enabled
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+void GLShaderCache::warm()
+{
+    removeStaleDrivers();
+
+    QDir dir(m_directory);
+    const QStringList files = dir.entryList({QStringLiteral("*") + s_suffix}, QDir::Files);
+    for (const QString &fileName : files) {
+        QFile file(dir.filePath(fileName));
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        QDataStream stream(&file);
+        quint32 version;
+        quint32 format;
+        Binary binary;
+        stream >> version >> format >> binary.data;
+        if (stream.status() != QDataStream::Ok || version != s_cacheVersion || binary.data.isEmpty()) {
+            file.remove();
+            continue;
+        }
+        binary.format = format;
+        m_binaries.insert(fileName.left(fileName.size() - s_suffix.size()).toLatin1(), binary);
+    }
+
+    QFile traitsFile(dir.filePath(s_traitsFile));
+    if (traitsFile.open(QIODevice::ReadOnly)) {
+        QDataStream stream(&traitsFile);
+        QVector<quint32> traits;
+        stream >> traits;
+        if (stream.status() == QDataStream::Ok) {
+            for (quint32 traitSet : traits) {
+                m_traits << ShaderTraits(QFlag(int(traitSet)));
+            }
+        }
+        if (m_traits.count() > s_maxTraits) {
+            m_traits.remove(0, m_traits.count() - s_maxTraits);
+            m_traitsChanged = true;
+        }
+    }
+    qCDebug(LIBKWINGLUTILS) << "Loaded" << m_binaries.count() << "shader binaries from" << m_directory;
+}
+
+QByteArray GLShaderCache::key(const QByteArray &vertexSource, const QByteArray &fragmentSource, const QByteArray &bindings) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(vertexSource);
+    hash.addData("\0", 1);
+    hash.addData(fragmentSource);
+    hash.addData("\0", 1);
+    hash.addData(bindings);
+    return hash.result().toHex();
+}
+
+void GLShaderCache::prepareLink(GLuint program) const
+{
+    // GLES 2 with GL_OES_get_program_binary lacks the hint, its binaries are always retrievable
+    if (!GLPlatform::instance()->isGLES() || hasGLVersion(3, 0)) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+bool GLShaderCache::load(GLuint program, const QByteArray &key)
+{
+    const auto it = m_binaries.constFind(key);
+    if (it == m_binaries.constEnd()) {
+        return false;
+    }
+    glProgramBinary(program, it->format, it->data.constData(), it->data.size());
+
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status) {
+        // the driver changed without changing its version strings
+        qCDebug(LIBKWINGLUTILS) << "Dropping rejected shader binary" << key;
+        remove(key);
+        return false;
+    }
+    m_binaries[key].used = true;
+    return true;
+}
+
+void GLShaderCache::store(GLuint program, const QByteArray &key)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    Binary binary;
+    binary.data.resize(length);
+    glGetProgramBinary(program, length, nullptr, &binary.format, binary.data.data());
+    binary.used = true;
+    m_binaries.insert(key, binary);
+    if (!m_pendingBinaries.contains(key)) {
+        m_pendingBinaries << key;
+    }
+}
+
+void GLShaderCache::flush()
+{
+    if (!m_pendingBinaries.isEmpty() || m_traitsChanged) {
+        if (!QDir().mkpath(m_directory)) {
+            return;
+        }
+        for (const QByteArray &key : qAsConst(m_pendingBinaries)) {
+            storeBinary(key);
+        }
+        m_pendingBinaries.clear();
+        if (m_traitsChanged) {
+            storeTraits();
+            m_traitsChanged = false;
+        }
+    }
+    evict();
+}
+
+QVector<ShaderTraits> GLShaderCache::traits() const
+{
+    return m_traits;
+}
+
+void GLShaderCache::addTraits(ShaderTraits traits)
+{
+    if (m_traits.contains(traits)) {
+        return;
+    }
+    m_traits << traits;
+    if (m_traits.count() > s_maxTraits) {
+        m_traits.removeFirst();
+    }
+    m_traitsChanged = true;
+}
+
+QString GLShaderCache::filePath(const QByteArray &key) const
+{
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(key) + s_suffix;
+}
+
+void GLShaderCache::remove(const QByteArray &key)
+{
+    m_binaries.remove(key);
+    m_pendingBinaries.removeOne(key);
+    QFile::remove(filePath(key));
+}
+
+void GLShaderCache::removeStaleDrivers() const
+{
+    // binaries of another driver or driver version can't ever be loaded again
+    QDir dir(m_baseDirectory);
+    const QString current = QFileInfo(m_directory).fileName();
+    const QStringList drivers = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &driver : drivers) {
+        if (driver == current) {
+            continue;
+        }
+        qCDebug(LIBKWINGLUTILS) << "Removing shader binaries of a previous driver" << driver;
+        QDir(dir.filePath(driver)).removeRecursively();
+    }
+}
+
+void GLShaderCache::storeBinary(const QByteArray &key) const
+{
+    const auto it = m_binaries.constFind(key);
+    if (it == m_binaries.constEnd()) {
+        return;
+    }
+    QSaveFile file(filePath(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream << s_cacheVersion << quint32(it->format) << it->data;
+    if (!file.commit()) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to store shader binary in" << file.fileName();
+    }
+}
+
+void GLShaderCache::evict()
+{
+    QDir dir(m_directory);
+    // the modification time tells when a binary got used the last time
+    const QDateTime now = QDateTime::currentDateTime();
+    for (auto it = m_binaries.begin(); it != m_binaries.end(); ++it) {
+        if (!it->used) {
+            continue;
+        }
+        QFile file(filePath(it.key()));
+        if (file.open(QIODevice::ReadWrite | QIODevice::ExistingOnly)) {
+            file.setFileTime(now, QFileDevice::FileModificationTime);
+        }
+        it->used = false;
+    }
+
+    const QFileInfoList files = dir.entryInfoList({QStringLiteral("*") + s_suffix}, QDir::Files, QDir::Time);
+    qint64 size = 0;
+    for (int i = 0; i < files.count(); ++i) {
+        const QFileInfo &info = files.at(i);
+        size += info.size();
+        if (i < s_maxBinaries && size <= s_maxCacheSize) {
+            continue;
+        }
+        const QByteArray key = info.completeBaseName().toLatin1();
+        qCDebug(LIBKWINGLUTILS) << "Evicting shader binary" << key;
+        m_binaries.remove(key);
+        QFile::remove(info.filePath());
+    }
+}
+
+void GLShaderCache::storeTraits() const
+{
+    QSaveFile file(m_directory + QLatin1Char('/') + s_traitsFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QVector<quint32> traits;
+    traits.reserve(m_traits.count());
+    for (ShaderTraits traitSet : m_traits) {
+        traits << quint32(traitSet);
+    }
+    QDataStream stream(&file);
+    stream << traits;
+    file.commit();
+}
+
+}
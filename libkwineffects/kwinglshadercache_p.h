@@ -0,0 +1,114 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#ifndef KWIN_GLSHADERCACHE_P_H
+#define KWIN_GLSHADERCACHE_P_H
+
+#include "kwinglutils.h"
+#include <kwinglutils_export.h>
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <epoxy/gl.h>
+
+namespace KWin
+{
+
+/**
+ * @internal
+ *
+ * Persistent cache of linked shader programs.
+ *
+ * The binaries are stored per GL driver in @p directory, so a driver update
+ * doesn't pick up stale binaries. Programs are identified by a key over their
+ * sources and attribute bindings, see key().
+ *
+ * New binaries are only written to disk when the cache gets destroyed, so that
+ * compiling a shader during a frame doesn't wait for the disk.
+ */
+class KWINGLUTILS_EXPORT GLShaderCache
+{
+public:
+    explicit GLShaderCache(const QString &directory);
+    ~GLShaderCache();
+
+    /**
+     * Reads all binaries of the current driver into memory, so that loading a
+     * program later on doesn't touch the disk. The binaries of other drivers
+     * get removed.
+     */
+    void warm();
+    /**
+     * Writes the binaries and traits added since the last call to disk and
+     * drops the least recently used binaries exceeding the size limit.
+     */
+    void flush();
+
+    QByteArray key(const QByteArray &vertexSource, const QByteArray &fragmentSource, const QByteArray &bindings) const;
+
+    /**
+     * Must be called before linking a program which gets passed to store().
+     */
+    void prepareLink(GLuint program) const;
+    /**
+     * Loads the binary for @p key into @p program.
+     * @returns @c true if the program is linked afterwards
+     */
+    bool load(GLuint program, const QByteArray &key);
+    void store(GLuint program, const QByteArray &key);
+
+    /**
+     * The trait sets of the built-in shaders which got used, ShaderManager
+     * creates them when it gets warmed up.
+     */
+    QVector<ShaderTraits> traits() const;
+    void addTraits(ShaderTraits traits);
+
+    /**
+     * @returns Whether the driver supports retrieving program binaries
+     */
+    static bool supported();
+
+private:
+    QString filePath(const QByteArray &key) const;
+    void remove(const QByteArray &key);
+    void removeStaleDrivers() const;
+    void storeBinary(const QByteArray &key) const;
+    void storeTraits() const;
+    void evict();
+
+    struct Binary {
+        GLenum format = GL_NONE;
+        QByteArray data;
+        bool used = false;
+    };
+    QString m_baseDirectory;
+    QString m_directory;
+    QHash<QByteArray, Binary> m_binaries;
+    QVector<QByteArray> m_pendingBinaries;
+    QVector<ShaderTraits> m_traits;
+    bool m_traitsChanged = false;
+};
+
+}
+
+#endif
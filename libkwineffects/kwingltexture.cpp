@@ -324,7 +324,7 @@ void GLTexturePrivate::initStatic()
         s_supportsARGB32 = QSysInfo::ByteOrder == QSysInfo::LittleEndian &&
             hasGLExtension(QByteArrayLiteral("GL_EXT_texture_format_BGRA8888"));
 
-        s_supportsUnpack = hasGLExtension(QByteArrayLiteral("GL_EXT_unpack_subimage"));
+        s_supportsUnpack = hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_EXT_unpack_subimage"));
     }
 }
 
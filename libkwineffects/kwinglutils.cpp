@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "kwineffects.h"
 #include "kwinglplatform.h"
+#include "kwinglshadercache_p.h"
 #include "logging_p.h"
 
 #include <QPixmap>
@@ -36,10 +37,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QVector3D>
 #include <QVector4D>
 #include <QMatrix4x4>
+#include <QStandardPaths>
 #include <QVarLengthArray>
 
 #include <array>
 #include <cmath>
+#include <cstring>
 #include <deque>
 
 #define DEBUG_GLRENDERTARGET 0
@@ -81,6 +84,7 @@ void initGL(const std::function<resolveFuncPtr(const char*)> &resolveFunction)
     GLTexturePrivate::initStatic();
     GLRenderTarget::initStatic();
     GLVertexBuffer::initStatic();
+    GLPixelUnpackBuffer::initStatic();
 }
 
 void cleanupGL()
@@ -89,6 +93,7 @@ void cleanupGL()
     GLTexturePrivate::cleanup();
     GLRenderTarget::cleanup();
     GLVertexBuffer::cleanup();
+    GLPixelUnpackBuffer::cleanup();
     GLPlatform::cleanup();
 
     glExtensions.clear();
@@ -195,6 +200,11 @@ bool GLShader::link()
     // Be optimistic
     mValid = true;
 
+    // Linking invalidates the locations and resets the values of the uniforms
+    mLocationsResolved = false;
+    mUniformLocations.clear();
+    mUniformValues.clear();
+
     glLinkProgram(mProgram);
 
     // Get the program info log
@@ -351,10 +361,38 @@ void GLShader::resolveLocations()
 
 int GLShader::uniformLocation(const char *name)
 {
+    // fromRawData avoids a deep copy for the lookup
+    auto it = mUniformLocations.constFind(QByteArray::fromRawData(name, qstrlen(name)));
+    if (it != mUniformLocations.constEnd()) {
+        return *it;
+    }
     const int location = glGetUniformLocation(mProgram, name);
+    mUniformLocations.insert(QByteArray(name), location);
     return location;
 }
 
+// Remembers the value of the uniform at @p location and returns whether it differs
+// from the value that got set last.
+bool GLShader::updateUniformValue(int location, GLenum type, const void *value, size_t size)
+{
+    // Locations are usually small consecutive numbers, don't shadow if this one is not
+    static const int maxShadowedLocation = 255;
+    if (location > maxShadowedLocation) {
+        return true;
+    }
+    Q_ASSERT(size <= sizeof(UniformValue::data));
+    if (location >= mUniformValues.size()) {
+        mUniformValues.resize(location + 1);
+    }
+    UniformValue &uniform = mUniformValues[location];
+    if (uniform.type == type && memcmp(uniform.data, value, size) == 0) {
+        return false;
+    }
+    uniform.type = type;
+    memcpy(uniform.data, value, size);
+    return true;
+}
+
 bool GLShader::setUniform(GLShader::MatrixUniform uniform, const QMatrix4x4 &matrix)
 {
     resolveLocations();
@@ -441,7 +479,7 @@ bool GLShader::setUniform(const char *name, const QColor& color)
 
 bool GLShader::setUniform(int location, float value)
 {
-    if (location >= 0) {
+    if (location >= 0 && updateUniformValue(location, GL_FLOAT, &value, sizeof(value))) {
         glUniform1f(location, value);
     }
     return (location >= 0);
@@ -449,7 +487,7 @@ bool GLShader::setUniform(int location, float value)
 
 bool GLShader::setUniform(int location, int value)
 {
-    if (location >= 0) {
+    if (location >= 0 && updateUniformValue(location, GL_INT, &value, sizeof(value))) {
         glUniform1i(location, value);
     }
     return (location >= 0);
@@ -457,7 +495,7 @@ bool GLShader::setUniform(int location, int value)
 
 bool GLShader::setUniform(int location, const QVector2D &value)
 {
-    if (location >= 0) {
+    if (location >= 0 && updateUniformValue(location, GL_FLOAT_VEC2, &value, 2 * sizeof(GLfloat))) {
         glUniform2fv(location, 1, (const GLfloat*)&value);
     }
     return (location >= 0);
@@ -465,7 +503,7 @@ bool GLShader::setUniform(int location, const QVector2D &value)
 
 bool GLShader::setUniform(int location, const QVector3D &value)
 {
-    if (location >= 0) {
+    if (location >= 0 && updateUniformValue(location, GL_FLOAT_VEC3, &value, 3 * sizeof(GLfloat))) {
         glUniform3fv(location, 1, (const GLfloat*)&value);
     }
     return (location >= 0);
@@ -473,7 +511,7 @@ bool GLShader::setUniform(int location, const QVector3D &value)
 
 bool GLShader::setUniform(int location, const QVector4D &value)
 {
-    if (location >= 0) {
+    if (location >= 0 && updateUniformValue(location, GL_FLOAT_VEC4, &value, 4 * sizeof(GLfloat))) {
         glUniform4fv(location, 1, (const GLfloat*)&value);
     }
     return (location >= 0);
@@ -488,7 +526,9 @@ bool GLShader::setUniform(int location, const QMatrix4x4 &value)
         for (int i = 0; i < 16; ++i) {
             m[i] = data[i];
         }
-        glUniformMatrix4fv(location, 1, GL_FALSE, m);
+        if (updateUniformValue(location, GL_FLOAT_MAT4, m, sizeof(m))) {
+            glUniformMatrix4fv(location, 1, GL_FALSE, m);
+        }
     }
     return (location >= 0);
 }
@@ -496,7 +536,12 @@ bool GLShader::setUniform(int location, const QMatrix4x4 &value)
 bool GLShader::setUniform(int location, const QColor &color)
 {
     if (location >= 0) {
-        glUniform4f(location, color.redF(), color.greenF(), color.blueF(), color.alphaF());
+        const GLfloat value[] = {
+            GLfloat(color.redF()), GLfloat(color.greenF()), GLfloat(color.blueF()), GLfloat(color.alphaF())
+        };
+        if (updateUniformValue(location, GL_FLOAT_VEC4, value, sizeof(value))) {
+            glUniform4fv(location, 1, value);
+        }
     }
     return (location >= 0);
 }
@@ -560,6 +605,17 @@ ShaderManager::ShaderManager()
     } else {
         m_resourcePath = QStringLiteral(":/effect-shaders-1.10/");
     }
+
+    if (GLShaderCache::supported()) {
+        m_cache = new GLShaderCache(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+                                    + QStringLiteral("/kwin/shaders"));
+        m_cache->warm();
+        // create the built-in shaders up front, so that the first frame using them doesn't hitch
+        const QVector<ShaderTraits> traits = m_cache->traits();
+        for (ShaderTraits traitSet : traits) {
+            shader(traitSet);
+        }
+    }
 }
 
 ShaderManager::~ShaderManager()
@@ -570,6 +626,7 @@ ShaderManager::~ShaderManager()
 
     qDeleteAll(m_shaderHash);
     m_shaderHash.clear();
+    delete m_cache;
 }
 
 static bool fuzzyCompare(const QVector4D &lhs, const QVector4D &rhs)
@@ -877,6 +934,26 @@ QByteArray ShaderManager::generateFragmentSource(ShaderTraits traits) const
         stream << "uniform vec4 textureClamp;\n";
     }
 
+    // The selectors pick the chroma channel out of the plane textures, which allows to
+    // share one shader between the NV12 (Y_UV), YUV420 (Y_U_V) and YUYV (Y_XUXV) layouts
+    QByteArray sample = textureLookup + QByteArrayLiteral("(sampler, texcoordC)");
+    if ((traits & ShaderTrait::MapTexture) && (traits & ShaderTrait::YuvConversion)) {
+        stream << "uniform sampler2D samplerU;\n";
+        stream << "uniform sampler2D samplerV;\n";
+        stream << "uniform vec4 uSelector;\n";
+        stream << "uniform vec4 vSelector;\n";
+
+        // BT.601 with limited range
+        stream << "\nvec4 sampleYuv(vec2 texcoord)\n{\n";
+        stream << "    float y = 1.16438356 * (" << textureLookup << "(sampler, texcoord).r - 0.0625);\n";
+        stream << "    float u = dot(" << textureLookup << "(samplerU, texcoord), uSelector) - 0.5;\n";
+        stream << "    float v = dot(" << textureLookup << "(samplerV, texcoord), vSelector) - 0.5;\n";
+        stream << "    return vec4(y + 1.59602678 * v, y - 0.39176229 * u - 0.81296764 * v, y + 2.01723214 * u, 1.0);\n";
+        stream << "}\n";
+
+        sample = QByteArrayLiteral("sampleYuv(texcoordC)");
+    }
+
     if (output != QByteArrayLiteral("gl_FragColor"))
         stream << "\nout vec4 " << output << ";\n";
 
@@ -890,7 +967,7 @@ QByteArray ShaderManager::generateFragmentSource(ShaderTraits traits) const
         }
 
         if (traits & (ShaderTrait::Modulate | ShaderTrait::AdjustSaturation)) {
-            stream << "    vec4 texel = " << textureLookup << "(sampler, texcoordC);\n";
+            stream << "    vec4 texel = " << sample << ";\n";
             if (traits & ShaderTrait::Modulate)
                 stream << "    texel *= modulation;\n";
             if (traits & ShaderTrait::AdjustSaturation)
@@ -898,7 +975,7 @@ QByteArray ShaderManager::generateFragmentSource(ShaderTraits traits) const
 
             stream << "    " << output << " = texel;\n";
         } else {
-            stream << "    " << output << " = " << textureLookup << "(sampler, texcoordC);\n";
+            stream << "    " << output << " = " << sample << ";\n";
         }
     } else if (traits & ShaderTrait::UniformColor)
         stream << "    " << output << " = geometryColor;\n";
@@ -927,13 +1004,13 @@ GLShader *ShaderManager::generateCustomShader(ShaderTraits traits, const QByteAr
 #endif
 
     GLShader *shader = new GLShader(GLShader::ExplicitLinking);
-    shader->load(vertex, fragment);
-
-    shader->bindAttributeLocation("position", VA_Position);
-    shader->bindAttributeLocation("texcoord", VA_TexCoord);
-    shader->bindFragDataLocation("fragColor", 0);
-
-    shader->link();
+    linkShader(shader, vertex, fragment, QByteArrayLiteral("position,texcoord,fragColor"),
+        [] (GLShader *shader) {
+            shader->bindAttributeLocation("position", VA_Position);
+            shader->bindAttributeLocation("texcoord", VA_TexCoord);
+            shader->bindFragDataLocation("fragColor", 0);
+        }
+    );
     return shader;
 }
 
@@ -971,6 +1048,9 @@ GLShader *ShaderManager::shader(ShaderTraits traits)
     if (!shader) {
         shader = generateShader(traits);
         m_shaderHash.insert(traits, shader);
+        if (m_cache && shader->isValid()) {
+            m_cache->addTraits(traits);
+        }
     }
 
     return shader;
@@ -1036,13 +1116,39 @@ void ShaderManager::bindAttributeLocations(GLShader *shader) const
 GLShader *ShaderManager::loadShaderFromCode(const QByteArray &vertexSource, const QByteArray &fragmentSource)
 {
     GLShader *shader = new GLShader(GLShader::ExplicitLinking);
-    shader->load(vertexSource, fragmentSource);
-    bindAttributeLocations(shader);
-    bindFragDataLocations(shader);
-    shader->link();
+    linkShader(shader, vertexSource, fragmentSource, QByteArrayLiteral("vertex,texCoord,fragColor"),
+        [this] (GLShader *shader) {
+            bindAttributeLocations(shader);
+            bindFragDataLocations(shader);
+        }
+    );
     return shader;
 }
 
+void ShaderManager::linkShader(GLShader *shader, const QByteArray &vertexSource, const QByteArray &fragmentSource,
+                               const QByteArray &bindings, const std::function<void (GLShader *)> &bind)
+{
+    QByteArray key;
+    if (m_cache) {
+        key = m_cache->key(vertexSource, fragmentSource, bindings);
+        if (m_cache->load(shader->mProgram, key)) {
+            shader->mValid = true;
+            return;
+        }
+    }
+
+    if (!shader->load(vertexSource, fragmentSource)) {
+        return;
+    }
+    bind(shader);
+    if (m_cache) {
+        m_cache->prepareLink(shader->mProgram);
+    }
+    if (shader->link() && m_cache) {
+        m_cache->store(shader->mProgram, key);
+    }
+}
+
 /***  GLRenderTarget  ***/
 bool GLRenderTarget::sSupported = false;
 bool GLRenderTarget::s_blitSupported = false;
@@ -2316,4 +2422,273 @@ GLVertexBuffer *GLVertexBuffer::streamingBuffer()
     return GLVertexBufferPrivate::streamingBuffer;
 }
 
+//*********************************
+// GLPixelUnpackBufferPrivate
+//*********************************
+
+class GLPixelUnpackBufferPrivate
+{
+public:
+    ~GLPixelUnpackBufferPrivate();
+
+    void uploadCopy(GLenum target, const QImage &image, const QRegion &region, GLenum format, GLenum type);
+    void uploadUnpack(GLenum target, const QImage &image, const QRegion &region, GLenum format, GLenum type);
+    void uploadStream(GLenum target, const QImage &image, const QRegion &region, GLenum format, GLenum type);
+
+    // a buffer is not written again before the next ones have been used,
+    // so an upload doesn't wait for the previous transfers to finish
+    static const int s_ringSize = 3;
+    GLuint buffers[s_ringSize] = {};
+    GLsizeiptr capacities[s_ringSize] = {};
+    int nextBuffer = 0;
+    GLPixelUnpackBuffer::Mode mode = GLPixelUnpackBuffer::Mode::Copy;
+
+    static bool supportsUnpack;
+    static bool supportsPixelBuffers;
+    static GLPixelUnpackBuffer *streamingBuffer;
+};
+
+bool GLPixelUnpackBufferPrivate::supportsUnpack = false;
+bool GLPixelUnpackBufferPrivate::supportsPixelBuffers = false;
+GLPixelUnpackBuffer *GLPixelUnpackBufferPrivate::streamingBuffer = nullptr;
+
+GLPixelUnpackBufferPrivate::~GLPixelUnpackBufferPrivate()
+{
+    for (GLuint buffer : buffers) {
+        if (buffer) {
+            glDeleteBuffers(1, &buffer);
+        }
+    }
+}
+
+void GLPixelUnpackBufferPrivate::uploadCopy(GLenum target, const QImage &image, const QRegion &region, GLenum format, GLenum type)
+{
+    for (const QRect &rect : region) {
+        const QRect r = rect & image.rect();
+        if (r.isEmpty()) {
+            continue;
+        }
+        const QImage part = image.copy(r);
+        glTexSubImage2D(target, 0, r.x(), r.y(), r.width(), r.height(), format, type, part.constBits());
+    }
+}
+
+void GLPixelUnpackBufferPrivate::uploadUnpack(GLenum target, const QImage &image, const QRegion &region, GLenum format, GLenum type)
+{
+    // GL_UNPACK_ROW_LENGTH counts pixels, the rows of e.g. a shm buffer may be padded by
+    // a stride which isn't a multiple of them
+    if (image.bytesPerLine() % 4) {
+        uploadCopy(target, image, region, format, type);
+        return;
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, image.bytesPerLine() / 4);
+    for (const QRect &rect : region) {
+        const QRect r = rect & image.rect();
+        if (r.isEmpty()) {
+            continue;
+        }
+        glTexSubImage2D(target, 0, r.x(), r.y(), r.width(), r.height(), format, type,
+                        image.constScanLine(r.y()) + r.x() * 4);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+void GLPixelUnpackBufferPrivate::uploadStream(GLenum target, const QImage &image, const QRegion &region, GLenum format, GLenum type)
+{
+    QVarLengthArray<QRect, 16> rects;
+    GLsizeiptr size = 0;
+    for (const QRect &rect : region) {
+        const QRect r = rect & image.rect();
+        if (!r.isEmpty()) {
+            rects.append(r);
+            size += r.width() * r.height() * 4;
+        }
+    }
+    if (size == 0) {
+        return;
+    }
+
+    const int index = nextBuffer;
+    nextBuffer = (nextBuffer + 1) % s_ringSize;
+    if (!buffers[index]) {
+        glGenBuffers(1, &buffers[index]);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[index]);
+    if (capacities[index] < size) {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        capacities[index] = size;
+    }
+    uint8_t *map = static_cast<uint8_t *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                                           GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (!map) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        uploadUnpack(target, image, region, format, type);
+        return;
+    }
+
+    // pack the rows of all rectangles tightly, the transfers are queued once the buffer is unmapped
+    uint8_t *dst = map;
+    for (const QRect &r : rects) {
+        const int rowSize = r.width() * 4;
+        for (int y = r.y(); y <= r.bottom(); ++y) {
+            std::memcpy(dst, image.constScanLine(y) + r.x() * 4, rowSize);
+            dst += rowSize;
+        }
+    }
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    uintptr_t offset = 0;
+    for (const QRect &r : rects) {
+        glTexSubImage2D(target, 0, r.x(), r.y(), r.width(), r.height(), format, type,
+                        reinterpret_cast<const void *>(offset));
+        offset += r.width() * r.height() * 4;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+//*********************************
+// GLPixelUnpackBuffer
+//*********************************
+
+GLPixelUnpackBuffer::GLPixelUnpackBuffer()
+    : d(new GLPixelUnpackBufferPrivate)
+{
+    setMode(Mode::Stream);
+}
+
+GLPixelUnpackBuffer::~GLPixelUnpackBuffer()
+{
+    delete d;
+}
+
+GLPixelUnpackBuffer::Mode GLPixelUnpackBuffer::mode() const
+{
+    return d->mode;
+}
+
+void GLPixelUnpackBuffer::setMode(Mode mode)
+{
+    if (mode == Mode::Stream && !GLPixelUnpackBufferPrivate::supportsPixelBuffers) {
+        mode = Mode::Unpack;
+    }
+    if (mode == Mode::Unpack && !GLPixelUnpackBufferPrivate::supportsUnpack) {
+        mode = Mode::Copy;
+    }
+    d->mode = mode;
+}
+
+void GLPixelUnpackBuffer::upload(GLenum target, const QImage &image, const QRegion &region, GLenum format, GLenum type)
+{
+    Q_ASSERT(image.depth() == 32);
+    switch (d->mode) {
+    case Mode::Stream:
+        d->uploadStream(target, image, region, format, type);
+        break;
+    case Mode::Unpack:
+        d->uploadUnpack(target, image, region, format, type);
+        break;
+    case Mode::Copy:
+        d->uploadCopy(target, image, region, format, type);
+        break;
+    }
+}
+
+void GLPixelUnpackBuffer::initStatic()
+{
+    if (GLPlatform::instance()->isGLES()) {
+        GLPixelUnpackBufferPrivate::supportsUnpack = hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_EXT_unpack_subimage"));
+        GLPixelUnpackBufferPrivate::supportsPixelBuffers = hasGLVersion(3, 0);
+    } else {
+        GLPixelUnpackBufferPrivate::supportsUnpack = true;
+        GLPixelUnpackBufferPrivate::supportsPixelBuffers = hasGLVersion(3, 0) ||
+            (hasGLExtension(QByteArrayLiteral("GL_ARB_pixel_buffer_object")) && hasGLExtension(QByteArrayLiteral("GL_ARB_map_buffer_range")));
+    }
+    if (qgetenv("KWIN_GL_PIXEL_BUFFERS") == QByteArrayLiteral("0")) {
+        GLPixelUnpackBufferPrivate::supportsPixelBuffers = false;
+    }
+    GLPixelUnpackBufferPrivate::streamingBuffer = new GLPixelUnpackBuffer;
+}
+
+void GLPixelUnpackBuffer::cleanup()
+{
+    delete GLPixelUnpackBufferPrivate::streamingBuffer;
+    GLPixelUnpackBufferPrivate::streamingBuffer = nullptr;
+    GLPixelUnpackBufferPrivate::supportsUnpack = false;
+    GLPixelUnpackBufferPrivate::supportsPixelBuffers = false;
+}
+
+GLPixelUnpackBuffer *GLPixelUnpackBuffer::streamingBuffer()
+{
+    return GLPixelUnpackBufferPrivate::streamingBuffer;
+}
+
+//*********************************
+// GLAsyncReadback
+//*********************************
+
+class GLAsyncReadbackPrivate
+{
+public:
+    GLuint buffer = 0;
+    GLsync fence = nullptr;
+    QSize size;
+};
+
+GLAsyncReadback::GLAsyncReadback(const QRect &rect)
+    : d(new GLAsyncReadbackPrivate)
+{
+    d->size = rect.size();
+
+    glGenBuffers(1, &d->buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, d->buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, rect.width() * rect.height() * 4, nullptr, GL_STREAM_READ);
+    glReadPixels(rect.x(), rect.y(), rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    d->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLAsyncReadback::~GLAsyncReadback()
+{
+    if (d->fence) {
+        glDeleteSync(d->fence);
+    }
+    glDeleteBuffers(1, &d->buffer);
+    delete d;
+}
+
+bool GLAsyncReadback::isReady() const
+{
+    if (!d->fence) {
+        return true;
+    }
+    // flushing makes sure the fence gets to the GPU at all
+    const GLenum result = glClientWaitSync(d->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+QImage GLAsyncReadback::image() const
+{
+    const GLsizeiptr size = d->size.width() * d->size.height() * 4;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, d->buffer);
+    const uchar *data = static_cast<const uchar *>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT));
+    QImage image;
+    if (data) {
+        image = QImage(data, d->size.width(), d->size.height(), QImage::Format_RGBA8888).copy();
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    return image;
+}
+
+bool GLAsyncReadback::supported()
+{
+    const bool hasFences = GLPlatform::instance()->isGLES()
+        ? hasGLVersion(3, 0)
+        : hasGLVersion(3, 2) || hasGLExtension(QByteArrayLiteral("GL_ARB_sync"));
+    return GLPixelUnpackBufferPrivate::supportsPixelBuffers && hasFences;
+}
+
 } // namespace
@@ -28,8 +28,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "kwingltexture.h"
 
 // Qt
+#include <QByteArray>
+#include <QHash>
 #include <QSize>
 #include <QStack>
+#include <QVector>
 
 /** @addtogroup kwineffects */
 /** @{ */
@@ -47,6 +50,9 @@ namespace KWin
 
 class GLVertexBuffer;
 class GLVertexBufferPrivate;
+class GLPixelUnpackBufferPrivate;
+class GLShaderCache;
+class GLAsyncReadbackPrivate;
 
 // Initializes OpenGL stuff. This includes resolving function pointers as
 //  well as checking for GL version and extensions
@@ -86,8 +92,18 @@ public:
 
     bool link();
 
+    /**
+     * The locations are cached per shader, so looking up the same uniform again
+     * does not query the GL.
+     */
     int uniformLocation(const char* name);
 
+    /**
+     * The setUniform methods remember the value of each uniform and skip the GL call if
+     * the uniform already has the passed value. Uniforms which are changed without using
+     * these methods, e.g. by calling glUniform directly, must not be set through them.
+     */
+
     bool setUniform(const char* name, float value);
     bool setUniform(const char* name, int value);
     bool setUniform(const char* name, const QVector2D& value);
@@ -167,6 +183,13 @@ protected:
     void resolveLocations();
 
 private:
+    bool updateUniformValue(int location, GLenum type, const void *value, size_t size);
+
+    struct UniformValue {
+        GLenum type = GL_NONE;
+        GLfloat data[16];
+    };
+
     unsigned int mProgram;
     bool mValid:1;
     bool mLocationsResolved:1;
@@ -177,6 +200,8 @@ private:
     int mFloatLocation[FloatUniformCount];
     int mIntLocation[IntUniformCount];
     int mColorLocation[ColorUniformCount];
+    QHash<QByteArray, int> mUniformLocations;
+    QVector<UniformValue> mUniformValues;
 
     friend class ShaderManager;
 };
@@ -188,6 +213,7 @@ enum class ShaderTrait {
     Modulate         = (1 << 2),
     AdjustSaturation = (1 << 3),
     ClampTexture     = (1 << 4),
+    YuvConversion    = (1 << 5), ///< @since 5.19, samples luma from sampler, chroma from samplerU and samplerV
 };
 
 Q_DECLARE_FLAGS(ShaderTraits, ShaderTrait)
@@ -322,10 +348,13 @@ private:
     QByteArray generateVertexSource(ShaderTraits traits) const;
     QByteArray generateFragmentSource(ShaderTraits traits) const;
     GLShader *generateShader(ShaderTraits traits);
+    void linkShader(GLShader *shader, const QByteArray &vertexSource, const QByteArray &fragmentSource,
+                    const QByteArray &bindings, const std::function<void (GLShader *)> &bind);
 
     QStack<GLShader*> m_boundShaders;
     QHash<ShaderTraits, GLShader *> m_shaderHash;
     QString m_resourcePath;
+    GLShaderCache *m_cache = nullptr;
     static ShaderManager *s_shaderManager;
 };
 
@@ -820,6 +849,107 @@ private:
     static qreal s_virtualScreenScale;
 };
 
+/**
+ * @short Uploads pixel data into textures.
+ *
+ * Uploads rectangles of an image into a texture without converting or copying the
+ * whole image first. The rows are read straight from the memory of the image with
+ * the help of GL_UNPACK_ROW_LENGTH. If pixel buffer objects are supported, the rows
+ * are staged in a ring of buffer objects instead, so that the transfer into the
+ * texture happens asynchronously.
+ *
+ * @since 5.19
+ */
+class KWINGLUTILS_EXPORT GLPixelUnpackBuffer
+{
+public:
+    /**
+     * How the pixels are passed on to the GL implementation.
+     */
+    enum class Mode {
+        Copy, ///< Every rectangle is copied out of the image
+        Unpack, ///< The rectangles are read from the image memory with GL_UNPACK_ROW_LENGTH
+        Stream ///< The rectangles are staged in pixel buffer objects
+    };
+
+    GLPixelUnpackBuffer();
+    ~GLPixelUnpackBuffer();
+
+    /**
+     * The way uploads are done, by default the best one supported.
+     */
+    Mode mode() const;
+    /**
+     * Forces the given @p mode, falls back to a supported one if needed.
+     */
+    void setMode(Mode mode);
+
+    /**
+     * Uploads the parts of @p image inside @p region to the same position of the texture
+     * bound to @p target. @p format and @p type describe the pixels of @p image, which has
+     * to use four bytes per pixel.
+     */
+    void upload(GLenum target, const QImage &image, const QRegion &region, GLenum format, GLenum type);
+
+    /**
+     * @internal
+     */
+    static void initStatic();
+
+    /**
+     * @internal
+     */
+    static void cleanup();
+
+    /**
+     * @return A shared buffer for streaming pixel data
+     */
+    static GLPixelUnpackBuffer *streamingBuffer();
+
+private:
+    GLPixelUnpackBufferPrivate *const d;
+    Q_DISABLE_COPY(GLPixelUnpackBuffer)
+};
+
+/**
+ * @short Reads pixels back from the GPU without stalling the pipeline.
+ *
+ * The pixels get copied into a pixel buffer object and a fence is inserted behind
+ * the copy. The pixels can be fetched without waiting once the GPU passed the fence,
+ * which can be polled with isReady().
+ *
+ * @since 5.19
+ */
+class KWINGLUTILS_EXPORT GLAsyncReadback
+{
+public:
+    /**
+     * Starts reading the pixels inside @p rect of the currently bound framebuffer.
+     * The rectangle is in OpenGL window coordinates, its origin is the bottom left corner.
+     */
+    explicit GLAsyncReadback(const QRect &rect);
+    ~GLAsyncReadback();
+
+    /**
+     * @returns @c true once the pixels arrived in the pixel buffer, does not block
+     */
+    bool isReady() const;
+    /**
+     * The read pixels in RGBA byte order with the rows ordered bottom to top, the way
+     * OpenGL returns them. Blocks until the GPU finished if the readback is not ready yet.
+     */
+    QImage image() const;
+
+    /**
+     * @returns Whether pixel buffer objects and fences are supported
+     */
+    static bool supported();
+
+private:
+    GLAsyncReadbackPrivate *const d;
+    Q_DISABLE_COPY(GLAsyncReadback)
+};
+
 } // namespace
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(KWin::ShaderTraits)
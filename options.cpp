@@ -120,6 +120,7 @@ Options::Options(QObject *parent)
     , m_glPreferBufferSwap(Options::defaultGlPreferBufferSwap())
     , m_glPlatformInterface(Options::defaultGlPlatformInterface())
     , m_windowsBlockCompositing(true)
+    , m_effectRenderBudget(Options::defaultEffectRenderBudget())
     , OpTitlebarDblClick(Options::defaultOperationTitlebarDblClick())
     , CmdActiveTitlebar1(Options::defaultCommandActiveTitlebar1())
     , CmdActiveTitlebar2(Options::defaultCommandActiveTitlebar2())
@@ -670,6 +671,16 @@ void Options::setWindowsBlockCompositing(bool value)
     emit windowsBlockCompositingChanged();
 }
 
+void Options::setEffectRenderBudget(int effectRenderBudget)
+{
+    effectRenderBudget = qBound(0, effectRenderBudget, 100);
+    if (m_effectRenderBudget == effectRenderBudget) {
+        return;
+    }
+    m_effectRenderBudget = effectRenderBudget;
+    emit effectRenderBudgetChanged();
+}
+
 void Options::setGlPreferBufferSwap(char glPreferBufferSwap)
 {
     if (glPreferBufferSwap == 'a') {
@@ -838,6 +849,7 @@ void Options::syncFromKcfgc()
     setElectricBorderTiling(m_settings->electricBorderTiling());
     setElectricBorderCornerRatio(m_settings->electricBorderCornerRatio());
     setWindowsBlockCompositing(m_settings->windowsBlockCompositing());
+    setEffectRenderBudget(m_settings->effectRenderBudget());
 
 }
 
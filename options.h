@@ -184,6 +184,10 @@ class KWIN_EXPORT Options : public QObject
     Q_PROPERTY(GlSwapStrategy glPreferBufferSwap READ glPreferBufferSwap WRITE setGlPreferBufferSwap NOTIFY glPreferBufferSwapChanged)
     Q_PROPERTY(KWin::OpenGLPlatformInterface glPlatformInterface READ glPlatformInterface WRITE setGlPlatformInterface NOTIFY glPlatformInterfaceChanged)
     Q_PROPERTY(bool windowsBlockCompositing READ windowsBlockCompositing WRITE setWindowsBlockCompositing NOTIFY windowsBlockCompositingChanged)
+    /**
+     * Percentage of the frame time a single effect may take before it gets bypassed for a while, 0 disables it.
+     */
+    Q_PROPERTY(int effectRenderBudget READ effectRenderBudget WRITE setEffectRenderBudget NOTIFY effectRenderBudgetChanged)
 public:
 
     explicit Options(QObject *parent = nullptr);
@@ -580,6 +584,11 @@ public:
         return m_windowsBlockCompositing;
     }
 
+    int effectRenderBudget() const
+    {
+        return m_effectRenderBudget;
+    }
+
     QStringList modifierOnlyDBusShortcut(Qt::KeyboardModifier mod) const;
 
     // setters
@@ -639,6 +648,7 @@ public:
     void setGlPreferBufferSwap(char glPreferBufferSwap);
     void setGlPlatformInterface(OpenGLPlatformInterface interface);
     void setWindowsBlockCompositing(bool set);
+    void setEffectRenderBudget(int effectRenderBudget);
 
     // default values
     static WindowOperation defaultOperationTitlebarDblClick() {
@@ -743,6 +753,9 @@ public:
     static OpenGLPlatformInterface defaultGlPlatformInterface() {
         return kwinApp()->shouldUseWaylandForCompositing() ? EglPlatformInterface : GlxPlatformInterface;
     }
+    static int defaultEffectRenderBudget() {
+        return 0;
+    }
     /**
      * Performs loading all settings except compositing related.
      */
@@ -815,6 +828,7 @@ Q_SIGNALS:
     void glPreferBufferSwapChanged();
     void glPlatformInterfaceChanged();
     void windowsBlockCompositingChanged();
+    void effectRenderBudgetChanged();
     void animationSpeedChanged();
 
     void configChanged();
@@ -859,6 +873,7 @@ private:
     GlSwapStrategy m_glPreferBufferSwap;
     OpenGLPlatformInterface m_glPlatformInterface;
     bool m_windowsBlockCompositing;
+    int m_effectRenderBudget;
 
     WindowOperation OpTitlebarDblClick;
     WindowOperation opMaxButtonRightClick = defaultOperationMaxButtonRightClick();
@@ -193,10 +193,10 @@ void Platform::setSoftWareCursor(bool set)
     }
     m_softWareCursor = set;
     if (m_softWareCursor) {
-        connect(Cursors::self(), &Cursors::positionChanged, this, &Platform::triggerCursorRepaint);
+        connect(Cursors::self(), &Cursors::positionChanged, this, &Platform::triggerCursorMotionRepaint);
         connect(Cursors::self(), &Cursors::currentCursorChanged, this, &Platform::triggerCursorRepaint);
     } else {
-        disconnect(Cursors::self(), &Cursors::positionChanged, this, &Platform::triggerCursorRepaint);
+        disconnect(Cursors::self(), &Cursors::positionChanged, this, &Platform::triggerCursorMotionRepaint);
         disconnect(Cursors::self(), &Cursors::currentCursorChanged, this, &Platform::triggerCursorRepaint);
     }
 }
@@ -210,6 +210,15 @@ void Platform::triggerCursorRepaint()
     Compositor::self()->addRepaint(Cursors::self()->currentCursor()->geometry());
 }
 
+void Platform::triggerCursorMotionRepaint()
+{
+    if (!Compositor::self()) {
+        return;
+    }
+    Compositor::self()->addPointerMotionRepaint(QRegion(m_cursor.lastRenderedGeometry)
+                                                | Cursors::self()->currentCursor()->geometry());
+}
+
 void Platform::cursorRendered(const QRect &geometry)
 {
     if (m_softWareCursor) {
@@ -542,6 +542,7 @@ protected:
 
 private:
     void triggerCursorRepaint();
+    void triggerCursorMotionRepaint();
     bool m_softWareCursor = false;
     struct {
         QRect lastRenderedGeometry;
@@ -389,8 +389,9 @@ void AbstractEglTexture::updateTexture(WindowPixmap *pixmap)
     auto s = pixmap->surface();
     if (EglDmabufBuffer *dmabuf = static_cast<EglDmabufBuffer *>(buffer->linuxDmabufBuffer())) {
         q->bind();
-        glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, (GLeglImageOES) dmabuf->images()[0]);   //TODO
+        glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, (GLeglImageOES) dmabuf->images()[0]);
         q->unbind();
+        updateDmabufPlanes(dmabuf);
         if (m_image != EGL_NO_IMAGE_KHR) {
             eglDestroyImageKHR(m_backend->eglDisplay(), m_image);
         }
@@ -438,35 +439,33 @@ void AbstractEglTexture::updateTexture(WindowPixmap *pixmap)
     const QRegion damage = s->trackedDamage();
     s->resetTrackedDamage();
     auto scale = s->scale(); //damage is normalised, so needs converting up to match texture
-
-    // TODO: this should be shared with GLTexture::update
-    if (GLPlatform::instance()->isGLES()) {
-        if (s_supportsARGB32 && (image.format() == QImage::Format_ARGB32 || image.format() == QImage::Format_ARGB32_Premultiplied)) {
-            const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-            for (const QRect &rect : damage) {
-                auto scaledRect = QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
-                glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                                GL_BGRA_EXT, GL_UNSIGNED_BYTE, im.copy(scaledRect).bits());
-            }
-        } else {
-            const QImage im = image.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
-            for (const QRect &rect : damage) {
-                auto scaledRect = QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
-                glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                                GL_RGBA, GL_UNSIGNED_BYTE, im.copy(scaledRect).bits());
-            }
-        }
-    } else {
-        const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-        for (const QRect &rect : damage) {
-            auto scaledRect = QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
-            glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                            GL_BGRA, GL_UNSIGNED_BYTE, im.copy(scaledRect).bits());
-        }
+    QRegion scaledDamage;
+    for (const QRect &rect : damage) {
+        scaledDamage += QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
     }
+    uploadImage(image, scaledDamage);
     q->unbind();
 }
 
+void AbstractEglTexture::uploadImage(const QImage &image, const QRegion &region)
+{
+    // The texture got created from BGRA data unless the GL implementation lacks support for it,
+    // an opaque texture just drops the alpha channel
+    const GLenum format = m_uploadFormat == QImage::Format_RGBA8888_Premultiplied ? GL_RGBA : GL_BGRA;
+    const bool matchesTexture = image.format() == m_uploadFormat ||
+        (m_uploadFormat == QImage::Format_RGB32 && image.format() == QImage::Format_ARGB32_Premultiplied);
+    if (matchesTexture) {
+        GLPixelUnpackBuffer::streamingBuffer()->upload(m_target, image, region, format, GL_UNSIGNED_BYTE);
+        return;
+    }
+    // convert only the parts which get uploaded
+    for (const QRect &rect : region) {
+        const QImage im = image.copy(rect).convertToFormat(m_uploadFormat);
+        glTexSubImage2D(m_target, 0, rect.x(), rect.y(), im.width(), im.height(),
+                        format, GL_UNSIGNED_BYTE, im.constBits());
+    }
+}
+
 bool AbstractEglTexture::loadShmTexture(const QPointer< KWayland::Server::BufferInterface > &buffer)
 {
     const QImage &image = buffer->data();
@@ -498,14 +497,17 @@ bool AbstractEglTexture::loadShmTexture(const QPointer< KWayland::Server::Buffer
             const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
             glTexImage2D(m_target, 0, GL_BGRA_EXT, im.width(), im.height(),
                          0, GL_BGRA_EXT, GL_UNSIGNED_BYTE, im.bits());
+            m_uploadFormat = QImage::Format_ARGB32_Premultiplied;
         } else {
             const QImage im = image.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
             glTexImage2D(m_target, 0, GL_RGBA, im.width(), im.height(),
                          0, GL_RGBA, GL_UNSIGNED_BYTE, im.bits());
+            m_uploadFormat = QImage::Format_RGBA8888_Premultiplied;
         }
     } else {
         glTexImage2D(m_target, 0, format, size.width(), size.height(), 0,
                     GL_BGRA, GL_UNSIGNED_BYTE, image.bits());
+        m_uploadFormat = format == GL_RGB8 ? QImage::Format_RGB32 : QImage::Format_ARGB32_Premultiplied;
     }
 
     q->unbind();
@@ -543,7 +545,7 @@ bool AbstractEglTexture::loadEglTexture(const QPointer< KWayland::Server::Buffer
 bool AbstractEglTexture::loadDmabufTexture(const QPointer< KWayland::Server::BufferInterface > &buffer)
 {
     auto *dmabuf = static_cast<EglDmabufBuffer *>(buffer->linuxDmabufBuffer());
-    if (!dmabuf || dmabuf->images()[0] == EGL_NO_IMAGE_KHR) {
+    if (!dmabuf || dmabuf->images().isEmpty() || dmabuf->images()[0] == EGL_NO_IMAGE_KHR) {
         qCritical(KWIN_OPENGL) << "Invalid dmabuf-based wl_buffer";
         q->discard();
         return false;
@@ -557,6 +559,7 @@ bool AbstractEglTexture::loadDmabufTexture(const QPointer< KWayland::Server::Buf
     q->bind();
     glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, (GLeglImageOES) dmabuf->images()[0]);
     q->unbind();
+    updateDmabufPlanes(dmabuf);
 
     m_size = dmabuf->size();
     q->setYInverted(!(dmabuf->flags() & KWayland::Server::LinuxDmabufUnstableV1Interface::YInverted));
@@ -564,6 +567,53 @@ bool AbstractEglTexture::loadDmabufTexture(const QPointer< KWayland::Server::Buf
     return true;
 }
 
+void AbstractEglTexture::updateDmabufPlanes(EglDmabufBuffer *dmabuf)
+{
+    const QVector<EGLImage> images = dmabuf->images();
+    if (dmabuf->textureType() == EGL_TEXTURE_RGBA || images.count() < 2) {
+        glDeleteTextures(2, m_planes);
+        m_planes[0] = m_planes[1] = 0;
+        return;
+    }
+
+    if (!m_planes[0]) {
+        glGenTextures(2, m_planes);
+        for (GLuint plane : m_planes) {
+            glBindTexture(GL_TEXTURE_2D, plane);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+    }
+
+    // Y_UV and Y_XUXV carry both chroma channels in the second image
+    const EGLImage uImage = images[1];
+    const EGLImage vImage = images.count() > 2 ? images[2] : images[1];
+    glBindTexture(GL_TEXTURE_2D, m_planes[0]);
+    glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, (GLeglImageOES) uImage);
+    glBindTexture(GL_TEXTURE_2D, m_planes[1]);
+    glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, (GLeglImageOES) vImage);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    switch (dmabuf->textureType()) {
+    case EGL_TEXTURE_Y_UV_WL:
+        m_uSelector = QVector4D(1, 0, 0, 0);
+        m_vSelector = QVector4D(0, 1, 0, 0);
+        break;
+    case EGL_TEXTURE_Y_XUXV_WL:
+        // the second image is sampled as ARGB8888, that is Y1 in red, U in green and V in alpha
+        m_uSelector = QVector4D(0, 1, 0, 0);
+        m_vSelector = QVector4D(0, 0, 0, 1);
+        break;
+    case EGL_TEXTURE_Y_U_V_WL:
+    default:
+        m_uSelector = QVector4D(1, 0, 0, 0);
+        m_vSelector = QVector4D(1, 0, 0, 0);
+        break;
+    }
+}
+
 bool AbstractEglTexture::loadInternalImageObject(WindowPixmap *pixmap)
 {
     // FIXME: Share some code with loadShmTexture().
@@ -598,14 +648,17 @@ bool AbstractEglTexture::loadInternalImageObject(WindowPixmap *pixmap)
             const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
             glTexImage2D(m_target, 0, GL_BGRA_EXT, im.width(), im.height(),
                          0, GL_BGRA_EXT, GL_UNSIGNED_BYTE, im.bits());
+            m_uploadFormat = QImage::Format_ARGB32_Premultiplied;
         } else {
             const QImage im = image.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
             glTexImage2D(m_target, 0, GL_RGBA, im.width(), im.height(),
                          0, GL_RGBA, GL_UNSIGNED_BYTE, im.bits());
+            m_uploadFormat = QImage::Format_RGBA8888_Premultiplied;
         }
     } else {
         glTexImage2D(m_target, 0, format, size.width(), size.height(), 0,
                     GL_BGRA, GL_UNSIGNED_BYTE, image.bits());
+        m_uploadFormat = format == GL_RGB8 ? QImage::Format_RGB32 : QImage::Format_ARGB32_Premultiplied;
     }
 
     q->unbind();
@@ -675,34 +728,13 @@ bool AbstractEglTexture::updateFromInternalImageObject(WindowPixmap *pixmap)
     const QRegion damage = pixmap->toplevel()->damage();
     const qreal scale = image.devicePixelRatio();
 
-    q->bind();
-
-    // TODO: this should be shared with GLTexture::update
-    if (GLPlatform::instance()->isGLES()) {
-        if (s_supportsARGB32 && (image.format() == QImage::Format_ARGB32 || image.format() == QImage::Format_ARGB32_Premultiplied)) {
-            const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-            for (const QRect &rect : damage) {
-                auto scaledRect = QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
-                glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                                GL_BGRA_EXT, GL_UNSIGNED_BYTE, im.copy(scaledRect).bits());
-            }
-        } else {
-            const QImage im = image.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
-            for (const QRect &rect : damage) {
-                auto scaledRect = QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
-                glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                                GL_RGBA, GL_UNSIGNED_BYTE, im.copy(scaledRect).bits());
-            }
-        }
-    } else {
-        const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-        for (const QRect &rect : damage) {
-            auto scaledRect = QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
-            glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                            GL_BGRA, GL_UNSIGNED_BYTE, im.copy(scaledRect).bits());
-        }
+    QRegion scaledDamage;
+    for (const QRect &rect : damage) {
+        scaledDamage += QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
     }
 
+    q->bind();
+    uploadImage(image, scaledDamage);
     q->unbind();
 
     return true;
@@ -40,6 +40,7 @@ namespace KWin
 {
 
 class EglDmabuf;
+class EglDmabufBuffer;
 
 class KWIN_EXPORT AbstractEglBackend : public QObject, public OpenGLBackend
 {
@@ -118,9 +119,13 @@ private:
     EGLImageKHR attach(const QPointer<KWayland::Server::BufferInterface> &buffer);
     bool updateFromFBO(const QSharedPointer<QOpenGLFramebufferObject> &fbo);
     bool updateFromInternalImageObject(WindowPixmap *pixmap);
+    void uploadImage(const QImage &image, const QRegion &region);
+    void updateDmabufPlanes(EglDmabufBuffer *dmabuf);
     SceneOpenGLTexture *q;
     AbstractEglBackend *m_backend;
     EGLImageKHR m_image;
+    // the layout of the pixels the texture got created from
+    QImage::Format m_uploadFormat = QImage::Format_Invalid;
 };
 
 }
@@ -103,6 +103,18 @@ bool OpenGLBackend::perScreenRendering() const
     return false;
 }
 
+bool OpenGLBackend::perScreenPresentation() const
+{
+    return false;
+}
+
+bool OpenGLBackend::scanout(int screenId, KWayland::Server::SurfaceInterface *surface)
+{
+    Q_UNUSED(screenId)
+    Q_UNUSED(surface)
+    return false;
+}
+
 void OpenGLBackend::copyPixels(const QRegion &region)
 {
     const int height = screens()->size().height();
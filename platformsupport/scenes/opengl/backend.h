@@ -26,6 +26,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <kwin_export.h>
 
+namespace KWayland
+{
+namespace Server
+{
+class SurfaceInterface;
+}
+}
+
 namespace KWin
 {
 class OpenGLBackend;
@@ -90,7 +98,21 @@ public:
      * Default implementation returns @c false.
      */
     virtual bool perScreenRendering() const;
+    /**
+     * Whether every screen is presented on its own, at its own refresh rate. Only
+     * considered if perScreenRendering() is @c true.
+     * Default implementation returns @c false.
+     */
+    virtual bool perScreenPresentation() const;
     virtual QRegion prepareRenderingForScreen(int screenId);
+    /**
+     * Tries to put the buffer attached to @p surface directly on the screen @p screenId
+     * instead of compositing it. Only considered if perScreenPresentation() is @c true.
+     * Default implementation returns @c false.
+     *
+     * @returns @c true if the buffer got presented, @c false if the screen has to be composited
+     */
+    virtual bool scanout(int screenId, KWayland::Server::SurfaceInterface *surface);
     /**
      * @brief Compositor is going into idle mode, flushes any pending paints.
      */
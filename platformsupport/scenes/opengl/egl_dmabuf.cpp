@@ -210,6 +210,11 @@ void EglDmabufBuffer::addImage(EGLImage image)
     m_images << image;
 }
 
+void EglDmabufBuffer::setTextureType(EGLint textureType)
+{
+    m_textureType = textureType;
+}
+
 void EglDmabufBuffer::removeImages()
 {
     for (auto image : m_images) {
@@ -308,11 +313,18 @@ KWayland::Server::LinuxDmabufUnstableV1Buffer* EglDmabuf::importBuffer(const QVe
         return new EglDmabufBuffer(img, planes, format, size, flags, this);
     }
 
-    // TODO: to enable this we must be able to store multiple textures per window pixmap
-    //       and when on window draw do yuv to rgb transformation per shader (see Weston)
-//    // not a single image, try yuv import
-//    return yuvImport(planes, format, size, flags);
+    // not a single image, try to import the planes of a yuv buffer on their own,
+    // the scene converts them to rgb when sampling
+    return yuvImport(planes, format, size, flags);
+}
 
+static const YuvFormat *findYuvFormat(uint32_t format)
+{
+    for (const YuvFormat &yuvFormat : yuvFormats) {
+        if (yuvFormat.format == format) {
+            return &yuvFormat;
+        }
+    }
     return nullptr;
 }
 
@@ -321,44 +333,50 @@ KWayland::Server::LinuxDmabufUnstableV1Buffer* EglDmabuf::yuvImport(const QVecto
                                                                     const QSize &size,
                                                                     Flags flags)
 {
-    YuvFormat yuvFormat;
-    for (YuvFormat f : yuvFormats) {
-        if (f.format == format) {
-            yuvFormat = f;
-            break;
-        }
-    }
-    if (yuvFormat.format == 0) {
+    const YuvFormat *yuvFormat = findYuvFormat(format);
+    if (!yuvFormat || planes.count() != yuvFormat->inputPlanes) {
         return nullptr;
     }
-    if (planes.count() != yuvFormat.inputPlanes) {
+
+    auto *buf = new EglDmabufBuffer(planes, format, size, flags, this);
+    if (!importYuvPlanes(buf)) {
+        delete buf;
         return nullptr;
     }
+    return buf;
+}
 
-    auto *buf = new EglDmabufBuffer(planes, format, size, flags, this);
+bool EglDmabuf::importYuvPlanes(EglDmabufBuffer *buffer)
+{
+    const YuvFormat *yuvFormat = findYuvFormat(buffer->format());
+    if (!yuvFormat) {
+        return false;
+    }
+    const QVector<Plane> planes = buffer->planes();
+    const QSize size = buffer->size();
 
-    for (int i = 0; i < yuvFormat.outputPlanes; i++) {
-        int planeIndex = yuvFormat.planes[i].planeIndex;
+    for (int i = 0; i < yuvFormat->outputPlanes; i++) {
+        int planeIndex = yuvFormat->planes[i].planeIndex;
         Plane plane = {
             planes[planeIndex].fd,
             planes[planeIndex].offset,
             planes[planeIndex].stride,
             planes[planeIndex].modifier
         };
-        const auto planeFormat = yuvFormat.planes[i].format;
-        const auto planeSize = QSize(size.width() / yuvFormat.planes[i].widthDivisor,
-                                     size.height() / yuvFormat.planes[i].heightDivisor);
+        const auto planeFormat = yuvFormat->planes[i].format;
+        const auto planeSize = QSize(size.width() / yuvFormat->planes[i].widthDivisor,
+                                     size.height() / yuvFormat->planes[i].heightDivisor);
         auto *image = createImage(QVector<Plane>(1, plane),
                                   planeFormat,
                                   planeSize);
         if (!image) {
-            delete buf;
-            return nullptr;
+            buffer->removeImages();
+            return false;
         }
-        buf->addImage(image);
+        buffer->addImage(image);
     }
-    // TODO: add buf import properties
-    return buf;
+    buffer->setTextureType(yuvFormat->textureType);
+    return true;
 }
 
 EglDmabuf* EglDmabuf::factory(AbstractEglBackend *backend)
@@ -387,7 +405,11 @@ EglDmabuf::EglDmabuf(AbstractEglBackend *backend)
     for (auto *buffer : prevBuffersSet) {
         auto *buf = static_cast<EglDmabufBuffer*>(buffer);
         buf->setInterfaceImplementation(this);
-        buf->addImage(createImage(buf->planes(), buf->format(), buf->size()));
+        if (buf->textureType() != EGL_TEXTURE_RGBA) {
+            importYuvPlanes(buf);
+        } else {
+            buf->addImage(createImage(buf->planes(), buf->format(), buf->size()));
+        }
     }
     setSupportedFormatsAndModifiers();
 }
@@ -434,6 +456,11 @@ void filterFormatsWithMultiplePlanes(QVector<uint32_t> &formats)
 {
     QVector<uint32_t>::iterator it = formats.begin();
     while (it != formats.end()) {
+        // the planes of these get imported separately
+        if (findYuvFormat(*it)) {
+            it++;
+            continue;
+        }
         for (auto linuxFormat : s_multiPlaneFormats) {
             if (*it == linuxFormat) {
                 qDebug() << "Filter multi-plane format" << *it;
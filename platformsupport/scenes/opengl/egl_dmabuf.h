@@ -62,8 +62,16 @@ public:
 
     QVector<EGLImage> images() const { return m_images; }
 
+    /**
+     * The layout of the images, EGL_TEXTURE_RGBA for a single image or one of the
+     * YUV texture formats of EGL_WL_bind_wayland_display for a buffer split into planes.
+     */
+    EGLint textureType() const { return m_textureType; }
+    void setTextureType(EGLint textureType);
+
 private:
     QVector<EGLImage> m_images;
+    EGLint m_textureType = EGL_TEXTURE_RGBA;
     EglDmabuf *m_interfaceImpl;
     ImportType m_importType;
 };
@@ -93,6 +101,7 @@ private:
                                                              uint32_t format,
                                                              const QSize &size,
                                                              Flags flags);
+    bool importYuvPlanes(EglDmabufBuffer *buffer);
 
     void setSupportedFormatsAndModifiers();
 
@@ -22,6 +22,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "backend.h"
 #include "scene.h"
 
+#include <kwinglutils.h>
+
 namespace KWin
 {
 
@@ -64,12 +66,43 @@ void SceneOpenGLTexture::updateFromPixmap(WindowPixmap *pixmap)
     d->updateTexture(pixmap);
 }
 
+bool SceneOpenGLTexture::isYuv() const
+{
+    Q_D(const SceneOpenGLTexture);
+    return d->m_planes[0] != 0;
+}
+
+void SceneOpenGLTexture::bindPlanes(GLShader *shader)
+{
+    Q_D(SceneOpenGLTexture);
+    for (int i = 0; i < 2; ++i) {
+        glActiveTexture(GL_TEXTURE1 + i);
+        glBindTexture(GL_TEXTURE_2D, d->m_planes[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    shader->setUniform("samplerU", 1);
+    shader->setUniform("samplerV", 2);
+    shader->setUniform("uSelector", d->m_uSelector);
+    shader->setUniform("vSelector", d->m_vSelector);
+}
+
+void SceneOpenGLTexture::unbindPlanes()
+{
+    for (int i = 0; i < 2; ++i) {
+        glActiveTexture(GL_TEXTURE1 + i);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
 SceneOpenGLTexturePrivate::SceneOpenGLTexturePrivate()
 {
 }
 
 SceneOpenGLTexturePrivate::~SceneOpenGLTexturePrivate()
 {
+    glDeleteTextures(2, m_planes);
 }
 
 void SceneOpenGLTexturePrivate::updateTexture(WindowPixmap *pixmap)
@@ -23,9 +23,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <kwingltexture.h>
 #include <kwingltexture_p.h>
 
+#include <QVector4D>
+
 namespace KWin
 {
 
+class GLShader;
 class OpenGLBackend;
 class SceneOpenGLTexturePrivate;
 class WindowPixmap;
@@ -40,6 +43,18 @@ public:
 
     void discard() override final;
 
+    /**
+     * Whether the texture holds the luma plane of a YUV buffer. Such a texture has to be
+     * painted with a shader that has the ShaderTrait::YuvConversion.
+     */
+    bool isYuv() const;
+    /**
+     * Binds the chroma planes to the texture units 1 and 2 and points the samplers
+     * of the YUV conversion @p shader at them.
+     */
+    void bindPlanes(GLShader *shader);
+    void unbindPlanes();
+
 private:
     SceneOpenGLTexture(SceneOpenGLTexturePrivate& dd);
 
@@ -60,6 +75,12 @@ public:
     virtual void updateTexture(WindowPixmap *pixmap);
     virtual OpenGLBackend *backend() = 0;
 
+    // Chroma plane textures of a YUV buffer, the texture itself holds the luma plane
+    GLuint m_planes[2] = {0, 0};
+    // The chroma channels within the plane textures
+    QVector4D m_uSelector;
+    QVector4D m_vSelector;
+
 protected:
     SceneOpenGLTexturePrivate();
 
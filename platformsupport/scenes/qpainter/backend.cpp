@@ -59,6 +59,23 @@ bool QPainterBackend::perScreenRendering() const
     return false;
 }
 
+bool QPainterBackend::perScreenPresentation() const
+{
+    return false;
+}
+
+bool QPainterBackend::syncsToVBlank() const
+{
+    return false;
+}
+
+void QPainterBackend::presentScreen(int screenId, int mask, const QRegion &damage)
+{
+    Q_UNUSED(screenId)
+    Q_UNUSED(mask)
+    Q_UNUSED(damage)
+}
+
 QImage *QPainterBackend::bufferForScreen(int screenId)
 {
     Q_UNUSED(screenId)
@@ -86,6 +86,23 @@ public:
      * Default implementation returns @c false.
      */
     virtual bool perScreenRendering() const;
+    /**
+     * Whether every screen is presented on its own, at its own refresh rate. If @c true
+     * presentScreen() is called for every painted screen instead of present().
+     * Only considered if perScreenRendering() is @c true.
+     * Default implementation returns @c false.
+     */
+    virtual bool perScreenPresentation() const;
+    /**
+     * Presents the buffer of the screen @p screenId, used if perScreenPresentation() is @c true.
+     * Default implementation does nothing.
+     */
+    virtual void presentScreen(int screenId, int mask, const QRegion &damage);
+    /**
+     * Whether the presented frames are synchronized to the vblank of the screens.
+     * Default implementation returns @c false.
+     */
+    virtual bool syncsToVBlank() const;
 
 protected:
     QPainterBackend();
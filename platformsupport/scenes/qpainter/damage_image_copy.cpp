@@ -0,0 +1,59 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "damage_image_copy.h"
+
+#include <QImage>
+#include <QRegion>
+
+#include <cstring>
+
+namespace KWin
+{
+
+qint64 copyDamagedImage(QImage &target, const QImage &source, const QRegion &damage, qreal scale)
+{
+    if (source.isNull()) {
+        target = QImage();
+        return 0;
+    }
+    if (target.size() != source.size() || target.format() != source.format()) {
+        target = source.copy();
+        return target.sizeInBytes();
+    }
+    const int bytesPerPixel = source.depth() / 8;
+    const QRect bounds = source.rect();
+    qint64 copied = 0;
+    for (const QRect &rect : damage) {
+        const QRect scaledRect = QRect(rect.x() * scale, rect.y() * scale,
+                                       rect.width() * scale, rect.height() * scale).intersected(bounds);
+        if (scaledRect.isEmpty()) {
+            continue;
+        }
+        const int offset = scaledRect.x() * bytesPerPixel;
+        const int length = scaledRect.width() * bytesPerPixel;
+        for (int y = scaledRect.top(); y <= scaledRect.bottom(); ++y) {
+            std::memcpy(target.scanLine(y) + offset, source.constScanLine(y) + offset, length);
+        }
+        copied += qint64(length) * scaledRect.height();
+    }
+    return copied;
+}
+
+}
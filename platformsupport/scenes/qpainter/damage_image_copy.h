@@ -0,0 +1,44 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_SCENE_QPAINTER_DAMAGE_IMAGE_COPY_H
+#define KWIN_SCENE_QPAINTER_DAMAGE_IMAGE_COPY_H
+
+#include <QtGlobal>
+
+class QImage;
+class QRegion;
+
+namespace KWin
+{
+
+/**
+ * @brief Copies the @p damage of @p source into the persistent @p target image.
+ *
+ * The @p damage is in surface local coordinates and gets multiplied by @p scale to
+ * map it into buffer coordinates. If @p target does not have the size and format
+ * of @p source it is replaced by a deep copy of the complete @p source.
+ *
+ * @returns the number of bytes which got copied
+ */
+qint64 copyDamagedImage(QImage &target, const QImage &source, const QRegion &damage, qreal scale);
+
+}
+
+#endif
@@ -0,0 +1,117 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "drm_atomic_cursor.h"
+#include "drm_buffer.h"
+#include "drm_object_plane.h"
+#include "logging.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <xf86drm.h>
+
+namespace KWin
+{
+
+DrmAtomicCursor::DrmAtomicCursor(DrmPlane *plane, int fd)
+    : m_plane(plane)
+    , m_fd(fd)
+{
+}
+
+void DrmAtomicCursor::setBuffer(DrmBuffer *buffer)
+{
+    m_buffer = buffer;
+    m_dirty = true;
+}
+
+void DrmAtomicCursor::setPosition(const QPoint &pos)
+{
+    if (m_pos == pos) {
+        return;
+    }
+    m_pos = pos;
+    m_dirty = true;
+}
+
+void DrmAtomicCursor::setCrtc(uint32_t crtcId)
+{
+    if (m_crtcId == crtcId) {
+        return;
+    }
+    m_crtcId = crtcId;
+    m_dirty = true;
+}
+
+void DrmAtomicCursor::updatePlane()
+{
+    const bool visible = m_buffer && m_crtcId != 0;
+    const QSize size = visible ? m_buffer->size() : QSize();
+    m_plane->setValue(int(DrmPlane::PropertyIndex::SrcX), 0);
+    m_plane->setValue(int(DrmPlane::PropertyIndex::SrcY), 0);
+    m_plane->setValue(int(DrmPlane::PropertyIndex::SrcW), size.width() << 16);
+    m_plane->setValue(int(DrmPlane::PropertyIndex::SrcH), size.height() << 16);
+    m_plane->setValue(int(DrmPlane::PropertyIndex::CrtcX), m_pos.x());
+    m_plane->setValue(int(DrmPlane::PropertyIndex::CrtcY), m_pos.y());
+    m_plane->setValue(int(DrmPlane::PropertyIndex::CrtcW), size.width());
+    m_plane->setValue(int(DrmPlane::PropertyIndex::CrtcH), size.height());
+    m_plane->setValue(int(DrmPlane::PropertyIndex::FbId), visible ? m_buffer->bufferId() : 0);
+    m_plane->setValue(int(DrmPlane::PropertyIndex::CrtcId), visible ? m_crtcId : 0);
+}
+
+bool DrmAtomicCursor::populate(drmModeAtomicReq *req)
+{
+    updatePlane();
+    return m_plane->atomicPopulate(req);
+}
+
+void DrmAtomicCursor::committed()
+{
+    m_dirty = false;
+}
+
+bool DrmAtomicCursor::commit(void *userData)
+{
+    Q_ASSERT(!m_commitPending);
+    drmModeAtomicReq *req = drmModeAtomicAlloc();
+    if (!req) {
+        qCWarning(KWIN_DRM) << "DRM: couldn't allocate atomic request";
+        return false;
+    }
+    bool ok = populate(req);
+    if (ok && drmModeAtomicCommit(m_fd, req, DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, userData) != 0) {
+        qCWarning(KWIN_DRM) << "Atomic cursor commit failed:" << strerror(errno);
+        ok = false;
+    }
+    drmModeAtomicFree(req);
+    if (!ok) {
+        return false;
+    }
+    m_dirty = false;
+    m_commitPending = true;
+    return true;
+}
+
+void DrmAtomicCursor::pageFlipped()
+{
+    m_commitPending = false;
+}
+
+}
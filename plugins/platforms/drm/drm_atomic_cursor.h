@@ -0,0 +1,109 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_DRM_ATOMIC_CURSOR_H
+#define KWIN_DRM_ATOMIC_CURSOR_H
+
+#include <QPoint>
+#include <xf86drmMode.h>
+
+namespace KWin
+{
+
+class DrmBuffer;
+class DrmPlane;
+
+/**
+ * The hardware cursor of an output in atomic mode, shown on a cursor plane.
+ *
+ * Changes only get staged. They go along with the next atomic commit of the output
+ * through populate(), or get committed on their own through commit() while the output
+ * is idle. A commit of its own doesn't flip any buffers of the output, it only occupies
+ * the output until its page flip event arrives.
+ */
+class DrmAtomicCursor
+{
+public:
+    DrmAtomicCursor(DrmPlane *plane, int fd);
+
+    DrmPlane *plane() const {
+        return m_plane;
+    }
+
+    /**
+     * Shows @p buffer on the plane, @c nullptr hides the cursor.
+     */
+    void setBuffer(DrmBuffer *buffer);
+    /**
+     * Position of the top left corner of the cursor buffer on the crtc.
+     */
+    void setPosition(const QPoint &pos);
+    /**
+     * The crtc the cursor is shown on, 0 while the crtc is off. A plane must not be
+     * attached to a disabled crtc.
+     */
+    void setCrtc(uint32_t crtcId);
+
+    /**
+     * @returns Whether there are changes which did not get committed yet
+     */
+    bool isDirty() const {
+        return m_dirty;
+    }
+    /**
+     * @returns Whether a commit() waits for its page flip event
+     */
+    bool isCommitPending() const {
+        return m_commitPending;
+    }
+
+    /**
+     * Adds the cursor state to @p req of an atomic commit of the whole output.
+     */
+    bool populate(drmModeAtomicReq *req);
+    /**
+     * The commit populated through populate() went through.
+     */
+    void committed();
+
+    /**
+     * Commits the staged state on its own with a nonblocking commit. Its page flip event
+     * carries @p userData.
+     */
+    bool commit(void *userData);
+    /**
+     * The page flip event of the last commit() arrived.
+     */
+    void pageFlipped();
+
+private:
+    void updatePlane();
+
+    DrmPlane *m_plane;
+    int m_fd;
+    DrmBuffer *m_buffer = nullptr;
+    QPoint m_pos;
+    uint32_t m_crtcId = 0;
+    bool m_dirty = false;
+    bool m_commitPending = false;
+};
+
+}
+
+#endif
@@ -27,18 +27,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "logging.h"
 #include "logind.h"
 #include "main.h"
+#include "scene.h"
 #include "scene_qpainter_drm_backend.h"
 #include "screens_drm.h"
 #include "udev.h"
 #include "wayland_server.h"
 #if HAVE_GBM
 #include "egl_gbm_backend.h"
+#include "linux_dmabuf.h"
 #include <gbm.h>
+#include <drm_fourcc.h>
 #endif
 #if HAVE_EGL_STREAMS
 #include "egl_stream_backend.h"
 #endif
 // KWayland
+#include <KWayland/Server/buffer_interface.h>
 #include <KWayland/Server/seat_interface.h>
 // KF5
 #include <KConfigGroup>
@@ -65,11 +69,27 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define DRM_CAP_CURSOR_HEIGHT 0x9
 #endif
 
+#ifndef DRM_FORMAT_MOD_LINEAR
+#define DRM_FORMAT_MOD_LINEAR 0
+#endif
+
+#ifndef DRM_FORMAT_MOD_INVALID
+#define DRM_FORMAT_MOD_INVALID ((1ULL << 56) - 1)
+#endif
+
 #define KWIN_DRM_EVENT_CONTEXT_VERSION 2
 
 namespace KWin
 {
 
+// Whether the scene presents every output on its own. In that case the compositor
+// is told about the page flips per output instead of waiting for all of them.
+static bool presentsPerOutput()
+{
+    Compositor *compositor = Compositor::self();
+    return compositor && compositor->scene() && compositor->scene()->perScreenPresentation();
+}
+
 DrmBackend::DrmBackend(QObject *parent)
     : Platform(parent)
     , m_udev(new Udev)
@@ -94,7 +114,7 @@ DrmBackend::~DrmBackend()
 #endif
     if (m_fd >= 0) {
         // wait for pageflips
-        while (m_pageFlipsPending != 0) {
+        while (m_pageFlipsPending != 0 || m_cursorCommitsPending != 0) {
             QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
         }
 
@@ -207,7 +227,11 @@ void DrmBackend::reactivate()
     }
     // restart compositor
     m_pageFlipsPending = 0;
+    m_cursorCommitsPending = 0;
     if (Compositor *compositor = Compositor::self()) {
+        for (int i = 0; i < m_enabledOutputs.count(); ++i) {
+            compositor->bufferSwapComplete(i);
+        }
         compositor->bufferSwapComplete();
         compositor->addRepaintFull();
     }
@@ -218,8 +242,8 @@ void DrmBackend::deactivate()
     if (!m_active) {
         return;
     }
-    // block compositor
-    if (m_pageFlipsPending == 0 && Compositor::self()) {
+    // block compositor, with per output presentation pending page flips don't block it
+    if ((m_pageFlipsPending == 0 || presentsPerOutput()) && Compositor::self()) {
         Compositor::self()->aboutToSwapBuffers();
     }
     // hide cursor and disable
@@ -238,16 +262,32 @@ void DrmBackend::pageFlipHandler(int fd, unsigned int frame, unsigned int sec, u
     Q_UNUSED(usec)
     auto output = reinterpret_cast<DrmOutput*>(data);
 
-    output->pageFlipped();
-    output->m_backend->m_pageFlipsPending--;
-    if (output->m_backend->m_pageFlipsPending == 0) {
-        // TODO: improve, this currently means we wait for all page flips or all outputs.
-        // It would be better to driver the repaint per output
+    DrmBackend *backend = output->m_backend;
+    const int screenId = backend->m_enabledOutputs.indexOf(output);
 
+    if (output->isCursorCommitPending()) {
+        // the compositor didn't wait for the cursor, only a frame presented meanwhile concerns it
+        output->pageFlipped();
+        backend->m_cursorCommitsPending--;
+        if (output->presentDeferredFrame()) {
+            backend->commitCursor(output);
+            return;
+        }
+        // the held back frame got dropped, don't leave the compositor waiting for its page flip
+    } else {
+        output->pageFlipped();
+    }
+    backend->m_pageFlipsPending--;
+    if (presentsPerOutput()) {
+        // every output is repainted as soon as its own page flip completed
+        Compositor::self()->bufferSwapComplete(screenId);
+    } else if (backend->m_pageFlipsPending == 0) {
         if (Compositor::self()) {
             Compositor::self()->bufferSwapComplete();
         }
     }
+    // pointer motion during the flip, unless a new frame already took it along
+    backend->commitCursor(output);
 }
 
 void DrmBackend::openDrm()
@@ -611,10 +651,7 @@ bool DrmBackend::present(DrmBuffer *buffer, DrmOutput *output)
     }
 
     if (output->present(buffer)) {
-        m_pageFlipsPending++;
-        if (m_pageFlipsPending == 1 && Compositor::self()) {
-            Compositor::self()->aboutToSwapBuffers();
-        }
+        bufferPresented(output);
         return true;
     } else if (m_deleteBufferAfterPageFlip) {
         delete buffer;
@@ -622,6 +659,28 @@ bool DrmBackend::present(DrmBuffer *buffer, DrmOutput *output)
     return false;
 }
 
+bool DrmBackend::scanout(DrmBuffer *buffer, DrmOutput *output)
+{
+    if (!buffer || buffer->bufferId() == 0 || !output->scanout(buffer)) {
+        if (m_deleteBufferAfterPageFlip) {
+            delete buffer;
+        }
+        return false;
+    }
+    bufferPresented(output);
+    return true;
+}
+
+void DrmBackend::bufferPresented(DrmOutput *output)
+{
+    m_pageFlipsPending++;
+    if (presentsPerOutput()) {
+        Compositor::self()->aboutToSwapBuffers(m_enabledOutputs.indexOf(output));
+    } else if (m_pageFlipsPending == 1 && Compositor::self()) {
+        Compositor::self()->aboutToSwapBuffers();
+    }
+}
+
 void DrmBackend::initCursor()
 {
 
@@ -648,6 +707,7 @@ void DrmBackend::initCursor()
                 } else {
                     (*it)->hideCursor();
                 }
+                commitCursor(*it);
             }
         }
     );
@@ -718,6 +778,7 @@ void DrmBackend::doHideCursor()
     }
     for (auto it = m_outputs.constBegin(); it != m_outputs.constEnd(); ++it) {
         (*it)->hideCursor();
+        commitCursor(*it);
     }
 }
 
@@ -728,6 +789,17 @@ void DrmBackend::moveCursor(Cursor *cursor, const QPoint &pos)
     }
     for (auto it = m_outputs.constBegin(); it != m_outputs.constEnd(); ++it) {
         (*it)->moveCursor(cursor, pos);
+        commitCursor(*it);
+    }
+}
+
+void DrmBackend::commitCursor(DrmOutput *output)
+{
+    // A cursor plane is updated without compositing. The commit occupies the output until
+    // the next vblank, further motion is collected until then. The compositor doesn't wait
+    // for it, a frame presented meanwhile gets committed right after it.
+    if (output->commitCursor()) {
+        m_cursorCommitsPending++;
     }
 }
 
@@ -771,6 +843,35 @@ DrmSurfaceBuffer *DrmBackend::createBuffer(const std::shared_ptr<GbmSurface> &su
     DrmSurfaceBuffer *b = new DrmSurfaceBuffer(m_fd, surface);
     return b;
 }
+
+DrmDmabufBuffer *DrmBackend::createBuffer(KWayland::Server::BufferInterface *buffer)
+{
+    DmabufBuffer *dmabuf = static_cast<DmabufBuffer *>(buffer->linuxDmabufBuffer());
+    if (!dmabuf || !m_gbmDevice) {
+        return nullptr;
+    }
+    // Without drmModeAddFB2WithModifiers only single plane buffers with an implicit
+    // or linear layout can be turned into a framebuffer
+    if (dmabuf->planes().count() != 1 || dmabuf->flags()) {
+        return nullptr;
+    }
+    const DmabufBuffer::Plane &plane = dmabuf->planes().first();
+    if (plane.offset != 0 || (plane.modifier != DRM_FORMAT_MOD_INVALID && plane.modifier != DRM_FORMAT_MOD_LINEAR)) {
+        return nullptr;
+    }
+    gbm_import_fd_data data;
+    data.fd = plane.fd;
+    data.width = dmabuf->size().width();
+    data.height = dmabuf->size().height();
+    data.stride = plane.stride;
+    data.format = dmabuf->format();
+    gbm_bo *bo = gbm_bo_import(m_gbmDevice, GBM_BO_IMPORT_FD, &data, GBM_BO_USE_SCANOUT);
+    if (!bo) {
+        qCDebug(KWIN_DRM) << "Importing client buffer for scanout failed";
+        return nullptr;
+    }
+    return new DrmDmabufBuffer(m_fd, bo, buffer);
+}
 #endif
 
 void DrmBackend::updateOutputsEnabled()
@@ -42,6 +42,14 @@ struct gbm_bo;
 struct gbm_device;
 struct gbm_surface;
 
+namespace KWayland
+{
+namespace Server
+{
+class BufferInterface;
+}
+}
+
 namespace KWin
 {
 
@@ -75,8 +83,18 @@ public:
     DrmDumbBuffer *createBuffer(const QSize &size);
 #if HAVE_GBM
     DrmSurfaceBuffer *createBuffer(const std::shared_ptr<GbmSurface> &surface);
+    /**
+     * Imports the client @p buffer for direct scanout. Returns @c nullptr if the
+     * buffer cannot be imported.
+     */
+    DrmDmabufBuffer *createBuffer(KWayland::Server::BufferInterface *buffer);
 #endif
     bool present(DrmBuffer *buffer, DrmOutput *output);
+    /**
+     * Puts the client @p buffer directly on @p output. Fails instead of changing the
+     * mode, the output has to be composited then.
+     */
+    bool scanout(DrmBuffer *buffer, DrmOutput *output);
 
     int fd() const {
         return m_fd;
@@ -161,6 +179,8 @@ private:
     void updateCursor();
     void moveCursor(Cursor *cursor, const QPoint &pos);
     void initCursor();
+    void bufferPresented(DrmOutput *output);
+    void commitCursor(DrmOutput *output);
     void readOutputsConfiguration();
     void writeOutputsConfiguration();
     QByteArray generateOutputConfigurationUuid() const;
@@ -184,6 +204,8 @@ private:
     bool m_cursorEnabled = false;
     QSize m_cursorSize;
     int m_pageFlipsPending = 0;
+    // commits of the cursor plane alone, they are not waited for by the compositor
+    int m_cursorCommitsPending = 0;
     bool m_active = false;
     QByteArray m_devNode;
 #if HAVE_EGL_STREAMS
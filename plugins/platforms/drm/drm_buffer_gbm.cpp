@@ -23,10 +23,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "logging.h"
 
+#include <KWayland/Server/buffer_interface.h>
+
 // system
 #include <sys/mman.h>
 // c++
 #include <cerrno>
+#include <cstring>
 // drm
 #include <xf86drm.h>
 #include <xf86drmMode.h>
@@ -66,4 +69,35 @@ void DrmSurfaceBuffer::releaseGbm()
     m_bo = nullptr;
 }
 
+// DrmDmabufBuffer
+DrmDmabufBuffer::DrmDmabufBuffer(int fd, gbm_bo *bo, KWayland::Server::BufferInterface *buffer)
+    : DrmBuffer(fd)
+    , m_bo(bo)
+    , m_buffer(buffer)
+{
+    if (m_buffer) {
+        // the client must not reuse the buffer while it is on screen
+        m_buffer->ref();
+    }
+    m_size = QSize(gbm_bo_get_width(m_bo), gbm_bo_get_height(m_bo));
+    const uint32_t handles[4] = { gbm_bo_get_handle(m_bo).u32, 0, 0, 0 };
+    const uint32_t pitches[4] = { gbm_bo_get_stride(m_bo), 0, 0, 0 };
+    const uint32_t offsets[4] = { 0, 0, 0, 0 };
+    if (drmModeAddFB2(fd, m_size.width(), m_size.height(), gbm_bo_get_format(m_bo), handles, pitches, offsets, &m_bufferId, 0) != 0) {
+        qCWarning(KWIN_DRM) << "drmModeAddFB2 failed for client buffer:" << strerror(errno);
+        m_bufferId = 0;
+    }
+}
+
+DrmDmabufBuffer::~DrmDmabufBuffer()
+{
+    if (m_bufferId) {
+        drmModeRmFB(fd(), m_bufferId);
+    }
+    gbm_bo_destroy(m_bo);
+    if (m_buffer) {
+        m_buffer->unref();
+    }
+}
+
 }
@@ -23,10 +23,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "drm_buffer.h"
 
+#include <QPointer>
+
 #include <memory>
 
 struct gbm_bo;
 
+namespace KWayland
+{
+namespace Server
+{
+class BufferInterface;
+}
+}
+
 namespace KWin
 {
 
@@ -61,6 +71,26 @@ private:
     gbm_bo *m_bo = nullptr;
 };
 
+/**
+ * @brief A client buffer imported through gbm to be put directly on an output.
+ *
+ * Takes ownership of @p bo and keeps a reference on the client buffer as long as it exists.
+ */
+class DrmDmabufBuffer : public DrmBuffer
+{
+public:
+    DrmDmabufBuffer(int fd, gbm_bo *bo, KWayland::Server::BufferInterface *buffer);
+    ~DrmDmabufBuffer() override;
+
+    gbm_bo *getBo() const {
+        return m_bo;
+    }
+
+private:
+    gbm_bo *m_bo;
+    QPointer<KWayland::Server::BufferInterface> m_buffer;
+};
+
 }
 
 #endif
@@ -18,10 +18,12 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "drm_output.h"
+#include "drm_atomic_cursor.h"
 #include "drm_backend.h"
 #include "drm_object_plane.h"
 #include "drm_object_crtc.h"
 #include "drm_object_connector.h"
+#include "drm_scanout.h"
 
 #include "composite.h"
 #include "cursor.h"
@@ -60,6 +62,7 @@ DrmOutput::~DrmOutput()
 {
     Q_ASSERT(!m_pageFlipPending);
     teardown();
+    delete m_atomicCursor;
 }
 
 void DrmOutput::teardown()
@@ -80,6 +83,9 @@ void DrmOutput::teardown()
         }
         m_primaryPlane->setCurrent(nullptr);
     }
+    if (m_cursorPlane) {
+        m_cursorPlane->setOutput(nullptr);
+    }
 
     m_crtc->setOutput(nullptr);
     m_conn->setOutput(nullptr);
@@ -104,15 +110,64 @@ void DrmOutput::releaseGbm()
 
 bool DrmOutput::hideCursor()
 {
+    if (m_atomicCursor) {
+        m_atomicCursor->setBuffer(nullptr);
+        return true;
+    }
     return drmModeSetCursor(m_backend->fd(), m_crtc->id(), 0, 0, 0) == 0;
 }
 
 bool DrmOutput::showCursor(DrmDumbBuffer *c)
 {
+    if (m_atomicCursor) {
+        m_atomicCursor->setBuffer(c);
+        return true;
+    }
     const QSize &s = c->size();
     return drmModeSetCursor(m_backend->fd(), m_crtc->id(), c->handle(), s.width(), s.height()) == 0;
 }
 
+bool DrmOutput::commitCursor()
+{
+    if (!m_atomicCursor || !m_atomicCursor->isDirty() || m_deleted) {
+        return false;
+    }
+    // otherwise the cursor state goes with the next commit of the output
+    if (m_pageFlipPending || m_modesetRequested || m_dpmsModePending != DpmsMode::On) {
+        return false;
+    }
+    if (!LogindIntegration::self()->isActiveSession()) {
+        return false;
+    }
+    m_atomicCursor->setCrtc(m_crtc->id());
+    if (!m_atomicCursor->commit(this)) {
+        return false;
+    }
+    m_pageFlipPending = true;
+    return true;
+}
+
+bool DrmOutput::isCursorCommitPending() const
+{
+    return m_atomicCursor && m_atomicCursor->isCommitPending();
+}
+
+bool DrmOutput::presentDeferredFrame()
+{
+    if (!m_deferredFrame) {
+        return true;
+    }
+    DrmBuffer *buffer = m_deferredFrame;
+    m_deferredFrame = nullptr;
+    if (!m_deleted && m_dpmsModePending == DpmsMode::On && presentAtomically(buffer)) {
+        return true;
+    }
+    if (m_backend->deleteBufferAfterPageFlip()) {
+        delete buffer;
+    }
+    return false;
+}
+
 bool DrmOutput::showCursor()
 {
     const bool ret = showCursor(m_cursor[m_cursorIndex]);
@@ -211,6 +266,10 @@ void DrmOutput::moveCursor(Cursor* cursor, const QPoint &globalPos)
     }
     pos *= scale();
     pos -= hotspotMatrix.map(cursor->hotspot());
+    if (m_atomicCursor) {
+        m_atomicCursor->setPosition(pos);
+        return;
+    }
     drmModeMoveCursor(m_backend->fd(), m_crtc->id(), pos.x(), pos.y());
 }
 
@@ -265,6 +324,12 @@ bool DrmOutput::init(drmModeConnector *connector)
         if (!initPrimaryPlane()) {
             return false;
         }
+        // without a cursor plane the legacy cursor ioctls are used
+#if HAVE_EGL_STREAMS
+        // EglStreamBackend flips through EGL, a cursor commit of its own would collide with it
+        if (!m_backend->useEglStreams())
+#endif
+            initCursorPlane();
     }
 
     setInternal(connector->connector_type == DRM_MODE_CONNECTOR_LVDS || connector->connector_type == DRM_MODE_CONNECTOR_eDP
@@ -424,7 +489,7 @@ bool DrmOutput::initPrimaryPlane()
     return false;
 }
 
-bool DrmOutput::initCursorPlane()       // TODO: Add call in init (but needs layer support in general first)
+bool DrmOutput::initCursorPlane()
 {
     for (int i = 0; i < m_backend->planes().size(); ++i) {
         DrmPlane* p = m_backend->planes()[i];
@@ -445,6 +510,7 @@ bool DrmOutput::initCursorPlane()       // TODO: Add call in init (but needs lay
         }
         p->setOutput(this);
         m_cursorPlane = p;
+        m_atomicCursor = new DrmAtomicCursor(p, m_backend->fd());
         qCDebug(KWIN_DRM) << "Initialized cursor plane" << p->id() << "on CRTC" << m_crtc->id();
         return true;
     }
@@ -737,6 +803,10 @@ void DrmOutput::pageFlipped()
     // In legacy mode we might get a page flip through a blank.
     Q_ASSERT(m_pageFlipPending || !m_backend->atomicModeSetting());
     m_pageFlipPending = false;
+    const bool cursorCommit = isCursorCommitPending();
+    if (cursorCommit) {
+        m_atomicCursor->pageFlipped();
+    }
 
     if (m_deleted) {
         deleteLater();
@@ -746,6 +816,13 @@ void DrmOutput::pageFlipped()
     if (!m_crtc) {
         return;
     }
+    if (cursorCommit) {
+        // a cursor commit doesn't flip any buffers
+        if (m_atomicOffPending) {
+            dpmsAtomicOff();
+        }
+        return;
+    }
     // Egl based surface buffers get destroyed, QPainter based dumb buffers not
     // TODO: split up DrmOutput in two for dumb and egl/gbm surface buffer compatible subclasses completely?
     if (m_backend->deleteBufferAfterPageFlip()) {
@@ -802,6 +879,28 @@ bool DrmOutput::present(DrmBuffer *buffer)
     }
 }
 
+bool DrmOutput::scanout(DrmBuffer *buffer)
+{
+    // client buffers are only tried on an output which is already set up, so that a
+    // rejected buffer doesn't have any side effects besides falling back to composition
+    if (!m_backend->atomicModeSetting() || m_modesetRequested || m_dpmsModePending != DpmsMode::On) {
+        return false;
+    }
+    if (m_pageFlipPending || !LogindIntegration::self()->isActiveSession()) {
+        return false;
+    }
+
+    if (m_atomicCursor) {
+        m_atomicCursor->setCrtc(m_crtc->id());
+    }
+    if (!scanoutAtomically(m_backend->fd(), m_primaryPlane, buffer, m_atomicCursor, this)) {
+        return false;
+    }
+    m_nextPlanesFlipList << m_primaryPlane;
+    m_pageFlipPending = true;
+    return true;
+}
+
 bool DrmOutput::dpmsAtomicOff()
 {
     m_atomicOffPending = false;
@@ -833,6 +932,11 @@ bool DrmOutput::presentAtomically(DrmBuffer *buffer)
     }
 
     if (m_pageFlipPending) {
+        if (isCursorCommitPending() && !m_deferredFrame) {
+            // the frame goes out right after the cursor commit, see presentDeferredFrame()
+            m_deferredFrame = buffer;
+            return true;
+        }
         qCWarning(KWIN_DRM) << "Page not yet flipped.";
         return false;
     }
@@ -1004,6 +1108,11 @@ bool DrmOutput::doAtomicCommit(AtomicCommitMode mode)
         DrmPlane *p = m_nextPlanesFlipList[i];
         ret &= p->atomicPopulate(req);
     }
+    if (m_atomicCursor) {
+        // the cursor follows the dpms state and gets updated with every commit
+        m_atomicCursor->setCrtc(m_dpmsModePending == DpmsMode::On ? m_crtc->id() : 0);
+        ret &= m_atomicCursor->populate(req);
+    }
 
     if (!ret) {
         qCWarning(KWIN_DRM) << "Failed to populate atomic planes. Abort atomic commit!";
@@ -1017,6 +1126,9 @@ bool DrmOutput::doAtomicCommit(AtomicCommitMode mode)
         return false;
     }
 
+    if (mode == AtomicCommitMode::Real && m_atomicCursor) {
+        m_atomicCursor->committed();
+    }
     if (mode == AtomicCommitMode::Real && (flags & DRM_MODE_ATOMIC_ALLOW_MODESET)) {
         qCDebug(KWIN_DRM) << "Atomic Modeset successful.";
         m_modesetRequested = false;
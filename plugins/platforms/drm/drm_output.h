@@ -35,6 +35,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace KWin
 {
 
+class DrmAtomicCursor;
 class DrmBackend;
 class DrmBuffer;
 class DrmDumbBuffer;
@@ -59,6 +60,11 @@ public:
     void moveCursor(Cursor* cursor, const QPoint &globalPos);
     bool init(drmModeConnector *connector);
     bool present(DrmBuffer *buffer);
+    /**
+     * Puts the client @p buffer on the primary plane without changing the mode.
+     * Returns @c false if the hardware doesn't accept the buffer in the current state.
+     */
+    bool scanout(DrmBuffer *buffer);
     void pageFlipped();
 
     // These values are defined by the kernel
@@ -134,6 +140,20 @@ private:
     void initUuid();
     bool initPrimaryPlane();
     bool initCursorPlane();
+    /**
+     * Commits a changed cursor plane on its own, without waiting for the next frame.
+     * Returns @c true if a page flip got queued for it.
+     */
+    bool commitCursor();
+    /**
+     * @returns Whether the pending page flip is one of a cursor commit, not of a frame
+     */
+    bool isCursorCommitPending() const;
+    /**
+     * Commits the frame held back while a cursor commit was pending.
+     * Returns @c false if there was one and it couldn't be presented.
+     */
+    bool presentDeferredFrame();
 
     void atomicEnable();
     void atomicDisable();
@@ -185,6 +205,10 @@ private:
     DrmDumbBuffer *m_cursor[2] = {nullptr, nullptr};
     int m_cursorIndex = 0;
     bool m_hasNewCursor = false;
+    // the hardware cursor on m_cursorPlane in atomic mode
+    DrmAtomicCursor *m_atomicCursor = nullptr;
+    // a frame presented while a cursor commit was pending
+    DrmBuffer *m_deferredFrame = nullptr;
     bool m_deleted = false;
 };
 
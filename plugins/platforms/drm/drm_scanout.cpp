@@ -0,0 +1,73 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "drm_scanout.h"
+#include "drm_atomic_cursor.h"
+#include "drm_object_plane.h"
+#include "logging.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+
+namespace KWin
+{
+
+static bool commit(int fd, DrmPlane *plane, DrmAtomicCursor *cursor, uint32_t flags, void *userData)
+{
+    drmModeAtomicReq *req = drmModeAtomicAlloc();
+    if (!req) {
+        qCWarning(KWIN_DRM) << "DRM: couldn't allocate atomic request";
+        return false;
+    }
+    bool ok = plane->atomicPopulate(req);
+    if (cursor) {
+        ok &= cursor->populate(req);
+    }
+    if (ok && drmModeAtomicCommit(fd, req, flags, userData) != 0) {
+        qCDebug(KWIN_DRM) << "Atomic commit of client buffer failed:" << strerror(errno);
+        ok = false;
+    }
+    drmModeAtomicFree(req);
+    return ok;
+}
+
+bool scanoutAtomically(int fd, DrmPlane *plane, DrmBuffer *buffer, DrmAtomicCursor *cursor, void *userData)
+{
+    plane->setNext(buffer);
+
+    if (!commit(fd, plane, cursor, DRM_MODE_ATOMIC_TEST_ONLY, userData)) {
+        qCDebug(KWIN_DRM) << "Atomic test commit of client buffer failed. Falling back to composition.";
+        plane->setNext(nullptr);
+        return false;
+    }
+    if (!commit(fd, plane, cursor, DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, userData)) {
+        qCDebug(KWIN_DRM) << "Atomic commit of client buffer failed. Falling back to composition.";
+        plane->setNext(nullptr);
+        return false;
+    }
+    if (cursor) {
+        cursor->committed();
+    }
+    return true;
+}
+
+}
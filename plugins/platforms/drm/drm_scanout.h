@@ -0,0 +1,42 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_DRM_SCANOUT_H
+#define KWIN_DRM_SCANOUT_H
+
+namespace KWin
+{
+
+class DrmAtomicCursor;
+class DrmBuffer;
+class DrmPlane;
+
+/**
+ * Shows the client @p buffer on @p plane of an output which is already set up, along with
+ * the pending state of the @p cursor if there is one.
+ *
+ * The request is committed with DRM_MODE_ATOMIC_TEST_ONLY first and only committed for real
+ * if the kernel accepts it. If either commit is rejected the next buffer of @p plane is reset
+ * and @c false is returned, the output falls back to composition then.
+ */
+bool scanoutAtomically(int fd, DrmPlane *plane, DrmBuffer *buffer, DrmAtomicCursor *cursor, void *userData);
+
+}
+
+#endif
@@ -28,6 +28,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "screens.h"
 // kwin libs
 #include <kwinglplatform.h>
+// KWayland
+#include <KWayland/Server/buffer_interface.h>
+#include <KWayland/Server/surface_interface.h>
 // Qt
 #include <QOpenGLContext>
 // system
@@ -520,7 +523,9 @@ void EglGbmBackend::endRenderingFrameForScreen(int screenId,
     Output &output = m_outputs[screenId];
     renderFramebufferToSurface(output);
 
-    if (damagedRegion.intersected(output.output->geometry()).isEmpty() && screenId == 0) {
+    const QRect geometry = output.output->geometry();
+    const QRegion damage = damagedRegion.intersected(geometry);
+    if (damage.isEmpty()) {
 
         // If the damaged region of a window is fully occluded, the only
         // rendering done, if any, will have been to repair a reused back
@@ -529,29 +534,21 @@ void EglGbmBackend::endRenderingFrameForScreen(int screenId,
         // In this case we won't post the back buffer. Instead we'll just
         // set the buffer age to 1, so the repaired regions won't be
         // rendered again in the next frame.
-        if (!renderedRegion.intersected(output.output->geometry()).isEmpty())
+        if (!renderedRegion.intersected(geometry).isEmpty())
             glFlush();
 
-        for (auto &output: m_outputs) {
-            output.bufferAge = 1;
-        }
+        output.bufferAge = 1;
         return;
     }
     presentOnOutput(output);
 
-    // Save the damaged region to history
-    // Note: damage history is only collected for the first screen. For any other screen full
-    // repaints are triggered. This is due to a limitation in Scene::paintGenericScreen which resets
-    // the Toplevel's repaint. So multiple calls to Scene::paintScreen as it's done in multi-output
-    // rendering only have correct damage information for the first screen. If we try to track
-    // damage nevertheless, it creates artifacts. So for the time being we work around the problem
-    // by only supporting buffer age on the first output. To properly support buffer age on all
-    // outputs the rendering needs to be refactored in general.
-    if (supportsBufferAge() && screenId == 0) {
+    // Save the damaged region to history. The scene hands the repaints of the windows
+    // to every screen it paints, so the damage is complete for all outputs.
+    if (supportsBufferAge()) {
         if (output.damageHistory.count() > 10) {
             output.damageHistory.removeLast();
         }
-        output.damageHistory.prepend(damagedRegion.intersected(output.output->geometry()));
+        output.damageHistory.prepend(damage);
     }
 }
 
@@ -565,6 +562,31 @@ bool EglGbmBackend::perScreenRendering() const
     return true;
 }
 
+bool EglGbmBackend::perScreenPresentation() const
+{
+    return true;
+}
+
+bool EglGbmBackend::scanout(int screenId, KWayland::Server::SurfaceInterface *surface)
+{
+    Output &output = m_outputs[screenId];
+    KWayland::Server::BufferInterface *buffer = surface->buffer();
+    if (!buffer->linuxDmabufBuffer() || buffer->size() != output.output->pixelSize()
+            || output.output->transform() != AbstractWaylandOutput::Transform::Normal) {
+        return false;
+    }
+    DrmDmabufBuffer *drmBuffer = m_backend->createBuffer(buffer);
+    if (!drmBuffer) {
+        return false;
+    }
+    if (!m_backend->scanout(drmBuffer, output.output)) {
+        return false;
+    }
+    // the next composited frame doesn't know what the client buffer contained
+    output.damageHistory.clear();
+    return true;
+}
+
 /************************************************
  * EglTexture
  ************************************************/
@@ -49,7 +49,9 @@ public:
     void endRenderingFrameForScreen(int screenId, const QRegion &damage, const QRegion &damagedRegion) override;
     bool usesOverlayWindow() const override;
     bool perScreenRendering() const override;
+    bool perScreenPresentation() const override;
     QRegion prepareRenderingForScreen(int screenId) override;
+    bool scanout(int screenId, KWayland::Server::SurfaceInterface *surface) override;
     void init() override;
 
 protected:
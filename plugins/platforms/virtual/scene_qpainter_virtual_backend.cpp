@@ -19,10 +19,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "scene_qpainter_virtual_backend.h"
 #include "virtual_backend.h"
+#include "virtual_output.h"
+#include "composite.h"
 #include "cursor.h"
 #include "screens.h"
 
 #include <QPainter>
+#include <QTimer>
 
 namespace KWin
 {
@@ -48,7 +51,8 @@ QImage *VirtualQPainterBackend::bufferForScreen(int screen)
 
 bool VirtualQPainterBackend::needsFullRepaint() const
 {
-    return true;
+    // the back buffers are kept between frames, so only the damage has to be painted
+    return false;
 }
 
 void VirtualQPainterBackend::prepareRenderingFrame()
@@ -76,6 +80,28 @@ void VirtualQPainterBackend::present(int mask, const QRegion &damage)
     }
 }
 
+void VirtualQPainterBackend::presentScreen(int screenId, int mask, const QRegion &damage)
+{
+    Q_UNUSED(mask)
+    Q_UNUSED(damage)
+    if (m_backend->saveFrames()) {
+        m_backBuffers[screenId].save(QStringLiteral("%1/screen%2-%3.png").arg(m_backend->screenshotDirPath(), QString::number(screenId), QString::number(m_frameCounter++)));
+    }
+    VirtualOutput *output = static_cast<VirtualOutput *>(m_backend->enabledOutputs().value(screenId));
+    if (!output) {
+        return;
+    }
+    // Simulate a page flip which completes with the next vblank of the output.
+    Compositor::self()->aboutToSwapBuffers(screenId);
+    QTimer::singleShot(output->timeToNextVBlank(), Qt::PreciseTimer, this,
+        [screenId] {
+            if (Compositor *compositor = Compositor::self()) {
+                compositor->bufferSwapComplete(screenId);
+            }
+        }
+    );
+}
+
 bool VirtualQPainterBackend::usesOverlayWindow() const
 {
     return false;
@@ -86,4 +112,15 @@ bool VirtualQPainterBackend::perScreenRendering() const
     return true;
 }
 
+bool VirtualQPainterBackend::perScreenPresentation() const
+{
+    return m_backend->perScreenPresentation();
+}
+
+bool VirtualQPainterBackend::syncsToVBlank() const
+{
+    // the simulated page flips complete with the vblank of the output
+    return m_backend->perScreenPresentation() && m_backend->syncsToVBlank();
+}
+
 }
@@ -43,7 +43,10 @@ public:
     bool usesOverlayWindow() const override;
     void prepareRenderingFrame() override;
     void present(int mask, const QRegion &damage) override;
+    void presentScreen(int screenId, int mask, const QRegion &damage) override;
     bool perScreenRendering() const override;
+    bool perScreenPresentation() const override;
+    bool syncsToVBlank() const override;
 
 private:
     void createOutputs();
@@ -57,6 +57,9 @@ VirtualBackend::~VirtualBackend()
 
 void VirtualBackend::init()
 {
+    // read on init as the tests create the platform before they set up the environment
+    m_perScreenPresentation = qEnvironmentVariableIsSet("KWIN_WAYLAND_VIRTUAL_PER_SCREEN_PRESENTATION");
+
     /*
      * Some tests currently expect one output present at start,
      * others set them explicitly.
@@ -112,10 +115,11 @@ Outputs VirtualBackend::enabledOutputs() const
     return m_enabledOutputs;
 }
 
-void VirtualBackend::setVirtualOutputs(int count, QVector<QRect> geometries, QVector<int> scales)
+void VirtualBackend::setVirtualOutputs(int count, QVector<QRect> geometries, QVector<int> scales, QVector<int> refreshRates)
 {
     Q_ASSERT(geometries.size() == 0 || geometries.size() == count);
     Q_ASSERT(scales.size() == 0 || scales.size() == count);
+    Q_ASSERT(refreshRates.size() == 0 || refreshRates.size() == count);
 
     bool countChanged = m_outputs.size() != count;
     qDeleteAll(m_outputs.begin(), m_outputs.end());
@@ -125,11 +129,12 @@ void VirtualBackend::setVirtualOutputs(int count, QVector<QRect> geometries, QVe
     int sumWidth = 0;
     for (int i = 0; i < count; i++) {
         VirtualOutput *vo = new VirtualOutput(this);
+        const int refreshRate = refreshRates.size() ? refreshRates.at(i) : 60000;
         if (geometries.size()) {
             const QRect geo = geometries.at(i);
-            vo->init(geo.topLeft(), geo.size());
+            vo->init(geo.topLeft(), geo.size(), refreshRate);
         } else {
-            vo->init(QPoint(sumWidth, 0), initialWindowSize());
+            vo->init(QPoint(sumWidth, 0), initialWindowSize(), refreshRate);
             sumWidth += initialWindowSize().width();
         }
         if (scales.size()) {
@@ -48,11 +48,32 @@ public:
     }
     QString screenshotDirPath() const;
 
+    /**
+     * Whether the outputs present their frames on their own, simulating a page flip which
+     * completes with the next vblank of the output. Only enabled through the environment
+     * variable KWIN_WAYLAND_VIRTUAL_PER_SCREEN_PRESENTATION, so the tests not caring about
+     * page flips keep a single presentation for all outputs.
+     */
+    bool perScreenPresentation() const {
+        return m_perScreenPresentation;
+    }
+    /**
+     * Whether the compositor schedules the frames of the outputs for their vblanks. Only
+     * considered with per screen presentation, the tests switch it at runtime to cover the
+     * frame scheduling both with and without vsync.
+     */
+    bool syncsToVBlank() const {
+        return m_syncsToVBlank;
+    }
+    Q_INVOKABLE void setSyncsToVBlank(bool enabled) {
+        m_syncsToVBlank = enabled;
+    }
+
     Screens *createScreens(QObject *parent = nullptr) override;
     QPainterBackend* createQPainterBackend() override;
     OpenGLBackend *createOpenGLBackend() override;
 
-    Q_INVOKABLE void setVirtualOutputs(int count, QVector<QRect> geometries = QVector<QRect>(), QVector<int> scales = QVector<int>());
+    Q_INVOKABLE void setVirtualOutputs(int count, QVector<QRect> geometries = QVector<QRect>(), QVector<int> scales = QVector<int>(), QVector<int> refreshRates = QVector<int>());
 
     Outputs outputs() const override;
     Outputs enabledOutputs() const override;
@@ -72,6 +93,8 @@ private:
     QVector<VirtualOutput*> m_enabledOutputs;
 
     QScopedPointer<QTemporaryDir> m_screenshotDir;
+    bool m_perScreenPresentation = false;
+    bool m_syncsToVBlank = false;
 };
 
 }
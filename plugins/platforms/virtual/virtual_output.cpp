@@ -29,19 +29,20 @@ VirtualOutput::VirtualOutput(QObject *parent)
     static int identifier = -1;
     identifier++;
     setName("Virtual-" + QString::number(identifier));
+    m_vblankClock.start();
 }
 
 VirtualOutput::~VirtualOutput()
 {
 }
 
-void VirtualOutput::init(const QPoint &logicalPosition, const QSize &pixelSize)
+void VirtualOutput::init(const QPoint &logicalPosition, const QSize &pixelSize, int refreshRate)
 {
     KWayland::Server::OutputDeviceInterface::Mode mode;
     mode.id = 0;
     mode.size = pixelSize;
     mode.flags = KWayland::Server::OutputDeviceInterface::ModeFlag::Current;
-    mode.refreshRate = 60000;  // TODO
+    mode.refreshRate = refreshRate;
     initInterfaces("model_TODO", "manufacturer_TODO", "UUID_TODO", pixelSize, { mode });
     setGeometry(QRect(logicalPosition, pixelSize));
 }
@@ -52,4 +53,13 @@ void VirtualOutput::setGeometry(const QRect &geo)
     setGlobalPos(geo.topLeft());
 }
 
+int VirtualOutput::timeToNextVBlank() const
+{
+    // refresh rate is in mHz
+    const qint64 interval = 1000000000000LL / qMax(refreshRate(), 1000);
+    const qint64 now = m_vblankClock.nsecsElapsed();
+    const qint64 nextVBlank = (now / interval + 1) * interval;
+    return (nextVBlank - now + 999999) / 1000000;
+}
+
 }
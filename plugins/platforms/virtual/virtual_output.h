@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "abstract_wayland_output.h"
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QRect>
 
@@ -37,10 +38,15 @@ public:
     VirtualOutput(QObject *parent = nullptr);
     ~VirtualOutput() override;
 
-    void init(const QPoint &logicalPosition, const QSize &pixelSize);
+    void init(const QPoint &logicalPosition, const QSize &pixelSize, int refreshRate = 60000);
 
     void setGeometry(const QRect &geo);
 
+    /**
+     * Time in milliseconds until the next simulated vblank of the output.
+     */
+    int timeToNextVBlank() const;
+
     int gammaRampSize() const override {
         return m_gammaSize;
     }
@@ -55,6 +61,7 @@ private:
 
     int m_gammaSize = 200;
     bool m_gammaResult = true;
+    QElapsedTimer m_vblankClock;
 };
 
 }
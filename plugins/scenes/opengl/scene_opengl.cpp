@@ -41,6 +41,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "composite.h"
 #include "deleted.h"
 #include "effects.h"
+#include "frametracer.h"
 #include "lanczosfilter.h"
 #include "main.h"
 #include "overlaywindow.h"
@@ -502,6 +503,11 @@ bool SceneOpenGL::blocksForRetrace() const
     return m_backend->blocksForRetrace();
 }
 
+bool SceneOpenGL::perScreenPresentation() const
+{
+    return m_backend->perScreenRendering() && m_backend->perScreenPresentation();
+}
+
 void SceneOpenGL::idle()
 {
     m_backend->idle();
@@ -630,8 +636,22 @@ qint64 SceneOpenGL::paint(const QRegion &damage, const QList<Toplevel *> &toplev
     if (m_backend->perScreenRendering()) {
         // trigger start render timer
         m_backend->prepareRenderingFrame();
+        const QRegion screensDamage = damageWithWindowRepaints(damage);
         for (int i = 0; i < screens()->count(); ++i) {
             const QRect &geo = screens()->geometry(i);
+            if (perScreenPresentation() && !screensDamage.intersects(geo)) {
+                // nothing changed on this screen or it still waits for its previous frame
+                continue;
+            }
+            if (perScreenPresentation()) {
+                Toplevel *candidate = directScanoutCandidate(geo);
+                if (candidate && m_backend->scanout(i, candidate->surface())) {
+                    // the client buffer is on screen, the windows below it don't need a paint
+                    resetWindowRepaints();
+                    emit screenRendered(i, screensDamage.intersected(geo));
+                    continue;
+                }
+            }
             QRegion update;
             QRegion valid;
             // prepare rendering makes context current on the output
@@ -649,14 +669,18 @@ qint64 SceneOpenGL::paint(const QRegion &damage, const QList<Toplevel *> &toplev
 
             int mask = 0;
             updateProjectionMatrix();
-            paintScreen(&mask, damage.intersected(geo), repaint, &update, &valid, projectionMatrix(), geo);   // call generic implementation
+            paintScreen(&mask, screensDamage.intersected(geo), repaint, &update, &valid, projectionMatrix(), geo);   // call generic implementation
             paintCursor();
 
             GLVertexBuffer::streamingBuffer()->endOfFrame();
 
+            FrameTracer::self()->begin("present");
             m_backend->endRenderingFrameForScreen(i, valid, update);
+            FrameTracer::self()->end("present");
 
             GLVertexBuffer::streamingBuffer()->framePosted();
+
+            emit screenRendered(i, update.intersected(geo));
         }
     } else {
         m_backend->makeCurrent();
@@ -693,7 +717,9 @@ qint64 SceneOpenGL::paint(const QRegion &damage, const QList<Toplevel *> &toplev
 
         GLVertexBuffer::streamingBuffer()->endOfFrame();
 
+        FrameTracer::self()->begin("present");
         m_backend->endRenderingFrame(validRegion, updateRegion);
+        FrameTracer::self()->end("present");
 
         GLVertexBuffer::streamingBuffer()->framePosted();
     }
@@ -1306,7 +1332,25 @@ QMatrix4x4 OpenGLWindow::modelViewProjectionMatrix(int mask, const WindowPaintDa
     return scene->projectionMatrix() * mvMatrix;
 }
 
-void OpenGLWindow::renderSubSurface(GLShader *shader, const QMatrix4x4 &mvp, const QMatrix4x4 &windowMatrix, OpenGLWindowPixmap *pixmap, const QRegion &region, bool hardwareClipping)
+// Pushes the shader converting the planes of a YUV texture to RGB. Returns nullptr if the texture
+// holds RGB data or the window gets painted with a custom shader, which only gets to see the luma plane.
+GLShader *OpenGLWindow::pushYuvShader(SceneOpenGLTexture *texture, ShaderTraits traits,
+                                      const WindowPaintData &data, float opacity) const
+{
+    if (!traits || !texture->isYuv()) {
+        return nullptr;
+    }
+    GLShader *shader = ShaderManager::instance()->pushShader(traits | ShaderTrait::YuvConversion);
+    shader->setUniform(GLShader::Saturation, data.saturation());
+    shader->setUniform(GLShader::ModulationConstant, modulate(opacity, data.brightness()));
+    shader->setUniform(GLShader::TextureClamp, QVector4D({0, 0, 1, 1}));
+    texture->bindPlanes(shader);
+    return shader;
+}
+
+void OpenGLWindow::renderSubSurface(GLShader *shader, ShaderTraits traits, const WindowPaintData &data,
+                                    const QMatrix4x4 &mvp, const QMatrix4x4 &windowMatrix,
+                                    OpenGLWindowPixmap *pixmap, const QRegion &region, bool hardwareClipping)
 {
     QMatrix4x4 newWindowMatrix = windowMatrix;
     newWindowMatrix.translate(pixmap->subSurface()->position().x(), pixmap->subSurface()->position().y());
@@ -1319,11 +1363,17 @@ void OpenGLWindow::renderSubSurface(GLShader *shader, const QMatrix4x4 &mvp, con
     if (!pixmap->texture()->isNull()) {
         setBlendEnabled(pixmap->buffer() && pixmap->buffer()->hasAlphaChannel());
         // render this texture
-        shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp * newWindowMatrix);
         auto texture = pixmap->texture();
+        GLShader *yuvShader = pushYuvShader(texture, traits, data, data.opacity());
+        GLShader *textureShader = yuvShader ? yuvShader : shader;
+        textureShader->setUniform(GLShader::ModelViewProjectionMatrix, mvp * newWindowMatrix);
         texture->bind();
         texture->render(region, QRect(0, 0, texture->width() / scale, texture->height() / scale), hardwareClipping);
         texture->unbind();
+        if (yuvShader) {
+            texture->unbindPlanes();
+            ShaderManager::instance()->popShader();
+        }
     }
 
     const auto &children = pixmap->children();
@@ -1331,7 +1381,7 @@ void OpenGLWindow::renderSubSurface(GLShader *shader, const QMatrix4x4 &mvp, con
         if (pixmap->subSurface().isNull() || pixmap->subSurface()->surface().isNull() || !pixmap->subSurface()->surface()->isMapped()) {
             continue;
         }
-        renderSubSurface(shader, mvp, newWindowMatrix, static_cast<OpenGLWindowPixmap*>(pixmap), region, hardwareClipping);
+        renderSubSurface(shader, traits, data, mvp, newWindowMatrix, static_cast<OpenGLWindowPixmap*>(pixmap), region, hardwareClipping);
     }
 }
 
@@ -1364,8 +1414,9 @@ void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPai
         }
     }
 
+    ShaderTraits traits;
     if (!shader) {
-        ShaderTraits traits = ShaderTrait::MapTexture;
+        traits = ShaderTrait::MapTexture;
         if (useX11TextureClamp) {
             traits |= ShaderTrait::ClampTexture;
         }
@@ -1468,7 +1519,11 @@ void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPai
 
         setBlendEnabled(nodes[i].hasAlpha || nodes[i].opacity < 1.0);
 
-        if (opacity != nodes[i].opacity) {
+        // the planes of a YUV buffer need to be converted by a dedicated shader
+        GLShader *yuvShader = i == ContentLeaf ? pushYuvShader(s_frameTexture, traits, data, nodes[i].opacity) : nullptr;
+        if (yuvShader) {
+            yuvShader->setUniform(GLShader::ModelViewProjectionMatrix, mvpMatrix);
+        } else if (opacity != nodes[i].opacity) {
             shader->setUniform(GLShader::ModulationConstant,
                                modulate(nodes[i].opacity, data.brightness()));
             opacity = nodes[i].opacity;
@@ -1498,6 +1553,11 @@ void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPai
         }
 
         vbo->draw(region, primitiveType, nodes[i].firstVertex, nodes[i].vertexCount, m_hardwareClipping);
+
+        if (yuvShader) {
+            s_frameTexture->unbindPlanes();
+            ShaderManager::instance()->popShader();
+        }
     }
 
     vbo->unbindArrays();
@@ -1511,7 +1571,7 @@ void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPai
         if (pixmap->subSurface().isNull() || pixmap->subSurface()->surface().isNull() || !pixmap->subSurface()->surface()->isMapped()) {
             continue;
         }
-        renderSubSurface(shader, modelViewProjection, windowMatrix, static_cast<OpenGLWindowPixmap*>(pixmap), region, m_hardwareClipping);
+        renderSubSurface(shader, traits, data, modelViewProjection, windowMatrix, static_cast<OpenGLWindowPixmap*>(pixmap), region, m_hardwareClipping);
     }
 
     setBlendEnabled(false);
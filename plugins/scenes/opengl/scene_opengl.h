@@ -54,6 +54,7 @@ public:
     bool usesOverlayWindow() const override;
     bool blocksForRetrace() const override;
     bool syncsToVBlank() const override;
+    bool perScreenPresentation() const override;
     bool makeOpenGLContextCurrent() override;
     void doneOpenGLContextCurrent() override;
     Decoration::Renderer *createDecorationRenderer(Decoration::DecoratedClientImpl *impl) override;
@@ -183,7 +184,10 @@ private:
     QVector4D modulate(float opacity, float brightness) const;
     void setBlendEnabled(bool enabled);
     void setupLeafNodes(LeafNode *nodes, const WindowQuadList *quads, const WindowPaintData &data);
-    void renderSubSurface(GLShader *shader, const QMatrix4x4 &mvp, const QMatrix4x4 &windowMatrix,
+    GLShader *pushYuvShader(SceneOpenGLTexture *texture, ShaderTraits traits,
+                            const WindowPaintData &data, float opacity) const;
+    void renderSubSurface(GLShader *shader, ShaderTraits traits, const WindowPaintData &data,
+                          const QMatrix4x4 &mvp, const QMatrix4x4 &windowMatrix,
                           OpenGLWindowPixmap *pixmap, const QRegion &region, bool hardwareClipping);
     bool beginRenderWindow(int mask, const QRegion &region, WindowPaintData &data);
     void endRenderWindow();
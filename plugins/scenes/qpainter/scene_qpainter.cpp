@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "cursor.h"
 #include "deleted.h"
 #include "effects.h"
+#include "frametracer.h"
 #include "main.h"
 #include "screens.h"
 #include "toplevel.h"
@@ -31,6 +32,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "wayland_server.h"
 
 #include <kwineffectquickview.h>
+#include <platformsupport/scenes/qpainter/damage_image_copy.h>
 
 #include <KWayland/Server/buffer_interface.h>
 #include <KWayland/Server/subcompositor_interface.h>
@@ -102,14 +104,27 @@ qint64 SceneQPainter::paint(const QRegion &_damage, const QList<Toplevel *> &top
     int mask = 0;
     m_backend->prepareRenderingFrame();
     if (m_backend->perScreenRendering()) {
+        damage = damageWithWindowRepaints(damage);
         const bool needsFullRepaint = m_backend->needsFullRepaint();
+        const bool presentPerScreen = perScreenPresentation();
         if (needsFullRepaint) {
             mask |= Scene::PAINT_SCREEN_BACKGROUND_FIRST;
-            damage = screens()->geometry();
+            if (!presentPerScreen) {
+                damage = screens()->geometry();
+            }
         }
         QRegion overallUpdate;
         for (int i = 0; i < screens()->count(); ++i) {
             const QRect geometry = screens()->geometry(i);
+            if (presentPerScreen) {
+                if (!damage.intersects(geometry)) {
+                    // nothing changed on this screen or it still waits for its previous frame
+                    continue;
+                }
+                if (needsFullRepaint) {
+                    damage |= geometry;
+                }
+            }
             QImage *buffer = m_backend->bufferForScreen(i);
             if (!buffer || buffer->isNull()) {
                 continue;
@@ -125,9 +140,20 @@ qint64 SceneQPainter::paint(const QRegion &_damage, const QList<Toplevel *> &top
 
             m_painter->restore();
             m_painter->end();
+
+            if (presentPerScreen) {
+                FrameTracer::self()->begin("present");
+                m_backend->presentScreen(i, mask, updateRegion);
+                FrameTracer::self()->end("present");
+            }
+            emit screenRendered(i, updateRegion.intersected(geometry));
         }
         m_backend->showOverlay();
-        m_backend->present(mask, overallUpdate);
+        if (!presentPerScreen) {
+            FrameTracer::self()->begin("present");
+            m_backend->present(mask, overallUpdate);
+            FrameTracer::self()->end("present");
+        }
     } else {
         m_painter->begin(m_backend->buffer());
         m_painter->setClipping(true);
@@ -143,7 +169,9 @@ qint64 SceneQPainter::paint(const QRegion &_damage, const QList<Toplevel *> &top
         m_backend->showOverlay();
 
         m_painter->end();
+        FrameTracer::self()->begin("present");
         m_backend->present(mask, updateRegion);
+        FrameTracer::self()->end("present");
     }
 
     // do cleanup
@@ -453,7 +481,6 @@ WindowPixmap *QPainterWindowPixmap::createChild(const QPointer<KWayland::Server:
 
 void QPainterWindowPixmap::updateBuffer()
 {
-    const auto oldBuffer = buffer();
     WindowPixmap::updateBuffer();
     const auto &b = buffer();
     if (!surface()) {
@@ -465,14 +492,12 @@ void QPainterWindowPixmap::updateBuffer()
         m_image = QImage();
         return;
     }
-    if (b == oldBuffer) {
-        return;
-    }
-    // perform deep copy
-    m_image = b->data().copy();
-    if (auto s = surface()) {
-        s->resetTrackedDamage();
-    }
+    // Everything outside of the tracked damage is unchanged since the last update,
+    // so only the damaged parts get copied into the persistent image. A deep copy
+    // is only performed if the buffer size or format changed.
+    auto s = surface();
+    copyDamagedImage(m_image, b->data(), s->trackedDamage(), s->scale());
+    s->resetTrackedDamage();
 }
 
 bool QPainterWindowPixmap::isValid() const
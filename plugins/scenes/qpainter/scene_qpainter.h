@@ -35,6 +35,8 @@ class KWIN_EXPORT SceneQPainter : public Scene
 public:
     ~SceneQPainter() override;
     bool usesOverlayWindow() const override;
+    bool perScreenPresentation() const override;
+    bool syncsToVBlank() const override;
     OverlayWindow* overlayWindow() const override;
     qint64 paint(const QRegion &damage, const QList<Toplevel *> &windows) override;
     void paintGenericScreen(int mask, const ScreenPaintData &data) override;
@@ -180,6 +182,18 @@ bool SceneQPainter::usesOverlayWindow() const
     return m_backend->usesOverlayWindow();
 }
 
+inline
+bool SceneQPainter::perScreenPresentation() const
+{
+    return m_backend->perScreenRendering() && m_backend->perScreenPresentation();
+}
+
+inline
+bool SceneQPainter::syncsToVBlank() const
+{
+    return m_backend->syncsToVBlank();
+}
+
 inline
 OverlayWindow* SceneQPainter::overlayWindow() const
 {
@@ -0,0 +1,90 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "renderjournal.h"
+
+#include <QtMath>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+RenderJournal::RenderJournal(int capacity)
+    : m_capacity(qMax(capacity, 1))
+{
+    m_entries.reserve(m_capacity);
+}
+
+void RenderJournal::add(qint64 renderTime, qint64 leadTime)
+{
+    const Entry entry{renderTime, renderTime > leadTime};
+    if (m_entries.count() < m_capacity) {
+        m_entries.append(entry);
+    } else {
+        m_entries[m_next] = entry;
+    }
+    m_next = (m_next + 1) % m_capacity;
+}
+
+void RenderJournal::clear()
+{
+    m_entries.clear();
+    m_next = 0;
+}
+
+bool RenderJournal::isEmpty() const
+{
+    return m_entries.isEmpty();
+}
+
+int RenderJournal::count() const
+{
+    return m_entries.count();
+}
+
+qint64 RenderJournal::predictedRenderTime() const
+{
+    if (m_entries.isEmpty()) {
+        return 0;
+    }
+    qreal sum = 0;
+    for (const Entry &entry : m_entries) {
+        sum += entry.renderTime;
+    }
+    const qreal mean = sum / m_entries.count();
+    qreal variance = 0;
+    for (const Entry &entry : m_entries) {
+        variance += (entry.renderTime - mean) * (entry.renderTime - mean);
+    }
+    variance /= m_entries.count();
+    return qCeil(mean + 2 * qSqrt(variance));
+}
+
+qreal RenderJournal::missRate() const
+{
+    if (m_entries.isEmpty()) {
+        return 0;
+    }
+    const int missed = std::count_if(m_entries.constBegin(), m_entries.constEnd(),
+                                     [](const Entry &entry) { return entry.missed; });
+    return qreal(missed) / m_entries.count();
+}
+
+}
@@ -0,0 +1,73 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QVector>
+
+namespace KWin
+{
+
+/**
+ * @brief The RenderJournal records how long the recently rendered frames took.
+ *
+ * The Compositor uses it to predict how much time the next frame is going to need,
+ * so it can start compositing just early enough to hit the next vblank. Each entry
+ * also remembers whether the frame took longer than the time it was scheduled with,
+ * i.e. whether the frame missed its vblank.
+ */
+class KWIN_EXPORT RenderJournal
+{
+public:
+    explicit RenderJournal(int capacity = 32);
+
+    /**
+     * Adds a frame which took @p renderTime nanoseconds to paint and present and
+     * was started @p leadTime nanoseconds before the vblank it targeted.
+     */
+    void add(qint64 renderTime, qint64 leadTime);
+    void clear();
+
+    bool isEmpty() const;
+    int count() const;
+
+    /**
+     * @returns the expected render time of the next frame in nanoseconds, that is the
+     * average of the recorded frames plus twice their standard deviation, or @c 0 if
+     * the journal is empty.
+     */
+    qint64 predictedRenderTime() const;
+    /**
+     * @returns the share of the recorded frames which did not finish within their lead time.
+     */
+    qreal missRate() const;
+
+private:
+    struct Entry {
+        qint64 renderTime;
+        bool missed;
+    };
+    QVector<Entry> m_entries;
+    int m_capacity;
+    int m_next = 0;
+};
+
+}
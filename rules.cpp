@@ -22,13 +22,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <kconfig.h>
 #include <KXMessages>
-#include <QRegExp>
 #include <QTemporaryFile>
 #include <QFile>
 #include <QFileInfo>
 #include <QDebug>
 #include <QDir>
 
+#include <algorithm>
+
 #ifndef KCMRULES
 #include "x11client.h"
 #include "client_machine.h"
@@ -184,6 +185,23 @@ void Rules::readFromSettings(const RuleSettings *settings)
     READ_SET_RULE(shortcut);
     READ_FORCE_RULE(disableglobalshortcuts,);
     READ_SET_RULE(desktopfile);
+    compileRegExps();
+}
+
+static QRegularExpression compileRegExp(const QString &pattern)
+{
+    QRegularExpression regExp(pattern);
+    // JIT compile the pattern now instead of on first use
+    regExp.optimize();
+    return regExp;
+}
+
+void Rules::compileRegExps()
+{
+    wmclassregexp = wmclassmatch == RegExpMatch ? compileRegExp(QString::fromUtf8(wmclass)) : QRegularExpression();
+    windowroleregexp = windowrolematch == RegExpMatch ? compileRegExp(QString::fromUtf8(windowrole)) : QRegularExpression();
+    titleregexp = titlematch == RegExpMatch ? compileRegExp(title) : QRegularExpression();
+    clientmachineregexp = clientmachinematch == RegExpMatch ? compileRegExp(QString::fromUtf8(clientmachine)) : QRegularExpression();
 }
 
 #undef READ_MATCH_STRING
@@ -346,7 +364,7 @@ bool Rules::matchWMClass(const QByteArray& match_class, const QByteArray& match_
         // TODO optimize?
         QByteArray cwmclass = wmclasscomplete
                               ? match_name + ' ' + match_class : match_class;
-        if (wmclassmatch == RegExpMatch && QRegExp(QString::fromUtf8(wmclass)).indexIn(QString::fromUtf8(cwmclass)) == -1)
+        if (wmclassmatch == RegExpMatch && !wmclassregexp.match(QString::fromUtf8(cwmclass)).hasMatch())
             return false;
         if (wmclassmatch == ExactMatch && wmclass != cwmclass)
             return false;
@@ -359,7 +377,7 @@ bool Rules::matchWMClass(const QByteArray& match_class, const QByteArray& match_
 bool Rules::matchRole(const QByteArray& match_role) const
 {
     if (windowrolematch != UnimportantMatch) {
-        if (windowrolematch == RegExpMatch && QRegExp(QString::fromUtf8(windowrole)).indexIn(QString::fromUtf8(match_role)) == -1)
+        if (windowrolematch == RegExpMatch && !windowroleregexp.match(QString::fromUtf8(match_role)).hasMatch())
             return false;
         if (windowrolematch == ExactMatch && windowrole != match_role)
             return false;
@@ -372,7 +390,7 @@ bool Rules::matchRole(const QByteArray& match_role) const
 bool Rules::matchTitle(const QString& match_title) const
 {
     if (titlematch != UnimportantMatch) {
-        if (titlematch == RegExpMatch && QRegExp(title).indexIn(match_title) == -1)
+        if (titlematch == RegExpMatch && !titleregexp.match(match_title).hasMatch())
             return false;
         if (titlematch == ExactMatch && title != match_title)
             return false;
@@ -390,7 +408,7 @@ bool Rules::matchClientMachine(const QByteArray& match_machine, bool local) cons
                 && matchClientMachine("localhost", true))
             return true;
         if (clientmachinematch == RegExpMatch
-                && QRegExp(QString::fromUtf8(clientmachine)).indexIn(QString::fromUtf8(match_machine)) == -1)
+                && !clientmachineregexp.match(QString::fromUtf8(match_machine)).hasMatch())
             return false;
         if (clientmachinematch == ExactMatch
                 && clientmachine != match_machine)
@@ -423,6 +441,11 @@ bool Rules::match(const AbstractClient* c) const
     return true;
 }
 
+QByteArray Rules::exactWMClass() const
+{
+    return wmclassmatch == ExactMatch ? wmclass : QByteArray();
+}
+
 #define NOW_REMEMBER(_T_, _V_) ((selection & _T_) && (_V_##rule == (SetRule)Remember))
 
 bool Rules::update(AbstractClient* c, int selection)
@@ -964,29 +987,55 @@ void RuleBook::deleteAll()
 {
     qDeleteAll(m_rules);
     m_rules.clear();
+    m_rulesIndexDirty = true;
+}
+
+void RuleBook::updateRulesIndex()
+{
+    if (!m_rulesIndexDirty) {
+        return;
+    }
+    m_exactWMClassRules.clear();
+    m_anyWMClassRules.clear();
+    for (int i = 0; i < m_rules.count(); ++i) {
+        const QByteArray wmclass = m_rules.at(i)->exactWMClass();
+        if (wmclass.isEmpty()) {
+            m_anyWMClassRules.append(i);
+        } else {
+            m_exactWMClassRules[wmclass].append(i);
+        }
+    }
+    m_rulesIndexDirty = false;
 }
 
 WindowRules RuleBook::find(const AbstractClient* c, bool ignore_temporary)
 {
+    updateRulesIndex();
+    // only the rules which can match the window class are evaluated, in priority order
+    QVector<int> candidates = m_anyWMClassRules;
+    candidates += m_exactWMClassRules.value(c->resourceClass());
+    candidates += m_exactWMClassRules.value(c->resourceName() + ' ' + c->resourceClass());
+    std::sort(candidates.begin(), candidates.end());
+
     QVector< Rules* > ret;
-    for (QList< Rules* >::Iterator it = m_rules.begin();
-            it != m_rules.end();
-       ) {
-        if (ignore_temporary && (*it)->isTemporary()) {
-            ++it;
+    QVector< Rules* > usedTemporary;
+    for (int index : qAsConst(candidates)) {
+        Rules *rule = m_rules.at(index);
+        if (ignore_temporary && rule->isTemporary()) {
             continue;
         }
-        if ((*it)->match(c)) {
-            Rules* rule = *it;
+        if (rule->match(c)) {
             qCDebug(KWIN_CORE) << "Rule found:" << rule << ":" << c;
             if (rule->isTemporary())
-                it = m_rules.erase(it);
-            else
-                ++it;
+                usedTemporary.append(rule);
             ret.append(rule);
-            continue;
         }
-        ++it;
+    }
+    if (!usedTemporary.isEmpty()) {
+        for (Rules *rule : qAsConst(usedTemporary)) {
+            m_rules.removeOne(rule);
+        }
+        m_rulesIndexDirty = true;
     }
     return WindowRules(ret);
 }
@@ -1022,6 +1071,7 @@ void RuleBook::load()
         m_config->reparseConfiguration();
     }
     m_rules = RuleBookSettings(m_config).rules().toList();
+    m_rulesIndexDirty = true;
 }
 
 void RuleBook::save()
@@ -1052,6 +1102,7 @@ void RuleBook::temporaryRulesMessage(const QString& message)
             was_temporary = true;
     Rules* rule = new Rules(message, true);
     m_rules.prepend(rule);   // highest priority first
+    m_rulesIndexDirty = true;
     if (!was_temporary)
         QTimer::singleShot(60000, this, SLOT(cleanupTemporaryRules()));
 }
@@ -1064,6 +1115,7 @@ void RuleBook::cleanupTemporaryRules()
        ) {
         if ((*it)->discardTemporary(false)) { // deletes (*it)
             it = m_rules.erase(it);
+            m_rulesIndexDirty = true;
         } else {
             if ((*it)->isTemporary())
                 has_temporary = true;
@@ -1088,6 +1140,7 @@ void RuleBook::discardUsed(AbstractClient* c, bool withdrawn)
                 c->removeRule(*it);
                 Rules* r = *it;
                 it = m_rules.erase(it);
+                m_rulesIndexDirty = true;
                 delete r;
                 continue;
             }
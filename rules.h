@@ -23,7 +23,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 
 #include <netwm_def.h>
+#include <QHash>
 #include <QRect>
+#include <QRegularExpression>
 #include <QVector>
 
 #include "placement.h"
@@ -143,6 +145,11 @@ public:
 #ifndef KCMRULES
     bool discardUsed(bool withdrawn);
     bool match(const AbstractClient* c) const;
+    /**
+     * @returns The window class a window needs to have for this rule to match, or an empty
+     * QByteArray if the rule can match windows of any class.
+     */
+    QByteArray exactWMClass() const;
     bool update(AbstractClient*, int selection);
     bool isTemporary() const;
     bool discardTemporary(bool force);   // removes if temporary and forced or too old
@@ -192,6 +199,7 @@ private:
     bool matchTitle(const QString& match_title) const;
     bool matchClientMachine(const QByteArray& match_machine, bool local) const;
     void readFromSettings(const RuleSettings *settings);
+    void compileRegExps();
     static ForceRule convertForceRule(int v);
     static QString getDecoColor(const QString &themeName);
 #ifndef KCMRULES
@@ -212,6 +220,11 @@ private:
     QByteArray clientmachine;
     StringMatch clientmachinematch;
     NET::WindowTypes types; // types for matching
+    // compiled once in readFromSettings() for the patterns using RegExpMatch
+    QRegularExpression wmclassregexp;
+    QRegularExpression windowroleregexp;
+    QRegularExpression titleregexp;
+    QRegularExpression clientmachineregexp;
     Placement::Policy placement;
     ForceRule placementrule;
     QPoint position;
@@ -313,9 +326,14 @@ private Q_SLOTS:
 private:
     void deleteAll();
     void initWithX11();
+    void updateRulesIndex();
     QTimer *m_updateTimer;
     bool m_updatesDisabled;
     QList<Rules*> m_rules;
+    // indexes into m_rules, rules requiring an exact window class are looked up by that class
+    QHash<QByteArray, QVector<int>> m_exactWMClassRules;
+    QVector<int> m_anyWMClassRules;
+    bool m_rulesIndexDirty = true;
     QScopedPointer<KXMessages> m_temporaryRulesMessages;
     KSharedConfig::Ptr m_config;
 
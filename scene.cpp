@@ -74,7 +74,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "x11client.h"
 #include "deleted.h"
 #include "effects.h"
+#include "frametracer.h"
+#include "main.h"
 #include "overlaywindow.h"
+#include "platform.h"
 #include "screens.h"
 #include "shadow.h"
 #include "wayland_server.h"
@@ -111,6 +114,8 @@ void Scene::paintScreen(int* mask, const QRegion &damage, const QRegion &repaint
     const QRegion displayRegion(0, 0, screenSize.width(), screenSize.height());
     *mask = (damage == displayRegion) ? 0 : PAINT_SCREEN_REGION;
 
+    FrameTraceScope traceScope("Scene::paintScreen");
+
     updateTimeDiff();
     // preparation step
     static_cast<EffectsHandlerImpl*>(effects)->startPaint();
@@ -121,7 +126,9 @@ void Scene::paintScreen(int* mask, const QRegion &damage, const QRegion &repaint
     pdata.mask = *mask;
     pdata.paint = region;
 
+    FrameTracer::self()->begin("Effects::prePaintScreen");
     effects->prePaintScreen(pdata, time_diff);
+    FrameTracer::self()->end("Effects::prePaintScreen");
     *mask = pdata.mask;
     region = pdata.paint;
 
@@ -146,13 +153,17 @@ void Scene::paintScreen(int* mask, const QRegion &damage, const QRegion &repaint
     }
 
     ScreenPaintData data(projection, outputGeometry);
+    FrameTracer::self()->begin("Effects::paintScreen");
     effects->paintScreen(*mask, region, data);
+    FrameTracer::self()->end("Effects::paintScreen");
 
+    FrameTracer::self()->begin("Effects::postPaint");
     foreach (Window *w, stacking_order) {
         effects->postPaintWindow(effectWindow(w));
     }
 
     effects->postPaintScreen();
+    FrameTracer::self()->end("Effects::postPaint");
 
     // make sure not to go outside of the screen area
     *updateRegion = damaged_region;
@@ -455,6 +466,56 @@ void Scene::clearStackingOrder()
     stacking_order.clear();
 }
 
+QRegion Scene::damageWithWindowRepaints(const QRegion &damage) const
+{
+    QRegion region = damage;
+    for (Window *window : stacking_order) {
+        region |= window->window()->repaints();
+    }
+    return region;
+}
+
+Toplevel *Scene::directScanoutCandidate(const QRect &geometry) const
+{
+    EffectsHandlerImpl *effectsImpl = static_cast<EffectsHandlerImpl *>(effects);
+    if (effectsImpl->hasActiveFullScreenEffect() || effectsImpl->blocksDirectScanout()) {
+        return nullptr;
+    }
+    if (kwinApp()->platform()->usesSoftwareCursor() && !kwinApp()->platform()->isCursorHidden()) {
+        return nullptr;
+    }
+    for (auto it = stacking_order.crbegin(); it != stacking_order.crend(); ++it) {
+        Window *window = *it;
+        Toplevel *toplevel = window->window();
+        if (!window->isVisible() || !toplevel->visibleRect().intersects(geometry)) {
+            continue;
+        }
+        // the topmost window has to cover the screen exactly with nothing but its buffer
+        if (toplevel->frameGeometry() != geometry || toplevel->bufferGeometry() != geometry) {
+            return nullptr;
+        }
+        if (toplevel->opacity() != 1.0) {
+            return nullptr;
+        }
+        if (toplevel->hasAlpha() && !(QRegion(QRect(QPoint(0, 0), geometry.size())) - toplevel->opaqueRegion()).isEmpty()) {
+            return nullptr;
+        }
+        KWayland::Server::SurfaceInterface *surface = toplevel->surface();
+        if (!surface || !surface->buffer() || !surface->childSubSurfaces().isEmpty()) {
+            return nullptr;
+        }
+        return toplevel;
+    }
+    return nullptr;
+}
+
+void Scene::resetWindowRepaints()
+{
+    for (Window *window : stacking_order) {
+        window->window()->resetRepaints();
+    }
+}
+
 static Scene::Window *s_recursionCheck = nullptr;
 
 void Scene::paintWindow(Window* w, int mask, const QRegion &_region, const WindowQuadList &quads)
@@ -630,6 +691,11 @@ bool Scene::syncsToVBlank() const
     return false;
 }
 
+bool Scene::perScreenPresentation() const
+{
+    return false;
+}
+
 void Scene::screenGeometryChanged(const QSize &size)
 {
     if (!overlayWindow()) {
@@ -147,6 +147,12 @@ public:
     virtual void idle();
     virtual bool blocksForRetrace() const;
     virtual bool syncsToVBlank() const;
+    /**
+     * Whether every screen is presented on its own. In that case the platform reports the
+     * page flips through Compositor::aboutToSwapBuffers(int) and Compositor::bufferSwapComplete(int)
+     * and paint() skips the screens which are not covered by the damage.
+     */
+    virtual bool perScreenPresentation() const;
     virtual OverlayWindow* overlayWindow() const = 0;
 
     virtual bool makeOpenGLContextCurrent();
@@ -200,6 +206,11 @@ public:
 
 Q_SIGNALS:
     void frameRendered();
+    /**
+     * Emitted by scenes painting the screens one by one after the screen @p screenId
+     * has been painted. @p damage is the region of the screen which has been updated.
+     */
+    void screenRendered(int screenId, const QRegion &damage);
     void resetCompositing();
 
 public Q_SLOTS:
@@ -211,6 +222,16 @@ protected:
     virtual Window *createWindow(Toplevel *toplevel) = 0;
     void createStackingOrder(const QList<Toplevel *> &toplevels);
     void clearStackingOrder();
+    // The damage including the repaints of the windows in the stacking order. The repaints
+    // of the windows are reset while painting a screen, so scenes painting the screens one
+    // by one have to pass them on to the other screens through the damage.
+    QRegion damageWithWindowRepaints(const QRegion &damage) const;
+    // The topmost window on the screen with the given geometry if its client buffer can be
+    // put directly on the screen, otherwise nullptr and the screen has to be composited.
+    Toplevel *directScanoutCandidate(const QRect &geometry) const;
+    // Resets the repaints of the windows in the stacking order, used when a screen got
+    // presented without painting it.
+    void resetWindowRepaints();
     // shared implementation, starts painting the screen
     void paintScreen(int *mask, const QRegion &damage, const QRegion &repaint,
                      QRegion *updateRegion, QRegion *validRegion, const QMatrix4x4 &projection = QMatrix4x4(), const QRect &outputGeometry = QRect());
@@ -0,0 +1,170 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "smartplacement.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+void SmartPlacement::addWindow(const QRect &geometry, int weight)
+{
+    m_windows.push_back({geometry.x(), geometry.y(), geometry.x() + geometry.width(), geometry.y() + geometry.height(), weight});
+}
+
+QPoint SmartPlacement::place(const QSize &size, const QRect &area) const
+{
+    /*
+     * SmartPlacement by Cristian Tibirna (tibirna@kde.org)
+     * adapted for kwm (16-19jan98) and for kwin (16Nov1999) using (with
+     * permission) ideas from fvwm, authored by
+     * Anthony Martin (amartin@engr.csulb.edu).
+     * Xinerama supported added by Balaji Ramani (balaji@yablibli.com)
+     * with ideas from xfce.
+     */
+    const long int none = 0, h_wrong = -1, w_wrong = -2; // overlap types
+    long int overlap = none, min_overlap = 0;
+
+    int x = area.left();
+    int y = area.top();
+    int x_optimal = x, y_optimal = y;
+
+    // client gabarit
+    const int ch = size.height() - 1;
+    const int cw = size.width() - 1;
+
+    // the windows in the order the sweep line reaches them
+    std::vector<const Window *> byTop;
+    byTop.reserve(m_windows.size());
+    std::vector<int> tops;
+    tops.reserve(m_windows.size());
+    std::vector<int> bottoms;
+    bottoms.reserve(m_windows.size());
+    for (const Window &window : m_windows) {
+        byTop.push_back(&window);
+        tops.push_back(window.top);
+        bottoms.push_back(window.bottom);
+    }
+    std::sort(byTop.begin(), byTop.end(), [] (const Window *a, const Window *b) {
+        return a->top < b->top;
+    });
+    std::sort(tops.begin(), tops.end());
+    std::sort(bottoms.begin(), bottoms.end());
+
+    // windows overlapping the rows [y, y + ch], y only ever grows
+    std::vector<const Window *> band;
+    auto next = byTop.cbegin();
+    int bandY = y - 1;
+
+    bool first_pass = true;
+    int nextX = x;
+
+    // loop over possible positions
+    do {
+        // test if enough room in x and y directions
+        if (y + ch > area.bottom() && ch < area.height()) {
+            overlap = h_wrong; // this throws the algorithm to an exit
+        } else if (x + cw > area.right()) {
+            overlap = w_wrong;
+        } else {
+            if (bandY != y) {
+                band.erase(std::remove_if(band.begin(), band.end(), [y] (const Window *window) {
+                    return window->bottom <= y;
+                }), band.end());
+                for (; next != byTop.cend() && (*next)->top < y + ch; ++next) {
+                    if ((*next)->bottom > y) {
+                        band.push_back(*next);
+                    }
+                }
+                bandY = y;
+            }
+
+            overlap = none;
+            const int cxl = x, cxr = x + cw;
+            nextX = area.right();
+            if (nextX - cw > x) {
+                nextX -= cw;
+            }
+            for (const Window *window : band) {
+                // if windows overlap, calc the overall overlapping
+                if (cxl < window->right && cxr > window->left) {
+                    const int xl = qMax(cxl, window->left);
+                    const int xr = qMin(cxr, window->right);
+                    const int yt = qMax(y, window->top);
+                    const int yb = qMin(y + ch, window->bottom);
+                    overlap += long(window->weight) * (xr - xl) * (yb - yt);
+                }
+                // determine the first non-overlapped x position
+                if (window->right > x && nextX > window->right) {
+                    nextX = window->right;
+                }
+                const int basket = window->left - cw;
+                if (basket > x && nextX > basket) {
+                    nextX = basket;
+                }
+            }
+
+            // first time we get no overlap we stop
+            if (overlap == none) {
+                x_optimal = x;
+                y_optimal = y;
+                break;
+            }
+        }
+
+        if (first_pass) {
+            first_pass = false;
+            min_overlap = overlap;
+        } else if (overlap >= none && overlap < min_overlap) {
+            // save the best position and the minimum overlap up to now
+            min_overlap = overlap;
+            x_optimal = x;
+            y_optimal = y;
+        }
+
+        if (overlap > none) {
+            x = nextX;
+        } else if (overlap == w_wrong) {
+            // not enough x dimension, go to the next row below an edge of a window
+            x = area.left();
+            int possible = area.bottom();
+            if (possible - ch > y) {
+                possible -= ch;
+            }
+            const auto bottom = std::upper_bound(bottoms.cbegin(), bottoms.cend(), y);
+            if (bottom != bottoms.cend() && possible > *bottom) {
+                possible = *bottom;
+            }
+            const auto top = std::upper_bound(tops.cbegin(), tops.cend(), y + ch);
+            if (top != tops.cend() && possible > *top - ch) {
+                possible = *top - ch;
+            }
+            y = possible;
+        }
+    } while (overlap != none && overlap != h_wrong && y < area.bottom());
+
+    if (ch >= area.height()) {
+        y_optimal = area.top();
+    }
+
+    return QPoint(x_optimal, y_optimal);
+}
+
+}
@@ -0,0 +1,72 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+
+#include <vector>
+
+namespace KWin
+{
+
+/**
+ * @brief Finds the position with the least overlap for a window among the occupied areas of a desktop.
+ *
+ * The occupied areas get collected once with addWindow(). place() then walks the same
+ * candidate positions as the original smart placement, but sweeps a horizontal band of the
+ * height of the placed window over the areas sorted by their top edge. Only the areas in the
+ * band are looked at for a candidate position and the next row is found with a binary search.
+ */
+class KWIN_EXPORT SmartPlacement
+{
+public:
+    /**
+     * Overlap weight of windows kept above the others.
+     */
+    static const int aboveWeight = 16;
+
+    /**
+     * Adds the frame @p geometry of a window, its overlap with the placed window gets
+     * multiplied by @p weight. Windows with a weight of @c 0 don't count as overlapping,
+     * but positions are still aligned to their edges.
+     */
+    void addWindow(const QRect &geometry, int weight = 1);
+
+    /**
+     * @returns the top left position for a window of @p size inside @p area
+     */
+    QPoint place(const QSize &size, const QRect &area) const;
+
+private:
+    struct Window {
+        int left;
+        int top;
+        int right;
+        int bottom;
+        int weight;
+    };
+    std::vector<Window> m_windows;
+};
+
+}
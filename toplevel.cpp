@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "atoms.h"
 #include "client_machine.h"
 #include "composite.h"
+#include "damagecollector.h"
 #include "effects.h"
 #include "screens.h"
 #include "shadow.h"
@@ -67,6 +68,9 @@ Toplevel::Toplevel()
 Toplevel::~Toplevel()
 {
     Q_ASSERT(damage_handle == XCB_NONE);
+    if (Compositor *compositor = Compositor::self()) {
+        compositor->removeTrackedWindow(this);
+    }
     delete info;
 }
 
@@ -101,6 +105,7 @@ void Toplevel::copyToDeleted(Toplevel* c)
     damage_region = c->damage_region;
     repaints_region = c->repaints_region;
     layer_repaints_region = c->layer_repaints_region;
+    trackRepaints();
     is_shape = c->is_shape;
     effect_window = c->effect_window;
     if (effect_window != nullptr)
@@ -138,7 +143,12 @@ QRect Toplevel::visibleRect() const
 
 Xcb::Property Toplevel::fetchWmClientLeader() const
 {
-    return Xcb::Property(false, window(), atoms->wm_client_leader, XCB_ATOM_WINDOW, 0, 10000);
+    return fetchWmClientLeader(window());
+}
+
+Xcb::Property Toplevel::fetchWmClientLeader(xcb_window_t window)
+{
+    return Xcb::Property(false, window, atoms->wm_client_leader, XCB_ATOM_WINDOW, 0, 10000);
 }
 
 void Toplevel::readWmClientLeader(Xcb::Property &prop)
@@ -310,7 +320,7 @@ void Toplevel::discardWindowPixmap()
 
 void Toplevel::damageNotifyEvent()
 {
-    m_isDamaged = true;
+    markDamaged();
 
     // Note: The rect is supposed to specify the damage extents,
     //       but we don't know it at this point. No one who connects
@@ -326,27 +336,17 @@ bool Toplevel::compositing() const
     return Workspace::self()->compositing();
 }
 
-bool Toplevel::resetAndFetchDamage()
+bool Toplevel::resetAndFetchDamage(DamageCollector *collector)
 {
     if (!m_isDamaged)
         return false;
 
-    if (damage_handle == XCB_NONE) {
+    if (damage_handle == XCB_NONE || !collector) {
         m_isDamaged = false;
         return true;
     }
 
-    xcb_connection_t *conn = connection();
-
-    // Create a new region and copy the damage region to it,
-    // resetting the damaged state.
-    xcb_xfixes_region_t region = xcb_generate_id(conn);
-    xcb_xfixes_create_region(conn, region, 0, nullptr);
-    xcb_damage_subtract(conn, damage_handle, 0, region);
-
-    // Send a fetch-region request and destroy the region
-    m_regionCookie = xcb_xfixes_fetch_region_unchecked(conn, region);
-    xcb_xfixes_destroy_region(conn, region);
+    m_regionCookie = collector->fetch(damage_handle);
 
     m_isDamaged = false;
     m_damageReplyPending = true;
@@ -354,45 +354,23 @@ bool Toplevel::resetAndFetchDamage()
     return m_damageReplyPending;
 }
 
-void Toplevel::getDamageRegionReply()
+void Toplevel::getDamageRegionReply(DamageCollector *collector)
 {
     if (!m_damageReplyPending)
         return;
 
     m_damageReplyPending = false;
 
-    // Get the fetch-region reply
-    xcb_xfixes_fetch_region_reply_t *reply =
-            xcb_xfixes_fetch_region_reply(connection(), m_regionCookie, nullptr);
-
-    if (!reply)
+    const QRegion region = collector->reply(m_regionCookie);
+    if (region.isEmpty())
         return;
 
-    // Convert the reply to a QRegion
-    int count = xcb_xfixes_fetch_region_rectangles_length(reply);
-    QRegion region;
-
-    if (count > 1 && count < 16) {
-        xcb_rectangle_t *rects = xcb_xfixes_fetch_region_rectangles(reply);
-
-        QVector<QRect> qrects;
-        qrects.reserve(count);
-
-        for (int i = 0; i < count; i++)
-            qrects << QRect(rects[i].x, rects[i].y, rects[i].width, rects[i].height);
-
-        region.setRects(qrects.constData(), count);
-    } else
-        region += QRect(reply->extents.x, reply->extents.y,
-                        reply->extents.width, reply->extents.height);
-
     const QRect bufferRect = bufferGeometry();
     const QRect frameRect = frameGeometry();
 
     damage_region += region;
     repaints_region += region.translated(bufferRect.topLeft() - frameRect.topLeft());
-
-    free(reply);
+    trackRepaints();
 }
 
 void Toplevel::addDamageFull()
@@ -410,6 +388,7 @@ void Toplevel::addDamageFull()
 
     damage_region = damagedRect;
     repaints_region |= damagedRect.translated(offsetX, offsetY);
+    trackRepaints();
 
     emit damaged(this, damagedRect);
 }
@@ -425,6 +404,7 @@ void Toplevel::addRepaint(const QRect& r)
         return;
     }
     repaints_region += r;
+    trackRepaints();
     emit needsRepaint();
 }
 
@@ -440,6 +420,7 @@ void Toplevel::addRepaint(const QRegion& r)
         return;
     }
     repaints_region += r;
+    trackRepaints();
     emit needsRepaint();
 }
 
@@ -449,6 +430,7 @@ void Toplevel::addLayerRepaint(const QRect& r)
         return;
     }
     layer_repaints_region += r;
+    trackRepaints();
     emit needsRepaint();
 }
 
@@ -463,12 +445,14 @@ void Toplevel::addLayerRepaint(const QRegion& r)
     if (!compositing())
         return;
     layer_repaints_region += r;
+    trackRepaints();
     emit needsRepaint();
 }
 
 void Toplevel::addRepaintFull()
 {
     repaints_region = visibleRect().translated(-pos());
+    trackRepaints();
     emit needsRepaint();
 }
 
@@ -478,6 +462,21 @@ void Toplevel::resetRepaints()
     layer_repaints_region = QRegion();
 }
 
+void Toplevel::trackRepaints()
+{
+    if (Compositor *compositor = Compositor::self()) {
+        compositor->addRepaintedWindow(this);
+    }
+}
+
+void Toplevel::markDamaged()
+{
+    m_isDamaged = true;
+    if (Compositor *compositor = Compositor::self()) {
+        compositor->addDamagedWindow(this);
+    }
+}
+
 void Toplevel::addWorkspaceRepaint(int x, int y, int w, int h)
 {
     addWorkspaceRepaint(QRect(x, y, w, h));
@@ -671,7 +670,12 @@ xcb_window_t Toplevel::frameId() const
 
 Xcb::Property Toplevel::fetchSkipCloseAnimation() const
 {
-    return Xcb::Property(false, window(), atoms->kde_skip_close_animation, XCB_ATOM_CARDINAL, 0, 1);
+    return fetchSkipCloseAnimation(window());
+}
+
+Xcb::Property Toplevel::fetchSkipCloseAnimation(xcb_window_t window)
+{
+    return Xcb::Property(false, window, atoms->kde_skip_close_animation, XCB_ATOM_CARDINAL, 0, 1);
 }
 
 void Toplevel::readSkipCloseAnimation(Xcb::Property &property)
@@ -717,7 +721,7 @@ void Toplevel::setSurface(KWayland::Server::SurfaceInterface *surface)
             // TODO improve to only update actual visual area
             if (ready_for_painting) {
                 addDamageFull();
-                m_isDamaged = true;
+                markDamaged();
             }
         }
     );
@@ -731,7 +735,9 @@ void Toplevel::setSurface(KWayland::Server::SurfaceInterface *surface)
 
 void Toplevel::addDamage(const QRegion &damage)
 {
-    m_isDamaged = true;
+    // subclasses extend repaints_region before calling this
+    trackRepaints();
+    markDamaged();
     damage_region += damage;
     for (const QRect &r : damage) {
         emit damaged(this, r);
@@ -52,6 +52,7 @@ namespace KWin
 {
 
 class ClientMachine;
+class DamageCollector;
 class Deleted;
 class EffectWindowImpl;
 class Shadow;
@@ -498,20 +499,20 @@ public:
     virtual Layer layer() const = 0;
 
     /**
-     * Resets the damage state and sends a request for the damage region.
+     * Resets the damage state and sends a request for the damage region through @p collector.
      * A call to this function must be followed by a call to getDamageRegionReply(),
      * or the reply will be leaked.
      *
      * Returns true if the window was damaged, and false otherwise.
      */
-    bool resetAndFetchDamage();
+    bool resetAndFetchDamage(DamageCollector *collector);
 
     /**
      * Gets the reply from a previous call to resetAndFetchDamage().
      * Calling this function is a no-op if there is no pending reply.
      * Call damage() to return the fetched region.
      */
-    void getDamageRegionReply();
+    void getDamageRegionReply(DamageCollector *collector);
 
     bool skipsCloseAnimation() const;
     void setSkipCloseAnimation(bool set);
@@ -682,6 +683,7 @@ protected:
     void addDamageFull();
     virtual void addDamage(const QRegion &damage);
     Xcb::Property fetchWmClientLeader() const;
+    static Xcb::Property fetchWmClientLeader(xcb_window_t window);
     void readWmClientLeader(Xcb::Property &p);
     void getWmClientLeader();
     void getWmClientMachine();
@@ -699,12 +701,14 @@ protected:
     void getResourceClass();
     void setResourceClass(const QByteArray &name, const QByteArray &className = QByteArray());
     Xcb::Property fetchSkipCloseAnimation() const;
+    static Xcb::Property fetchSkipCloseAnimation(xcb_window_t window);
     void readSkipCloseAnimation(Xcb::Property &prop);
     void getSkipCloseAnimation();
     virtual void debug(QDebug& stream) const = 0;
     void copyToDeleted(Toplevel* c);
     void disownDataPassedToDeleted();
     friend QDebug& operator<<(QDebug& stream, const Toplevel*);
+    friend class X11ClientPrefetch;
     void deleteEffectWindow();
     void setDepth(int depth);
     QRect m_frameGeometry;
@@ -714,6 +718,15 @@ protected:
     bool ready_for_painting;
     QRegion repaints_region; // updating, repaint just requires repaint of that area
     QRegion layer_repaints_region;
+    /**
+     * Lets the Compositor know that repaints_region or layer_repaints_region got extended,
+     * has to be called after modifying them.
+     */
+    void trackRepaints();
+    /**
+     * Marks the window as damaged, the damage gets fetched with the next compositing pass.
+     */
+    void markDamaged();
     /**
      * An FBO object KWin internal windows might render to.
      */
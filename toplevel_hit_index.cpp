@@ -0,0 +1,157 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "toplevel_hit_index.h"
+#include <toplevel.h>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+static int cellIndex(int coordinate)
+{
+    // round towards negative infinity, windows can be at negative positions
+    if (coordinate >= 0) {
+        return coordinate / ToplevelHitIndex::cellSize;
+    }
+    return (coordinate - ToplevelHitIndex::cellSize + 1) / ToplevelHitIndex::cellSize;
+}
+
+ToplevelHitIndex::ToplevelHitIndex(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ToplevelHitIndex::~ToplevelHitIndex()
+{
+    clear();
+}
+
+quint64 ToplevelHitIndex::cellKey(int column, int row)
+{
+    return (quint64(quint32(column)) << 32) | quint32(row);
+}
+
+void ToplevelHitIndex::invalidate()
+{
+    m_valid = false;
+}
+
+void ToplevelHitIndex::clear()
+{
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        disconnect(it.key(), nullptr, this, nullptr);
+    }
+    m_entries.clear();
+    m_cells.clear();
+}
+
+void ToplevelHitIndex::rebuild(const QList<Toplevel *> &toplevels)
+{
+    clear();
+    for (int i = 0; i < toplevels.count(); ++i) {
+        Toplevel *toplevel = toplevels.at(i);
+        const Entry entry{i, toplevel->inputGeometry()};
+        m_entries.insert(toplevel, entry);
+        insert(toplevel, entry);
+
+        connect(toplevel, &Toplevel::geometryShapeChanged, this, &ToplevelHitIndex::update);
+        connect(toplevel, &Toplevel::frameGeometryChanged, this, &ToplevelHitIndex::update);
+        connect(toplevel, &QObject::destroyed, this, &ToplevelHitIndex::handleDestroyed);
+    }
+    m_valid = true;
+}
+
+const QVector<Toplevel *> &ToplevelHitIndex::candidates(const QPoint &pos) const
+{
+    static const QVector<Toplevel *> s_empty;
+    const auto it = m_cells.constFind(cellKey(cellIndex(pos.x()), cellIndex(pos.y())));
+    if (it == m_cells.constEnd()) {
+        return s_empty;
+    }
+    return *it;
+}
+
+void ToplevelHitIndex::insert(Toplevel *toplevel, const Entry &entry)
+{
+    if (entry.rect.isEmpty()) {
+        return;
+    }
+    auto isAbove = [this] (Toplevel *other, int position) {
+        return m_entries.value(other).position > position;
+    };
+    for (int column = cellIndex(entry.rect.left()); column <= cellIndex(entry.rect.right()); ++column) {
+        for (int row = cellIndex(entry.rect.top()); row <= cellIndex(entry.rect.bottom()); ++row) {
+            QVector<Toplevel *> &cell = m_cells[cellKey(column, row)];
+            // keep the cell sorted from top to bottom
+            cell.insert(std::lower_bound(cell.begin(), cell.end(), entry.position, isAbove), toplevel);
+        }
+    }
+}
+
+void ToplevelHitIndex::remove(Toplevel *toplevel, const Entry &entry)
+{
+    if (entry.rect.isEmpty()) {
+        return;
+    }
+    for (int column = cellIndex(entry.rect.left()); column <= cellIndex(entry.rect.right()); ++column) {
+        for (int row = cellIndex(entry.rect.top()); row <= cellIndex(entry.rect.bottom()); ++row) {
+            const quint64 key = cellKey(column, row);
+            auto it = m_cells.find(key);
+            if (it == m_cells.end()) {
+                continue;
+            }
+            it->removeOne(toplevel);
+            if (it->isEmpty()) {
+                m_cells.erase(it);
+            }
+        }
+    }
+}
+
+void ToplevelHitIndex::update(Toplevel *toplevel)
+{
+    auto it = m_entries.find(toplevel);
+    if (it == m_entries.end()) {
+        return;
+    }
+    const QRect rect = toplevel->inputGeometry();
+    if (rect == it->rect) {
+        return;
+    }
+    remove(toplevel, *it);
+    it->rect = rect;
+    insert(toplevel, *it);
+}
+
+void ToplevelHitIndex::handleDestroyed(QObject *object)
+{
+    // the Toplevel part is already gone, the pointer may only be used as a key
+    Toplevel *toplevel = static_cast<Toplevel *>(object);
+    const auto it = m_entries.constFind(toplevel);
+    if (it == m_entries.constEnd()) {
+        return;
+    }
+    remove(toplevel, *it);
+    m_entries.erase(it);
+    m_valid = false;
+}
+
+}
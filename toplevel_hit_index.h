@@ -0,0 +1,89 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QHash>
+#include <QObject>
+#include <QRect>
+#include <QVector>
+
+namespace KWin
+{
+
+class Toplevel;
+
+/**
+ * @brief Grid over the input geometry of windows to find the windows under a position quickly.
+ *
+ * The screen space is split into square cells. Every cell lists the windows whose input
+ * geometry overlaps it, sorted from top to bottom. A hit test only looks at the windows
+ * of the cell containing the position instead of all windows.
+ *
+ * The index follows the geometry changes of the indexed windows on its own. Changes to the
+ * set of windows or their order have to be announced with invalidate(), the index then gets
+ * rebuilt by the next call to rebuild().
+ */
+class KWIN_EXPORT ToplevelHitIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ToplevelHitIndex(QObject *parent = nullptr);
+    ~ToplevelHitIndex() override;
+
+    /**
+     * @returns @c false if the index has to be rebuilt before it can be used
+     */
+    bool isValid() const {
+        return m_valid;
+    }
+    void invalidate();
+    /**
+     * Indexes @p toplevels, later windows in the list are above earlier ones.
+     */
+    void rebuild(const QList<Toplevel *> &toplevels);
+
+    /**
+     * The windows whose input geometry overlaps the cell containing @p pos, the top most
+     * first. Callers still have to check whether the input geometry contains @p pos.
+     */
+    const QVector<Toplevel *> &candidates(const QPoint &pos) const;
+
+    static const int cellSize = 256;
+
+private:
+    struct Entry {
+        int position;
+        QRect rect;
+    };
+    void clear();
+    void insert(Toplevel *toplevel, const Entry &entry);
+    void remove(Toplevel *toplevel, const Entry &entry);
+    void update(Toplevel *toplevel);
+    void handleDestroyed(QObject *object);
+    static quint64 cellKey(int column, int row);
+
+    QHash<Toplevel *, Entry> m_entries;
+    QHash<quint64, QVector<Toplevel *>> m_cells;
+    bool m_valid = false;
+};
+
+}
@@ -58,6 +58,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "virtualdesktops.h"
 #include "was_user_interaction_x11_filter.h"
 #include "wayland_server.h"
+#include "x11clientprefetch.h"
 #include "xcbutils.h"
 #include "main.h"
 #include "decorations/decorationbridge.h"
@@ -67,8 +68,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <KLocalizedString>
 #include <KStartupInfo>
 // Qt
+#include <QElapsedTimer>
 #include <QtConcurrentRun>
 
+#include <memory>
+
 namespace KWin
 {
 
@@ -373,6 +377,9 @@ void Workspace::initWithX11()
         // Begin updates blocker block
         StackingUpdatesBlocker blocker(this);
 
+        QElapsedTimer timer;
+        timer.start();
+
         Xcb::Tree tree(rootWindow());
         xcb_window_t *wins = xcb_query_tree_children(tree.data());
 
@@ -385,7 +392,10 @@ void Workspace::initWithX11()
             windowGeometries[i] = Xcb::WindowGeometry(wins[i]);
         }
 
-        // Get the replies
+        // Get the replies and request what managing needs for all windows
+        // before managing the first one, so that the replies arrive in one go
+        QVector<xcb_window_t> unmanaged;
+        std::vector<std::unique_ptr<X11ClientPrefetch>> prefetches;
         for (int i = 0; i < tree->children_len; i++) {
             Xcb::WindowAttributes attr(windowAttributes.at(i));
 
@@ -396,17 +406,34 @@ void Workspace::initWithX11()
             if (attr->override_redirect) {
                 if (attr->map_state == XCB_MAP_STATE_VIEWABLE &&
                     attr->_class != XCB_WINDOW_CLASS_INPUT_ONLY)
-                    // ### This will request the attributes again
-                    createUnmanaged(wins[i]);
+                    unmanaged << wins[i];
             } else if (attr->map_state != XCB_MAP_STATE_UNMAPPED) {
                 if (Application::wasCrash()) {
                     fixPositionAfterCrash(wins[i], windowGeometries.at(i).data());
                 }
 
-                // ### This will request the attributes again
-                createClient(wins[i], true);
+                // Properties can change before manage() selects for their changes,
+                // so select for them now to not miss any change after the prefetch
+                const uint32_t eventMask = attr->your_event_mask | XCB_EVENT_MASK_PROPERTY_CHANGE;
+                xcb_change_window_attributes(connection(), wins[i], XCB_CW_EVENT_MASK, &eventMask);
+                prefetches.emplace_back(new X11ClientPrefetch(wins[i]));
             }
         }
+        const qint64 requestTime = timer.restart();
+
+        // The creation order doesn't define the stacking order: the clients keep the order
+        // of the tree among themselves, and the unmanaged windows get stacked by querying
+        // the tree in updateXStackingOrder(). So they don't need to be interleaved.
+        for (xcb_window_t window : qAsConst(unmanaged)) {
+            // ### This will request the attributes again
+            createUnmanaged(window);
+        }
+        for (const auto &prefetch : prefetches) {
+            createClient(prefetch->window(), true, prefetch.get());
+        }
+        qCDebug(KWIN_CORE) << "Adopted" << int(prefetches.size()) << "windows and" << unmanaged.count()
+                           << "unmanaged windows, requests took" << requestTime << "ms, managing took"
+                           << timer.elapsed() << "ms";
 
         // Propagate clients, will really happen at the end of the updates blocker block
         updateStackingOrder(true);
@@ -474,6 +501,10 @@ Workspace::~Workspace()
         m_allClients.removeAll(c);
         desktops.removeAll(c);
     }
+    m_clientsByWindow.clear();
+    m_clientsByWrapper.clear();
+    m_clientsByFrame.clear();
+    m_clientsByInput.clear();
     X11Client::cleanupX11();
 
     if (waylandServer()) {
@@ -521,7 +552,7 @@ void Workspace::setupClientConnections(AbstractClient *c)
     connect(c, &AbstractClient::minimizedChanged, this, std::bind(&Workspace::clientMinimizedChanged, this, c));
 }
 
-X11Client *Workspace::createClient(xcb_window_t w, bool is_mapped)
+X11Client *Workspace::createClient(xcb_window_t w, bool is_mapped, X11ClientPrefetch *prefetch)
 {
     StackingUpdatesBlocker blocker(this);
     X11Client *c = new X11Client();
@@ -530,7 +561,7 @@ X11Client *Workspace::createClient(xcb_window_t w, bool is_mapped)
         connect(c, &X11Client::blockingCompositingChanged, compositor, &X11Compositor::updateClientCompositeBlocking);
     }
     connect(c, SIGNAL(clientFullScreenSet(KWin::X11Client *,bool,bool)), ScreenEdges::self(), SIGNAL(checkBlocking()));
-    if (!c->manage(w, is_mapped)) {
+    if (!c->manage(w, is_mapped, prefetch)) {
         X11Client::deleteClient(c);
         return nullptr;
     }
@@ -574,6 +605,7 @@ void Workspace::addClient(X11Client *c)
         clients.append(c);
         m_allClients.append(c);
     }
+    addToWindowIndex(c);
     if (!unconstrained_stacking_order.contains(c))
         unconstrained_stacking_order.append(c);   // Raise if it hasn't got any stacking position yet
     if (!stacking_order.contains(c))    // It'll be updated later, and updateToolWindows() requires
@@ -598,9 +630,48 @@ void Workspace::addClient(X11Client *c)
 void Workspace::addUnmanaged(Unmanaged* c)
 {
     unmanaged.append(c);
+    m_unmanagedByWindow.insert(c->window(), c);
     markXStackingOrderAsDirty();
 }
 
+void Workspace::addToWindowIndex(X11Client *c)
+{
+    m_clientsByWindow.insert(c->window(), c);
+    m_clientsByWrapper.insert(c->wrapperId(), c);
+    m_clientsByFrame.insert(c->frameId(), c);
+    if (c->inputId() != XCB_WINDOW_NONE) {
+        m_clientsByInput.insert(c->inputId(), c);
+    }
+}
+
+void Workspace::removeFromWindowIndex(X11Client *c)
+{
+    m_clientsByWindow.remove(c->window());
+    m_clientsByWrapper.remove(c->wrapperId());
+    m_clientsByFrame.remove(c->frameId());
+    if (c->inputId() != XCB_WINDOW_NONE) {
+        m_clientsByInput.remove(c->inputId());
+    }
+}
+
+/**
+ * Keeps the window id index in sync when the decoration input window of @p c
+ * gets created or destroyed. Clients which are not managed yet are ignored,
+ * addClient() picks up their current input window.
+ */
+void Workspace::updateClientInputId(X11Client *c, xcb_window_t oldInputId)
+{
+    if (m_clientsByWindow.value(c->window()) != c) {
+        return;
+    }
+    if (oldInputId != XCB_WINDOW_NONE) {
+        m_clientsByInput.remove(oldInputId);
+    }
+    if (c->inputId() != XCB_WINDOW_NONE) {
+        m_clientsByInput.insert(c->inputId(), c);
+    }
+}
+
 /**
  * Destroys the client \a c
  */
@@ -624,6 +695,7 @@ void Workspace::removeClient(X11Client *c)
     clients.removeAll(c);
     m_allClients.removeAll(c);
     desktops.removeAll(c);
+    removeFromWindowIndex(c);
     markXStackingOrderAsDirty();
     attention_chain.removeAll(c);
     Group* group = findGroup(c->window());
@@ -650,6 +722,7 @@ void Workspace::removeUnmanaged(Unmanaged* c)
 {
     Q_ASSERT(unmanaged.contains(c));
     unmanaged.removeAll(c);
+    m_unmanagedByWindow.remove(c->window());
     emit unmanagedRemoved(c);
     markXStackingOrderAsDirty();
 }
@@ -1683,30 +1756,26 @@ Unmanaged *Workspace::findUnmanaged(std::function<bool (const Unmanaged*)> func)
 
 Unmanaged *Workspace::findUnmanaged(xcb_window_t w) const
 {
-    return findUnmanaged([w](const Unmanaged *u) {
-        return u->window() == w;
-    });
+    if (w == XCB_WINDOW_NONE) {
+        return nullptr;
+    }
+    return m_unmanagedByWindow.value(w);
 }
 
 X11Client *Workspace::findClient(Predicate predicate, xcb_window_t w) const
 {
+    if (w == XCB_WINDOW_NONE) {
+        return nullptr;
+    }
     switch (predicate) {
     case Predicate::WindowMatch:
-        return findClient([w](const X11Client *c) {
-            return c->window() == w;
-        });
+        return m_clientsByWindow.value(w);
     case Predicate::WrapperIdMatch:
-        return findClient([w](const X11Client *c) {
-            return c->wrapperId() == w;
-        });
+        return m_clientsByWrapper.value(w);
     case Predicate::FrameIdMatch:
-        return findClient([w](const X11Client *c) {
-            return c->frameId() == w;
-        });
+        return m_clientsByFrame.value(w);
     case Predicate::InputIdMatch:
-        return findClient([w](const X11Client *c) {
-            return c->inputId() == w;
-        });
+        return m_clientsByInput.value(w);
     }
     return nullptr;
 }
@@ -29,6 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "sm.h"
 #include "utils.h"
 // Qt
+#include <QHash>
 #include <QTimer>
 #include <QVector>
 // std
@@ -62,6 +63,7 @@ class Toplevel;
 class Unmanaged;
 class UserActionsMenu;
 class X11Client;
+class X11ClientPrefetch;
 class X11EventFilter;
 enum class Predicate;
 
@@ -334,6 +336,7 @@ public:
     Group* findClientLeaderGroup(const X11Client *c) const;
 
     void removeUnmanaged(Unmanaged*);   // Only called from Unmanaged::release()
+    void updateClientInputId(X11Client *c, xcb_window_t oldInputId);   // Only called from X11Client
     void removeDeleted(Deleted*);
     void addDeleted(Deleted*, Toplevel*);
 
@@ -556,11 +559,13 @@ private:
     void saveOldScreenSizes();
 
     /// This is the right way to create a new client
-    X11Client *createClient(xcb_window_t w, bool is_mapped);
+    X11Client *createClient(xcb_window_t w, bool is_mapped, X11ClientPrefetch *prefetch = nullptr);
     void setupClientConnections(AbstractClient *client);
     void addClient(X11Client *c);
     Unmanaged* createUnmanaged(xcb_window_t w);
     void addUnmanaged(Unmanaged* c);
+    void addToWindowIndex(X11Client *c);
+    void removeFromWindowIndex(X11Client *c);
 
     void addShellClient(AbstractClient *client);
     void removeShellClient(AbstractClient *client);
@@ -603,6 +608,13 @@ private:
     QList<Deleted *> deleted;
     QList<InternalClient *> m_internalClients;
 
+    // Window id lookup tables for findClient(Predicate, xcb_window_t) and findUnmanaged(xcb_window_t)
+    QHash<xcb_window_t, X11Client *> m_clientsByWindow;
+    QHash<xcb_window_t, X11Client *> m_clientsByWrapper;
+    QHash<xcb_window_t, X11Client *> m_clientsByFrame;
+    QHash<xcb_window_t, X11Client *> m_clientsByInput;
+    QHash<xcb_window_t, Unmanaged *> m_unmanagedByWindow;
+
     QList<Toplevel *> unconstrained_stacking_order; // Topmost last
     QList<Toplevel *> stacking_order; // Topmost last
     QVector<xcb_window_t> manual_overlays; //Topmost last
@@ -41,6 +41,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #endif
 #include "workspace.h"
 #include "screenedge.h"
+#include "x11clientprefetch.h"
 #include "decorations/decorationbridge.h"
 #include "decorations/decoratedclient.h"
 #include <KDecoration2/Decoration>
@@ -330,12 +331,24 @@ void X11Client::destroyClient()
  * reparenting, initial geometry, initial state, placement, etc.
  * Returns false if KWin is not going to manage this window.
  */
-bool X11Client::manage(xcb_window_t w, bool isMapped)
+bool X11Client::manage(xcb_window_t w, bool isMapped, X11ClientPrefetch *prefetch)
 {
     StackingUpdatesBlocker stacking_blocker(workspace());
 
-    Xcb::WindowAttributes attr(w);
-    Xcb::WindowGeometry windowGeometry(w);
+    QScopedPointer<X11ClientPrefetch> ownPrefetch;
+    if (!prefetch) {
+        // Properties can change before embedClient() selects for their changes, so select
+        // for them now to not miss any change after the prefetch. embedClient() replaces
+        // the event mask later on.
+        const uint32_t eventMask = XCB_EVENT_MASK_PROPERTY_CHANGE;
+        xcb_change_window_attributes(connection(), w, XCB_CW_EVENT_MASK, &eventMask);
+        ownPrefetch.reset(new X11ClientPrefetch(w));
+        prefetch = ownPrefetch.data();
+    }
+    Q_ASSERT(prefetch->window() == w);
+
+    Xcb::WindowAttributes &attr = prefetch->attributes;
+    Xcb::WindowGeometry &windowGeometry = prefetch->geometry;
     if (attr.isNull() || windowGeometry.isNull()) {
         return false;
     }
@@ -381,15 +394,15 @@ bool X11Client::manage(xcb_window_t w, bool isMapped)
         NET::WM2DesktopFileName |
         NET::WM2GTKFrameExtents;
 
-    auto wmClientLeaderCookie = fetchWmClientLeader();
-    auto skipCloseAnimationCookie = fetchSkipCloseAnimation();
-    auto showOnScreenEdgeCookie = fetchShowOnScreenEdge();
-    auto colorSchemeCookie = fetchColorScheme();
-    auto firstInTabBoxCookie = fetchFirstInTabBox();
-    auto transientCookie = fetchTransient();
-    auto activitiesCookie = fetchActivities();
-    auto applicationMenuServiceNameCookie = fetchApplicationMenuServiceName();
-    auto applicationMenuObjectPathCookie = fetchApplicationMenuObjectPath();
+    auto &wmClientLeaderCookie = prefetch->wmClientLeader;
+    auto &skipCloseAnimationCookie = prefetch->skipCloseAnimation;
+    auto &showOnScreenEdgeCookie = prefetch->showOnScreenEdge;
+    auto &colorSchemeCookie = prefetch->colorScheme;
+    auto &firstInTabBoxCookie = prefetch->firstInTabBox;
+    auto &transientCookie = prefetch->transient;
+    auto &activitiesCookie = prefetch->activities;
+    auto &applicationMenuServiceNameCookie = prefetch->applicationMenuServiceName;
+    auto &applicationMenuObjectPathCookie = prefetch->applicationMenuObjectPath;
 
     m_geometryHints.init(window());
     m_motif.init(window());
@@ -998,7 +1011,11 @@ void X11Client::updateInputWindow()
     }
 
     if (region.isEmpty()) {
-        m_decoInputExtent.reset();
+        if (m_decoInputExtent.isValid()) {
+            const xcb_window_t oldInputId = m_decoInputExtent;
+            m_decoInputExtent.reset();
+            workspace()->updateClientInputId(this, oldInputId);
+        }
         return;
     }
 
@@ -1021,6 +1038,7 @@ void X11Client::updateInputWindow()
             XCB_EVENT_MASK_POINTER_MOTION
         };
         m_decoInputExtent.create(bounds, XCB_WINDOW_CLASS_INPUT_ONLY, mask, values);
+        workspace()->updateClientInputId(this, XCB_WINDOW_NONE);
         if (mapping_state == Mapped)
             m_decoInputExtent.map();
     } else {
@@ -1103,7 +1121,11 @@ void X11Client::destroyDecoration()
             emit geometryShapeChanged(this, oldgeom);
         }
     }
-    m_decoInputExtent.reset();
+    if (m_decoInputExtent.isValid()) {
+        const xcb_window_t oldInputId = m_decoInputExtent;
+        m_decoInputExtent.reset();
+        workspace()->updateClientInputId(this, oldInputId);
+    }
 }
 
 void X11Client::layoutDecorationRects(QRect &left, QRect &top, QRect &right, QRect &bottom) const
@@ -2507,10 +2529,16 @@ void X11Client::debug(QDebug& stream) const
 }
 
 Xcb::StringProperty X11Client::fetchActivities() const
+{
+    return fetchActivities(window());
+}
+
+Xcb::StringProperty X11Client::fetchActivities(xcb_window_t window)
 {
 #ifdef KWIN_BUILD_ACTIVITIES
-    return Xcb::StringProperty(window(), atoms->activities);
+    return Xcb::StringProperty(window, atoms->activities);
 #else
+    Q_UNUSED(window)
     return Xcb::StringProperty();
 #endif
 }
@@ -2586,7 +2614,12 @@ void X11Client::setSessionActivityOverride(bool needed)
 
 Xcb::Property X11Client::fetchFirstInTabBox() const
 {
-    return Xcb::Property(false, m_client, atoms->kde_first_in_window_list,
+    return fetchFirstInTabBox(m_client);
+}
+
+Xcb::Property X11Client::fetchFirstInTabBox(xcb_window_t window)
+{
+    return Xcb::Property(false, window, atoms->kde_first_in_window_list,
                          atoms->kde_first_in_window_list, 0, 1);
 }
 
@@ -2604,7 +2637,12 @@ void X11Client::updateFirstInTabBox()
 
 Xcb::StringProperty X11Client::fetchColorScheme() const
 {
-    return Xcb::StringProperty(m_client, atoms->kde_color_sheme);
+    return fetchColorScheme(m_client);
+}
+
+Xcb::StringProperty X11Client::fetchColorScheme(xcb_window_t window)
+{
+    return Xcb::StringProperty(window, atoms->kde_color_sheme);
 }
 
 void X11Client::readColorScheme(Xcb::StringProperty &property)
@@ -2756,7 +2794,12 @@ QMatrix4x4 X11Client::inputTransformation() const
 
 Xcb::Property X11Client::fetchShowOnScreenEdge() const
 {
-    return Xcb::Property(false, window(), atoms->kde_screen_edge_show, XCB_ATOM_CARDINAL, 0, 1);
+    return fetchShowOnScreenEdge(window());
+}
+
+Xcb::Property X11Client::fetchShowOnScreenEdge(xcb_window_t window)
+{
+    return Xcb::Property(false, window, atoms->kde_screen_edge_show, XCB_ATOM_CARDINAL, 0, 1);
 }
 
 void X11Client::readShowOnScreenEdge(Xcb::Property &property)
@@ -2868,7 +2911,12 @@ QSize X11Client::resizeIncrements() const
 
 Xcb::StringProperty X11Client::fetchApplicationMenuServiceName() const
 {
-    return Xcb::StringProperty(m_client, atoms->kde_net_wm_appmenu_service_name);
+    return fetchApplicationMenuServiceName(m_client);
+}
+
+Xcb::StringProperty X11Client::fetchApplicationMenuServiceName(xcb_window_t window)
+{
+    return Xcb::StringProperty(window, atoms->kde_net_wm_appmenu_service_name);
 }
 
 void X11Client::readApplicationMenuServiceName(Xcb::StringProperty &property)
@@ -2884,7 +2932,12 @@ void X11Client::checkApplicationMenuServiceName()
 
 Xcb::StringProperty X11Client::fetchApplicationMenuObjectPath() const
 {
-    return Xcb::StringProperty(m_client, atoms->kde_net_wm_appmenu_object_path);
+    return fetchApplicationMenuObjectPath(m_client);
+}
+
+Xcb::StringProperty X11Client::fetchApplicationMenuObjectPath(xcb_window_t window)
+{
+    return Xcb::StringProperty(window, atoms->kde_net_wm_appmenu_object_path);
 }
 
 void X11Client::readApplicationMenuObjectPath(Xcb::StringProperty &property)
@@ -3088,7 +3141,12 @@ bool X11Client::sameAppWindowRoleMatch(const X11Client *c1, const X11Client *c2,
 
 Xcb::TransientFor X11Client::fetchTransient() const
 {
-    return Xcb::TransientFor(window());
+    return fetchTransient(window());
+}
+
+Xcb::TransientFor X11Client::fetchTransient(xcb_window_t window)
+{
+    return Xcb::TransientFor(window);
 }
 
 void X11Client::readTransientProperty(Xcb::TransientFor &transientFor)
@@ -5016,7 +5074,7 @@ void X11Client::damageNotifyEvent()
 {
     if (m_syncRequest.isPending && isResize()) {
         emit damaged(this, QRect());
-        m_isDamaged = true;
+        markDamaged();
         return;
     }
 
@@ -44,6 +44,7 @@ class KStartupInfoId;
 namespace KWin
 {
 
+class X11ClientPrefetch;
 
 /**
  * @brief Defines Predicates on how to search for a Client.
@@ -127,7 +128,10 @@ public:
     bool windowEvent(xcb_generic_event_t *e);
     NET::WindowType windowType(bool direct = false, int supported_types = 0) const override;
 
-    bool manage(xcb_window_t w, bool isMapped);
+    /**
+     * @param prefetch The requests issued for @p w ahead of time, if @c null they get issued now
+     */
+    bool manage(xcb_window_t w, bool isMapped, X11ClientPrefetch *prefetch = nullptr);
     void releaseWindow(bool on_shutdown = false);
     void destroyClient() override;
 
@@ -280,9 +284,11 @@ public:
     void layoutDecorationRects(QRect &left, QRect &top, QRect &right, QRect &bottom) const override;
 
     Xcb::Property fetchFirstInTabBox() const;
+    static Xcb::Property fetchFirstInTabBox(xcb_window_t window);
     void readFirstInTabBox(Xcb::Property &property);
     void updateFirstInTabBox();
     Xcb::StringProperty fetchColorScheme() const;
+    static Xcb::StringProperty fetchColorScheme(xcb_window_t window);
     void readColorScheme(Xcb::StringProperty &property);
     void updateColorScheme() override;
 
@@ -302,10 +308,12 @@ public:
     void showOnScreenEdge() override;
 
     Xcb::StringProperty fetchApplicationMenuServiceName() const;
+    static Xcb::StringProperty fetchApplicationMenuServiceName(xcb_window_t window);
     void readApplicationMenuServiceName(Xcb::StringProperty &property);
     void checkApplicationMenuServiceName();
 
     Xcb::StringProperty fetchApplicationMenuObjectPath() const;
+    static Xcb::StringProperty fetchApplicationMenuObjectPath(xcb_window_t window);
     void readApplicationMenuObjectPath(Xcb::StringProperty &property);
     void checkApplicationMenuObjectPath();
 
@@ -465,6 +473,7 @@ private:
     void updateInputWindow();
 
     Xcb::Property fetchShowOnScreenEdge() const;
+    static Xcb::Property fetchShowOnScreenEdge(xcb_window_t window);
     void readShowOnScreenEdge(Xcb::Property &property);
     /**
      * Reads the property and creates/destroys the screen edge if required
@@ -493,6 +502,7 @@ private:
     MappingState mapping_state;
 
     Xcb::TransientFor fetchTransient() const;
+    static Xcb::TransientFor fetchTransient(xcb_window_t window);
     void readTransientProperty(Xcb::TransientFor &transientFor);
     void readTransient();
     xcb_window_t verifyTransientFor(xcb_window_t transient_for, bool set);
@@ -539,8 +549,10 @@ private:
     friend struct ResetupRulesProcedure;
 
     friend bool performTransiencyCheck();
+    friend class X11ClientPrefetch;
 
     Xcb::StringProperty fetchActivities() const;
+    static Xcb::StringProperty fetchActivities(xcb_window_t window);
     void readActivities(Xcb::StringProperty &property);
     void checkActivities();
     bool activitiesDefined; //whether the x property was actually set
@@ -0,0 +1,58 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "x11clientprefetch.h"
+#include "x11client.h"
+
+namespace KWin
+{
+
+// The requests are issued by the same fetch methods X11Client uses when the properties change
+X11ClientPrefetch::X11ClientPrefetch(xcb_window_t window)
+    : attributes(window)
+    , geometry(window)
+    , wmClientLeader(Toplevel::fetchWmClientLeader(window))
+    , skipCloseAnimation(Toplevel::fetchSkipCloseAnimation(window))
+    , showOnScreenEdge(X11Client::fetchShowOnScreenEdge(window))
+    , colorScheme(X11Client::fetchColorScheme(window))
+    , firstInTabBox(X11Client::fetchFirstInTabBox(window))
+    , transient(X11Client::fetchTransient(window))
+    , activities(X11Client::fetchActivities(window))
+    , applicationMenuServiceName(X11Client::fetchApplicationMenuServiceName(window))
+    , applicationMenuObjectPath(X11Client::fetchApplicationMenuObjectPath(window))
+    , m_window(window)
+{
+}
+
+void X11ClientPrefetch::waitForReplies()
+{
+    attributes.data();
+    geometry.data();
+    wmClientLeader.data();
+    skipCloseAnimation.data();
+    showOnScreenEdge.data();
+    colorScheme.data();
+    firstInTabBox.data();
+    transient.data();
+    activities.data();
+    applicationMenuServiceName.data();
+    applicationMenuObjectPath.data();
+}
+
+}
@@ -0,0 +1,66 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#pragma once
+
+#include "xcbutils.h"
+
+namespace KWin
+{
+
+/**
+ * @brief The requests X11Client::manage() needs the replies of before it can do anything else.
+ *
+ * All of them get issued when the X11ClientPrefetch is created, without waiting for any
+ * reply. When adopting many windows at once, e.g. at startup or after Xwayland got restarted,
+ * creating the X11ClientPrefetch for all of them before managing the first one lets the
+ * server answer the requests of all windows in one go, instead of one round trip per window.
+ */
+class KWIN_EXPORT X11ClientPrefetch
+{
+public:
+    explicit X11ClientPrefetch(xcb_window_t window);
+
+    xcb_window_t window() const {
+        return m_window;
+    }
+
+    /**
+     * Blocks until the replies to all requests arrived.
+     */
+    void waitForReplies();
+
+    Xcb::WindowAttributes attributes;
+    Xcb::WindowGeometry geometry;
+    Xcb::Property wmClientLeader;
+    Xcb::Property skipCloseAnimation;
+    Xcb::Property showOnScreenEdge;
+    Xcb::StringProperty colorScheme;
+    Xcb::Property firstInTabBox;
+    Xcb::TransientFor transient;
+    Xcb::StringProperty activities;
+    Xcb::StringProperty applicationMenuServiceName;
+    Xcb::StringProperty applicationMenuObjectPath;
+
+private:
+    xcb_window_t m_window;
+    Q_DISABLE_COPY(X11ClientPrefetch)
+};
+
+}
@@ -0,0 +1,94 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "chunkqueue.h"
+
+#include <unistd.h>
+
+namespace KWin
+{
+namespace Xwl
+{
+
+const qint64 ChunkQueue::QueueFull;
+
+ChunkQueue::ChunkQueue(int chunkSize, int maxChunks)
+    : m_chunkSize(chunkSize)
+    , m_maxChunks(maxChunks)
+{
+}
+
+qint64 ChunkQueue::readFrom(int fd)
+{
+    if (m_chunks.isEmpty() || m_chunks.last().size == m_chunkSize) {
+        if (m_chunks.count() == m_maxChunks) {
+            return QueueFull;
+        }
+        Chunk chunk;
+        if (!m_pool.isEmpty()) {
+            chunk.buffer = m_pool.takeLast();
+        } else {
+            chunk.buffer.resize(m_chunkSize);
+        }
+        chunk.size = 0;
+        m_chunks.append(chunk);
+    }
+
+    Chunk &chunk = m_chunks.last();
+    const ssize_t length = read(fd, chunk.buffer.data() + chunk.size, m_chunkSize - chunk.size);
+    if (length > 0) {
+        chunk.size += length;
+    }
+    return length;
+}
+
+bool ChunkQueue::isEmpty() const
+{
+    return m_chunks.isEmpty() || m_chunks.first().size == 0;
+}
+
+bool ChunkQueue::isFull() const
+{
+    return m_chunks.count() == m_maxChunks && m_chunks.last().size == m_chunkSize;
+}
+
+bool ChunkQueue::hasCompleteChunk() const
+{
+    return !m_chunks.isEmpty() && m_chunks.first().size == m_chunkSize;
+}
+
+QByteArray ChunkQueue::first() const
+{
+    if (m_chunks.isEmpty()) {
+        return QByteArray();
+    }
+    const Chunk &chunk = m_chunks.first();
+    return QByteArray::fromRawData(chunk.buffer.constData(), chunk.size);
+}
+
+void ChunkQueue::takeFirst()
+{
+    if (m_chunks.isEmpty()) {
+        return;
+    }
+    m_pool.append(m_chunks.takeFirst().buffer);
+}
+
+} // namespace Xwl
+} // namespace KWin
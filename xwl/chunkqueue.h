@@ -0,0 +1,105 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2020 The KWin developers <kwin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_XWL_CHUNKQUEUE
+#define KWIN_XWL_CHUNKQUEUE
+
+#include <QByteArray>
+#include <QVector>
+
+namespace KWin
+{
+namespace Xwl
+{
+
+/**
+ * Queue of data read from a file descriptor, portioned in chunks of equal size.
+ *
+ * At most maxChunks() chunks are queued, isFull() tells the reader to stop reading
+ * until the first chunk has been consumed. Consumed chunks are kept and reused for
+ * the next data, so a transfer only allocates its buffers once.
+ */
+class ChunkQueue
+{
+public:
+    explicit ChunkQueue(int chunkSize, int maxChunks = 2);
+
+    int chunkSize() const {
+        return m_chunkSize;
+    }
+    int maxChunks() const {
+        return m_maxChunks;
+    }
+
+    /**
+     * Returned by readFrom() if all chunks are full, nothing got read then.
+     */
+    static const qint64 QueueFull = -2;
+
+    /**
+     * Reads from @p fd into the last chunk, starting a new one if it is full.
+     *
+     * @returns the number of bytes read, @c 0 at the end of the data, @c -1 on error
+     * and QueueFull if the queue is full
+     */
+    qint64 readFrom(int fd);
+
+    /**
+     * @returns @c true if no data is queued
+     */
+    bool isEmpty() const;
+    /**
+     * @returns @c true if all chunks are queued and full, no more data can be read
+     */
+    bool isFull() const;
+    /**
+     * @returns @c true if the first chunk has been filled completely
+     */
+    bool hasCompleteChunk() const;
+    /**
+     * @returns the number of queued chunks
+     */
+    int count() const {
+        return m_chunks.count();
+    }
+
+    /**
+     * The data of the first chunk. It stays valid until takeFirst() gets called.
+     */
+    QByteArray first() const;
+    /**
+     * Drops the first chunk, its buffer is kept for reuse.
+     */
+    void takeFirst();
+
+private:
+    struct Chunk {
+        QByteArray buffer;
+        int size;
+    };
+    int m_chunkSize;
+    int m_maxChunks;
+    QVector<Chunk> m_chunks;
+    QVector<QByteArray> m_pool;
+};
+
+} // namespace Xwl
+} // namespace KWin
+
+#endif
@@ -35,6 +35,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <KWayland/Server/datadevice_interface.h>
 #include <KWayland/Server/seat_interface.h>
 
+#include <algorithm>
+
 using namespace KWayland::Client;
 using namespace KWayland::Server;
 
@@ -45,6 +47,9 @@ namespace Xwl
 
 static DataBridge *s_self = nullptr;
 
+// in Bytes: the largest chunk sent in a single property change
+static const uint32_t s_maxIncrChunkSize = 1024 * 1024;
+
 DataBridge *DataBridge::self()
 {
     return s_self;
@@ -55,6 +60,13 @@ DataBridge::DataBridge(QObject *parent)
 {
     s_self = this;
 
+    // in units of four bytes, includes BIG-REQUESTS if supported; the reply is only
+    // waited for once per connection
+    const uint32_t maximumRequestLength = xcb_get_maximum_request_length(kwinApp()->x11Connection());
+    // leave room for the request header
+    const uint32_t maximumData = maximumRequestLength * 4 - sizeof(xcb_change_property_request_t);
+    m_incrChunkSize = std::min(maximumData, s_maxIncrChunkSize);
+
     DataDeviceManager *dataDeviceManager = waylandServer()->internalDataDeviceManager();
     Seat *seat = waylandServer()->internalSeat();
     m_dataDevice = dataDeviceManager->getDataDevice(seat, this);
@@ -82,6 +82,14 @@ public:
     {
         return m_dnd;
     }
+    /**
+     * The size of the chunks of incremental transfers to X clients. A chunk has to fit
+     * into a single ChangeProperty request of the Xwayland connection.
+     */
+    int incrChunkSize() const
+    {
+        return m_incrChunkSize;
+    }
 
 private:
     void init();
@@ -90,6 +98,7 @@ private:
 
     Clipboard *m_clipboard = nullptr;
     Dnd *m_dnd = nullptr;
+    int m_incrChunkSize = 0;
 
     /* Internal data device interface */
     KWayland::Client::DataDevice *m_dataDevice = nullptr;
@@ -49,9 +49,6 @@ namespace KWin
 namespace Xwl
 {
 
-// in Bytes: equals 64KB
-static const uint32_t s_incrChunkSize = 63 * 1024;
-
 Transfer::Transfer(xcb_atom_t selection, qint32 fd, xcb_timestamp_t timestamp, QObject *parent)
     : QObject(parent)
     , m_atom(selection)
@@ -100,6 +97,7 @@ TransferWltoX::TransferWltoX(xcb_atom_t selection, xcb_selection_request_event_t
                              qint32 fd, QObject *parent)
     : Transfer(selection, fd, 0, parent)
     , m_request(request)
+    , m_chunks(DataBridge::self()->incrChunkSize())
 {
 }
 
@@ -130,20 +128,25 @@ int TransferWltoX::flushSourceData()
                         m_request->property,
                         m_request->target,
                         8,
-                        m_chunks.first().first.size(),
-                        m_chunks.first().first.data());
+                        m_chunks.first().size(),
+                        m_chunks.first().constData());
     xcb_flush(xcbConn);
 
     m_propertyIsSet = true;
     resetTimeout();
 
-    const auto rm = m_chunks.takeFirst();
-    return rm.first.size();
+    const int size = m_chunks.first().size();
+    m_chunks.takeFirst();
+    if (socketNotifier()) {
+        // there is room for new data again
+        socketNotifier()->setEnabled(true);
+    }
+    return size;
 }
 
 void TransferWltoX::startIncr()
 {
-    Q_ASSERT(m_chunks.size() == 1);
+    Q_ASSERT(m_chunks.count() == 1);
 
     xcb_connection_t *xcbConn = kwinApp()->x11Connection();
 
@@ -153,7 +156,7 @@ void TransferWltoX::startIncr()
                                   XCB_CW_EVENT_MASK, mask);
 
     // spec says to make the available space larger
-    const uint32_t chunkSpace = 1024 + s_incrChunkSize;
+    const uint32_t chunkSpace = 1024 + m_chunks.chunkSize();
     xcb_change_property(xcbConn,
                         XCB_PROP_MODE_REPLACE,
                         m_request->requestor,
@@ -172,20 +175,12 @@ void TransferWltoX::startIncr()
 
 void TransferWltoX::readWlSource()
 {
-    if (m_chunks.size() == 0 ||
-            m_chunks.last().second == s_incrChunkSize) {
-        // append new chunk
-        auto next = QPair<QByteArray, int>();
-        next.first.resize(s_incrChunkSize);
-        next.second = 0;
-        m_chunks.append(next);
+    const qint64 readLen = m_chunks.readFrom(fd());
+    if (readLen == ChunkQueue::QueueFull) {
+        // the notifier fired once more before it got disabled, the data stays in the fd
+        socketNotifier()->setEnabled(false);
+        return;
     }
-
-    const auto oldLen = m_chunks.last().second;
-    const auto avail = s_incrChunkSize - m_chunks.last().second;
-    Q_ASSERT(avail > 0);
-
-    ssize_t readLen = read(fd(), m_chunks.last().first.data() + oldLen, avail);
     if (readLen == -1) {
         qCWarning(KWIN_XWL) << "Error reading in Wl data.";
 
@@ -193,12 +188,9 @@ void TransferWltoX::readWlSource()
         endTransfer();
         return;
     }
-    m_chunks.last().second = oldLen + readLen;
 
     if (readLen == 0) {
         // at the fd end - complete transfer now
-        m_chunks.last().first.resize(m_chunks.last().second);
-
         if (incr()) {
             // incremental transfer is to be completed now
             m_flushPropertyOnDelete = true;
@@ -214,7 +206,7 @@ void TransferWltoX::readWlSource()
             Q_EMIT selectionNotify(m_request, true);
             endTransfer();
         }
-    } else if (m_chunks.last().second == s_incrChunkSize) {
+    } else if (m_chunks.hasCompleteChunk()) {
         // first chunk full, but not yet at fd end -> go incremental
         if (incr()) {
             m_flushPropertyOnDelete = true;
@@ -226,6 +218,11 @@ void TransferWltoX::readWlSource()
             // starting incremental transfer
             startIncr();
         }
+        if (m_chunks.isFull()) {
+            // the requestor is slower than the source, wait for it to
+            // consume a chunk before reading more
+            socketNotifier()->setEnabled(false);
+        }
     }
     resetTimeout();
 }
@@ -269,7 +266,7 @@ void TransferWltoX::handlePropertyDelete()
             xcb_flush(xcbConn);
             m_flushPropertyOnDelete = false;
             endTransfer();
-        } else {
+        } else if (!m_chunks.isEmpty()) {
             flushSourceData();
         }
     }
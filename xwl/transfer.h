@@ -20,9 +20,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef KWIN_XWL_TRANSFER
 #define KWIN_XWL_TRANSFER
 
+#include "chunkqueue.h"
+
 #include <QObject>
 #include <QSocketNotifier>
-#include <QVector>
 
 #include <xcb/xcb.h>
 
@@ -137,10 +138,10 @@ private:
 
     xcb_selection_request_event_t *m_request = nullptr;
 
-    /* contains all received data portioned in chunks
-     * TODO: explain second QPair component
+    /* contains the received data not yet sent to the X client,
+     * bounded so that a slow requestor stops reading from the source
      */
-    QVector<QPair<QByteArray, int> > m_chunks;
+    ChunkQueue m_chunks;
 
     bool m_propertyIsSet = false;
     bool m_flushPropertyOnDelete = false;